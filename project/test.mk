@@ -62,3 +62,29 @@ $(TARGET_TEST)/common: CFLAGS = $(TEST_CFLAGS)
 $(TARGET_TEST)/common: LDFLAGS = $(TEST_DEPS) $(TEST_LDFLAGS)
 $(TARGET_TEST)/common: $(TEST_OBJECT) $(wildcard $(TARGET_OBJ)/*) | build prepare
 	$(executable)
+
+###############################################################################
+##  BENCHMARK TARGETS                                                		 ##
+###############################################################################
+
+SOURCE_BENCH = $(SOURCE_PATH)/bench
+TARGET_BENCH = $(TARGET_BASE)/bench
+
+BENCH_SOURCE = $(wildcard $(SOURCE_BENCH)/*.c)
+BENCH_TARGETS = $(patsubst $(SOURCE_BENCH)/%.c,$(TARGET_BENCH)/%,$(BENCH_SOURCE))
+
+.PHONY: bench
+bench: bench-build
+	@for b in $(BENCH_TARGETS); do echo "== $$(basename $$b)"; $$b || exit 1; done
+
+.PHONY: bench-build
+bench-build: $(BENCH_TARGETS)
+
+$(TARGET_BENCH)/%.o: CFLAGS = $(TEST_CFLAGS)
+$(TARGET_BENCH)/%.o: $(SOURCE_BENCH)/%.c
+	$(object)
+
+$(TARGET_BENCH)/%: CFLAGS = $(TEST_CFLAGS)
+$(TARGET_BENCH)/%: LDFLAGS = $(TEST_LDFLAGS)
+$(TARGET_BENCH)/%: $(TARGET_BENCH)/%.o $(TEST_DEPS) | build prepare
+	$(executable)
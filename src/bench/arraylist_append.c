@@ -0,0 +1,88 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+/*
+ * Times appending to an as_arraylist one element at a time under each growth
+ * policy, with the small block size unpack_list() and UDF result lists use.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <aerospike/as_arraylist.h>
+#include <aerospike/as_nil.h>
+
+#include <citrusleaf/cf_clock.h>
+
+#define BLOCK_SIZE	8
+#define ROUNDS		5
+
+static const uint32_t sizes[] = { 1000, 10000, 100000, 1000000 };
+
+static const char *growth_names[] = {
+	"hybrid",
+	"linear",
+	"geometric"
+};
+
+/******************************************************************************
+ * MAIN
+ *****************************************************************************/
+
+int
+main(int argc, char **argv)
+{
+	printf("%-10s %10s %14s %12s\n", "growth", "elements", "per append", "capacity");
+
+	for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		for (as_arraylist_growth g = AS_ARRAYLIST_GROW_HYBRID;
+				g <= AS_ARRAYLIST_GROW_GEOMETRIC; g++) {
+			// Linear growth is quadratic - don't wait for the largest size.
+			if (g == AS_ARRAYLIST_GROW_LINEAR && sizes[s] > 100000) {
+				continue;
+			}
+
+			uint64_t total_ns = 0;
+			uint32_t capacity = 0;
+
+			for (int r = 0; r < ROUNDS; r++) {
+				as_arraylist list;
+				as_arraylist_init(&list, 0, BLOCK_SIZE);
+				as_arraylist_set_growth(&list, g);
+
+				uint64_t start = cf_getns();
+
+				for (uint32_t i = 0; i < sizes[s]; i++) {
+					if (as_arraylist_append(&list, (as_val *)&as_nil) !=
+							AS_ARRAYLIST_OK) {
+						fprintf(stderr, "append failed\n");
+						return 1;
+					}
+				}
+
+				total_ns += cf_getns() - start;
+				capacity = list.capacity;
+				as_arraylist_destroy(&list);
+			}
+
+			printf("%-10s %10u %11.1f ns %12u\n", growth_names[g], sizes[s],
+					(double)total_ns / ROUNDS / sizes[s], capacity);
+		}
+	}
+
+	return 0;
+}
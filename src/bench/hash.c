@@ -0,0 +1,207 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+/*
+ * Compares the as_val key hashes against the byte at a time sdbm hash and
+ * 32 bit truncation they replaced: bucket distribution under h % capacity, as
+ * as_hashmap uses them, and throughput by key length.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <aerospike/as_integer.h>
+#include <aerospike/as_string.h>
+
+#include <citrusleaf/cf_clock.h>
+#include <citrusleaf/cf_hash_math.h>
+
+#define KEYS		100000
+#define CAPACITY	32768
+#define ROUNDS		2000000
+
+/******************************************************************************
+ * REFERENCE HASHES
+ *****************************************************************************/
+
+static uint32_t
+ref_sdbm(const uint8_t *buf, size_t size)
+{
+	uint32_t hash = 0;
+
+	while (size--) {
+		hash = *buf++ + (hash << 6) + (hash << 16) - hash;
+	}
+
+	return hash;
+}
+
+static uint32_t
+ref_int(int64_t v)
+{
+	return (uint32_t)v;
+}
+
+/******************************************************************************
+ * DISTRIBUTION
+ *****************************************************************************/
+
+static uint32_t buckets[CAPACITY];
+
+// Longest chain and the chi-squared statistic relative to a uniform spread -
+// about CAPACITY for a good hash.
+static void
+report(const char *name, const char *hash, const uint32_t *hashes)
+{
+	memset(buckets, 0, sizeof(buckets));
+
+	for (uint32_t i = 0; i < KEYS; i++) {
+		buckets[hashes[i] % CAPACITY]++;
+	}
+
+	double expect = (double)KEYS / CAPACITY;
+	double chi2 = 0;
+	uint32_t max = 0;
+
+	for (uint32_t b = 0; b < CAPACITY; b++) {
+		double d = buckets[b] - expect;
+		chi2 += d * d / expect;
+
+		if (buckets[b] > max) {
+			max = buckets[b];
+		}
+	}
+
+	printf("%-22s %-8s %10u %14.0f\n", name, hash, max, chi2);
+}
+
+static void
+distribution(void)
+{
+	uint32_t *old = malloc(KEYS * sizeof(uint32_t));
+	uint32_t *new = malloc(KEYS * sizeof(uint32_t));
+	char key[32];
+
+	printf("%-22s %-8s %10s %14s\n", "keys", "hash", "max chain", "chi-squared");
+
+	for (uint32_t i = 0; i < KEYS; i++) {
+		old[i] = ref_int(i);
+		new[i] = cf_hash_mix64(i);
+	}
+
+	report("sequential ints", "old", old);
+	report("sequential ints", "new", new);
+
+	for (uint32_t i = 0; i < KEYS; i++) {
+		old[i] = ref_int((int64_t)i << 32);
+		new[i] = cf_hash_mix64((uint64_t)i << 32);
+	}
+
+	report("ints << 32", "old", old);
+	report("ints << 32", "new", new);
+
+	for (uint32_t i = 0; i < KEYS; i++) {
+		old[i] = ref_int((int64_t)i * CAPACITY);
+		new[i] = cf_hash_mix64((uint64_t)i * CAPACITY);
+	}
+
+	report("ints * capacity", "old", old);
+	report("ints * capacity", "new", new);
+
+	for (uint32_t i = 0; i < KEYS; i++) {
+		int len = sprintf(key, "user:%08u", i);
+		old[i] = ref_sdbm((uint8_t *)key, len);
+		new[i] = cf_hash_murmur32((uint8_t *)key, len);
+	}
+
+	report("strings user:%08u", "old", old);
+	report("strings user:%08u", "new", new);
+
+	free(old);
+	free(new);
+}
+
+/******************************************************************************
+ * THROUGHPUT
+ *****************************************************************************/
+
+static void
+throughput(void)
+{
+	static const uint32_t lens[] = { 8, 16, 32, 64, 256, 1024 };
+	// Each round hashes at a different offset, so the compiler can't hoist it.
+	uint8_t buf[1024 + 64];
+
+	for (uint32_t i = 0; i < sizeof(buf); i++) {
+		buf[i] = (uint8_t)(i * 31 + 7);
+	}
+
+	printf("\n%-8s %12s %12s %8s\n", "bytes", "sdbm", "murmur", "speedup");
+
+	for (uint32_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+		uint32_t len = lens[l];
+		uint32_t rounds = ROUNDS * 8 / len;
+		uint32_t check = 0;
+
+		uint64_t start = cf_getns();
+
+		for (uint32_t r = 0; r < rounds; r++) {
+			check += ref_sdbm(buf + (r & 63), len);
+		}
+
+		uint64_t old_ns = cf_getns() - start;
+
+		start = cf_getns();
+
+		for (uint32_t r = 0; r < rounds; r++) {
+			check += cf_hash_murmur32(buf + (r & 63), len);
+		}
+
+		uint64_t new_ns = cf_getns() - start;
+
+		printf("%-8u %9.2f ns %9.2f ns %7.2fx   (%u)\n", len,
+				(double)old_ns / rounds, (double)new_ns / rounds,
+				(double)old_ns / (new_ns ? new_ns : 1), check & 1);
+	}
+}
+
+/******************************************************************************
+ * MAIN
+ *****************************************************************************/
+
+int
+main(int argc, char **argv)
+{
+	distribution();
+	throughput();
+
+	// Sanity check that the as_val hooks use the new hashes.
+	as_integer i;
+	as_integer_init(&i, 1);
+
+	as_string s;
+	as_string_init(&s, "abc", false);
+
+	if (as_val_hashcode((as_val *)&i) != cf_hash_mix64(1) ||
+			as_val_hashcode((as_val *)&s) != cf_hash_murmur32((uint8_t *)"abc", 3)) {
+		fprintf(stderr, "as_val hashcode mismatch\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+/*
+ * Compares as_unpack_skip() against the element by element switch walker it
+ * replaced, on packed lists with different element mixes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <aerospike/as_msgpack.h>
+
+#include <citrusleaf/cf_byte_order.h>
+#include <citrusleaf/cf_clock.h>
+
+#define ELEMENTS	100000
+#define ROUNDS		200
+
+/******************************************************************************
+ * REFERENCE WALKER
+ *****************************************************************************/
+
+static int64_t ref_size(as_unpacker *pk);
+
+static inline uint32_t
+ref_extract(as_unpacker *pk, uint32_t width)
+{
+	const uint8_t *p = pk->buffer + pk->offset;
+	pk->offset += width;
+
+	if (width == 1) {
+		return p[0];
+	}
+
+	if (width == 2) {
+		return cf_swap_from_be16(*(uint16_t *)p);
+	}
+
+	return cf_swap_from_be32(*(uint32_t *)p);
+}
+
+static int64_t
+ref_elements_size(as_unpacker *pk, uint64_t count)
+{
+	int64_t total = 0;
+
+	for (uint64_t i = 0; i < count; i++) {
+		int64_t ret = ref_size(pk);
+
+		if (ret < 0) {
+			return -1;
+		}
+
+		total += ret;
+	}
+
+	return total;
+}
+
+static int64_t
+ref_size(as_unpacker *pk)
+{
+	if (pk->offset >= pk->length) {
+		return -1;
+	}
+
+	uint8_t type = pk->buffer[pk->offset++];
+
+	switch (type) {
+	case 0xc0:
+	case 0xc3:
+	case 0xc2:
+		return 1;
+	case 0xd0:
+	case 0xcc:
+		pk->offset++;
+		return 2;
+	case 0xd1:
+	case 0xcd:
+		pk->offset += 2;
+		return 3;
+	case 0xca:
+	case 0xd2:
+	case 0xce:
+		pk->offset += 4;
+		return 5;
+	case 0xcb:
+	case 0xd3:
+	case 0xcf:
+		pk->offset += 8;
+		return 9;
+	case 0xc4:
+	case 0xd9: {
+		uint32_t length = ref_extract(pk, 1);
+		pk->offset += length;
+		return 2 + length;
+	}
+	case 0xc5:
+	case 0xda: {
+		uint32_t length = ref_extract(pk, 2);
+		pk->offset += length;
+		return 3 + length;
+	}
+	case 0xc6:
+	case 0xdb: {
+		uint32_t length = ref_extract(pk, 4);
+		pk->offset += length;
+		return 5 + length;
+	}
+	case 0xdc:
+		return 3 + ref_elements_size(pk, ref_extract(pk, 2));
+	case 0xdd:
+		return 5 + ref_elements_size(pk, ref_extract(pk, 4));
+	case 0xde:
+		return 3 + ref_elements_size(pk, 2 * (uint64_t)ref_extract(pk, 2));
+	case 0xdf:
+		return 5 + ref_elements_size(pk, 2 * (uint64_t)ref_extract(pk, 4));
+	default:
+		break;
+	}
+
+	if ((type & 0xe0) == 0xa0) {
+		pk->offset += type & 0x1f;
+		return 1 + (type & 0x1f);
+	}
+
+	if ((type & 0xf0) == 0x80) {
+		return 1 + ref_elements_size(pk, 2 * (uint64_t)(type & 0x0f));
+	}
+
+	if ((type & 0xf0) == 0x90) {
+		return 1 + ref_elements_size(pk, type & 0x0f);
+	}
+
+	if (type < 0x80 || type >= 0xe0) {
+		return 1;
+	}
+
+	return -8;
+}
+
+/******************************************************************************
+ * DATA
+ *****************************************************************************/
+
+typedef enum {
+	MIX_FIXINT,
+	MIX_FIXSTR,
+	MIX_SCALAR,
+	MIX_NESTED
+} mix;
+
+static const char *mix_names[] = {
+	"small ints",
+	"short strings",
+	"ints, doubles, strings",
+	"nested maps and lists"
+};
+
+static uint32_t
+pack_data(as_packer *pk, mix m)
+{
+	as_pack_list_header(pk, ELEMENTS);
+
+	for (uint32_t i = 0; i < ELEMENTS; i++) {
+		switch (m) {
+		case MIX_FIXINT:
+			as_pack_int64(pk, (int64_t)(i % 160) - 32);
+			break;
+		case MIX_FIXSTR:
+			as_pack_str(pk, (const uint8_t *)"abcdefghijklmnop", i % 17);
+			break;
+		case MIX_SCALAR:
+			if (i % 3 == 0) {
+				as_pack_int64(pk, (int64_t)i * 1000003);
+			}
+			else if (i % 3 == 1) {
+				as_pack_double(pk, i * 0.5);
+			}
+			else {
+				as_pack_str(pk, (const uint8_t *)"abcdefgh", 8);
+			}
+			break;
+		case MIX_NESTED:
+			as_pack_map_header(pk, 2);
+			as_pack_str(pk, (const uint8_t *)"k", 1);
+			as_pack_list_header(pk, 3);
+			as_pack_int64(pk, i);
+			as_pack_int64(pk, i + 1);
+			as_pack_int64(pk, 100000 + i);
+			as_pack_int64(pk, 7);
+			as_pack_nil(pk);
+			break;
+		}
+	}
+
+	return pk->offset;
+}
+
+/******************************************************************************
+ * MAIN
+ *****************************************************************************/
+
+int
+main(int argc, char **argv)
+{
+	uint32_t capacity = ELEMENTS * 32;
+	uint8_t *buf = malloc(capacity);
+
+	if (! buf) {
+		return 1;
+	}
+
+	printf("%-24s %12s %12s %8s\n", "data", "reference", "skip", "speedup");
+
+	for (mix m = MIX_FIXINT; m <= MIX_NESTED; m++) {
+		as_packer pk = {
+				.buffer = buf,
+				.capacity = capacity
+		};
+
+		uint32_t size = pack_data(&pk, m);
+		int64_t check = 0;
+
+		uint64_t start = cf_getns();
+
+		for (int r = 0; r < ROUNDS; r++) {
+			as_unpacker upk = { .buffer = buf, .length = size };
+			check += ref_size(&upk);
+		}
+
+		uint64_t ref_ns = cf_getns() - start;
+
+		start = cf_getns();
+
+		for (int r = 0; r < ROUNDS; r++) {
+			as_unpacker upk = { .buffer = buf, .length = size };
+			check -= as_unpack_skip(&upk, 1);
+		}
+
+		uint64_t skip_ns = cf_getns() - start;
+
+		if (check != 0) {
+			fprintf(stderr, "size mismatch for %s\n", mix_names[m]);
+			free(buf);
+			return 1;
+		}
+
+		printf("%-24s %9.1f us %9.1f us %7.2fx\n", mix_names[m],
+				ref_ns / 1000.0 / ROUNDS, skip_ns / 1000.0 / ROUNDS,
+				(double)ref_ns / (skip_ns ? skip_ns : 1));
+	}
+
+	free(buf);
+	return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+/*
+ * Compares cf_queue with cf_queue_mpmc under contention. Every thread pushes
+ * an element and then pops one, so the queues stay short and all threads
+ * fight over the same few cells.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+#include <citrusleaf/cf_clock.h>
+#include <citrusleaf/cf_queue.h>
+#include <citrusleaf/cf_queue_mpmc.h>
+
+#define PAIRS		2000000
+#define MAX_THREADS	64
+
+/******************************************************************************
+ * WORKERS
+ *****************************************************************************/
+
+typedef struct {
+	void *q;
+	uint32_t pairs;
+	pthread_barrier_t *start;
+} worker_args;
+
+static void *
+locked_worker(void *udata)
+{
+	worker_args *args = (worker_args *)udata;
+	cf_queue *q = (cf_queue *)args->q;
+	uint64_t v = 1;
+
+	pthread_barrier_wait(args->start);
+
+	for (uint32_t i = 0; i < args->pairs; i++) {
+		cf_queue_push(q, &v);
+		cf_queue_pop(q, &v, CF_QUEUE_FOREVER);
+	}
+
+	return NULL;
+}
+
+static void *
+mpmc_worker(void *udata)
+{
+	worker_args *args = (worker_args *)udata;
+	cf_queue_mpmc *q = (cf_queue_mpmc *)args->q;
+	uint64_t v = 1;
+
+	pthread_barrier_wait(args->start);
+
+	for (uint32_t i = 0; i < args->pairs; i++) {
+		while (cf_queue_mpmc_push(q, &v) != CF_QUEUE_OK) {
+			sched_yield();
+		}
+
+		cf_queue_mpmc_pop(q, &v, CF_QUEUE_FOREVER);
+	}
+
+	return NULL;
+}
+
+static uint64_t
+run(void *(*worker)(void *), void *q, uint32_t n_threads)
+{
+	pthread_t threads[MAX_THREADS];
+	worker_args args[MAX_THREADS];
+	pthread_barrier_t start;
+
+	pthread_barrier_init(&start, NULL, n_threads + 1);
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		args[i].q = q;
+		args[i].pairs = PAIRS / n_threads;
+		args[i].start = &start;
+		pthread_create(&threads[i], NULL, worker, &args[i]);
+	}
+
+	pthread_barrier_wait(&start);
+
+	uint64_t start_ns = cf_getns();
+
+	for (uint32_t i = 0; i < n_threads; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	pthread_barrier_destroy(&start);
+	return cf_getns() - start_ns;
+}
+
+/******************************************************************************
+ * MAIN
+ *****************************************************************************/
+
+int
+main(int argc, char **argv)
+{
+	printf("%-8s %14s %14s %8s\n", "threads", "cf_queue", "cf_queue_mpmc",
+			"speedup");
+
+	for (uint32_t n = 1; n <= MAX_THREADS; n *= 2) {
+		cf_queue *locked = cf_queue_create(sizeof(uint64_t), true);
+		cf_queue_mpmc *mpmc = cf_queue_mpmc_create(sizeof(uint64_t),
+				MAX_THREADS);
+
+		if (! locked || ! mpmc) {
+			return 1;
+		}
+
+		uint64_t locked_ns = run(locked_worker, locked, n);
+		uint64_t mpmc_ns = run(mpmc_worker, mpmc, n);
+		double ops = 2.0 * (PAIRS / n) * n;
+
+		printf("%-8u %9.2f Mop/s %9.2f Mop/s %7.2fx\n", n,
+				ops * 1000 / locked_ns, ops * 1000 / mpmc_ns,
+				(double)locked_ns / (mpmc_ns ? mpmc_ns : 1));
+
+		cf_queue_destroy(locked);
+		cf_queue_mpmc_destroy(mpmc);
+	}
+
+	return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+/*
+ * Compares ways of waiting for a fan-out of tiny tasks on as_thread_pool: an
+ * as_monitor per task, a task group, and parallel_for.
+ */
+
+#include <stdio.h>
+
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_monitor.h>
+#include <aerospike/as_thread_pool.h>
+
+#include <citrusleaf/cf_clock.h>
+
+#define REQUESTS	2000
+#define FAN_OUT		64
+#define THREADS		8
+
+/******************************************************************************
+ * TASKS
+ *****************************************************************************/
+
+static uint64_t counter;
+
+typedef struct {
+	as_monitor monitor;
+} monitor_task;
+
+static void
+monitor_task_fn(void *data)
+{
+	as_incr_uint64(&counter);
+	as_monitor_notify(&((monitor_task *)data)->monitor);
+}
+
+static void
+group_task_fn(void *data)
+{
+	as_incr_uint64(&counter);
+}
+
+static void
+range_fn(void *udata, uint64_t begin, uint64_t end)
+{
+	as_add_uint64(&counter, end - begin);
+}
+
+/******************************************************************************
+ * RUNS
+ *****************************************************************************/
+
+static uint64_t
+run_monitors(as_thread_pool *pool)
+{
+	monitor_task tasks[FAN_OUT];
+	uint64_t start = cf_getns();
+
+	for (uint32_t r = 0; r < REQUESTS; r++) {
+		for (uint32_t i = 0; i < FAN_OUT; i++) {
+			as_monitor_init(&tasks[i].monitor);
+			as_monitor_begin(&tasks[i].monitor);
+			as_thread_pool_queue_task(pool, monitor_task_fn, &tasks[i]);
+		}
+
+		for (uint32_t i = 0; i < FAN_OUT; i++) {
+			as_monitor_wait(&tasks[i].monitor);
+			as_monitor_destroy(&tasks[i].monitor);
+		}
+	}
+
+	return cf_getns() - start;
+}
+
+static uint64_t
+run_group(as_thread_pool *pool)
+{
+	as_task_group group;
+	uint64_t start = cf_getns();
+
+	for (uint32_t r = 0; r < REQUESTS; r++) {
+		as_task_group_init(&group, pool);
+
+		for (uint32_t i = 0; i < FAN_OUT; i++) {
+			as_task_group_queue(&group, group_task_fn, NULL);
+		}
+
+		as_task_group_wait(&group, CF_QUEUE_FOREVER);
+		as_task_group_destroy(&group);
+	}
+
+	return cf_getns() - start;
+}
+
+static uint64_t
+run_parallel_for(as_thread_pool *pool)
+{
+	uint64_t start = cf_getns();
+
+	for (uint32_t r = 0; r < REQUESTS; r++) {
+		as_thread_pool_parallel_for(pool, 0, FAN_OUT, 1, range_fn, NULL);
+	}
+
+	return cf_getns() - start;
+}
+
+/******************************************************************************
+ * MAIN
+ *****************************************************************************/
+
+int
+main(int argc, char **argv)
+{
+	printf("%-10s %14s %14s %14s\n", "pool", "monitors", "task group",
+			"parallel_for");
+
+	for (int stealing = 0; stealing < 2; stealing++) {
+		as_thread_pool pool;
+
+		if ((stealing ? as_thread_pool_init_stealing(&pool, THREADS) :
+				as_thread_pool_init(&pool, THREADS)) != 0) {
+			return 1;
+		}
+
+		counter = 0;
+
+		uint64_t monitor_ns = run_monitors(&pool);
+		uint64_t group_ns = run_group(&pool);
+		uint64_t range_ns = run_parallel_for(&pool);
+
+		as_thread_pool_destroy(&pool);
+
+		if (counter != 3ULL * REQUESTS * FAN_OUT) {
+			fprintf(stderr, "task count mismatch\n");
+			return 1;
+		}
+
+		printf("%-10s %11.2f us %11.2f us %11.2f us\n",
+				stealing ? "stealing" : "shared",
+				monitor_ns / 1000.0 / REQUESTS, group_ns / 1000.0 / REQUESTS,
+				range_ns / 1000.0 / REQUESTS);
+	}
+
+	return 0;
+}
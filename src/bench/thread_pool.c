@@ -0,0 +1,166 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+/*
+ * Compares as_thread_pool's shared dispatch queue with work stealing mode, on
+ * tiny tasks queued from outside the pool and on trees of tasks queued by
+ * other tasks.
+ */
+
+#include <stdio.h>
+
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_thread_pool.h>
+
+#include <citrusleaf/cf_clock.h>
+
+#define TASKS		1000000
+#define TREE_DEPTH	18
+#define MAX_THREADS	16
+
+/******************************************************************************
+ * TASKS
+ *****************************************************************************/
+
+static uint32_t counter;
+
+static void
+count_task(void *data)
+{
+	as_incr_uint32(&counter);
+}
+
+typedef struct {
+	as_thread_pool *pool;
+	uint32_t depth;
+} tree_node;
+
+static tree_node nodes[TREE_DEPTH];
+
+static void
+tree_task(void *data)
+{
+	tree_node *node = (tree_node *)data;
+
+	as_incr_uint32(&counter);
+
+	if (node->depth + 1 < TREE_DEPTH) {
+		as_thread_pool_queue_task(node->pool, tree_task, &nodes[node->depth + 1]);
+		as_thread_pool_queue_task(node->pool, tree_task, &nodes[node->depth + 1]);
+	}
+}
+
+/******************************************************************************
+ * RUNS
+ *****************************************************************************/
+
+static int
+init_pool(as_thread_pool *pool, uint32_t n_threads, bool stealing)
+{
+	return stealing ? as_thread_pool_init_stealing(pool, n_threads) :
+			as_thread_pool_init(pool, n_threads);
+}
+
+// Time from the first task queued until the pool has run them all and shut
+// down.
+static uint64_t
+run_flat(uint32_t n_threads, bool stealing)
+{
+	as_thread_pool pool;
+
+	if (init_pool(&pool, n_threads, stealing) != 0) {
+		return 0;
+	}
+
+	counter = 0;
+
+	uint64_t start = cf_getns();
+
+	for (uint32_t i = 0; i < TASKS; i++) {
+		as_thread_pool_queue_task(&pool, count_task, NULL);
+	}
+
+	as_thread_pool_destroy(&pool);
+
+	uint64_t ns = cf_getns() - start;
+
+	return counter == TASKS ? ns : 0;
+}
+
+static uint64_t
+run_tree(uint32_t n_threads, bool stealing)
+{
+	as_thread_pool pool;
+
+	if (init_pool(&pool, n_threads, stealing) != 0) {
+		return 0;
+	}
+
+	for (uint32_t i = 0; i < TREE_DEPTH; i++) {
+		nodes[i].pool = &pool;
+		nodes[i].depth = i;
+	}
+
+	counter = 0;
+
+	uint64_t start = cf_getns();
+
+	as_thread_pool_queue_task(&pool, tree_task, &nodes[0]);
+
+	// The shared queue can't be destroyed while tasks still queue more.
+	while (as_load_uint32(&counter) != (1 << TREE_DEPTH) - 1) {
+	}
+
+	uint64_t ns = cf_getns() - start;
+
+	as_thread_pool_destroy(&pool);
+	return ns;
+}
+
+/******************************************************************************
+ * MAIN
+ *****************************************************************************/
+
+int
+main(int argc, char **argv)
+{
+	printf("%-8s %-6s %12s %12s %8s\n", "threads", "tasks", "shared",
+			"stealing", "speedup");
+
+	for (uint32_t n = 1; n <= MAX_THREADS; n *= 2) {
+		uint64_t shared_ns = run_flat(n, false);
+		uint64_t stealing_ns = run_flat(n, true);
+
+		if (shared_ns == 0 || stealing_ns == 0) {
+			fprintf(stderr, "flat run failed with %u threads\n", n);
+			return 1;
+		}
+
+		printf("%-8u %-6s %9.1f ms %9.1f ms %7.2fx\n", n, "flat",
+				shared_ns / 1e6, stealing_ns / 1e6,
+				(double)shared_ns / stealing_ns);
+
+		shared_ns = run_tree(n, false);
+		stealing_ns = run_tree(n, true);
+
+		printf("%-8u %-6s %9.1f ms %9.1f ms %7.2fx\n", n, "tree",
+				shared_ns / 1e6, stealing_ns / 1e6,
+				(double)shared_ns / (stealing_ns ? stealing_ns : 1));
+	}
+
+	return 0;
+}
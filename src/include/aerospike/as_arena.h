@@ -0,0 +1,143 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ *	CONSTANTS
+ *****************************************************************************/
+
+/**
+ *	Default size of each arena chunk.
+ */
+#define AS_ARENA_CHUNK_SIZE 16384
+
+/**
+ *	Alignment of every arena allocation.
+ */
+#define AS_ARENA_ALIGN 8
+
+/******************************************************************************
+ *	TYPES
+ *****************************************************************************/
+
+/**
+ *	@private
+ *	Chunk of arena memory. Chunks are chained newest first.
+ */
+typedef struct as_arena_chunk_s {
+	struct as_arena_chunk_s *next;
+	size_t size;
+} as_arena_chunk;
+
+/**
+ *	Region allocator. Allocations are carved sequentially out of large chunks
+ *	and are never freed individually; the whole arena is released at once by
+ *	as_arena_reset() or as_arena_destroy().
+ *
+ *	An arena is not thread safe.
+ */
+typedef struct as_arena_s {
+	/**
+	 *	Current chunk, followed by older chunks.
+	 */
+	as_arena_chunk *head;
+
+	/**
+	 *	Free space in the current chunk.
+	 */
+	uint8_t *pos;
+	uint8_t *end;
+
+	/**
+	 *	Size of each new chunk.
+	 */
+	uint32_t chunk_size;
+
+	/**
+	 *	If true, then as_arena_destroy() will free the arena.
+	 */
+	bool free;
+} as_arena;
+
+/******************************************************************************
+ *	FUNCTIONS
+ *****************************************************************************/
+
+/**
+ *	Initialize a stack allocated arena. No memory is allocated until the first
+ *	as_arena_alloc().
+ *
+ *	@param arena		The arena to initialize.
+ *	@param chunk_size	Size of each chunk, 0 for AS_ARENA_CHUNK_SIZE.
+ *
+ *	@return The initialized arena.
+ */
+AS_EXTERN as_arena *as_arena_init(as_arena *arena, uint32_t chunk_size);
+
+/**
+ *	Create a heap allocated arena.
+ *
+ *	@param chunk_size	Size of each chunk, 0 for AS_ARENA_CHUNK_SIZE.
+ *
+ *	@return The new arena, NULL on failure.
+ */
+AS_EXTERN as_arena *as_arena_new(uint32_t chunk_size);
+
+/**
+ *	Release everything allocated from the arena, keeping the current chunk for
+ *	reuse.
+ */
+AS_EXTERN void as_arena_reset(as_arena *arena);
+
+/**
+ *	Release everything allocated from the arena and all of its chunks.
+ */
+AS_EXTERN void as_arena_destroy(as_arena *arena);
+
+/**
+ *	@private
+ *	Allocate from a new chunk. Use as_arena_alloc().
+ */
+AS_EXTERN void *as_arena_alloc_chunk(as_arena *arena, size_t size);
+
+/**
+ *	Allocate size bytes, aligned to AS_ARENA_ALIGN. The memory is not zeroed.
+ *
+ *	@return The memory, NULL on failure.
+ */
+static inline void *as_arena_alloc(as_arena *arena, size_t size)
+{
+	size = (size + AS_ARENA_ALIGN - 1) & ~(size_t)(AS_ARENA_ALIGN - 1);
+
+	if (size <= (size_t)(arena->end - arena->pos)) {
+		void *p = arena->pos;
+		arena->pos += size;
+		return p;
+	}
+
+	return as_arena_alloc_chunk(arena, size);
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
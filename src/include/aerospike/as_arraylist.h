@@ -102,7 +102,8 @@ typedef struct as_arraylist_s {
 	as_list _;
 
 	/**
-	 * Number of elements to add, when capacity is reached.
+	 * Number of elements to add, when capacity is reached. How many blocks
+	 * are added depends on the growth policy.
 	 * If 0 (zero), then capacity can't be expanded.
 	 */
 	uint32_t block_size;
@@ -117,19 +118,75 @@ typedef struct as_arraylist_s {
 	 */
 	uint32_t size;
 
+	/**
+	 * @private
+	 * Content hash, valid once hash_valid is set. See as_arraylist_hashcode().
+	 */
+	uint32_t hash;
+
 	/**
 	 * The elements of the list.
 	 */
 	as_val** elements;
 
+	/**
+	 * @private
+	 * Element storage shared with slices, see as_arraylist_slice(). NULL if
+	 * the list doesn't share its elements.
+	 */
+	struct as_arraylist_shared_s* shared;
+
 	/**
 	 * If true, then as_arraylist.elements will be freed when
 	 * as_arraylist_destroy() is called.
 	 */
 	bool free;
 
+	/**
+	 * @private
+	 * If true, then as_arraylist.hash is up to date.
+	 */
+	bool hash_valid;
+
+	/**
+	 * How capacity grows, an as_arraylist_growth. See
+	 * as_arraylist_set_growth().
+	 */
+	uint8_t growth;
+
 } as_arraylist;
 
+/**
+ * Capacity growth policies. All of them grow by whole blocks, and none grows
+ * a list with a block_size of 0.
+ */
+typedef enum as_arraylist_growth_e {
+
+	/**
+	 * Grow by block_size while capacity is below
+	 * AS_ARRAYLIST_GROW_THRESHOLD elements, and double it after that. Small
+	 * lists stay tight, and appending to large ones is amortized O(1).
+	 */
+	AS_ARRAYLIST_GROW_HYBRID	= 0,
+
+	/**
+	 * Always grow by block_size. Appending n elements one at a time copies
+	 * O(n^2 / block_size) pointers.
+	 */
+	AS_ARRAYLIST_GROW_LINEAR	= 1,
+
+	/**
+	 * Always at least double capacity.
+	 */
+	AS_ARRAYLIST_GROW_GEOMETRIC	= 2
+
+} as_arraylist_growth;
+
+/**
+ * Capacity, in elements, above which AS_ARRAYLIST_GROW_HYBRID lists double.
+ */
+#define AS_ARRAYLIST_GROW_THRESHOLD 1024
+
 /**
  * Status codes for various as_arraylist operations.
  */
@@ -153,7 +210,12 @@ typedef enum as_arraylist_status_e {
 	/**
 	 * Illegal array index.
 	 */
-	AS_ARRAYLIST_ERR_INDEX  = 3
+	AS_ARRAYLIST_ERR_INDEX  = 3,
+
+	/**
+	 * Value of a type the list can't hold, see as_typedlist.
+	 */
+	AS_ARRAYLIST_ERR_TYPE   = 4
 
 } as_arraylist_status;
 
@@ -225,12 +287,55 @@ as_arraylist_new(uint32_t capacity, uint32_t block_size);
 AS_EXTERN void
 as_arraylist_destroy(as_arraylist* list);
 
+/**
+ * Set how the list's capacity grows when it fills. Lists start out with
+ * AS_ARRAYLIST_GROW_HYBRID.
+ *
+ * @param list 		The list.
+ * @param growth		The growth policy.
+ * @relatesalso as_arraylist
+ */
+AS_EXTERN void
+as_arraylist_set_growth(as_arraylist* list, as_arraylist_growth growth);
+
+/**
+ * Make room for at least capacity elements, so that many can be added
+ * without reallocating. Works whatever the block_size and growth policy.
+ * Storage not owned by the list, e.g. from as_arraylist_inita(), is copied
+ * to the heap.
+ *
+ * @param list 		The list.
+ * @param capacity		The number of elements to make room for.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred.
+ * @relatesalso as_arraylist
+ */
+AS_EXTERN int
+as_arraylist_reserve(as_arraylist* list, uint32_t capacity);
+
+/**
+ * Release unused capacity, so capacity equals size. Storage not owned by the
+ * list is left alone.
+ *
+ * @param list 		The list.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred.
+ * @relatesalso as_arraylist
+ */
+AS_EXTERN int
+as_arraylist_shrink_to_fit(as_arraylist* list);
+
 /*******************************************************************************
  * VALUE FUNCTIONS
  ******************************************************************************/
 
 /**
- * The hash value of the list.
+ * The hash value of the list, which depends on the elements and their order.
+ *
+ * The first call hashes every element. After that the hash is kept up to date
+ * by set, append, concat and removal at the end, so later calls are O(1) until
+ * an insert or removal in the middle of the list. Changes made inside an
+ * element after it is added are not seen.
  *
  * @param list 	The list.
  *
@@ -293,7 +398,28 @@ AS_EXTERN as_val*
 as_arraylist_head(const as_arraylist* list);
 
 /**
- * Returns a new list containing all elements other than the head
+ * Return a new list of count elements starting at index, clamped to the end
+ * of the list.
+ *
+ * The new list is a view: it shares the element storage of list instead of
+ * copying it, so slicing is O(1) however long the list is. Whichever of the
+ * lists sharing storage is modified first copies its own elements out, so
+ * changes are never seen through another list. Lists whose storage the list
+ * doesn't own, like those from as_arraylist_inita(), are copied instead.
+ *
+ * @param list 	The list.
+ * @param index	Index of the first element of the slice.
+ * @param count	The number of elements in the slice.
+ *
+ * @return The new list, NULL on failure.
+ * @relatesalso as_arraylist
+ */
+AS_EXTERN as_arraylist*
+as_arraylist_slice(const as_arraylist* list, uint32_t index, uint32_t count);
+
+/**
+ * Returns a new list containing all elements other than the head. The new
+ * list is a slice, see as_arraylist_slice().
  *
  * @param list 	The list to get the elements from.
  *
@@ -304,7 +430,8 @@ AS_EXTERN as_arraylist*
 as_arraylist_tail(const as_arraylist* list);
 
 /**
- * Return a new list with the first n elements removed.
+ * Return a new list with the first n elements removed. The new list is a
+ * slice, see as_arraylist_slice().
  *
  * @param list 	The list.
  * @param n 		The number of elements to remove.
@@ -316,7 +443,8 @@ AS_EXTERN as_arraylist*
 as_arraylist_drop(const as_arraylist* list, uint32_t n);
 
 /**
- * Return a new list containing the first n elements.
+ * Return a new list containing the first n elements. The new list is a
+ * slice, see as_arraylist_slice().
  *
  * @param list 	The list.
  * @param n 		The number of elements to take.
@@ -225,6 +225,9 @@ extern "C" {
  * COMPARE AND SWAP
  *****************************************************************************/
 
+// bool as_cas_ptr(void** target, void* old_value, void* new_value)
+#define as_cas_ptr(_target, _old_value, _new_value) ck_pr_cas_ptr(_target, _old_value, _new_value)
+
 // bool as_cas_uint64(uint64_t* target, uint64_t old_value, uint64_t new_value)
 #define as_cas_uint64(_target, _old_value, _new_value) ck_pr_cas_64(_target, _old_value, _new_value)
 
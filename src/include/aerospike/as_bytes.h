@@ -272,6 +272,20 @@ typedef struct as_bytes_s {
 	 */
 	as_bytes_type type;
 
+	/**
+	 *	@private
+	 *	Reference counted region (see cf_rc_alloc()) that `value` points into.
+	 *	Released when the bytes are destroyed. NULL if `value` is not borrowed.
+	 */
+	void * backing;
+
+	/**
+	 *	@private
+	 *	Cached hashcode, 0 if not computed yet. The as_bytes functions that
+	 *	write `value` reset it - code writing `value` directly must too.
+	 */
+	uint32_t hash;
+
 } as_bytes;
 
 /******************************************************************************
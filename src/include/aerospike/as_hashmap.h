@@ -85,6 +85,9 @@ typedef struct as_hashmap_element_s {
  *
  *	This hashmap implementation is NOT threadsafe.
  *
+ *	Keys may be nil, boolean, integer, double, string, bytes, geojson or list
+ *	values. List keys are compared element by element.
+ *
  *	Internally, the hashmap stores keys' and values' pointers - it does NOT copy
  *	the keys or values, so the caller must ensure these keys and values are not
  *	destroyed while the hashmap is still in use.
@@ -131,6 +134,20 @@ typedef struct as_hashmap_s {
 	uint32_t insert_at;
 	uint32_t free_q;
 
+	/**
+	 * If true, then `table` and `extras` are heap allocated and owned by the
+	 * map. Otherwise they are caller storage which the map never grows or
+	 * frees.
+	 */
+	bool free;
+
+	/**
+	 * @private
+	 * Sum of the entry hashes, up to date if hash_valid is set.
+	 */
+	bool hash_valid;
+	uint32_t hash;
+
 } as_hashmap;
 
 /*******************************************************************************
@@ -160,6 +177,34 @@ AS_EXTERN as_hashmap * as_hashmap_init(as_hashmap * map, uint32_t buckets);
  */
 AS_EXTERN as_hashmap * as_hashmap_new(uint32_t buckets);
 
+/**
+ *	Size of the storage needed by as_hashmap_init_wrap().
+ *
+ *	@param buckets		The number of hash buckets.
+ *
+ *	@relatesalso as_hashmap
+ */
+static inline size_t as_hashmap_wrap_size(uint32_t buckets)
+{
+	// Main table plus enough extras for every bucket to chain.
+	return 2 * (size_t)(buckets > 1 ? buckets : 1) * sizeof(as_hashmap_element);
+}
+
+/**
+ *	Initialize a hashmap over caller provided storage of
+ *	as_hashmap_wrap_size(buckets) bytes. The storage is not freed with the map
+ *	and is never grown, so setting more than `buckets` keys may fail.
+ *
+ *	@param map 			The map to initialize.
+ *	@param buckets		The number of hash buckets.
+ *	@param storage		Storage for the table and its collision slots.
+ *
+ *	@return On success, the initialized map. Otherwise NULL.
+ *
+ *	@relatesalso as_hashmap
+ */
+AS_EXTERN as_hashmap * as_hashmap_init_wrap(as_hashmap * map, uint32_t buckets, void * storage);
+
 /**
  *	Free the map and associated resources.
  *
@@ -174,7 +219,12 @@ AS_EXTERN void as_hashmap_destroy(as_hashmap * map);
  ******************************************************************************/
 
 /**
- *	The hash value of the map.
+ *	The hash value of the map, which depends on the entries but not on their
+ *	order.
+ *
+ *	The first call hashes every entry. After that the hash is kept up to date
+ *	by set and remove, so later calls are O(1). Changes made inside a key or
+ *	value after it is added are not seen.
  *
  *	@param map 	The map.
  *
@@ -224,6 +274,28 @@ AS_EXTERN as_val * as_hashmap_get(const as_hashmap * map, const as_val * key);
  */
 AS_EXTERN int as_hashmap_set(as_hashmap * map, const as_val * key, const as_val * val);
 
+/**
+ *	Add count entries at once. All keys are hashed in one pass and the
+ *	collision slots they may need are allocated up front, so the load either
+ *	takes ownership of every key and value or of none of them.
+ *
+ *	If `unique` is true the caller guarantees that no key repeats and none is
+ *	already in the map - e.g. a map produced by the server - and entries are
+ *	linked in without searching their hash chains. Otherwise a repeated key
+ *	replaces the earlier entry, as with as_hashmap_set().
+ *
+ *	@param map 		The map.
+ *	@param keys		The keys.
+ *	@param vals		The values for the keys. NULL values are stored as nil.
+ *	@param count	The number of entries.
+ *	@param unique	If true, skip checking for repeated keys.
+ *
+ *	@return 0 on success. Otherwise an error occurred, and no entry was added.
+ *
+ *	@relatesalso as_hashmap
+ */
+AS_EXTERN int as_hashmap_load(as_hashmap * map, as_val ** keys, as_val ** vals, uint32_t count, bool unique);
+
 /**
  *	Remove all entries from the map.
  *
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+#include <aerospike/as_val.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ *	FUNCTIONS
+ *****************************************************************************/
+
+/**
+ *	@private
+ *	Whether k may be used as a key of as_hashmap, as_openmap or
+ *	as_orderedmap.
+ */
+bool as_hashmap_key_valid(const as_val * k);
+
+/**
+ *	@private
+ *	Whether two valid map keys are the same key.
+ */
+bool as_hashmap_key_eq(const as_val * v1, const as_val * v2);
+
+/**
+ *	@private
+ *	Hash of one map entry, summed over the entries into the map's hashcode.
+ */
+uint32_t as_hashmap_entry_hash(uint32_t key_hash, const as_val * v);
+
+/**
+ *	@private
+ *	Whether the hash of an entry may stay cached in its map. Lists and maps
+ *	can change in place without the map knowing, so entries holding them
+ *	are hashed afresh each time.
+ */
+static inline bool
+as_hashmap_entry_cacheable(const as_val * k, const as_val * v)
+{
+	as_val_t kt = as_val_type(k);
+	as_val_t vt = as_val_type(v);
+
+	return kt != AS_LIST && kt != AS_MAP && vt != AS_LIST && vt != AS_MAP;
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
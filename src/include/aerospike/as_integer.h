@@ -25,6 +25,20 @@
 extern "C" {
 #endif
 
+/******************************************************************************
+ *	CONSTANTS
+ ******************************************************************************/
+
+/**
+ *	Smallest value with a shared instance, see as_integer_new_shared().
+ */
+#define AS_INTEGER_SHARED_MIN -128
+
+/**
+ *	Largest value with a shared instance, see as_integer_new_shared().
+ */
+#define AS_INTEGER_SHARED_MAX 1023
+
 /******************************************************************************
  *	TYPES
  ******************************************************************************/
@@ -158,6 +172,22 @@ AS_EXTERN as_integer * as_integer_init(as_integer * integer, int64_t value);
  */
 AS_EXTERN as_integer * as_integer_new(int64_t value);
 
+/**
+ *	Like as_integer_new(), but values from AS_INTEGER_SHARED_MIN to
+ *	AS_INTEGER_SHARED_MAX return preallocated instances shared by everyone,
+ *	without allocating. Like as_nil, shared instances aren't reference
+ *	counted, so reserving and destroying them does nothing.
+ *
+ *	The result must not be modified, or initialized with as_integer_init().
+ *
+ *	@param value		The integer value.
+ *
+ *	@return On success, the integer. Otherwise NULL.
+ *
+ *	@relatesalso as_integer
+ */
+AS_EXTERN as_integer * as_integer_new_shared(int64_t value);
+
 /**
  *	Destroy the `as_integer` and release resources.
  *
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <aerospike/as_arraylist_iterator.h>
+#include <aerospike/as_typedlist_iterator.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,6 +34,7 @@ extern "C" {
 typedef union as_list_iterator_u {
 	
 	as_arraylist_iterator 	arraylist;
+	as_typedlist_iterator 	typedlist;
 
 } as_list_iterator;
 
@@ -18,6 +18,8 @@
 #pragma once
 
 #include <aerospike/as_hashmap_iterator.h>
+#include <aerospike/as_openmap_iterator.h>
+#include <aerospike/as_orderedmap_iterator.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,6 +35,8 @@ extern "C" {
 typedef union as_map_iterator_u {
 	
 	as_hashmap_iterator 	hashmap;
+	as_openmap_iterator 	openmap;
+	as_orderedmap_iterator 	orderedmap;
 
 } as_map_iterator;
 
@@ -16,15 +16,24 @@
  */
 #pragma once
 
+#include <aerospike/as_arena.h>
+#include <aerospike/as_buffer_pool.h>
 #include <aerospike/as_serializer.h>
 #include <aerospike/as_std.h>
 
+#if !defined(_MSC_VER)
+#include <sys/uio.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #define AS_PACKER_BUFFER_SIZE 8192
 
+#define AS_PACKED_LIST_FLAG_NONE			0x00
+#define AS_PACKED_LIST_FLAG_ORDERED			0x01
+
 #define AS_PACKED_MAP_FLAG_NONE				0x00
 #define AS_PACKED_MAP_FLAG_K_ORDERED		0x01
 #define AS_PACKED_MAP_FLAG_V_ORDERED		0x02 // not allowed on its own
@@ -37,12 +46,37 @@ typedef struct as_packer_buffer {
 	uint32_t length;
 } as_packer_buffer;
 
+// Payload referenced by a packer instead of copied into its buffer.
+typedef struct as_packer_ref_s {
+	const uint8_t *data;
+	uint32_t size;
+	uint32_t offset;	// offset in the packed buffer the payload belongs at
+} as_packer_ref;
+
+struct as_packer;
+
+// Make room for sz more bytes after offset, keeping the packed contents.
+// Return 0 on success.
+typedef int (*as_packer_grow_fn)(struct as_packer *pk, uint32_t sz);
+
 typedef struct as_packer {
 	struct as_packer_buffer *head;
 	struct as_packer_buffer *tail;
 	unsigned char *buffer;
 	uint32_t offset;
 	uint32_t capacity;
+	// If true, a full buffer is grown in place by doubling instead of being
+	// chained on head/tail. buffer must then come from cf_malloc().
+	bool contiguous;
+	// If set, called instead of either of the above to grow a full buffer.
+	as_packer_grow_fn grow;
+	void *grow_udata;
+	// If set, blob payloads of at least ref_threshold bytes are recorded here
+	// instead of copied, while there is room. See as_packer_iov().
+	as_packer_ref *refs;
+	uint32_t ref_count;
+	uint32_t ref_capacity;
+	uint32_t ref_threshold;
 } as_packer;
 
 typedef struct as_unpacker {
@@ -81,6 +115,74 @@ int as_pack_val(as_packer *pk, const as_val *val);
  * @return 0 on success
  */
 int as_unpack_val(as_unpacker *pk, as_val **val);
+/**
+ * Unpack without copying bytes contents. Bytes values point into
+ * pk->buffer, which must be the start of a region from cf_rc_alloc(). Each
+ * such value holds a reservation on the region and releases it when
+ * destroyed, so the caller may release its own reservation as soon as
+ * unpacking is done. The region is not modified. Strings and geojson must be
+ * null-terminated, so they are copied as by as_unpack_val().
+ * @return 0 on success
+ */
+int as_unpack_val_borrowed(as_unpacker *pk, as_val **val);
+/**
+ * Unpack with every value, and everything it points to, allocated from the
+ * arena. The values are not reference counted: as_val_destroy() has no
+ * effect on them and they are released with the arena. Lists and maps from
+ * the arena have fixed capacity.
+ * @return 0 on success
+ */
+int as_unpack_val_arena(as_unpacker *pk, as_val **val, as_arena *arena);
+/**
+ * Unpack a value known to be well formed with no repeated map keys, such as
+ * one produced by the server. Maps are loaded without checking for repeated
+ * keys - a repeated key would leave both entries in the map.
+ * @return 0 on success
+ */
+int as_unpack_val_trusted(as_unpacker *pk, as_val **val);
+
+/**
+ * Start a packer on a buffer popped from the pool, with at least size bytes
+ * of capacity after the pool's header. The packer grows by doubling into
+ * larger buffers from the pool, returning outgrown ones to it. Every other
+ * field of pk is reset, with blob references off.
+ * @return 0 on success
+ */
+int as_packer_pool_init(as_packer *pk, as_buffer_pool *pool, uint32_t size);
+/**
+ * Start of the pool buffer a pool packer is writing to, including the pool's
+ * header. Packed contents start header_size bytes in, at pk->buffer.
+ */
+static inline void *as_packer_pool_data(const as_packer *pk)
+{
+	return pk->buffer - ((as_buffer_pool *)pk->grow_udata)->header_size;
+}
+/**
+ * Return a pool packer's buffer to its pool.
+ */
+void as_packer_pool_release(as_packer *pk);
+
+/**
+ * Maximum number of iovec entries as_packer_iov() may need.
+ */
+static inline uint32_t as_packer_iov_count(const as_packer *pk)
+{
+	return pk->ref_count * 2 + 1;
+}
+/**
+ * Total packed size, including referenced payloads.
+ */
+uint64_t as_packer_size(const as_packer *pk);
+#if !defined(_MSC_VER)
+/**
+ * Describe the packed output as buffer segments interleaved with referenced
+ * payloads, ready for writev(). iov must have as_packer_iov_count() entries.
+ * The packer must not have chained buffers on head/tail, and referenced
+ * payloads must outlive the iovec.
+ * @return number of entries filled, negative on error
+ */
+int as_packer_iov(const as_packer *pk, struct iovec *iov);
+#endif
 
 /******************************************************************************
  * Pack direct functions
@@ -206,6 +308,11 @@ int as_unpack_nil(as_unpacker *pk);
  * @return negative int on error, size on success
  */
 int64_t as_unpack_size(as_unpacker *pk);
+/**
+ * Skip n packed values, including everything nested in them.
+ * @return negative int on error, total size of the values on success
+ */
+int64_t as_unpack_skip(as_unpacker *pk, uint32_t n);
 /**
  * Get size of packed blob.
  * @return negative int on error, size on success
@@ -261,6 +368,18 @@ int64_t as_unpack_map_header_element_count(as_unpacker *pk);
  */
 msgpack_compare_t as_unpack_buf_compare(const uint8_t *buf1, uint32_t size1, const uint8_t *buf2, uint32_t size2);
 msgpack_compare_t as_unpack_compare(as_unpacker *pk1, as_unpacker *pk2);
+/**
+ * Size of scratch memory for comparing values nested up to max_depth levels
+ * with as_unpack_compare_scratch().
+ */
+size_t as_unpack_compare_scratch_size(uint32_t max_depth);
+/**
+ * Compare like as_unpack_compare(), keeping all parse state in the caller's
+ * scratch memory instead of the stack and heap. Never allocates, and fails
+ * with MSGPACK_COMPARE_ERROR when nesting is deeper than the scratch allows.
+ */
+msgpack_compare_t as_unpack_compare_scratch(as_unpacker *pk1, as_unpacker *pk2, void *scratch, size_t scratch_size);
+msgpack_compare_t as_unpack_buf_compare_scratch(const uint8_t *buf1, uint32_t size1, const uint8_t *buf2, uint32_t size2, void *scratch, size_t scratch_size);
 /**
  * Compare two msgpack buffers.
  * @return true if buf1 < buf2
@@ -16,6 +16,7 @@
  */
 #pragma once
 
+#include <aerospike/as_arena.h>
 #include <aerospike/as_msgpack.h>
 #include <aerospike/as_serializer.h>
 
@@ -23,6 +24,27 @@
 extern "C" {
 #endif
 
+/******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+/**
+ * Msgpack serializer which deserializes into an arena.
+ * See as_unpack_val_arena().
+ */
+typedef struct as_msgpack_arena_serializer_s {
+	/**
+	 * @private
+	 * as_msgpack_arena_serializer is an as_serializer.
+	 */
+	as_serializer _;
+
+	/**
+	 * Arena that deserialized values are allocated from.
+	 */
+	as_arena *arena;
+} as_msgpack_arena_serializer;
+
 /******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
@@ -37,6 +59,12 @@ AS_EXTERN as_serializer *as_msgpack_new();
  */
 AS_EXTERN as_serializer *as_msgpack_init(as_serializer *);
 
+/**
+ * Initializes a msgpack serializer which deserializes into the arena.
+ * Serializing is unchanged.
+ */
+AS_EXTERN as_serializer *as_msgpack_arena_init(as_msgpack_arena_serializer *, as_arena *arena);
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
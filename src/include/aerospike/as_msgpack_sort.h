@@ -0,0 +1,92 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_msgpack.h>
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ *	TYPES
+ *****************************************************************************/
+
+/**
+ *	A packed element, or a packed map key and value pair, inside a larger
+ *	msgpack buffer.
+ */
+typedef struct as_msgpack_slice_s {
+	/**
+	 *	Offset of the element in the buffer.
+	 */
+	uint32_t offset;
+
+	/**
+	 *	Packed size of the element, or of the key and value of a pair.
+	 */
+	uint32_t size;
+} as_msgpack_slice;
+
+/******************************************************************************
+ *	FUNCTIONS
+ *****************************************************************************/
+
+/**
+ *	Sort slices of buf in place, in the order of as_unpack_compare(). Map
+ *	pairs are ordered by key. Elements that compare equal keep their relative
+ *	order, except that blobs with equal payloads are ordered by particle type,
+ *	and NaN sorts after all other doubles. Empty strings and blobs sort first
+ *	among their type.
+ *
+ *	Integer, double, boolean and nil elements, and string and blob elements
+ *	that differ within their first 8 bytes, are ordered by keys computed once
+ *	per slice. Only other elements are compared by reparsing them.
+ *
+ *	Comparison specials such as wildcards are rejected. A wildcard nested in a
+ *	list or map compares equal to anything, so such elements have no
+ *	consistent order and must not be sorted.
+ *
+ *	@param buf		Packed msgpack buffer.
+ *	@param slices	Slices of buf to sort.
+ *	@param count	Number of slices.
+ *
+ *	@return 0 on success, negative on failure or if a slice does not hold a
+ *	valid element.
+ */
+AS_EXTERN int as_msgpack_sort_slices(const uint8_t *buf, as_msgpack_slice *slices, uint32_t count);
+
+/**
+ *	Pack the slices, already sorted, as an ordered list
+ *	(AS_PACKED_LIST_FLAG_ORDERED).
+ *
+ *	@return 0 on success
+ */
+AS_EXTERN int as_msgpack_pack_ordered_list(as_packer *pk, const uint8_t *buf, const as_msgpack_slice *slices, uint32_t count);
+
+/**
+ *	Pack the key and value pair slices, already sorted, as a key ordered map
+ *	(AS_PACKED_MAP_FLAG_K_ORDERED).
+ *
+ *	@return 0 on success
+ */
+AS_EXTERN int as_msgpack_pack_ordered_map(as_packer *pk, const uint8_t *buf, const as_msgpack_slice *slices, uint32_t count);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
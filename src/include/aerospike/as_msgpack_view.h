@@ -0,0 +1,255 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_bytes.h>
+#include <aerospike/as_msgpack.h>
+#include <aerospike/as_std.h>
+#include <aerospike/as_val.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ *	CONSTANTS
+ *****************************************************************************/
+
+/**
+ *	Default number of items between recorded offsets of an as_msgpack_index.
+ */
+#define AS_MSGPACK_INDEX_STEP 16
+
+/******************************************************************************
+ *	TYPES
+ *****************************************************************************/
+
+/**
+ *	Read-only view over a single packed msgpack element.
+ *
+ *	A view never copies or allocates. It points into the caller's buffer, which
+ *	must outlive the view and every view derived from it. List elements and map
+ *	pairs are located on demand by skipping packed elements. The view remembers
+ *	the last position it reached, so walking elements in order costs one skip
+ *	per element rather than a rescan from the start.
+ *
+ *	Elements are only turned into as_val objects when explicitly requested via
+ *	as_msgpack_view_to_val().
+ */
+typedef struct as_msgpack_view_s {
+	/**
+	 *	Start of the packed element.
+	 */
+	const uint8_t *buffer;
+
+	/**
+	 *	Bound on the packed element. Exact for views obtained from a parent
+	 *	view, otherwise the size passed to as_msgpack_view_init().
+	 */
+	uint32_t size;
+
+	/**
+	 *	Type of the element.
+	 */
+	as_val_t type;
+
+	/**
+	 *	Number of list elements or map pairs. Zero for scalars.
+	 */
+	uint32_t count;
+
+	/**
+	 *	Offset of the first list element or map pair, past the header and any
+	 *	map metadata pair.
+	 */
+	uint32_t content_offset;
+
+	/**
+	 *	Map flags taken from the metadata pair (AS_PACKED_MAP_FLAG_*).
+	 */
+	uint8_t flags;
+
+	/**
+	 *	Index and offset of the last list element or map pair reached.
+	 */
+	uint32_t cursor_index;
+	uint32_t cursor_offset;
+} as_msgpack_view;
+
+/**
+ *	Offset index over a packed list or map, for repeated random access.
+ *
+ *	The index records the offset of every step-th list element or map pair,
+ *	so reaching any item skips at most step - 1 items. Lookups in key ordered
+ *	maps (AS_PACKED_MAP_FLAG_K_ORDERED) binary search the recorded keys. The
+ *	index does not copy the packed buffer, which must outlive it.
+ */
+typedef struct as_msgpack_index_s {
+	/**
+	 *	The indexed list or map.
+	 */
+	as_msgpack_view view;
+
+	/**
+	 *	Number of items between recorded offsets.
+	 */
+	uint32_t step;
+
+	/**
+	 *	Offsets of items 0, step, 2 * step, ...
+	 */
+	uint32_t *offsets;
+	uint32_t offsets_count;
+} as_msgpack_index;
+
+/******************************************************************************
+ *	FUNCTIONS
+ *****************************************************************************/
+
+/**
+ *	Initialize a view over the packed element at the start of buf.
+ *
+ *	@param view		The view to initialize.
+ *	@param buf		Packed msgpack buffer.
+ *	@param size		Size of buf.
+ *
+ *	@return 0 on success, negative on a malformed or truncated element.
+ */
+AS_EXTERN int as_msgpack_view_init(as_msgpack_view *view, const uint8_t *buf, uint32_t size);
+
+/**
+ *	Type of the viewed element.
+ */
+static inline as_val_t as_msgpack_view_type(const as_msgpack_view *view)
+{
+	return view->type;
+}
+
+/**
+ *	Number of list elements or map pairs. Zero for scalars.
+ */
+static inline uint32_t as_msgpack_view_count(const as_msgpack_view *view)
+{
+	return view->count;
+}
+
+/**
+ *	Get a view of the list element at index.
+ *
+ *	@return 0 on success, negative on failure.
+ */
+AS_EXTERN int as_msgpack_view_list_get(as_msgpack_view *view, uint32_t index, as_msgpack_view *elem);
+
+/**
+ *	Get views of the key and value of the map pair at index, in packed order.
+ *	Either key or value may be NULL.
+ *
+ *	@return 0 on success, negative on failure.
+ */
+AS_EXTERN int as_msgpack_view_map_get_pair(as_msgpack_view *view, uint32_t index, as_msgpack_view *key, as_msgpack_view *value);
+
+/**
+ *	Find the map value whose packed key equals the given packed key. Key
+ *	ordered maps stop scanning once a greater key is seen.
+ *
+ *	@return 0 if found, 1 if not found, negative on failure.
+ */
+AS_EXTERN int as_msgpack_view_map_find(as_msgpack_view *view, const uint8_t *key, uint32_t key_size, as_msgpack_view *value);
+
+/**
+ *	Find the map value whose key equals the given value.
+ *
+ *	@return 0 if found, 1 if not found, negative on failure.
+ */
+AS_EXTERN int as_msgpack_view_map_get(as_msgpack_view *view, const as_val *key, as_msgpack_view *value);
+
+/**
+ *	Read a scalar without allocating.
+ *
+ *	@return 0 on success, negative if the element is not of the requested type.
+ */
+AS_EXTERN int as_msgpack_view_get_bool(const as_msgpack_view *view, bool *value);
+AS_EXTERN int as_msgpack_view_get_int64(const as_msgpack_view *view, int64_t *value);
+AS_EXTERN int as_msgpack_view_get_double(const as_msgpack_view *view, double *value);
+
+/**
+ *	Point to string (or geojson) contents inside the packed buffer. The result
+ *	is not null-terminated.
+ *
+ *	@return pointer to contents, NULL if the element is not a string.
+ */
+AS_EXTERN const char *as_msgpack_view_get_str(const as_msgpack_view *view, uint32_t *len);
+
+/**
+ *	Point to blob contents inside the packed buffer. The particle type of the
+ *	blob is returned in type if it is not NULL.
+ *
+ *	@return pointer to contents, NULL if the element is not a blob.
+ */
+AS_EXTERN const uint8_t *as_msgpack_view_get_bytes(const as_msgpack_view *view, uint32_t *size, as_bytes_type *type);
+
+/**
+ *	Materialize the viewed element (and anything nested in it) as an as_val.
+ *	The caller owns the result.
+ *
+ *	@return the value, NULL on failure.
+ */
+AS_EXTERN as_val *as_msgpack_view_to_val(const as_msgpack_view *view);
+
+/**
+ *	Build an index over a list or map view in one pass. The view is copied.
+ *
+ *	@param index	The index to initialize.
+ *	@param view		View of the packed list or map.
+ *	@param step		Items between recorded offsets, 0 for AS_MSGPACK_INDEX_STEP.
+ *					A step of 1 gives constant time access.
+ *
+ *	@return 0 on success, negative on failure.
+ */
+AS_EXTERN int as_msgpack_index_init(as_msgpack_index *index, const as_msgpack_view *view, uint32_t step);
+
+/**
+ *	Release the recorded offsets.
+ */
+AS_EXTERN void as_msgpack_index_destroy(as_msgpack_index *index);
+
+/**
+ *	Get a view of the list element at i.
+ *
+ *	@return 0 on success, negative on failure.
+ */
+AS_EXTERN int as_msgpack_index_list_get(const as_msgpack_index *index, uint32_t i, as_msgpack_view *elem);
+
+/**
+ *	Get views of the key and value of the map pair at i, in packed order.
+ *	Either key or value may be NULL.
+ *
+ *	@return 0 on success, negative on failure.
+ */
+AS_EXTERN int as_msgpack_index_map_get_pair(const as_msgpack_index *index, uint32_t i, as_msgpack_view *key, as_msgpack_view *value);
+
+/**
+ *	Find the map value whose packed key equals the given packed key. Key
+ *	ordered maps are binary searched, others are scanned.
+ *
+ *	@return 0 if found, 1 if not found, negative on failure.
+ */
+AS_EXTERN int as_msgpack_index_map_find(const as_msgpack_index *index, const uint8_t *key, uint32_t key_size, as_msgpack_view *value);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_map.h>
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ *	CONSTANTS
+ ******************************************************************************/
+
+/**
+ *	Smallest slot table. Tables are always a power of 2.
+ */
+#define AS_OPENMAP_MIN_CAPACITY 8
+
+/**
+ *	The table doubles when an insert would take it past this load, in eighths.
+ */
+#define AS_OPENMAP_MAX_LOAD 7
+
+/******************************************************************************
+ *	TYPES
+ ******************************************************************************/
+
+/**
+ *	Internal structure only for use by as_openmap and as_openmap_iterator.
+ */
+typedef struct as_openmap_slot_s {
+	as_val * p_key;
+	as_val * p_val;
+
+	/**
+	 *	Mixed hash of the key, compared before the keys themselves.
+	 */
+	uint32_t hash;
+
+	/**
+	 *	Distance from the key's home slot plus 1, or 0 if the slot is empty.
+	 */
+	uint32_t dist;
+} as_openmap_slot;
+
+/**
+ *	An open addressing implementation of `as_map`.
+ *
+ *	Entries live directly in a single power of 2 slot table, placed by Robin
+ *	Hood linear probing: an inserted entry takes the slot of any entry closer
+ *	to its home slot, which keeps every probe sequence short. The table
+ *	doubles once it is AS_OPENMAP_MAX_LOAD / 8 full, so the initial capacity
+ *	is only a hint and lookups stay fast however many entries are added.
+ *
+ *	~~~~~~~~~~{.c}
+ *	as_openmap map;
+ *	as_openmap_init(&map, 32);
+ *	as_stringmap_set_int64((as_map *) &map, "a", 1);
+ *	as_openmap_destroy(&map);
+ *	~~~~~~~~~~
+ *
+ *	The `as_openmap` is a subtype of `as_map`, and has the same ownership rules
+ *	as `as_hashmap`: keys and values are not copied or reserved, and are
+ *	destroyed when removed, replaced, cleared or when the map is destroyed.
+ *
+ *	This map implementation is NOT threadsafe.
+ *
+ *	@extends as_map
+ *	@ingroup aerospike_t
+ */
+typedef struct as_openmap_s {
+
+	/**
+	 *	@private
+	 *	as_openmap is an as_map.
+	 *	You can cast as_openmap to as_map.
+	 */
+	as_map _;
+
+	/**
+	 *	Number of elements in the map.
+	 */
+	uint32_t count;
+
+	/**
+	 *	Number of slots, a power of 2.
+	 */
+	uint32_t capacity;
+
+	/**
+	 *	The slot table.
+	 */
+	as_openmap_slot * slots;
+
+	/**
+	 *	@private
+	 *	Sum of the entry hashes, up to date if hash_valid is set.
+	 */
+	bool hash_valid;
+	uint32_t hash;
+
+} as_openmap;
+
+/*******************************************************************************
+ *	INSTANCE FUNCTIONS
+ ******************************************************************************/
+
+/**
+ *	Initialize a stack allocated openmap.
+ *
+ *	@param map 			The map to initialize.
+ *	@param capacity		The number of entries expected, 0 for the minimum.
+ *
+ *	@return On success, the initialized map. Otherwise NULL.
+ *
+ *	@relatesalso as_openmap
+ */
+AS_EXTERN as_openmap * as_openmap_init(as_openmap * map, uint32_t capacity);
+
+/**
+ *	Creates a new map as an openmap.
+ *
+ *	@param capacity		The number of entries expected, 0 for the minimum.
+ *
+ *	@return On success, the new map. Otherwise NULL.
+ *
+ *	@relatesalso as_openmap
+ */
+AS_EXTERN as_openmap * as_openmap_new(uint32_t capacity);
+
+/**
+ *	Free the map and associated resources.
+ *
+ *	@param map 	The map to destroy.
+ *
+ *	@relatesalso as_openmap
+ */
+AS_EXTERN void as_openmap_destroy(as_openmap * map);
+
+/*******************************************************************************
+ *	INFO FUNCTIONS
+ ******************************************************************************/
+
+/**
+ *	The hash value of the map. Like as_hashmap_hashcode(), it is independent
+ *	of entry order and O(1) after the first call.
+ *
+ *	@relatesalso as_openmap
+ */
+AS_EXTERN uint32_t as_openmap_hashcode(const as_openmap * map);
+
+/**
+ *	Get the number of entries in the map.
+ *
+ *	@relatesalso as_openmap
+ */
+AS_EXTERN uint32_t as_openmap_size(const as_openmap * map);
+
+/*******************************************************************************
+ *	ACCESSOR AND MODIFIER FUNCTIONS
+ ******************************************************************************/
+
+/**
+ *	Get the value for specified key.
+ *
+ *	@param map 		The map.
+ *	@param key		The key.
+ *
+ *	@return The value for the specified key. Otherwise NULL.
+ *
+ *	@relatesalso as_openmap
+ */
+AS_EXTERN as_val * as_openmap_get(const as_openmap * map, const as_val * key);
+
+/**
+ *	Set the value for specified key.
+ *
+ *	@param map 		The map.
+ *	@param key		The key.
+ *	@param val		The value for the given key.
+ *
+ *	@return 0 on success. Otherwise an error occurred.
+ *
+ *	@relatesalso as_openmap
+ */
+AS_EXTERN int as_openmap_set(as_openmap * map, const as_val * key, const as_val * val);
+
+/**
+ *	Make room for at least count entries without further resizing.
+ *
+ *	@return 0 on success. Otherwise an error occurred.
+ *
+ *	@relatesalso as_openmap
+ */
+AS_EXTERN int as_openmap_reserve(as_openmap * map, uint32_t count);
+
+/**
+ *	Remove all entries from the map. The slot table is kept.
+ *
+ *	@return 0 on success. Otherwise an error occurred.
+ *
+ *	@relatesalso as_openmap
+ */
+AS_EXTERN int as_openmap_clear(as_openmap * map);
+
+/**
+ *	Remove the entry specified by the key.
+ *
+ *	@param map 	The map to remove the entry from.
+ *	@param key 	The key of the entry to be removed.
+ *
+ *	@return 0 on success. Otherwise an error occurred.
+ *
+ *	@relatesalso as_openmap
+ */
+AS_EXTERN int as_openmap_remove(as_openmap * map, const as_val * key);
+
+/******************************************************************************
+ *	ITERATION FUNCTIONS
+ *****************************************************************************/
+
+/**
+ *	Call the callback function for each entry in the map.
+ *
+ *	@param map		The map.
+ *	@param callback	The function to call for each entry.
+ *	@param udata	User-data to be passed to the callback.
+ *	
+ *	@return true if iteration completes fully. false if iteration was aborted.
+ *
+ *	@relatesalso as_openmap
+ */
+AS_EXTERN bool as_openmap_foreach(const as_openmap * map, as_map_foreach_callback callback, void * udata);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
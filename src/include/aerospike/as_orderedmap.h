@@ -0,0 +1,316 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_map.h>
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ *	CONSTANTS
+ ******************************************************************************/
+
+/**
+ *	Smallest entry array allocated for a heap map.
+ */
+#define AS_ORDEREDMAP_MIN_CAPACITY 8
+
+/******************************************************************************
+ *	TYPES
+ ******************************************************************************/
+
+/**
+ *	Internal structure only for use by as_orderedmap and as_orderedmap_iterator.
+ */
+typedef struct as_orderedmap_entry_s {
+	as_val * p_key;
+	as_val * p_val;
+} as_orderedmap_entry;
+
+/**
+ *	A key ordered implementation of `as_map`.
+ *
+ *	Entries are kept in one array sorted by key, in the collation of
+ *	as_unpack_compare(), and are found by binary search. Iteration, foreach
+ *	and packing visit entries in key order, so a map unpacked from a
+ *	K-ordered packed map packs back out in the same order without a sort.
+ *	Keys set in increasing order are appended; any other insert or remove
+ *	moves the entries after it.
+ *
+ *	~~~~~~~~~~{.c}
+ *	as_orderedmap map;
+ *	as_orderedmap_init(&map, 32);
+ *	as_stringmap_set_int64((as_map *) &map, "b", 2);
+ *	as_stringmap_set_int64((as_map *) &map, "a", 1);
+ *	as_orderedmap_destroy(&map);
+ *	~~~~~~~~~~
+ *
+ *	The map's flags are AS_PACKED_MAP_FLAG_K_ORDERED, and as_pack_val()
+ *	packs it with the map ext header so the ordering is kept on the wire. A
+ *	map unpacked as AS_PACKED_MAP_FLAG_KV_ORDERED keeps that flag and is
+ *	packed with it.
+ *
+ *	The `as_orderedmap` is a subtype of `as_map`, and has the same ownership
+ *	rules as `as_hashmap`: keys and values are not copied or reserved, and are
+ *	destroyed when removed, replaced, cleared or when the map is destroyed.
+ *
+ *	This map implementation is NOT threadsafe.
+ *
+ *	@extends as_map
+ *	@ingroup aerospike_t
+ */
+typedef struct as_orderedmap_s {
+
+	/**
+	 *	@private
+	 *	as_orderedmap is an as_map.
+	 *	You can cast as_orderedmap to as_map.
+	 */
+	as_map _;
+
+	/**
+	 *	Number of elements in the map.
+	 */
+	uint32_t count;
+
+	/**
+	 *	Number of entries the array can hold.
+	 */
+	uint32_t capacity;
+
+	/**
+	 *	The entries, sorted by key.
+	 */
+	as_orderedmap_entry * entries;
+
+	/**
+	 *	If true, entries is heap allocated and grows as needed.
+	 */
+	bool free;
+
+	/**
+	 *	@private
+	 *	Sum of the entry hashes, up to date if hash_valid is set.
+	 */
+	bool hash_valid;
+	uint32_t hash;
+
+} as_orderedmap;
+
+/*******************************************************************************
+ *	INSTANCE FUNCTIONS
+ ******************************************************************************/
+
+/**
+ *	Initialize a stack allocated orderedmap.
+ *
+ *	@param map 			The map to initialize.
+ *	@param capacity		The number of entries expected, 0 for the minimum.
+ *
+ *	@return On success, the initialized map. Otherwise NULL.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN as_orderedmap * as_orderedmap_init(as_orderedmap * map, uint32_t capacity);
+
+/**
+ *	Creates a new map as an orderedmap.
+ *
+ *	@param capacity		The number of entries expected, 0 for the minimum.
+ *
+ *	@return On success, the new map. Otherwise NULL.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN as_orderedmap * as_orderedmap_new(uint32_t capacity);
+
+/**
+ *	Size of the storage needed by as_orderedmap_init_wrap().
+ *
+ *	@param capacity		The number of entries.
+ *
+ *	@relatesalso as_orderedmap
+ */
+static inline size_t as_orderedmap_wrap_size(uint32_t capacity)
+{
+	return (size_t)(capacity > 1 ? capacity : 1) * sizeof(as_orderedmap_entry);
+}
+
+/**
+ *	Initialize an orderedmap over caller provided storage of
+ *	as_orderedmap_wrap_size(capacity) bytes. The storage is not freed with the
+ *	map and is never grown, so setting more than `capacity` keys fails.
+ *
+ *	@param map 			The map to initialize.
+ *	@param capacity		The number of entries.
+ *	@param storage		Storage for the entries.
+ *
+ *	@return On success, the initialized map. Otherwise NULL.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN as_orderedmap * as_orderedmap_init_wrap(as_orderedmap * map, uint32_t capacity, void * storage);
+
+/**
+ *	Free the map and associated resources.
+ *
+ *	@param map 	The map to destroy.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN void as_orderedmap_destroy(as_orderedmap * map);
+
+/*******************************************************************************
+ *	INFO FUNCTIONS
+ ******************************************************************************/
+
+/**
+ *	The hash value of the map. Like as_hashmap_hashcode(), it is independent
+ *	of entry order and O(1) after the first call.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN uint32_t as_orderedmap_hashcode(const as_orderedmap * map);
+
+/**
+ *	Get the number of entries in the map.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN uint32_t as_orderedmap_size(const as_orderedmap * map);
+
+/*******************************************************************************
+ *	ACCESSOR AND MODIFIER FUNCTIONS
+ ******************************************************************************/
+
+/**
+ *	Get the value for specified key.
+ *
+ *	@param map 		The map.
+ *	@param key		The key.
+ *
+ *	@return The value for the specified key. Otherwise NULL.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN as_val * as_orderedmap_get(const as_orderedmap * map, const as_val * key);
+
+/**
+ *	Get the index of the first entry whose key is not less than key, which
+ *	is as_orderedmap_size() if there is none.
+ *
+ *	@param map 		The map.
+ *	@param key		The key.
+ *	@param found	Set to true if the entry at the index has the key. May be
+ *					NULL.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN uint32_t as_orderedmap_find(const as_orderedmap * map, const as_val * key, bool * found);
+
+/**
+ *	Get the entry at index, in key order.
+ *
+ *	@return true if index is in range and key and value were set.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN bool as_orderedmap_get_at(const as_orderedmap * map, uint32_t index, as_val ** key, as_val ** val);
+
+/**
+ *	Set the value for specified key.
+ *
+ *	@param map 		The map.
+ *	@param key		The key.
+ *	@param val		The value for the given key.
+ *
+ *	@return 0 on success. Otherwise an error occurred.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN int as_orderedmap_set(as_orderedmap * map, const as_val * key, const as_val * val);
+
+/**
+ *	Make room for at least count entries without further resizing.
+ *
+ *	@return 0 on success. Otherwise an error occurred.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN int as_orderedmap_reserve(as_orderedmap * map, uint32_t count);
+
+/**
+ *	Remove all entries from the map. The entry array is kept.
+ *
+ *	@return 0 on success. Otherwise an error occurred.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN int as_orderedmap_clear(as_orderedmap * map);
+
+/**
+ *	Remove the entry specified by the key.
+ *
+ *	@param map 	The map to remove the entry from.
+ *	@param key 	The key of the entry to be removed.
+ *
+ *	@return 0 on success. Otherwise an error occurred.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN int as_orderedmap_remove(as_orderedmap * map, const as_val * key);
+
+/******************************************************************************
+ *	ITERATION FUNCTIONS
+ *****************************************************************************/
+
+/**
+ *	Call the callback function for each entry in the map, in key order.
+ *
+ *	@param map		The map.
+ *	@param callback	The function to call for each entry.
+ *	@param udata	User-data to be passed to the callback.
+ *	
+ *	@return true if iteration completes fully. false if iteration was aborted.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN bool as_orderedmap_foreach(const as_orderedmap * map, as_map_foreach_callback callback, void * udata);
+
+/**
+ *	Call the callback function for each entry with a key in [begin, end), in
+ *	key order. The start of the range is found by binary search.
+ *
+ *	@param map		The map.
+ *	@param begin	The first key of the range, or NULL to start at the first
+ *					entry.
+ *	@param end		The key ending the range, or NULL to run to the last entry.
+ *	@param callback	The function to call for each entry.
+ *	@param udata	User-data to be passed to the callback.
+ *	
+ *	@return true if iteration completes fully. false if iteration was aborted.
+ *
+ *	@relatesalso as_orderedmap
+ */
+AS_EXTERN bool as_orderedmap_foreach_range(const as_orderedmap * map, const as_val * begin, const as_val * end, as_map_foreach_callback callback, void * udata);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
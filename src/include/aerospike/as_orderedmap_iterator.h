@@ -0,0 +1,142 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_orderedmap.h>
+#include <aerospike/as_iterator.h>
+#include <aerospike/as_pair.h>
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ *	TYPES
+ ******************************************************************************/
+
+/**
+ *	Iterator for as_orderedmap. Used the same way as as_hashmap_iterator, but
+ *	entries come in key order, and as_orderedmap_iterator_init_range() limits
+ *	the iteration to a range of keys.
+ *
+ *	as_orderedmap_iterator_next() returns an as_pair pointer, which is re-used
+ *	for all the iterations and is only valid until the next iteration.
+ *
+ *	@extends as_iterator
+ */
+typedef struct as_orderedmap_iterator_s {
+
+	as_iterator _;
+
+	/**
+	 *	The orderedmap
+	 */
+	const as_orderedmap * map;
+
+	/**
+	 *	Next entry to return
+	 */
+	uint32_t pos;
+
+	/**
+	 *	Entry ending the iteration
+	 */
+	uint32_t end;
+
+	/**
+	 *	Last returned key & value
+	 */
+	as_pair pair;
+
+} as_orderedmap_iterator;
+
+/******************************************************************************
+ *	FUNCTIONS
+ *****************************************************************************/
+
+/**
+ *	Initializes a stack allocated as_iterator for the given as_orderedmap.
+ *
+ *	@param iterator 	The iterator to initialize.
+ *	@param map			The map to iterate.
+ *
+ *	@return On success, the initialized iterator. Otherwise NULL.
+ *
+ *	@relatesalso as_orderedmap_iterator
+ */
+AS_EXTERN as_orderedmap_iterator * as_orderedmap_iterator_init(as_orderedmap_iterator * iterator, const as_orderedmap * map);
+
+/**
+ *	Initializes a stack allocated as_iterator over the entries of the given
+ *	as_orderedmap with keys in [begin, end). Both ends are found by binary
+ *	search.
+ *
+ *	@param iterator 	The iterator to initialize.
+ *	@param map			The map to iterate.
+ *	@param begin		The first key of the range, or NULL to start at the
+ *						first entry.
+ *	@param end			The key ending the range, or NULL to run to the last
+ *						entry.
+ *
+ *	@return On success, the initialized iterator. Otherwise NULL.
+ *
+ *	@relatesalso as_orderedmap_iterator
+ */
+AS_EXTERN as_orderedmap_iterator * as_orderedmap_iterator_init_range(as_orderedmap_iterator * iterator, const as_orderedmap * map, const as_val * begin, const as_val * end);
+
+/**
+ *	Creates a heap allocated as_iterator for the given as_orderedmap.
+ *
+ *	@param map 			The map to iterate.
+ *
+ *	@return On success, the new iterator. Otherwise NULL.
+ *
+ *	@relatesalso as_orderedmap_iterator
+ */
+AS_EXTERN as_orderedmap_iterator * as_orderedmap_iterator_new(const as_orderedmap * map);
+
+/**
+ *	Destroy the iterator and releases resources used by the iterator.
+ *
+ *	@relatesalso as_orderedmap_iterator
+ */
+AS_EXTERN void as_orderedmap_iterator_destroy(as_orderedmap_iterator * iterator);
+
+/******************************************************************************
+ *	ITERATOR FUNCTIONS
+ *****************************************************************************/
+
+/**
+ *	Tests if there are more values available in the iterator.
+ *
+ *	@relatesalso as_orderedmap_iterator
+ */
+AS_EXTERN bool as_orderedmap_iterator_has_next(const as_orderedmap_iterator * iterator);
+
+/**
+ *	Get the next key & value pair and iterate past it.
+ *
+ *	@return The next pair if available. Otherwise NULL.
+ *
+ *	@relatesalso as_orderedmap_iterator
+ */
+AS_EXTERN const as_val * as_orderedmap_iterator_next(as_orderedmap_iterator * iterator);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
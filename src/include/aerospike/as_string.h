@@ -114,6 +114,12 @@ typedef struct as_string_s {
 	 */
 	bool free;
 
+	/**
+	 *	@private
+	 *	Cached hashcode, 0 if not computed yet.
+	 */
+	uint32_t hash;
+
 	/**
 	 *	The string value.
 	 */
@@ -193,7 +199,8 @@ AS_EXTERN as_string * as_string_new_wlen(char * value, size_t len, bool free);
 /**
  *	Create and initialize a new heap allocated `as_string`.
  *
- *	Value is cf_strdup()'d and will be freed when the as_string is destroyed.
+ *	Value is copied into the same allocation as the as_string, so the copy
+ *	costs no extra allocation and is released with the as_string.
  *
  *	@param value 	The NULL terminated string of character.
  *
@@ -201,6 +208,20 @@ AS_EXTERN as_string * as_string_new_wlen(char * value, size_t len, bool free);
  */
 AS_EXTERN as_string * as_string_new_strdup(const char * value);
 
+/**
+ *	Create and initialize a new heap allocated `as_string` from at most len
+ *	characters of value, like cf_strndup().
+ *
+ *	Value is copied into the same allocation as the as_string, as by
+ *	as_string_new_strdup().
+ *
+ *	@param value 	The string of characters.
+ *	@param len		The maximum number of characters to copy.
+ *
+ *	@return On success, the new string. Otherwise NULL.
+ */
+AS_EXTERN as_string * as_string_new_strndup(const char * value, size_t len);
+
 /**
  *	Destroy the as_string and associated resources.
  *
@@ -24,6 +24,16 @@
 extern "C" {
 #endif
 	
+/******************************************************************************
+ *	CONSTANTS
+ *****************************************************************************/
+
+/**
+ *	@private
+ *	Maximum number of threads in a work stealing thread pool.
+ */
+#define AS_THREAD_POOL_MAX_WORKERS 1024
+
 /******************************************************************************
  *	TYPES
  *****************************************************************************/
@@ -39,6 +49,59 @@ typedef void (*as_task_fn)(void* user_data);
  *	Thread finalization function callback.
  */
 typedef void (*as_fini_fn)();
+
+/**
+ *	@private
+ *	Range function callback for as_thread_pool_parallel_for(), called on
+ *	[begin, end).
+ */
+typedef void (*as_range_fn)(void* udata, uint64_t begin, uint64_t end);
+
+/**
+ *	@private
+ *	Thread pool options for as_thread_pool_init_options(). Zero initialize for
+ *	a default variable task thread pool.
+ *
+ *	CPU pinning and thread names are only applied on Linux, and are ignored
+ *	elsewhere.
+ */
+typedef struct as_thread_pool_options_s {
+	/**
+	 *	Run in work stealing mode, as as_thread_pool_init_stealing().
+	 */
+	bool stealing;
+
+	/**
+	 *	Pin the thread with index i to cpus[i % n_cpus]. Threads started by
+	 *	as_thread_pool_resize() continue from the running thread count.
+	 */
+	const uint16_t* cpus;
+	uint32_t n_cpus;
+
+	/**
+	 *	Without a CPU list, pin one thread per CPU the process is allowed to
+	 *	run on, in CPU order.
+	 */
+	bool pin_per_cpu;
+
+	/**
+	 *	Work stealing pools only. Each worker allocates its own deque and inbox
+	 *	once it is running, so with the kernel's first touch policy they are
+	 *	placed on the NUMA node of the worker's CPU. Use with pinning.
+	 */
+	bool numa_local;
+
+	/**
+	 *	Thread stack size in bytes, 0 for the system default.
+	 */
+	size_t stack_size;
+
+	/**
+	 *	Thread name prefix, or NULL. Threads are named "<name>-<index>",
+	 *	truncated to 15 characters.
+	 */
+	const char* name;
+} as_thread_pool_options;
 	
 /**
  *	@private
@@ -54,8 +117,40 @@ typedef struct as_thread_pool_s {
 	uint32_t task_complete_offset;
 	uint32_t thread_size;
 	uint32_t initialized;
+
+	// Work stealing pools only. Workers are created as threads are first
+	// started and kept until the pool is destroyed.
+	struct as_thread_pool_worker_s** workers;
+	uint32_t worker_count;
+	uint32_t next_worker;
+	uint32_t sleepers;
+	uint32_t waking;
+	pthread_mutex_t idle_lock;
+	pthread_cond_t idle_cond;
+	bool stealing;
+
+	// Thread options, see as_thread_pool_options. cpus is NULL when threads
+	// are not pinned.
+	uint16_t* cpus;
+	uint32_t n_cpus;
+	size_t stack_size;
+	char name[16];
+	bool numa_local;
 } as_thread_pool;
 
+/**
+ *	@private
+ *	Group of tasks that can be waited on together. Completions only touch an
+ *	atomic counter, except the one that completes the group, which wakes the
+ *	waiters.
+ */
+typedef struct as_task_group_s {
+	as_thread_pool* pool;
+	uint32_t pending;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+} as_task_group;
+
 /******************************************************************************
  *	FUNCTIONS
  *****************************************************************************/
@@ -91,6 +186,40 @@ int
 as_thread_pool_init_fixed(as_thread_pool* pool, uint32_t thread_size, as_task_fn task_fn,
 						  uint32_t task_size, uint32_t task_complete_offset);
 
+/**
+ *	@private
+ *	Initialize variable task thread pool in work stealing mode and start
+ *	thread_size threads.
+ *
+ *	Each thread has its own task deque instead of sharing one dispatch queue.
+ *	Tasks queued from a pool thread go on that thread's deque, tasks queued
+ *	from other threads are spread round-robin, and idle threads steal from the
+ *	others. Fixed tasks are not supported.
+ *
+ *	Returns:
+ *	0  : Success
+ *	-1 : Failed to initialize mutex lock
+ *	-2 : Failed to lock mutex
+ *	-3 : Some threads failed to start
+ */
+int
+as_thread_pool_init_stealing(as_thread_pool* pool, uint32_t thread_size);
+
+/**
+ *	@private
+ *	Initialize variable task thread pool with options and start thread_size
+ *	threads. A NULL options is the same as as_thread_pool_init().
+ *
+ *	Returns:
+ *	0  : Success
+ *	-1 : Failed to initialize mutex lock
+ *	-2 : Failed to lock mutex
+ *	-3 : Some threads failed to start
+ */
+int
+as_thread_pool_init_options(as_thread_pool* pool, uint32_t thread_size,
+							const as_thread_pool_options* options);
+
 /**
  *	@private
  *	Resize number of running threads in thread pool.
@@ -128,6 +257,72 @@ as_thread_pool_queue_task(as_thread_pool* pool, as_task_fn task_fn, void* task);
 int
 as_thread_pool_queue_task_fixed(as_thread_pool* pool, void* task);
 
+/**
+ *	@private
+ *	Initialize a task group on a variable task thread pool.
+ *
+ *	Returns:
+ *	0  : Success
+ *	-1 : Failed to initialize mutex lock
+ */
+int
+as_task_group_init(as_task_group* group, as_thread_pool* pool);
+
+/**
+ *	@private
+ *	Destroy a task group. All of its tasks must have completed.
+ */
+void
+as_task_group_destroy(as_task_group* group);
+
+/**
+ *	@private
+ *	Queue a variable task onto the group's thread pool as part of the group.
+ *
+ *	Returns:
+ *	0  : Success
+ *	-1 : No threads are running to process task.
+ *	-2 : Failed to push task onto dispatch queue
+ */
+int
+as_task_group_queue(as_task_group* group, as_task_fn task_fn, void* task);
+
+/**
+ *	@private
+ *	Number of the group's tasks not yet completed.
+ */
+static inline uint32_t
+as_task_group_pending(as_task_group* group)
+{
+	return *(volatile uint32_t*)&group->pending;
+}
+
+/**
+ *	@private
+ *	Wait until all of the group's tasks have completed. ms_wait is as for
+ *	cf_queue_pop(). Waiting from a task of a work stealing pool runs other
+ *	tasks meanwhile. Don't wait from a task of a shared queue pool, where the
+ *	group's tasks may be queued behind the waiting one.
+ *
+ *	Returns:
+ *	0  : All tasks completed
+ *	-1 : Timed out
+ */
+int
+as_task_group_wait(as_task_group* group, int ms_wait);
+
+/**
+ *	@private
+ *	Call fn on [begin, end) split into chunks of grain indexes, 0 to pick a
+ *	chunk size from the number of threads. Chunks are run by the calling
+ *	thread and by pool threads as they become free, and the call returns once
+ *	all have completed. Safe to call from a task of the same pool. Runs the
+ *	whole range in the calling thread if the pool can't take tasks.
+ */
+void
+as_thread_pool_parallel_for(as_thread_pool* pool, uint64_t begin, uint64_t end, uint64_t grain,
+							as_range_fn fn, void* udata);
+
 /**
  *	@private
  *	Destroy thread pool.
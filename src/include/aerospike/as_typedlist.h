@@ -0,0 +1,387 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_arraylist.h>
+#include <aerospike/as_list.h>
+#include <aerospike/as_std.h>
+#include <aerospike/as_val.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * CONSTANTS
+ *****************************************************************************/
+
+/**
+ * Smallest number of values allocated once a typed list grows.
+ */
+#define AS_TYPEDLIST_MIN_CAPACITY 8
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * A list of int64_t or double values, stored unboxed in one array.
+ *
+ * An as_arraylist of numbers holds a pointer to a separately allocated
+ * as_integer or as_double per element. as_typedlist holds the numbers
+ * themselves, 8 bytes each, contiguously - as_typedlist_int64s() and
+ * as_typedlist_doubles() expose them for scans.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_typedlist list;
+ * as_typedlist_init(&list, AS_INTEGER, 100);
+ * as_list_append_int64((as_list *) &list, 1);
+ * as_list_append_int64((as_list *) &list, 2);
+ * int64_t v = as_list_get_int64((as_list *) &list, 1);
+ * as_typedlist_destroy(&list);
+ * ~~~~~~~~~~
+ *
+ * The `as_typedlist` is a subtype of `as_list`, and the typed as_list
+ * accessors - as_list_get_int64(), as_list_append_double() and so on - work
+ * on the values directly. The generic ones take and return as_val:
+ * - Values passed in must be of the list's type. They are unboxed, and the
+ *   list takes ownership as with as_arraylist.
+ * - A value returned by as_list_get(), as_list_foreach() or an iterator is
+ *   boxed on first use and kept until that element changes or the list is
+ *   destroyed. Concurrent readers of an unchanging list get the same box.
+ *
+ * Values of the wrong type, strings and nil are refused with
+ * AS_ARRAYLIST_ERR_TYPE. as_pack_val() packs the values directly, without
+ * boxing them.
+ *
+ * @extends as_list
+ * @ingroup aerospike_t
+ */
+typedef struct as_typedlist_s {
+
+	/**
+	 * @private
+	 * as_typedlist is an as_list.
+	 * You can cast as_typedlist to as_list.
+	 */
+	as_list _;
+
+	/**
+	 * Type of the values, AS_INTEGER or AS_DOUBLE.
+	 */
+	as_val_t type;
+
+	/**
+	 * The number of values allocated.
+	 */
+	uint32_t capacity;
+
+	/**
+	 * The number of values used.
+	 */
+	uint32_t size;
+
+	/**
+	 * @private
+	 * Content hash, valid once hash_valid is set.
+	 */
+	uint32_t hash;
+
+	/**
+	 * The values, int64_t or double according to type.
+	 */
+	void* values;
+
+	/**
+	 * @private
+	 * Boxed values handed out by generic accessors, capacity long. NULL until
+	 * the first is needed.
+	 */
+	as_val** boxed;
+
+	/**
+	 * @private
+	 * If true, then as_typedlist.hash is up to date.
+	 */
+	bool hash_valid;
+
+} as_typedlist;
+
+/*******************************************************************************
+ * INSTANCE FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * Initialize a stack allocated as_typedlist.
+ *
+ * @param list 		The list to initialize.
+ * @param type			AS_INTEGER or AS_DOUBLE.
+ * @param capacity		The number of values to allocate to the list.
+ *
+ * @return On success, the initialized list. Otherwise NULL.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN as_typedlist*
+as_typedlist_init(as_typedlist* list, as_val_t type, uint32_t capacity);
+
+/**
+ * Create and initialize a heap allocated as_typedlist.
+ *
+ * @param type			AS_INTEGER or AS_DOUBLE.
+ * @param capacity		The number of values to allocate to the list.
+ *
+ * @return On success, the new list. Otherwise NULL.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN as_typedlist*
+as_typedlist_new(as_val_t type, uint32_t capacity);
+
+/**
+ * Destroy the list and release resources.
+ *
+ * @param list	The list to destroy.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN void
+as_typedlist_destroy(as_typedlist* list);
+
+/**
+ * Make room for at least capacity values.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN int
+as_typedlist_reserve(as_typedlist* list, uint32_t capacity);
+
+/**
+ * The values of an AS_INTEGER list, NULL for an AS_DOUBLE list.
+ *
+ * @relatesalso as_typedlist
+ */
+static inline int64_t*
+as_typedlist_int64s(const as_typedlist* list)
+{
+	return list->type == AS_INTEGER ? (int64_t*)list->values : NULL;
+}
+
+/**
+ * The values of an AS_DOUBLE list, NULL for an AS_INTEGER list.
+ *
+ * @relatesalso as_typedlist
+ */
+static inline double*
+as_typedlist_doubles(const as_typedlist* list)
+{
+	return list->type == AS_DOUBLE ? (double*)list->values : NULL;
+}
+
+/*******************************************************************************
+ * VALUE FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * The hash value of the list. Equal to the hash of an as_arraylist holding
+ * the same numbers.
+ *
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN uint32_t
+as_typedlist_hashcode(const as_typedlist* list);
+
+/**
+ * The number of values in the list.
+ *
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN uint32_t
+as_typedlist_size(const as_typedlist* list);
+
+/*******************************************************************************
+ * ACCESSOR AND MODIFIER FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * Get the value at index, boxed. The box belongs to the list.
+ *
+ * @return The value. NULL if index is out of range or boxing failed.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN as_val*
+as_typedlist_get(const as_typedlist* list, uint32_t index);
+
+/**
+ * Get the value at index of an AS_INTEGER list.
+ *
+ * @return The value. 0 if index is out of range or it is an AS_DOUBLE list.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN int64_t
+as_typedlist_get_int64(const as_typedlist* list, uint32_t index);
+
+/**
+ * Get the value at index of an AS_DOUBLE list.
+ *
+ * @return The value. 0.0 if index is out of range or it is an AS_INTEGER
+ * list.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN double
+as_typedlist_get_double(const as_typedlist* list, uint32_t index);
+
+/**
+ * Set the value at index from an as_integer or as_double of the list's type,
+ * and destroy it. An index of size appends.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred, and the
+ * value is not consumed.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN int
+as_typedlist_set(as_typedlist* list, uint32_t index, as_val* value);
+
+/**
+ * Set the value at index of an AS_INTEGER list. An index of size appends.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN int
+as_typedlist_set_int64(as_typedlist* list, uint32_t index, int64_t value);
+
+/**
+ * Set the value at index of an AS_DOUBLE list. An index of size appends.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN int
+as_typedlist_set_double(as_typedlist* list, uint32_t index, double value);
+
+/**
+ * Insert a value at index, from an as_integer or as_double of the list's
+ * type, and destroy it.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred, and the
+ * value is not consumed.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN int
+as_typedlist_insert(as_typedlist* list, uint32_t index, as_val* value);
+
+/**
+ * Insert a value at index of an AS_INTEGER list.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN int
+as_typedlist_insert_int64(as_typedlist* list, uint32_t index, int64_t value);
+
+/**
+ * Insert a value at index of an AS_DOUBLE list.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN int
+as_typedlist_insert_double(as_typedlist* list, uint32_t index, double value);
+
+/**
+ * Append a value, from an as_integer or as_double of the list's type, and
+ * destroy it.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred, and the
+ * value is not consumed.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN int
+as_typedlist_append(as_typedlist* list, as_val* value);
+
+/**
+ * Append a value to an AS_INTEGER list.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN int
+as_typedlist_append_int64(as_typedlist* list, int64_t value);
+
+/**
+ * Append a value to an AS_DOUBLE list.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN int
+as_typedlist_append_double(as_typedlist* list, double value);
+
+/**
+ * Remove the value at index.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN int
+as_typedlist_remove(as_typedlist* list, uint32_t index);
+
+/**
+ * Append all elements of list2, which must all be of the list's type. A
+ * typed list of the same type is copied in one go.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred, and the
+ * list is unchanged.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN int
+as_typedlist_concat(as_typedlist* list, const as_list* list2);
+
+/**
+ * Delete all values at and beyond index. Capacity is not reduced.
+ *
+ * @return AS_ARRAYLIST_OK on success. Otherwise an error occurred.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN int
+as_typedlist_trim(as_typedlist* list, uint32_t index);
+
+/**
+ * Return a new typed list of count values starting at index, clamped to the
+ * list.
+ *
+ * @return The new list. NULL on failure.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN as_typedlist*
+as_typedlist_range(const as_typedlist* list, uint32_t index, uint32_t count);
+
+/******************************************************************************
+ * ITERATION FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Call the callback function for each element, boxed, in the list.
+ *
+ * @return true if iteration completes fully. false if iteration was aborted.
+ * @relatesalso as_typedlist
+ */
+AS_EXTERN bool
+as_typedlist_foreach(const as_typedlist* list, as_list_foreach_callback callback, void* udata);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
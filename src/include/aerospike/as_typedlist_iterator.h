@@ -0,0 +1,124 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_typedlist.h>
+#include <aerospike/as_iterator.h>
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ *	TYPES
+ ******************************************************************************/
+
+/**
+ *	Iterator for as_typedlist.
+ *
+ *	Works like as_arraylist_iterator. Values are returned as the boxed
+ *	elements cached by as_typedlist_get(), and remain owned by the list.
+ *
+ *	@extends as_iterator
+ */
+typedef struct as_typedlist_iterator_s {
+
+	/**
+	 *	as_typedlist_iterator is an as_iterator.
+	 *	You can cast as_typedlist_iterator to as_iterator.
+	 */
+	as_iterator _;
+
+	/**
+	 *	The as_typedlist being iterated over
+	 */
+	const as_typedlist * list;
+
+	/**
+	 *	The current position of the iteration
+	 */
+	uint32_t pos;
+
+} as_typedlist_iterator;
+
+/******************************************************************************
+ *	FUNCTIONS
+ *****************************************************************************/
+
+/**
+ *	Initializes a stack allocated as_iterator for as_typedlist.
+ *
+ *	@param iterator 	The iterator to initialize.
+ *	@param list 		The list to iterate.
+ *
+ *	@return On success, the initialized iterator. Otherwise NULL.
+ *
+ *	@relatesalso as_typedlist_iterator
+ */
+AS_EXTERN as_typedlist_iterator * as_typedlist_iterator_init(as_typedlist_iterator * iterator, const as_typedlist * list);
+
+/**
+ *	Creates a new heap allocated as_iterator for as_typedlist.
+ *
+ *	@param list 		The list to iterate.
+ *
+ *	@return On success, the new iterator. Otherwise NULL.
+ *
+ *	@relatesalso as_typedlist_iterator
+ */
+AS_EXTERN as_typedlist_iterator * as_typedlist_iterator_new(const as_typedlist * list);
+
+/**
+ *	Destroy the iterator and releases resources used by the iterator.
+ *
+ *	@param iterator 	The iterator to release
+ *
+ *	@relatesalso as_typedlist_iterator
+ */
+AS_EXTERN void as_typedlist_iterator_destroy(as_typedlist_iterator * iterator);
+
+/******************************************************************************
+ *	ITERATOR FUNCTIONS
+ *****************************************************************************/
+
+/**
+ *	Tests if there are more values available in the iterator.
+ *
+ *	@param iterator 	The iterator to be tested.
+ *
+ *	@return true if there are more values. Otherwise false.
+ *
+ *	@relatesalso as_typedlist_iterator
+ */
+AS_EXTERN bool as_typedlist_iterator_has_next(const as_typedlist_iterator * iterator);
+
+/**
+ *	Attempts to get the next value from the iterator.
+ *	This will return the next value, and iterate past the value.
+ *
+ *	@param iterator 	The iterator to get the next value from.
+ *
+ *	@return The next value in the list if available. Otherwise NULL.
+ *
+ *	@relatesalso as_typedlist_iterator
+ */
+AS_EXTERN const as_val * as_typedlist_iterator_next(as_typedlist_iterator * iterator);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
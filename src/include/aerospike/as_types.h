@@ -33,9 +33,15 @@
 #include <aerospike/as_list.h>
 #include <aerospike/as_arraylist.h>
 #include <aerospike/as_arraylist_iterator.h>
+#include <aerospike/as_typedlist.h>
+#include <aerospike/as_typedlist_iterator.h>
 
 #include <aerospike/as_map.h>
 #include <aerospike/as_hashmap.h>
 #include <aerospike/as_hashmap_iterator.h>
+#include <aerospike/as_openmap.h>
+#include <aerospike/as_openmap_iterator.h>
+#include <aerospike/as_orderedmap.h>
+#include <aerospike/as_orderedmap_iterator.h>
 
 #include <aerospike/as_result.h>
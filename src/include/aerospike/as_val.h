@@ -94,7 +94,9 @@ typedef struct as_val_s {
 #define as_val_type(__v) (__v ? (as_val_type_e)((as_val *)__v)->type : AS_UNDEF)
 
 /**
- *	Increment the `as_val.count` of a value.
+ *	Increment the `as_val.count` of a value. Values with a zero count, like
+ *	values unpacked into an as_arena, aren't reference counted and are left
+ *	as they are.
  *	
  *	@param __v	The `as_val` to be incremented.
  *
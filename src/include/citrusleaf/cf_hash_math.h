@@ -22,6 +22,8 @@
 //
 
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
 //==========================================================
 // Public API.
@@ -107,3 +109,82 @@ cf_hash_ptr32(const void* p_ptr)
 {
 	return (uint32_t)((*(const uint64_t*)p_ptr * 0xe221f97c30e94e1dULL) >> 32);
 }
+
+
+// 32-bit finalizer from MurmurHash3 - every input bit affects every output bit.
+static inline uint32_t
+cf_hash_mix32(uint32_t hash)
+{
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35;
+	hash ^= hash >> 16;
+
+	return hash;
+}
+
+
+// 64-bit finalizer from MurmurHash3, folded to 32 bits. Use for integer keys.
+static inline uint32_t
+cf_hash_mix64(uint64_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+
+	return (uint32_t)(hash ^ (hash >> 32));
+}
+
+
+// 64-bit MurmurHash64A - consumes 8 bytes per step. Values depend on host
+// byte order, so don't persist them.
+static inline uint64_t
+cf_hash_murmur64(const uint8_t* buf, size_t size)
+{
+	const uint64_t m = 0xc6a4a7935bd1e995ULL;
+	uint64_t hash = 0x8445d61a4e774912ULL ^ (size * m);
+	const uint8_t* end = buf + (size & ~(size_t)7);
+
+	while (buf < end) {
+		uint64_t k;
+
+		memcpy(&k, buf, 8);
+		buf += 8;
+
+		k *= m;
+		k ^= k >> 47;
+		k *= m;
+
+		hash ^= k;
+		hash *= m;
+	}
+
+	size &= 7;
+
+	if (size != 0) {
+		uint64_t k = 0;
+
+		memcpy(&k, buf, size);
+		hash ^= k;
+		hash *= m;
+	}
+
+	hash ^= hash >> 47;
+	hash *= m;
+	hash ^= hash >> 47;
+
+	return hash;
+}
+
+
+// 32-bit word-at-a-time hash - cf_hash_murmur64() folded to 32 bits.
+static inline uint32_t
+cf_hash_murmur32(const uint8_t* buf, size_t size)
+{
+	uint64_t hash = cf_hash_murmur64(buf, size);
+
+	return (uint32_t)(hash ^ (hash >> 32));
+}
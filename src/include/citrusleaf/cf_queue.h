@@ -35,6 +35,7 @@ extern "C" {
 #define CF_QUEUE_ERR -1
 #define CF_QUEUE_EMPTY -2
 #define CF_QUEUE_NOMATCH -3 // used in reduce_pop methods
+#define CF_QUEUE_FULL -4 // used by bounded queues
 
 // mswait < 0 wait forever
 // mswait == 0 wait not at all
@@ -88,6 +89,12 @@ int cf_queue_sz(cf_queue *q);
  */
 int cf_queue_push(cf_queue *q, const void *ptr);
 
+/**
+ * Push n contiguous elements to the tail of the queue, under one lock
+ * acquisition and with one wake-up.
+ */
+int cf_queue_push_n(cf_queue *q, const void *ptr, uint32_t n);
+
 /**
  * Push element on the queue only if size < limit.
  */
@@ -108,6 +115,13 @@ int cf_queue_push_head(cf_queue *q, const void *ptr);
  */
 int cf_queue_pop(cf_queue *q, void *buf, int ms_wait);
 
+/**
+ * Pop up to n elements from the head of the queue into buf, under one lock
+ * acquisition. Waits for the first element as cf_queue_pop() does. Returns the
+ * number of elements popped, or CF_QUEUE_EMPTY.
+ */
+int cf_queue_pop_n(cf_queue *q, void *buf, uint32_t n, int ms_wait);
+
 /**
  * Run the entire queue, calling the callback, with the lock held.
  *
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+/*
+ * A bounded lock-free queue for any number of producer and consumer threads,
+ * holding elements of a fixed size like cf_queue.
+ *
+ * Push and pop never take a lock. Each cell carries a sequence number saying
+ * whether it is ready to be pushed to or popped from in the current lap, so
+ * producers and consumers only contend on their own position counter. A pop
+ * that has to wait parks the thread - on a futex on Linux - and a push only
+ * makes a wake up call when some thread is parked.
+ */
+#include <aerospike/as_std.h>
+#include <citrusleaf/cf_queue.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+#define CF_QUEUE_MPMC_CACHE_LINE 64
+
+/******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+/**
+ * cf_queue_mpmc
+ */
+typedef struct cf_queue_mpmc_s {
+	/**
+	 * Private data - please use API. The positions and the parking state
+	 * each get a cache line of their own.
+	 */
+	uint32_t        push_pos;       // position of the next push
+	uint8_t         pad1[CF_QUEUE_MPMC_CACHE_LINE - sizeof(uint32_t)];
+	uint32_t        pop_pos;        // position of the next pop
+	uint8_t         pad2[CF_QUEUE_MPMC_CACHE_LINE - sizeof(uint32_t)];
+	uint32_t        waiters;        // number of threads parked in pop
+	uint32_t        wakeups;        // bumped by every wake up, parked on
+	uint8_t         pad3[CF_QUEUE_MPMC_CACHE_LINE - 2 * sizeof(uint32_t)];
+	uint8_t *       cells;          // sequence numbers and elements
+	uint32_t        mask;           // number of cells - 1
+	uint32_t        cell_sz;        // number of bytes in a cell
+	size_t          element_sz;     // number of bytes in an element
+	bool            free_struct;    // free struct cf_queue_mpmc in addition to cells
+#if !defined(__linux__)
+	pthread_mutex_t LOCK;           // parking lock
+	pthread_cond_t  CV;             // parking condvar
+#endif
+} cf_queue_mpmc;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * Initialize a queue of at least capacity elements. Capacity is rounded up to
+ * a power of 2.
+ */
+bool cf_queue_mpmc_init(cf_queue_mpmc *q, size_t element_sz, uint32_t capacity);
+
+cf_queue_mpmc *cf_queue_mpmc_create(size_t element_sz, uint32_t capacity);
+
+void cf_queue_mpmc_destroy(cf_queue_mpmc *q);
+
+/**
+ * Get the number of elements the queue can hold.
+ */
+static inline uint32_t
+cf_queue_mpmc_capacity(const cf_queue_mpmc *q)
+{
+	return q->mask + 1;
+}
+
+/**
+ * Get the number of elements currently in the queue. Only a snapshot while
+ * other threads push and pop.
+ */
+int cf_queue_mpmc_sz(cf_queue_mpmc *q);
+
+/**
+ * Push to the tail of the queue. Returns CF_QUEUE_FULL if there is no room.
+ * A pop preempted part way through holds on to its cell, so a push a lap
+ * later may see CF_QUEUE_FULL even though the queue is not full.
+ */
+int cf_queue_mpmc_push(cf_queue_mpmc *q, const void *ptr);
+
+/**
+ * Pops from the head of the queue, waiting as cf_queue_pop() does.
+ */
+int cf_queue_mpmc_pop(cf_queue_mpmc *q, void *buf, int ms_wait);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_arena.h>
+#include <citrusleaf/alloc.h>
+
+/******************************************************************************
+ *	STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline uint8_t *
+as_arena_chunk_data(as_arena_chunk *chunk)
+{
+	return (uint8_t *)(chunk + 1);
+}
+
+static void
+as_arena_free_chunks(as_arena_chunk *chunk)
+{
+	while (chunk) {
+		as_arena_chunk *next = chunk->next;
+		cf_free(chunk);
+		chunk = next;
+	}
+}
+
+/******************************************************************************
+ *	FUNCTIONS
+ *****************************************************************************/
+
+as_arena *
+as_arena_init(as_arena *arena, uint32_t chunk_size)
+{
+	arena->head = NULL;
+	arena->pos = NULL;
+	arena->end = NULL;
+	arena->chunk_size = chunk_size != 0 ? chunk_size : AS_ARENA_CHUNK_SIZE;
+	arena->free = false;
+	return arena;
+}
+
+as_arena *
+as_arena_new(uint32_t chunk_size)
+{
+	as_arena *arena = cf_malloc(sizeof(as_arena));
+
+	if (! arena) {
+		return NULL;
+	}
+
+	as_arena_init(arena, chunk_size);
+	arena->free = true;
+	return arena;
+}
+
+void
+as_arena_reset(as_arena *arena)
+{
+	if (! arena->head) {
+		return;
+	}
+
+	as_arena_free_chunks(arena->head->next);
+	arena->head->next = NULL;
+	arena->pos = as_arena_chunk_data(arena->head);
+	arena->end = arena->pos + arena->head->size;
+}
+
+void
+as_arena_destroy(as_arena *arena)
+{
+	as_arena_free_chunks(arena->head);
+	arena->head = NULL;
+	arena->pos = NULL;
+	arena->end = NULL;
+
+	if (arena->free) {
+		cf_free(arena);
+	}
+}
+
+void *
+as_arena_alloc_chunk(as_arena *arena, size_t size)
+{
+	// Allocations that would waste more than a quarter of a chunk get a chunk
+	// of their own, leaving the current chunk to serve smaller requests.
+	bool dedicated = size > arena->chunk_size / 4;
+	size_t chunk_size = dedicated ? size : arena->chunk_size;
+	as_arena_chunk *chunk = cf_malloc(sizeof(as_arena_chunk) + chunk_size);
+
+	if (! chunk) {
+		return NULL;
+	}
+
+	chunk->size = chunk_size;
+
+	uint8_t *p = as_arena_chunk_data(chunk);
+
+	if (dedicated && arena->head) {
+		chunk->next = arena->head->next;
+		arena->head->next = chunk;
+		return p;
+	}
+
+	chunk->next = arena->head;
+	arena->head = chunk;
+	arena->pos = p + size;
+	arena->end = p + chunk_size;
+	return p;
+}
@@ -16,9 +16,11 @@
  */
 #include <aerospike/as_arraylist.h>
 #include <aerospike/as_arraylist_iterator.h>
+#include <aerospike/as_atomic.h>
 #include <aerospike/as_list.h>
 #include <aerospike/as_nil.h>
 #include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_hash_math.h>
 #include <string.h>
 
 /*******************************************************************************
@@ -27,6 +29,42 @@
 
 extern const as_list_hooks as_arraylist_list_hooks;
 
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+/*
+ * Element storage shared by a list and its slices. Holds one reference to
+ * each of its size elements, and is freed with the last list using it.
+ */
+typedef struct as_arraylist_shared_s {
+	uint32_t ref_count;
+	uint32_t size;
+	uint32_t capacity;
+	as_val** elements;
+} as_arraylist_shared;
+
+/*******************************************************************************
+ * STATIC FUNCTIONS
+ ******************************************************************************/
+
+static void
+as_arraylist_shared_release(as_arraylist_shared* shared)
+{
+	if (as_aaf_uint32(&shared->ref_count, -1) != 0) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < shared->size; i++) {
+		if (shared->elements[i]) {
+			as_val_destroy(shared->elements[i]);
+		}
+	}
+
+	cf_free(shared->elements);
+	cf_free(shared);
+}
+
 /*******************************************************************************
  * INSTANCE FUNCTIONS
  ******************************************************************************/
@@ -40,6 +78,10 @@ as_arraylist_init(as_arraylist* list, uint32_t capacity, uint32_t block_size)
 	list->block_size = block_size;
 	list->capacity = capacity;
 	list->size = 0;
+	list->hash = 0;
+	list->hash_valid = false;
+	list->growth = AS_ARRAYLIST_GROW_HYBRID;
+	list->shared = NULL;
 	if (list->capacity > 0) {
 		list->free = true;
 		list->elements = (as_val**) cf_calloc(capacity, sizeof(as_val*));
@@ -61,6 +103,10 @@ as_arraylist_new(uint32_t capacity, uint32_t block_size)
 	list->block_size = block_size;
 	list->capacity = capacity;
 	list->size = 0;
+	list->hash = 0;
+	list->hash_valid = false;
+	list->growth = AS_ARRAYLIST_GROW_HYBRID;
+	list->shared = NULL;
 	if (list->capacity > 0) {
 		list->free = true;
 		list->elements = (as_val**) cf_calloc(capacity, sizeof(as_val*));
@@ -75,7 +121,11 @@ as_arraylist_new(uint32_t capacity, uint32_t block_size)
 bool
 as_arraylist_release(as_arraylist* list)
 {
-	if (list->elements) {
+	if (list->shared) {
+		as_arraylist_shared_release(list->shared);
+		list->shared = NULL;
+	}
+	else if (list->elements) {
 		for (uint32_t i = 0; i < list->size; i++) {
 			if (list->elements[i]) {
 				as_val_destroy(list->elements[i]);
@@ -91,6 +141,8 @@ as_arraylist_release(as_arraylist* list)
 	list->elements = NULL;
 	list->size = 0;
 	list->capacity = 0;
+	list->hash = 0;
+	list->hash_valid = false;
 
 	return true;
 }
@@ -101,52 +153,281 @@ as_arraylist_destroy(as_arraylist* l)
 	as_list_destroy((as_list *) l);
 }
 
+void
+as_arraylist_set_growth(as_arraylist* list, as_arraylist_growth growth)
+{
+	list->growth = (uint8_t)growth;
+}
+
 /*******************************************************************************
  * STATIC FUNCTIONS
  ******************************************************************************/
 
+static int
+as_arraylist_resize(as_arraylist* list, uint32_t capacity)
+{
+	if (capacity == 0) {
+		if (list->free) {
+			cf_free(list->elements);
+		}
+		list->elements = NULL;
+		list->capacity = 0;
+		list->free = false;
+		return AS_ARRAYLIST_OK;
+	}
+
+	size_t new_bytes = sizeof(as_val*) * capacity;
+	as_val** elements;
+
+	if (list->free) {
+		elements = (as_val**) cf_realloc(list->elements, new_bytes);
+	}
+	else {
+		// Storage we don't own (e.g. on the stack) is copied, not moved.
+		elements = (as_val**) cf_malloc(new_bytes);
+		if (elements && list->size > 0) {
+			memcpy(elements, list->elements, sizeof(as_val*) * list->size);
+		}
+	}
+
+	if (! elements) {
+		return AS_ARRAYLIST_ERR_ALLOC;
+	}
+
+	// Zero everything beyond the used pointers.
+	if (capacity > list->size) {
+		memset(elements + list->size, 0,
+				sizeof(as_val*) * (capacity - list->size));
+	}
+
+	list->elements = elements;
+	list->capacity = capacity;
+	list->free = true;
+	return AS_ARRAYLIST_OK;
+}
+
+// Give a list that shares its storage elements of its own, before it is
+// modified.
+static int
+as_arraylist_unshare(as_arraylist* list)
+{
+	as_arraylist_shared* shared = list->shared;
+
+	if (! shared) {
+		return AS_ARRAYLIST_OK;
+	}
+
+	if (as_load_uint32(&shared->ref_count) == 1) {
+		// No slices left - take the storage over rather than copying it.
+		uint32_t offset = (uint32_t)(list->elements - shared->elements);
+
+		for (uint32_t i = 0; i < shared->size; i++) {
+			if ((i < offset || i >= offset + list->size) && shared->elements[i]) {
+				as_val_destroy(shared->elements[i]);
+			}
+		}
+
+		memmove(shared->elements, list->elements, sizeof(as_val*) * list->size);
+		memset(shared->elements + list->size, 0,
+				sizeof(as_val*) * (shared->capacity - list->size));
+
+		list->elements = shared->elements;
+		list->capacity = shared->capacity;
+		list->free = true;
+		list->shared = NULL;
+		cf_free(shared);
+		return AS_ARRAYLIST_OK;
+	}
+
+	as_val** elements = NULL;
+
+	if (list->capacity > 0) {
+		elements = (as_val**) cf_calloc(list->capacity, sizeof(as_val*));
+
+		if (! elements) {
+			return AS_ARRAYLIST_ERR_ALLOC;
+		}
+
+		for (uint32_t i = 0; i < list->size; i++) {
+			elements[i] = list->elements[i];
+
+			if (elements[i]) {
+				as_val_reserve(elements[i]);
+			}
+		}
+	}
+
+	list->elements = elements;
+	list->free = elements != NULL;
+	list->shared = NULL;
+	as_arraylist_shared_release(shared);
+	return AS_ARRAYLIST_OK;
+}
+
+// Move the list's elements to shared storage. Only storage the list owns can
+// be shared. Once set, list->shared owns the storage and list->free is
+// ignored.
+//
+// Concurrent readers may slice the same list, so shared storage is installed
+// with a CAS and a reader that loses the race uses the winner's. This is the
+// only write made on behalf of a const list, and it leaves the content as is.
+static as_arraylist_shared*
+as_arraylist_share(const as_arraylist* list)
+{
+	as_arraylist_shared* shared = as_load_ptr(&list->shared);
+
+	if (shared) {
+		return shared;
+	}
+
+	if (! list->free || ! list->elements) {
+		return NULL;
+	}
+
+	shared = (as_arraylist_shared*)cf_malloc(sizeof(as_arraylist_shared));
+
+	if (! shared) {
+		return NULL;
+	}
+
+	shared->ref_count = 1;
+	shared->size = list->size;
+	shared->capacity = list->capacity;
+	shared->elements = list->elements;
+
+	if (! as_cas_ptr((void**)&list->shared, NULL, shared)) {
+		cf_free(shared);
+		shared = as_load_ptr(&list->shared);
+	}
+
+	return shared;
+}
+
 static int
 as_arraylist_ensure(as_arraylist* list, uint32_t delta)
 {
 	// Check for capacity (in terms of elements, NOT size in bytes), and if we
 	// need to allocate more, do a realloc.
-	if ((list->size + delta) > list->capacity) {
+	uint64_t needed = (uint64_t)list->size + delta;
+
+	if (needed > list->capacity) {
 		// by convention - we allocate more space ONLY when the unit of
 		// (new) allocation is > 0.
 		if (list->block_size == 0) {
 			return AS_ARRAYLIST_ERR_MAX;
 		}
 		// Compute how much room we're missing for the new stuff
-		int new_room = (list->size + delta) - list->capacity;
+		uint64_t new_room = needed - list->capacity;
 		// Compute new capacity in terms of multiples of block_size
 		// This will get us (conservatively) at least one block
-		int new_blocks = (new_room + list->block_size) / list->block_size;
-		int new_capacity = list->capacity + (new_blocks * list->block_size);
-		size_t new_bytes = sizeof(as_val*) * new_capacity;
-		as_val** elements = (as_val**) cf_realloc(list->elements, new_bytes);
-		if (! elements) {
-			return AS_ARRAYLIST_ERR_ALLOC;
+		uint64_t new_blocks = (new_room + list->block_size) / list->block_size;
+		uint64_t new_capacity = list->capacity + (new_blocks * list->block_size);
+
+		// Past the threshold, grow in proportion to the list so appends stay
+		// amortized O(1).
+		if (list->growth == AS_ARRAYLIST_GROW_GEOMETRIC ||
+				(list->growth == AS_ARRAYLIST_GROW_HYBRID &&
+				 list->capacity >= AS_ARRAYLIST_GROW_THRESHOLD)) {
+			uint64_t doubled = (uint64_t)list->capacity * 2;
+			if (new_capacity < doubled) {
+				new_capacity = doubled;
+			}
 		}
-		// Zero everything beyond the old pointers.
-		size_t old_bytes = sizeof(as_val*) * list->capacity;
-		memset((uint8_t *)elements + old_bytes, 0, new_bytes - old_bytes);
-		// Set the new array pointer and capacity.
-		list->elements = elements;
-		list->capacity = new_capacity;
-		list->free = true;
+
+		if (new_capacity > UINT32_MAX) {
+			if (needed > UINT32_MAX) {
+				return AS_ARRAYLIST_ERR_MAX;
+			}
+			new_capacity = UINT32_MAX;
+		}
+
+		return as_arraylist_resize(list, (uint32_t)new_capacity);
 	}
 
 	return AS_ARRAYLIST_OK;
 }
 
+// The content hash is the sum of element hash * HASH_MULT^index. Any single
+// element can be updated in O(log index), anything that shifts elements
+// invalidates it. Lists and maps can change in place without the list
+// knowing, so the hash is only cached while no element is one.
+#define HASH_MULT 0x01000193
+
+static inline uint32_t
+hash_element(const as_val* v)
+{
+	return v ? as_val_hashcode(v) : 0;
+}
+
+static inline bool
+hash_cacheable(const as_val* v)
+{
+	as_val_t type = as_val_type(v);
+
+	return type != AS_LIST && type != AS_MAP;
+}
+
+static uint32_t
+hash_pow(uint32_t index)
+{
+	uint32_t result = 1;
+	uint32_t base = HASH_MULT;
+
+	while (index != 0) {
+		if (index & 1) {
+			result *= base;
+		}
+
+		base *= base;
+		index >>= 1;
+	}
+
+	return result;
+}
+
+// Replace the element hash at index, which may be the end of the list.
+static inline void
+hash_update(as_arraylist* list, uint32_t index, const as_val* old, const as_val* value)
+{
+	if (! hash_cacheable(value)) {
+		list->hash_valid = false;
+	}
+	else if (list->hash_valid) {
+		list->hash += (hash_element(value) - hash_element(old)) * hash_pow(index);
+	}
+}
+
 /*******************************************************************************
  * INFO FUNCTIONS
  ******************************************************************************/
 
+// Readers may share the list, so the hash is published with hash_valid set
+// last. Readers that race store the same hash.
 uint32_t
 as_arraylist_hashcode(const as_arraylist* list)
 {
-	return 0;
+	if (as_load_uint8((const uint8_t*)&list->hash_valid)) {
+		as_fence_lock();
+		return cf_hash_mix32(as_load_uint32(&list->hash) + list->size);
+	}
+
+	uint32_t hash = 0;
+	uint32_t mult = 1;
+	bool cacheable = true;
+
+	for (uint32_t i = 0; i < list->size; i++) {
+		hash += hash_element(list->elements[i]) * mult;
+		mult *= HASH_MULT;
+		cacheable = cacheable && hash_cacheable(list->elements[i]);
+	}
+
+	if (cacheable) {
+		as_store_uint32((uint32_t*)&list->hash, hash);
+		as_fence_store();
+		as_store_uint8((uint8_t*)&list->hash_valid, true);
+	}
+
+	return cf_hash_mix32(hash + list->size);
 }
 
 uint32_t
@@ -190,7 +471,11 @@ as_arraylist_get_str(const as_arraylist* list, uint32_t index)
 int
 as_arraylist_set(as_arraylist* list, uint32_t index, as_val* value)
 {
-	int rc = AS_ARRAYLIST_OK;
+	int rc = as_arraylist_unshare(list);
+
+	if (rc != AS_ARRAYLIST_OK) {
+		return rc;
+	}
 
 	if (index >= list->capacity) {
 		rc = as_arraylist_ensure(list, (index + 1) - list->size);
@@ -200,13 +485,22 @@ as_arraylist_set(as_arraylist* list, uint32_t index, as_val* value)
 		}
 	}
 
+	value = value ? value : (as_val*)&as_nil;
+
 	// Make sure that, before we free (destroy) something, it is within the
 	// legal bounds of the object.
 	if (index < list->size) {
+		hash_update(list, index, list->elements[index], value);
 		as_val_destroy(list->elements[index]);
 	}
+	else if (index == list->size) {
+		hash_update(list, index, NULL, value);
+	}
+	else {
+		list->hash_valid = false;
+	}
 
-	list->elements[index] = value ? value : (as_val*)&as_nil;
+	list->elements[index] = value;
 
 	if (index == list->size) {
 		list->size++;
@@ -225,7 +519,7 @@ as_arraylist_set(as_arraylist* list, uint32_t index, as_val* value)
 int
 as_arraylist_set_int64(as_arraylist* list, uint32_t index, int64_t value)
 {
-	return as_arraylist_set(list, index, (as_val*) as_integer_new(value));
+	return as_arraylist_set(list, index, (as_val*) as_integer_new_shared(value));
 }
 
 int
@@ -253,17 +547,30 @@ as_arraylist_insert(as_arraylist* list, uint32_t index, as_val* value)
 		delta = index + 1 - list->size;
 	}
 
-	int rc = as_arraylist_ensure(list, delta);
+	int rc = as_arraylist_unshare(list);
+
+	if (rc == AS_ARRAYLIST_OK) {
+		rc = as_arraylist_ensure(list, delta);
+	}
 
 	if (rc != AS_ARRAYLIST_OK) {
 		return rc;
 	}
 
+	value = value ? value : (as_val*)&as_nil;
+
+	if (index == list->size) {
+		hash_update(list, index, NULL, value);
+	}
+	else {
+		list->hash_valid = false;
+	}
+
 	for (uint32_t i = list->size; i > index; i--) {
 		list->elements[i] = list->elements[i - 1];
 	}
 
-	list->elements[index] = value ? value : (as_val*)&as_nil;
+	list->elements[index] = value;
 
 	if (index <= list->size) {
 		list->size++;
@@ -282,7 +589,7 @@ as_arraylist_insert(as_arraylist* list, uint32_t index, as_val* value)
 int
 as_arraylist_insert_int64(as_arraylist* list, uint32_t index, int64_t value)
 {
-	return as_arraylist_insert(list, index, (as_val*) as_integer_new(value));
+	return as_arraylist_insert(list, index, (as_val*) as_integer_new_shared(value));
 }
 
 int
@@ -310,7 +617,7 @@ as_arraylist_append(as_arraylist* list, as_val* value)
 int
 as_arraylist_append_int64(as_arraylist* list, int64_t value)
 {
-	return as_arraylist_append(list, (as_val*) as_integer_new(value));
+	return as_arraylist_append(list, (as_val*) as_integer_new_shared(value));
 }
 
 int
@@ -338,7 +645,7 @@ as_arraylist_prepend(as_arraylist* list, as_val* value)
 int
 as_arraylist_prepend_int64(as_arraylist* list, int64_t value)
 {
-	return as_arraylist_prepend(list, (as_val*) as_integer_new(value));
+	return as_arraylist_prepend(list, (as_val*) as_integer_new_shared(value));
 }
 
 int
@@ -364,6 +671,19 @@ as_arraylist_remove(as_arraylist* list, uint32_t index)
 		return AS_ARRAYLIST_ERR_INDEX;
 	}
 
+	int rc = as_arraylist_unshare(list);
+
+	if (rc != AS_ARRAYLIST_OK) {
+		return rc;
+	}
+
+	if (index == list->size - 1) {
+		hash_update(list, index, list->elements[index], NULL);
+	}
+	else {
+		list->hash_valid = false;
+	}
+
 	if (list->elements[index]) {
 		as_val_destroy(list->elements[index]);
 	}
@@ -385,17 +705,31 @@ as_arraylist_remove(as_arraylist* list, uint32_t index)
 int
 as_arraylist_concat(as_arraylist* list, const as_arraylist* list2)
 {
-	int rc = as_arraylist_ensure(list, list2->size);
+	int rc = as_arraylist_unshare(list);
+
+	if (rc == AS_ARRAYLIST_OK) {
+		rc = as_arraylist_ensure(list, list2->size);
+	}
 
 	if (rc != AS_ARRAYLIST_OK) {
 		return rc;
 	}
 
+	uint32_t mult = list->hash_valid ? hash_pow(list->size) : 0;
+
 	for (uint32_t i = 0; i < list2->size; i++) {
 		if (list2->elements[i]) {
 			as_val_reserve(list2->elements[i]);
 		}
 
+		if (! hash_cacheable(list2->elements[i])) {
+			list->hash_valid = false;
+		}
+		else if (list->hash_valid) {
+			list->hash += hash_element(list2->elements[i]) * mult;
+			mult *= HASH_MULT;
+		}
+
 		list->elements[list->size++] = list2->elements[i];
 	}
 
@@ -409,7 +743,20 @@ as_arraylist_trim(as_arraylist* list, uint32_t index)
 		return AS_ARRAYLIST_ERR_INDEX;
 	}
 
+	int rc = as_arraylist_unshare(list);
+
+	if (rc != AS_ARRAYLIST_OK) {
+		return rc;
+	}
+
+	uint32_t mult = list->hash_valid ? hash_pow(index) : 0;
+
 	for (uint32_t i = index; i < list->size; i++) {
+		if (list->hash_valid) {
+			list->hash -= hash_element(list->elements[i]) * mult;
+			mult *= HASH_MULT;
+		}
+
 		if (list->elements[i]) {
 			as_val_destroy(list->elements[i]);
 			list->elements[i] = NULL;
@@ -421,6 +768,32 @@ as_arraylist_trim(as_arraylist* list, uint32_t index)
 	return AS_ARRAYLIST_OK;
 }
 
+int
+as_arraylist_reserve(as_arraylist* list, uint32_t capacity)
+{
+	if (capacity <= list->capacity) {
+		return AS_ARRAYLIST_OK;
+	}
+
+	int rc = as_arraylist_unshare(list);
+
+	if (rc != AS_ARRAYLIST_OK) {
+		return rc;
+	}
+
+	return as_arraylist_resize(list, capacity);
+}
+
+int
+as_arraylist_shrink_to_fit(as_arraylist* list)
+{
+	if (list->shared || ! list->free || list->capacity == list->size) {
+		return AS_ARRAYLIST_OK;
+	}
+
+	return as_arraylist_resize(list, list->size);
+}
+
 as_val*
 as_arraylist_head(const as_arraylist* list)
 {
@@ -428,65 +801,77 @@ as_arraylist_head(const as_arraylist* list)
 }
 
 as_arraylist*
-as_arraylist_tail(const as_arraylist* list)
+as_arraylist_slice(const as_arraylist* list, uint32_t index, uint32_t count)
 {
-	if (list->size == 0) return NULL;
+	if (index > list->size) {
+		index = list->size;
+	}
 
-	as_arraylist* list2 = as_arraylist_new(list->size-1, list->block_size);
+	if (count > list->size - index) {
+		count = list->size - index;
+	}
 
-	for(uint32_t i = 1, j = 0; i < list->size; i++, j++) {
-		if (list->elements[i]) {
-			as_val_reserve(list->elements[i]);
-			list2->elements[j] = list2->elements[i];
+	as_arraylist_shared* shared = as_arraylist_share(list);
+
+	if (! shared) {
+		as_arraylist* list2 = as_arraylist_new(count, list->block_size);
+
+		if (! list2) {
+			return NULL;
 		}
-		else {
-			list2->elements[j] = 0;
+
+		for (uint32_t i = 0; i < count; i++) {
+			as_val* v = list->elements[index + i];
+
+			if (v) {
+				as_val_reserve(v);
+			}
+
+			list2->elements[i] = v;
 		}
+
+		list2->size = count;
+		return list2;
 	}
 
+	as_arraylist* list2 = (as_arraylist*) cf_malloc(sizeof(as_arraylist));
+
+	if (! list2) {
+		return NULL;
+	}
+
+	as_list_cons((as_list *) list2, true, &as_arraylist_list_hooks);
+	list2->block_size = list->block_size;
+	list2->capacity = count;
+	list2->size = count;
+	list2->hash = 0;
+	list2->hash_valid = false;
+	list2->growth = list->growth;
+	list2->elements = list->elements + index;
+	list2->free = false;
+	list2->shared = shared;
+	as_incr_uint32(&shared->ref_count);
 	return list2;
 }
 
 as_arraylist*
-as_arraylist_drop(const as_arraylist* list, uint32_t n)
+as_arraylist_tail(const as_arraylist* list)
 {
-	uint32_t		sz		= list->size;
-	uint32_t		c		= n < sz ? n : sz;
-	as_arraylist*	list2	= as_arraylist_new(sz-c, list->block_size);
-	
-	list2->size = sz-c;
-	for(uint32_t i = c, j = 0; j < list2->size; i++, j++) {
-		if (list->elements[i]) {
-			as_val_reserve(list->elements[i]);
-			list2->elements[j] = list->elements[i];
-		}
-		else {
-			list2->elements[j] = 0;
-		}
-	}
+	if (list->size == 0) return NULL;
 
-	return list2;
+	return as_arraylist_slice(list, 1, list->size - 1);
 }
 
 as_arraylist*
-as_arraylist_take(const as_arraylist* list, uint32_t n)
+as_arraylist_drop(const as_arraylist* list, uint32_t n)
 {
-	uint32_t		sz		= list->size;
-	uint32_t		c		= n < sz ? n : sz;
-	as_arraylist*	list2	= as_arraylist_new(c, list->block_size);
-
-	list2->size = c;
-	for(uint32_t i = 0; i < c; i++) {
-		if (list->elements[i]) {
-			as_val_reserve(list->elements[i]);
-			list2->elements[i] = list->elements[i];
-		}
-		else {
-			list2->elements[i] = 0;
-		}
-	}
+	return as_arraylist_slice(list, n, list->size);
+}
 
-	return list2;
+as_arraylist*
+as_arraylist_take(const as_arraylist* list, uint32_t n)
+{
+	return as_arraylist_slice(list, 0, n);
 }
 
 /*******************************************************************************
@@ -25,6 +25,7 @@
  ******************************************************************************/
 
 extern bool as_arraylist_release(as_arraylist * list);
+extern const as_list_hooks as_arraylist_list_hooks;
 
 /*******************************************************************************
  *	INSTANCE FUNCTIONS
@@ -182,9 +183,39 @@ static int _as_arraylist_list_remove(as_list * l, uint32_t i)
  *	ACCESSOR AND MODIFIER FUNCTIONS
  ******************************************************************************/
 
+static bool _as_arraylist_list_concat_foreach(as_val * v, void * udata)
+{
+	as_val_reserve(v);
+
+	if (as_arraylist_append((as_arraylist *) udata, v) != AS_ARRAYLIST_OK) {
+		as_val_destroy(v);
+		return false;
+	}
+
+	return true;
+}
+
 static int _as_arraylist_list_concat(as_list * l, const as_list * l2)
 {
-	return as_arraylist_concat((as_arraylist *) l, (const as_arraylist *) l2);
+	if (l2->hooks == &as_arraylist_list_hooks) {
+		return as_arraylist_concat((as_arraylist *) l, (const as_arraylist *) l2);
+	}
+
+	// Other list types are appended element by element.
+	as_arraylist * list = (as_arraylist *) l;
+	uint32_t size = list->size;
+	uint32_t n = as_list_size((as_list *) l2);
+
+	if (list->block_size != 0 && as_arraylist_reserve(list, size + n) != AS_ARRAYLIST_OK) {
+		return AS_ARRAYLIST_ERR_ALLOC;
+	}
+
+	if (! as_list_foreach(l2, _as_arraylist_list_concat_foreach, list)) {
+		as_arraylist_trim(list, size);
+		return AS_ARRAYLIST_ERR_MAX;
+	}
+
+	return AS_ARRAYLIST_OK;
 }
 
 static int _as_arraylist_list_trim(as_list * l, uint32_t i)
@@ -14,8 +14,10 @@
  * License for the specific language governing permissions and limitations under
  * the License.
  */
+#include <aerospike/as_atomic.h>
 #include <aerospike/as_bytes.h>
 #include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_hash_math.h>
 #include <string.h>
 
 /******************************************************************************
@@ -41,6 +43,8 @@ static inline as_bytes * as_bytes_cons(
     bytes->value = value;
     bytes->free = value_free;
     bytes->type = AS_BYTES_BLOB;
+    bytes->backing = NULL;
+    bytes->hash = 0;
 
     if ( value == NULL && size == 0 && capacity > 0 ) {
 	    bytes->value = cf_calloc(capacity, sizeof(uint8_t));
@@ -220,6 +224,7 @@ bool as_bytes_set(as_bytes * bytes, uint32_t index, const uint8_t * value, uint3
 {
     if ( index + size > bytes->capacity ) return false;
     memcpy(&bytes->value[index], value, size);
+    bytes->hash = 0;
     if ( index + size > bytes->size ) {
     	bytes->size = index + size;
     }
@@ -247,6 +252,8 @@ uint32_t as_bytes_set_var_int(const as_bytes * bytes, uint32_t index, uint32_t v
 	uint8_t* begin = bytes->value + index;
 	uint8_t* end = bytes->value + bytes->capacity;
 	uint8_t* p = begin;
+
+	((as_bytes *)bytes)->hash = 0;
 	
 	while (p < end && value >= 0x80) {
 		*p++ = (uint8_t)(value | 0x80);
@@ -313,6 +320,7 @@ bool as_bytes_truncate(as_bytes * bytes, uint32_t n)
 {
 	if ( n > bytes->size ) return false;
 	bytes->size = bytes->size - n;
+	bytes->hash = 0;
 	return true;
 }
 
@@ -363,6 +371,12 @@ bool as_bytes_ensure(as_bytes * bytes, uint32_t capacity, bool resize)
 		}
 		// copy the bytes
 		memcpy(buffer, bytes->value, bytes->size);
+
+		// a borrowed value no longer needs the region it pointed into
+		if ( bytes->backing ) {
+			cf_rc_releaseandfree(bytes->backing);
+			bytes->backing = NULL;
+		}
 	}
 
 	bytes->free = true;
@@ -382,18 +396,22 @@ void as_bytes_val_destroy(as_val * v)
     if ( b && b->free && b->value ) {
         cf_free(b->value);
     }
+
+    if ( b && b->backing ) {
+        cf_rc_releaseandfree(b->backing);
+        b->backing = NULL;
+    }
 }
 
 uint32_t as_bytes_val_hashcode(const as_val * v)
 {
     as_bytes * bytes = as_bytes_fromval(v);
     if ( bytes == NULL || bytes->value == NULL ) return 0;
-    uint32_t hash = 0;
-    uint8_t * buf = bytes->value;
-    int len = bytes->size;
-    while ( len-- ) {
-        int b = *buf++;
-        hash = b + (hash << 6) + (hash << 16) - hash;
+    // As for as_string, concurrent readers store the same hash.
+    uint32_t hash = as_load_uint32(&bytes->hash);
+    if ( hash == 0 ) {
+        hash = cf_hash_murmur32(bytes->value, bytes->size);
+        as_store_uint32(&bytes->hash, hash);
     }
     return hash;
 }
@@ -16,6 +16,7 @@
  */
 #include <aerospike/as_double.h>
 #include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_hash_math.h>
 #include <stdio.h>
 
 /******************************************************************************
@@ -71,8 +72,13 @@ as_double_val_hashcode(const as_val* val)
 		return 0;
 	}
 	
+	// 0.0 and -0.0 are equal keys, so must hash the same.
+	if (value_ptr->value == 0) {
+		return cf_hash_mix64(0);
+	}
+
 	uint64_t v = *(uint64_t*)&value_ptr->value;
-	return (uint32_t)(v ^ (v >> 32));
+	return cf_hash_mix64(v);
 }
 
 char*
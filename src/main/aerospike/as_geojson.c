@@ -16,6 +16,7 @@
  */
 #include <aerospike/as_geojson.h>
 #include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_hash_math.h>
 #include <string.h>
 
 /******************************************************************************
@@ -108,13 +109,7 @@ uint32_t as_geojson_val_hashcode(const as_val * v)
 {
 	as_geojson * string = as_geojson_fromval(v);
 	if ( string == NULL || string->value == NULL) return 0;
-	uint32_t hash = 0;
-	int c;
-	char * str = string->value;
-	while ( (c = *str++) ) {
-		hash = c + (hash << 6) + (hash << 16) - hash;
-	}
-	return hash;
+	return cf_hash_murmur32((const uint8_t *) string->value, as_geojson_len(string));
 }
 
 char * as_geojson_val_tostring(const as_val * v)
@@ -14,18 +14,22 @@
  * License for the specific language governing permissions and limitations under
  * the License.
  */
+#include <aerospike/as_atomic.h>
 #include <aerospike/as_boolean.h>
 #include <aerospike/as_bytes.h>
 #include <aerospike/as_double.h>
 #include <aerospike/as_geojson.h>
 #include <aerospike/as_hashmap.h>
 #include <aerospike/as_hashmap_iterator.h>
+#include <aerospike/as_hashmap_key.h>
 #include <aerospike/as_integer.h>
+#include <aerospike/as_list.h>
 #include <aerospike/as_map.h>
 #include <aerospike/as_nil.h>
 #include <aerospike/as_string.h>
 #include <aerospike/as_val.h>
 #include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_hash_math.h>
 #include <stddef.h>
 #include <string.h>
 
@@ -70,11 +74,15 @@ static as_hashmap * as_hashmap_cons(as_hashmap * map, uint32_t capacity)
 	map->extras = NULL;
 	map->insert_at = 1; // can't be 0 since next = 0 means end of chain
 	map->free_q = 0;
+	map->free = true;
+	map->hash_valid = false;
+	map->hash = 0;
 
 	return map;
 }
 
-static bool is_valid_key_type(const as_val * k)
+// Key helpers are shared with as_openmap and as_orderedmap.
+bool as_hashmap_key_valid(const as_val * k)
 {
 	if (! k) {
 		return false;
@@ -88,6 +96,7 @@ static bool is_valid_key_type(const as_val * k)
 	case AS_STRING:
 	case AS_BYTES:
 	case AS_GEOJSON:
+	case AS_LIST:
 		return true;
 	default:
 		return false;
@@ -96,7 +105,7 @@ static bool is_valid_key_type(const as_val * k)
 
 // TODO - should probably be an as_val "class static" method that covers all
 // types, but for now we'll locally cover only valid as_hashmap key types.
-static bool eq_val(const as_val * v1, const as_val * v2)
+bool as_hashmap_key_eq(const as_val * v1, const as_val * v2)
 {
 	if (as_val_type(v1) != as_val_type(v2)) {
 		return false;
@@ -114,24 +123,84 @@ static bool eq_val(const as_val * v1, const as_val * v2)
 	case AS_DOUBLE:
 		return as_double_get((const as_double *)v1) ==
 		as_double_get((const as_double *)v2);
-	case AS_STRING:
-		return 0 == strcmp(as_string_get((const as_string *)v1),
-				as_string_get((const as_string *)v2));
-	case AS_BYTES:
-		return as_bytes_size((const as_bytes *)v1) ==
-				as_bytes_size((const as_bytes *)v2) &&
-				0 == memcmp(as_bytes_get((const as_bytes *)v1),
-						as_bytes_get((const as_bytes *)v2),
-						as_bytes_size((const as_bytes *)v1));
+	case AS_STRING: {
+		as_string * s1 = (as_string *)v1;
+		as_string * s2 = (as_string *)v2;
+
+		// Reject on cached hashes or lengths before touching the contents.
+		uint32_t h1 = as_load_uint32(&s1->hash);
+		uint32_t h2 = as_load_uint32(&s2->hash);
+
+		if (h1 != 0 && h2 != 0 && h1 != h2) {
+			return false;
+		}
+
+		size_t len = as_string_len(s1);
+
+		return len == as_string_len(s2) &&
+				0 == memcmp(s1->value, s2->value, len);
+	}
+	case AS_BYTES: {
+		const as_bytes * b1 = (const as_bytes *)v1;
+		const as_bytes * b2 = (const as_bytes *)v2;
+
+		uint32_t h1 = as_load_uint32(&b1->hash);
+		uint32_t h2 = as_load_uint32(&b2->hash);
+
+		if (h1 != 0 && h2 != 0 && h1 != h2) {
+			return false;
+		}
+
+		return b1->type == b2->type && b1->size == b2->size &&
+				0 == memcmp(b1->value, b2->value, b1->size);
+	}
 	case AS_GEOJSON:
 		return 0 == strcmp(as_geojson_get((const as_geojson *)v1),
 						   as_geojson_get((const as_geojson *)v2));
+	case AS_LIST: {
+		const as_list * l1 = (const as_list *)v1;
+		const as_list * l2 = (const as_list *)v2;
+		uint32_t size = as_list_size(l1);
+
+		if (v1 == v2) {
+			return true;
+		}
+
+		// List hashcodes are O(1) once computed, so check them first.
+		if (size != as_list_size(l2) ||
+				as_val_hashcode(v1) != as_val_hashcode(v2)) {
+			return false;
+		}
+
+		for (uint32_t i = 0; i < size; i++) {
+			const as_val * e1 = as_list_get(l1, i);
+			const as_val * e2 = as_list_get(l2, i);
+
+			if (e1 == e2) {
+				continue;
+			}
+
+			// Elements that can't be keys only match themselves.
+			if (! e1 || ! e2 || ! as_hashmap_key_valid(e1) ||
+					! as_hashmap_key_eq(e1, e2)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
 	default:
 		// Should never get here.
 		return false;
 	}
 }
 
+// Entry hashes are summed, so mix key and value to keep swapped pairs apart.
+uint32_t as_hashmap_entry_hash(uint32_t key_hash, const as_val * v)
+{
+	return cf_hash_mix32(key_hash ^ cf_hash_mix32(as_val_hashcode(v) + 0x9e3779b9));
+}
+
 /******************************************************************************
  *	INSTANCE FUNCTIONS
  ******************************************************************************/
@@ -160,6 +229,33 @@ as_hashmap * as_hashmap_new(uint32_t capacity)
 	return as_hashmap_cons(map, capacity);
 }
 
+as_hashmap * as_hashmap_init_wrap(as_hashmap * map, uint32_t capacity, void * storage)
+{
+	if (! map || ! storage) {
+		return NULL;
+	}
+
+	as_map_cons((as_map *)map, false, 0, &as_hashmap_map_hooks);
+
+	size_t size = as_hashmap_wrap_size(capacity);
+
+	memset(storage, 0, size);
+
+	map->count = 0;
+	map->table_capacity = capacity > MIN_CAPACITY ? capacity : MIN_CAPACITY;
+	map->table = (as_hashmap_element *)storage;
+	map->capacity_step = 0;
+	map->extra_capacity = map->table_capacity;
+	map->extras = map->table + map->table_capacity;
+	map->insert_at = 1; // can't be 0 since next = 0 means end of chain
+	map->free_q = 0;
+	map->free = false;
+	map->hash_valid = false;
+	map->hash = 0;
+
+	return map;
+}
+
 bool as_hashmap_release(as_hashmap * map)
 {
 	if (! map) {
@@ -167,7 +263,10 @@ bool as_hashmap_release(as_hashmap * map)
 	}
 
 	as_hashmap_clear(map);
-	cf_free(map->table);
+
+	if (map->free) {
+		cf_free(map->table);
+	}
 
 	return true;
 }
@@ -180,12 +279,40 @@ void as_hashmap_destroy(as_hashmap * map) {
  *	INFO FUNCTIONS
  ******************************************************************************/
 
-/**
- *	@todo Fill In
- */
+typedef struct hashmap_hash_s {
+	uint32_t hash;
+	bool cacheable;
+} hashmap_hash;
+
+static bool hashmap_hash_entry(const as_val * k, const as_val * v, void * udata)
+{
+	hashmap_hash * h = (hashmap_hash *)udata;
+
+	h->hash += as_hashmap_entry_hash(as_val_hashcode(k), v);
+	h->cacheable = h->cacheable && as_hashmap_entry_cacheable(k, v);
+	return true;
+}
+
+// Readers may share the map, so the hash is summed locally and published with
+// hash_valid set last. Readers that race store the same hash. It is only
+// cached while no entry holds a list or map.
 uint32_t as_hashmap_hashcode(const as_hashmap * map)
 {
-	return 1;
+	if (as_load_uint8((const uint8_t *)&map->hash_valid)) {
+		as_fence_lock();
+		return cf_hash_mix32(as_load_uint32(&map->hash) + map->count);
+	}
+
+	hashmap_hash h = { 0, true };
+	as_hashmap_foreach(map, hashmap_hash_entry, &h);
+
+	if (h.cacheable) {
+		as_store_uint32((uint32_t *)&map->hash, h.hash);
+		as_fence_store();
+		as_store_uint8((uint8_t *)&map->hash_valid, true);
+	}
+
+	return cf_hash_mix32(h.hash + map->count);
 }
 
 uint32_t as_hashmap_size(const as_hashmap * map)
@@ -203,7 +330,7 @@ int as_hashmap_set(as_hashmap * map, const as_val * k, const as_val * v)
 		return -1;
 	}
 
-	if (! is_valid_key_type(k)) {
+	if (! as_hashmap_key_valid(k)) {
 		return -1;
 	}
 
@@ -214,9 +341,18 @@ int as_hashmap_set(as_hashmap * map, const as_val * k, const as_val * v)
 
 	as_hashmap_element * e = &map->table[i];
 
+	if (! as_hashmap_entry_cacheable(k, safe_v)) {
+		map->hash_valid = false;
+	}
+
+	// Added to the map hash once the entry is in.
+	uint32_t entry_hash = map->hash_valid ?
+			as_hashmap_entry_hash(h, safe_v) : 0;
+
 	// If the slot in the main table is empty - use it.
 	if (! e->p_key) {
 		map->count++;
+		map->hash += entry_hash;
 
 		e->p_key = (as_val *)k;
 		e->p_val = safe_v;
@@ -227,7 +363,12 @@ int as_hashmap_set(as_hashmap * map, const as_val * k, const as_val * v)
 	// There are existing elements hashed to this slot - follow the chain.
 	while (true) {
 		// If we find our key, replace the existing key and value.
-		if (eq_val(e->p_key, k)) {
+		if (as_hashmap_key_eq(e->p_key, k)) {
+			if (map->hash_valid) {
+				map->hash += entry_hash -
+						as_hashmap_entry_hash(h, e->p_val);
+			}
+
 			as_val_destroy(e->p_key);
 			as_val_destroy(e->p_val);
 			e->p_key = (as_val *)k;
@@ -251,6 +392,7 @@ int as_hashmap_set(as_hashmap * map, const as_val * k, const as_val * v)
 	// If there's space on the free-q, use it.
 	if (map->free_q != 0) {
 		map->count++;
+		map->hash += entry_hash;
 		prev_e->next = map->free_q;
 
 		e = &map->extras[map->free_q];
@@ -275,6 +417,12 @@ int as_hashmap_set(as_hashmap * map, const as_val * k, const as_val * v)
 	// First grow the extra capacity if necessary.
 	// TODO - vertical scaling.
 	if (map->insert_at >= map->extra_capacity) {
+		// Caller provided storage can't grow.
+		if (! map->free) {
+			prev_e->next = cur_end;
+			return -1;
+		}
+
 		size_t orig_size = map->extra_capacity * sizeof(as_hashmap_element);
 		uint32_t extra_capacity = map->extra_capacity + map->capacity_step;
 		size_t size = extra_capacity * sizeof(as_hashmap_element);
@@ -304,6 +452,7 @@ int as_hashmap_set(as_hashmap * map, const as_val * k, const as_val * v)
 	}
 
 	map->count++;
+	map->hash += entry_hash;
 
 	e = &map->extras[map->insert_at++];
 
@@ -313,13 +462,128 @@ int as_hashmap_set(as_hashmap * map, const as_val * k, const as_val * v)
 	return 0;
 }
 
+int as_hashmap_load(as_hashmap * map, as_val ** keys, as_val ** vals, uint32_t count, bool unique)
+{
+	if (! map) {
+		return -1;
+	}
+
+	if (count == 0) {
+		return 0;
+	}
+
+	uint32_t * hashes = (uint32_t *)cf_malloc(count * sizeof(uint32_t));
+
+	if (! hashes) {
+		return -2;
+	}
+
+	// Hash every key first, so a bad key fails the load before any is added.
+	for (uint32_t j = 0; j < count; j++) {
+		if (! as_hashmap_key_valid(keys[j])) {
+			cf_free(hashes);
+			return -3;
+		}
+
+		hashes[j] = as_val_hashcode(keys[j]);
+	}
+
+	// Make room for the worst case, every entry in a collision slot - except
+	// the first entry of an empty map, which surely lands in the main table.
+	uint32_t needed = map->insert_at + count - (map->count == 0 ? 1 : 0);
+
+	if (needed > map->extra_capacity) {
+		if (! map->free) {
+			cf_free(hashes);
+			return -4;
+		}
+
+		size_t orig_size = map->extra_capacity * sizeof(as_hashmap_element);
+		size_t size = needed * sizeof(as_hashmap_element);
+		as_hashmap_element * extras =
+				(as_hashmap_element *)cf_realloc(map->extras, size);
+
+		if (! extras) {
+			cf_free(hashes);
+			return -5;
+		}
+
+		memset((uint8_t *)extras + orig_size, 0, size - orig_size);
+		map->extras = extras;
+		map->extra_capacity = needed;
+	}
+
+	for (uint32_t j = 0; j < count; j++) {
+		as_val * k = keys[j];
+		as_val * v = (as_val *)(vals[j] ? vals[j] : &as_nil);
+		as_hashmap_element * e = &map->table[hashes[j] % map->table_capacity];
+
+		if (! e->p_key) {
+			e->p_key = k;
+			e->p_val = v;
+			map->count++;
+			continue;
+		}
+
+		if (! unique) {
+			as_hashmap_element * d = e;
+
+			while (! as_hashmap_key_eq(d->p_key, k) && d->next != 0) {
+				d = &map->extras[d->next];
+			}
+
+			if (as_hashmap_key_eq(d->p_key, k)) {
+				as_val_destroy(d->p_key);
+				as_val_destroy(d->p_val);
+				d->p_key = k;
+				d->p_val = v;
+				continue;
+			}
+		}
+
+		// Link the new entry in right after the main table slot.
+		uint32_t x = map->free_q;
+
+		if (x != 0) {
+			map->free_q = map->extras[x].next;
+		}
+		else {
+			x = map->insert_at++;
+		}
+
+		as_hashmap_element * n = &map->extras[x];
+
+		n->p_key = k;
+		n->p_val = v;
+		n->next = e->next;
+		e->next = x;
+		map->count++;
+	}
+
+	cf_free(hashes);
+	map->hash_valid = false;
+
+	// Give back the collision slots the worst case didn't need.
+	if (map->free && map->insert_at < map->extra_capacity) {
+		as_hashmap_element * extras = (as_hashmap_element *)cf_realloc(
+				map->extras, map->insert_at * sizeof(as_hashmap_element));
+
+		if (extras) {
+			map->extras = extras;
+			map->extra_capacity = map->insert_at;
+		}
+	}
+
+	return 0;
+}
+
 as_val * as_hashmap_get(const as_hashmap * map, const as_val * k)
 {
 	if (! map) {
 		return NULL;
 	}
 
-	if (! is_valid_key_type(k)) {
+	if (! as_hashmap_key_valid(k)) {
 		return NULL;
 	}
 
@@ -335,7 +599,7 @@ as_val * as_hashmap_get(const as_hashmap * map, const as_val * k)
 
 	// Follow the chain.
 	while (true) {
-		if (eq_val(e->p_key, k)) {
+		if (as_hashmap_key_eq(e->p_key, k)) {
 			return e->p_val;
 		}
 
@@ -378,14 +642,20 @@ int as_hashmap_clear(as_hashmap * map)
 
 	map->count = 0;
 
-	if (map->extras) {
+	if (! map->free) {
+		// Keep caller provided extras, the insert path expects them zeroed.
+		memset(map->extras, 0, map->extra_capacity * sizeof(as_hashmap_element));
+	}
+	else if (map->extras) {
 		cf_free(map->extras);
 		map->extras = NULL;
+		map->extra_capacity = 0;
 	}
 
-	map->extra_capacity = 0;
 	map->insert_at = 1;
 	map->free_q = 0;
+	map->hash_valid = false;
+	map->hash = 0;
 
 	return 0;
 }
@@ -396,7 +666,7 @@ int as_hashmap_remove(as_hashmap * map, const as_val * k)
 		return -1;
 	}
 
-	if (! is_valid_key_type(k)) {
+	if (! as_hashmap_key_valid(k)) {
 		return -1; // or 0?
 	}
 
@@ -411,9 +681,13 @@ int as_hashmap_remove(as_hashmap * map, const as_val * k)
 	}
 
 	// If the table slot has our key, remove it and repair the chain.
-	if (eq_val(e->p_key, k)) {
+	if (as_hashmap_key_eq(e->p_key, k)) {
 		map->count--;
 
+		if (map->hash_valid) {
+			map->hash -= as_hashmap_entry_hash(h, e->p_val);
+		}
+
 		as_val_destroy(e->p_key);
 		as_val_destroy(e->p_val);
 
@@ -455,9 +729,13 @@ int as_hashmap_remove(as_hashmap * map, const as_val * k)
 		// If we find our key, free its slot and repair the chain by changing
 		// the previous item's next "pointer".
 
-		if (eq_val(e->p_key, k)) {
+		if (as_hashmap_key_eq(e->p_key, k)) {
 			map->count--;
 
+			if (map->hash_valid) {
+				map->hash -= as_hashmap_entry_hash(h, e->p_val);
+			}
+
 			as_val_destroy(e->p_key);
 			as_val_destroy(e->p_val);
 			e->p_key = NULL;
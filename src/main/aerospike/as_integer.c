@@ -16,9 +16,26 @@
  */
 #include <aerospike/as_integer.h>
 #include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_hash_math.h>
 #include <stdio.h>
 #include <string.h>
 
+/******************************************************************************
+ *	CONSTANTS
+ *****************************************************************************/
+
+#define SHARED(__v) { ._ = { .type = AS_INTEGER, .free = false, .count = 0 }, .value = (__v) }
+#define SHARED4(__v) SHARED(__v), SHARED(__v + 1), SHARED(__v + 2), SHARED(__v + 3)
+#define SHARED16(__v) SHARED4(__v), SHARED4(__v + 4), SHARED4(__v + 8), SHARED4(__v + 12)
+#define SHARED64(__v) SHARED16(__v), SHARED16(__v + 16), SHARED16(__v + 32), SHARED16(__v + 48)
+#define SHARED256(__v) SHARED64(__v), SHARED64(__v + 64), SHARED64(__v + 128), SHARED64(__v + 192)
+
+// Instances for AS_INTEGER_SHARED_MIN to AS_INTEGER_SHARED_MAX.
+static const as_integer as_integer_shared[] = {
+	SHARED64(-128), SHARED64(-64),
+	SHARED256(0), SHARED256(256), SHARED256(512), SHARED256(768)
+};
+
 /******************************************************************************
  *	INSTANCE FUNCTIONS
  ******************************************************************************/
@@ -43,6 +60,15 @@ as_integer * as_integer_new(int64_t value)
 	return as_integer_cons(integer, true, value);
 }
 
+as_integer * as_integer_new_shared(int64_t value)
+{
+	if ( value >= AS_INTEGER_SHARED_MIN && value <= AS_INTEGER_SHARED_MAX ) {
+		return (as_integer *) &as_integer_shared[value - AS_INTEGER_SHARED_MIN];
+	}
+
+	return as_integer_new(value);
+}
+
 /******************************************************************************
  *	as_val FUNCTIONS
  ******************************************************************************/
@@ -58,7 +84,7 @@ void as_integer_val_destroy(as_val * v)
 uint32_t as_integer_val_hashcode(const as_val * v)
 {
 	as_integer * i = as_integer_fromval(v);
-	return i != NULL ? (uint32_t)i->value : 0;
+	return i != NULL ? cf_hash_mix64((uint64_t)i->value) : 0;
 }
 
 char * as_integer_val_tostring(const as_val * v)
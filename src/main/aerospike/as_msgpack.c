@@ -19,6 +19,7 @@
 
 #include <string.h>
 
+#include <aerospike/as_arena.h>
 #include <aerospike/as_msgpack_ext.h>
 #include <aerospike/as_serializer.h>
 #include <aerospike/as_types.h>
@@ -26,6 +27,10 @@
 #include <citrusleaf/alloc.h>
 #include <citrusleaf/cf_byte_order.h>
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
+
 /******************************************************************************
  * INTERNAL TYPEDEFS & CONSTANTS
  ******************************************************************************/
@@ -49,10 +54,18 @@ typedef struct msgpack_parse_state_s {
 
 typedef struct msgpack_parse_memblock_s {
 	struct msgpack_parse_memblock_s *prev;
-	msgpack_parse_state buffer[MSGPACK_PARSE_MEMBLOCK_STATE_COUNT];
+	msgpack_parse_state *buffer;
 	size_t count;
+	size_t capacity;
+	bool fixed;	// caller scratch, never chained or freed
 } msgpack_parse_memblock;
 
+typedef struct unpack_ctx_s {
+	void *backing;		// cf_rc_alloc() region to borrow blobs from
+	as_arena *arena;	// arena to allocate values from
+	bool unique_keys;	// map keys are known not to repeat
+} unpack_ctx;
+
 #define MSGPACK_COMPARE_RET_LESS_OR_GREATER(arg1, arg2) { \
 	if (arg1 < arg2) { \
 		return MSGPACK_COMPARE_LESS; \
@@ -73,9 +86,13 @@ static msgpack_parse_state *msgpack_parse_memblock_next(msgpack_parse_memblock *
 static inline bool msgpack_parse_memblock_has_prev(const msgpack_parse_memblock *block);
 static msgpack_parse_state *msgpack_parse_memblock_prev(msgpack_parse_memblock **block);
 static bool msgpack_parse_state_list_cmp_init(msgpack_parse_state *state, as_unpacker *pk1, as_unpacker *pk2);
-static bool msgpack_parse_state_list_size_init(msgpack_parse_state *state, as_unpacker *pk);
 static bool msgpack_parse_state_map_cmp_init(msgpack_parse_state *state, as_unpacker *pk1, as_unpacker *pk2);
-static bool msgpack_parse_state_map_size_init(msgpack_parse_state *state, as_unpacker *pk);
+
+// pack
+static int pack_pool_grow(as_packer *pk, uint32_t sz);
+
+// unpack
+static int unpack_val(as_unpacker *pk, as_val **val, const unpack_ctx *ctx);
 
 // msgpack_compare
 static inline msgpack_compare_t msgpack_compare_int(as_unpacker *pk1, as_unpacker *pk2);
@@ -91,6 +108,7 @@ static msgpack_compare_t msgpack_compare_list(as_unpacker *pk1, as_unpacker *pk2
 static msgpack_compare_t msgpack_compare_map(as_unpacker *pk1, as_unpacker *pk2, size_t depth);
 static inline msgpack_compare_t msgpack_peek_compare_type(const as_unpacker *pk1, const as_unpacker *pk2, as_val_t *type);
 static msgpack_compare_t msgpack_compare_non_recursive(as_unpacker *pk1, as_unpacker *pk2, msgpack_parse_memblock **block, msgpack_parse_state *state);
+static msgpack_compare_t msgpack_compare_nested(as_unpacker *pk1, as_unpacker *pk2, msgpack_parse_memblock **block, as_val_t type);
 static inline msgpack_compare_t msgpack_compare_type(as_unpacker *pk1, as_unpacker *pk2, as_val_t type, size_t depth);
 static inline msgpack_compare_t msgpack_compare_internal(as_unpacker *pk1, as_unpacker *pk2, size_t depth, as_val_t *type);
 
@@ -99,11 +117,7 @@ static int as_pack_inf_internal(as_packer *pk, bool resize);
 static int as_pack_wildcard_internal(as_packer *pk, bool resize);
 
 // unpack direct
-static int64_t unpack_list_elements_size(as_unpacker *pk, uint32_t ele_count, uint32_t depth);
-static int64_t unpack_map_elements_size(as_unpacker *pk, uint32_t ele_count, uint32_t depth);
 static inline as_val_t bytes_internal_type_to_as_val_t(uint8_t type);
-static int64_t unpack_size_non_recursive(as_unpacker *pk, msgpack_parse_memblock *block, msgpack_parse_state *state);
-static inline int64_t unpack_size_internal(as_unpacker *pk, uint32_t depth);
 static inline const uint8_t *unpack_str_bin(as_unpacker *pk, uint32_t *sz_r);
 
 
@@ -114,29 +128,67 @@ static inline const uint8_t *unpack_str_bin(as_unpacker *pk, uint32_t *sz_r);
 static msgpack_parse_memblock *
 msgpack_parse_memblock_create(msgpack_parse_memblock *prev)
 {
-	msgpack_parse_memblock *p = cf_malloc(sizeof(msgpack_parse_memblock));
+	msgpack_parse_memblock *p = cf_malloc(sizeof(msgpack_parse_memblock) +
+			MSGPACK_PARSE_MEMBLOCK_STATE_COUNT * sizeof(msgpack_parse_state));
+
+	if (! p) {
+		return NULL;
+	}
+
 	p->prev = prev;
+	p->buffer = (msgpack_parse_state *)(p + 1);
+	p->count = 0;
+	p->capacity = MSGPACK_PARSE_MEMBLOCK_STATE_COUNT;
+	p->fixed = false;
+	return p;
+}
+
+// Lay out a fixed block in caller scratch memory. Returns NULL if the scratch
+// can't hold the block and at least one state.
+static msgpack_parse_memblock *
+msgpack_parse_memblock_init_fixed(void *scratch, size_t size)
+{
+	// Keep the states aligned after the block header.
+	uintptr_t start = ((uintptr_t)scratch + sizeof(void *) - 1) &
+			~(uintptr_t)(sizeof(void *) - 1);
+	size_t used = (size_t)(start - (uintptr_t)scratch) +
+			sizeof(msgpack_parse_memblock);
+
+	if (! scratch || size < used + sizeof(msgpack_parse_state)) {
+		return NULL;
+	}
+
+	msgpack_parse_memblock *p = (msgpack_parse_memblock *)start;
+
+	p->prev = NULL;
+	p->buffer = (msgpack_parse_state *)(p + 1);
 	p->count = 0;
+	p->capacity = (size - used) / sizeof(msgpack_parse_state);
+	p->fixed = true;
 	return p;
 }
 
 static void
 msgpack_parse_memblock_destroy(msgpack_parse_memblock *block)
 {
-	while (block) {
+	while (block && ! block->fixed) {
 		msgpack_parse_memblock *p = block;
 		block = block->prev;
 		cf_free(p);
 	}
 }
 
+// Returns NULL when out of memory or when a fixed block is full.
 static msgpack_parse_state *
 msgpack_parse_memblock_next(msgpack_parse_memblock **block)
 {
 	msgpack_parse_memblock *ptr = *block;
 
-	if (ptr->count >= MSGPACK_PARSE_MEMBLOCK_STATE_COUNT) {
-		ptr = msgpack_parse_memblock_create(ptr);
+	if (ptr->count >= ptr->capacity) {
+		if (ptr->fixed || ! (ptr = msgpack_parse_memblock_create(ptr))) {
+			return NULL;
+		}
+
 		*block = ptr;
 	}
 
@@ -195,23 +247,6 @@ msgpack_parse_state_list_cmp_init(msgpack_parse_state *state, as_unpacker *pk1,
 	return true;
 }
 
-static bool
-msgpack_parse_state_list_size_init(msgpack_parse_state *state, as_unpacker *pk)
-{
-	int64_t len = as_unpack_list_header_element_count(pk);
-
-	if (len < 0) {
-		return false;
-	}
-
-	state->index = 0;
-	state->map_pair = 0;
-	state->len = (uint32_t)len;
-	state->type = AS_LIST;
-
-	return true;
-}
-
 static bool
 msgpack_parse_state_map_cmp_init(msgpack_parse_state *state, as_unpacker *pk1,
 		as_unpacker *pk2)
@@ -235,30 +270,172 @@ msgpack_parse_state_map_cmp_init(msgpack_parse_state *state, as_unpacker *pk1,
 	return true;
 }
 
-static bool
-msgpack_parse_state_map_size_init(msgpack_parse_state *state, as_unpacker *pk)
+/******************************************************************************
+ * PACK FUNCTIONS
+ ******************************************************************************/
+
+int
+as_packer_pool_init(as_packer *pk, as_buffer_pool *pool, uint32_t size)
 {
-	int64_t len = as_unpack_map_header_element_count(pk);
+	as_buffer_result br;
 
-	if (len < 0) {
-		return false;
+	if (as_buffer_pool_pop(pool, size, &br) < 0) {
+		return -1;
 	}
 
-	state->index = 0;
-	state->map_pair = 0;
-	state->len = (uint32_t)len;
-	state->type = AS_MAP;
+	pk->head = NULL;
+	pk->tail = NULL;
+	pk->buffer = (unsigned char *)br.data + pool->header_size;
+	pk->offset = 0;
+	pk->capacity = br.capacity;
+	pk->contiguous = false;
+	pk->grow = pack_pool_grow;
+	pk->grow_udata = pool;
+	pk->refs = NULL;
+	pk->ref_count = 0;
+	pk->ref_capacity = 0;
+	pk->ref_threshold = 0;
+	return 0;
+}
 
-	return true;
+void
+as_packer_pool_release(as_packer *pk)
+{
+	as_buffer_pool_push((as_buffer_pool *)pk->grow_udata,
+			as_packer_pool_data(pk), pk->capacity);
+	pk->buffer = NULL;
 }
 
-/******************************************************************************
- * PACK FUNCTIONS
- ******************************************************************************/
+uint64_t
+as_packer_size(const as_packer *pk)
+{
+	uint64_t size = pk->offset;
+
+	for (uint32_t i = 0; i < pk->ref_count; i++) {
+		size += pk->refs[i].size;
+	}
+
+	for (const as_packer_buffer *b = pk->head; b; b = b->next) {
+		size += b->length;
+	}
+
+	return size;
+}
+
+#if !defined(_MSC_VER)
+int
+as_packer_iov(const as_packer *pk, struct iovec *iov)
+{
+	if (pk->head) {
+		return -1;
+	}
+
+	uint32_t count = 0;
+	uint32_t offset = 0;
+
+	for (uint32_t i = 0; i < pk->ref_count; i++) {
+		const as_packer_ref *ref = &pk->refs[i];
+
+		if (ref->offset > offset) {
+			iov[count].iov_base = pk->buffer + offset;
+			iov[count].iov_len = ref->offset - offset;
+			count++;
+			offset = ref->offset;
+		}
+
+		iov[count].iov_base = (void *)ref->data;
+		iov[count].iov_len = ref->size;
+		count++;
+	}
+
+	if (pk->offset > offset) {
+		iov[count].iov_base = pk->buffer + offset;
+		iov[count].iov_len = pk->offset - offset;
+		count++;
+	}
+
+	return (int)count;
+}
+#endif
+
+static int
+pack_grow(as_packer *pk, uint32_t sz)
+{
+	// Double until the pending write fits, so a large output costs a
+	// logarithmic number of reallocs and no final gather.
+	uint64_t need = (uint64_t)pk->offset + sz;
+	uint64_t newcap = pk->capacity != 0 ? pk->capacity : AS_PACKER_BUFFER_SIZE;
+
+	while (newcap < need) {
+		newcap *= 2;
+	}
+
+	if (newcap > UINT32_MAX) {
+		if (need > UINT32_MAX) {
+			return -1;
+		}
+
+		newcap = UINT32_MAX;
+	}
+
+	unsigned char *buf = (unsigned char *)cf_realloc(pk->buffer, (size_t)newcap);
+
+	if (! buf) {
+		return -1;
+	}
+
+	pk->buffer = buf;
+	pk->capacity = (uint32_t)newcap;
+	return 0;
+}
+
+static int
+pack_pool_grow(as_packer *pk, uint32_t sz)
+{
+	as_buffer_pool *pool = (as_buffer_pool *)pk->grow_udata;
+	uint64_t need = (uint64_t)pk->offset + sz;
+	uint64_t newcap = pk->capacity != 0 ? pk->capacity : AS_PACKER_BUFFER_SIZE;
+
+	while (newcap < need) {
+		newcap *= 2;
+	}
+
+	if (newcap > UINT32_MAX - pool->header_size) {
+		if (need > UINT32_MAX - pool->header_size) {
+			return -1;
+		}
+
+		newcap = UINT32_MAX - pool->header_size;
+	}
+
+	as_buffer_result br;
+
+	if (as_buffer_pool_pop(pool, (uint32_t)newcap, &br) < 0) {
+		return -1;
+	}
+
+	// Carry over the pool header along with the packed contents.
+	unsigned char *old = as_packer_pool_data(pk);
+
+	memcpy(br.data, old, pool->header_size + pk->offset);
+	as_buffer_pool_push(pool, old, pk->capacity);
+
+	pk->buffer = (unsigned char *)br.data + pool->header_size;
+	pk->capacity = br.capacity;
+	return 0;
+}
 
 static int
 pack_resize(as_packer *pk, uint32_t sz)
 {
+	if (pk->grow) {
+		return pk->grow(pk, sz);
+	}
+
+	if (pk->contiguous) {
+		return pack_grow(pk, sz);
+	}
+
 	// Add current buffer to linked list and allocate a new buffer
 	as_packer_buffer *entry =
 			(as_packer_buffer *)cf_malloc(sizeof(as_packer_buffer));
@@ -293,12 +470,20 @@ pack_resize(as_packer *pk, uint32_t sz)
 	return 0;
 }
 
+// Direct pack functions never chain, since their callers expect all output in
+// pk->buffer. Growing a contiguous or custom buffer keeps the output whole.
+static inline bool
+pack_can_resize(const as_packer *pk, bool resize)
+{
+	return resize || pk->contiguous || pk->grow;
+}
+
 static inline int
 pack_append(as_packer *pk, const unsigned char *src, uint32_t sz, bool resize)
 {
 	if (pk->buffer) {
 		if (pk->offset + sz > pk->capacity) {
-			if (! resize || pack_resize(pk, sz) != 0) {
+			if (! pack_can_resize(pk, resize) || pack_resize(pk, sz) != 0) {
 				return -1;
 			}
 		}
@@ -308,12 +493,29 @@ pack_append(as_packer *pk, const unsigned char *src, uint32_t sz, bool resize)
 	return 0;
 }
 
+static inline int
+pack_append_ref(as_packer *pk, const unsigned char *src, uint32_t sz,
+		bool resize)
+{
+	if (pk->buffer && sz >= pk->ref_threshold &&
+			pk->ref_count < pk->ref_capacity) {
+		as_packer_ref *ref = &pk->refs[pk->ref_count++];
+
+		ref->data = src;
+		ref->size = sz;
+		ref->offset = pk->offset;
+		return 0;
+	}
+
+	return pack_append(pk, src, sz, resize);
+}
+
 static inline int
 pack_byte(as_packer *pk, uint8_t val, bool resize)
 {
 	if (pk->buffer) {
 		if (pk->offset + 1 > pk->capacity) {
-			if (! resize || pack_resize(pk, 1) != 0) {
+			if (! pack_can_resize(pk, resize) || pack_resize(pk, 1) != 0) {
 				return -1;
 			}
 		}
@@ -328,7 +530,7 @@ pack_type_uint8(as_packer *pk, unsigned char type, uint8_t val, bool resize)
 {
 	if (pk->buffer) {
 		if (pk->offset + 2 > pk->capacity) {
-			if (! resize || pack_resize(pk, 2) != 0) {
+			if (! pack_can_resize(pk, resize) || pack_resize(pk, 2) != 0) {
 				return -1;
 			}
 		}
@@ -345,7 +547,7 @@ pack_type_uint16(as_packer *pk, unsigned char type, uint16_t val, bool resize)
 {
 	if (pk->buffer) {
 		if (pk->offset + 3 > pk->capacity) {
-			if (! resize || pack_resize(pk, 3) != 0) {
+			if (! pack_can_resize(pk, resize) || pack_resize(pk, 3) != 0) {
 				return -1;
 			}
 		}
@@ -365,7 +567,7 @@ pack_type_uint32(as_packer *pk, unsigned char type, uint32_t val, bool resize)
 {
 	if (pk->buffer) {
 		if (pk->offset + 5 > pk->capacity) {
-			if (! resize || pack_resize(pk, 5) != 0) {
+			if (! pack_can_resize(pk, resize) || pack_resize(pk, 5) != 0) {
 				return -1;
 			}
 		}
@@ -383,7 +585,7 @@ pack_type_uint64(as_packer *pk, unsigned char type, uint64_t val, bool resize)
 {
 	if (pk->buffer) {
 		if (pk->offset + 9 > pk->capacity) {
-			if (! resize || pack_resize(pk, 9) != 0) {
+			if (! pack_can_resize(pk, resize) || pack_resize(pk, 9) != 0) {
 				return -1;
 			}
 		}
@@ -536,7 +738,7 @@ pack_string(as_packer *pk, as_string *s)
 	}
 
 	if (rc == 0) {
-		rc = pack_append(pk, (unsigned char*)s->value, length, true);
+		rc = pack_append_ref(pk, (unsigned char*)s->value, length, true);
 	}
 
 	return rc;
@@ -549,7 +751,7 @@ pack_geojson(as_packer *pk, as_geojson *s)
 	int rc = pack_byte_array_header(pk, length, AS_BYTES_GEOJSON);
 
 	if (rc == 0) {
-		rc = pack_append(pk, (unsigned char*)s->value, length, true);
+		rc = pack_append_ref(pk, (unsigned char*)s->value, length, true);
 	}
 
 	return rc;
@@ -561,12 +763,14 @@ pack_bytes(as_packer *pk, const as_bytes *b)
 	int rc = pack_byte_array_header(pk, b->size, b->type);
 
 	if (rc == 0) {
-		rc = pack_append(pk, b->value, b->size, true);
+		rc = pack_append_ref(pk, b->value, b->size, true);
 	}
 
 	return rc;
 }
 
+extern const as_list_hooks as_typedlist_list_hooks;
+
 static bool
 pack_list_foreach(as_val *val, void *udata)
 {
@@ -590,11 +794,25 @@ pack_list(as_packer *pk, as_list *l)
 		rc = pack_type_uint32(pk, 0xdd, size, true);
 	}
 
-	if (rc == 0) {
-		rc = as_list_foreach(l, pack_list_foreach, pk) ? 0 : 1;
+	if (rc != 0) {
+		return rc;
 	}
 
-	return rc;
+	// Typed lists pack straight from their unboxed storage.
+	if (l->hooks == &as_typedlist_list_hooks) {
+		as_typedlist *tl = (as_typedlist *)l;
+		const int64_t *ints = as_typedlist_int64s(tl);
+		const double *doubles = as_typedlist_doubles(tl);
+
+		for (uint32_t i = 0; i < size && rc == 0; i++) {
+			rc = ints ? pack_int64(pk, ints[i], true) :
+					pack_double(pk, doubles[i], true);
+		}
+
+		return rc;
+	}
+
+	return as_list_foreach(l, pack_list_foreach, pk) ? 0 : 1;
 }
 
 static bool
@@ -610,12 +828,22 @@ pack_map_foreach(const as_val *key, const as_val *val, void *udata)
 	return rc == 0;
 }
 
+extern const as_map_hooks as_orderedmap_map_hooks;
+
 static int
 pack_map(as_packer *pk, const as_map *m)
 {
 	uint32_t size = as_map_size(m);
+	// Only as_orderedmap iterates in key order - flag it so the order is kept.
+	// The flags field is public, so other maps with it set are packed
+	// unordered.
+	bool ordered = m->hooks == &as_orderedmap_map_hooks;
 	int rc;
 
+	if (ordered) {
+		size++;
+	}
+
 	if (size < 16) {
 		rc = pack_byte(pk, (uint8_t)(0x80 | size), true);
 	}
@@ -626,6 +854,16 @@ pack_map(as_packer *pk, const as_map *m)
 		rc = pack_type_uint32(pk, 0xdf, size, true);
 	}
 
+	if (rc == 0 && ordered) {
+		// Empty ext 8 key holding the flags, with a nil value. A KV-ordered
+		// flag from unpacking is kept, so the map round trips.
+		uint8_t flags = (m->flags & AS_PACKED_MAP_FLAG_KV_ORDERED) |
+				AS_PACKED_MAP_FLAG_K_ORDERED;
+		const uint8_t header[] = { 0xc7, 0x00, flags, 0xc0 };
+
+		rc = pack_append(pk, header, sizeof(header), true);
+	}
+
 	if (rc == 0) {
 		rc = as_map_foreach(m, pack_map_foreach, pk) ? 0 : 1;
 	}
@@ -789,41 +1027,173 @@ unpack_ext(as_unpacker *pk, uint8_t type, as_val **v)
 	return -1;
 }
 
+// Arena values are not reference counted - as_val_destroy() leaves them alone
+// and they are released with the arena.
+static inline as_val *
+arena_val(void *v)
+{
+	((as_val *)v)->count = 0;
+	return (as_val *)v;
+}
+
 static inline int
-unpack_boolean(bool b, as_val **v)
+unpack_integer_val(int64_t i, as_val **v, const unpack_ctx *ctx)
 {
-	// Aerospike does not support boolean, so we convert it to integer.
-	*v = (as_val *)as_integer_new(b ? 1 : 0);
+	if (ctx->arena) {
+		as_integer *integer = as_arena_alloc(ctx->arena, sizeof(as_integer));
+
+		if (! integer) {
+			return -1;
+		}
+
+		*v = arena_val(as_integer_init(integer, i));
+		return 0;
+	}
+
+	*v = (as_val *)as_integer_new_shared(i);
 	return 0;
 }
 
 static inline int
-unpack_integer_val(int64_t i, as_val **v)
+unpack_boolean(bool b, as_val **v, const unpack_ctx *ctx)
 {
-	*v = (as_val *)as_integer_new(i);
-	return 0;
+	// Aerospike does not support boolean, so we convert it to integer.
+	return unpack_integer_val(b ? 1 : 0, v, ctx);
 }
 
 static inline int
-unpack_double_val(double d, as_val **v)
+unpack_double_val(double d, as_val **v, const unpack_ctx *ctx)
 {
+	if (ctx->arena) {
+		as_double *dbl = as_arena_alloc(ctx->arena, sizeof(as_double));
+
+		if (! dbl) {
+			return -1;
+		}
+
+		*v = arena_val(as_double_init(dbl, d));
+		return 0;
+	}
+
 	*v = (as_val *)as_double_new(d);
 	return 0;
 }
 
 static int
-unpack_blob(as_unpacker *pk, uint32_t size, as_val **val)
+unpack_blob_arena(as_unpacker *pk, uint8_t type, uint32_t size, as_val **val,
+		as_arena *arena)
+{
+	if (size > pk->length - pk->offset) {
+		return -1;
+	}
+
+	const uint8_t *p = pk->buffer + pk->offset;
+
+	if (type == AS_BYTES_STRING || type == AS_BYTES_GEOJSON) {
+		char *v = as_arena_alloc(arena, size + 1);
+
+		if (! v) {
+			return -2;
+		}
+
+		memcpy(v, p, size);
+		v[size] = 0;
+
+		if (type == AS_BYTES_STRING) {
+			as_string *string = as_arena_alloc(arena, sizeof(as_string));
+
+			if (! string) {
+				return -3;
+			}
+
+			*val = arena_val(as_string_init_wlen(string, v, size, false));
+		}
+		else {
+			as_geojson *geo = as_arena_alloc(arena, sizeof(as_geojson));
+
+			if (! geo) {
+				return -4;
+			}
+
+			*val = arena_val(as_geojson_init_wlen(geo, v, size, false));
+		}
+	}
+	else {
+		uint8_t *v = NULL;
+
+		if (size != 0 && ! (v = as_arena_alloc(arena, size))) {
+			return -5;
+		}
+
+		as_bytes *b = as_arena_alloc(arena, sizeof(as_bytes));
+
+		if (! b) {
+			return -6;
+		}
+
+		if (size != 0) {
+			memcpy(v, p, size);
+		}
+
+		as_bytes_init_wrap(b, v, size, false);
+		b->type = (as_bytes_type)type;
+		*val = arena_val(b);
+	}
+
+	pk->offset += size;
+
+	return 0;
+}
+
+static int
+unpack_blob_borrowed(as_unpacker *pk, uint8_t type, uint32_t size, as_val **val,
+		void *backing)
+{
+	if (size > pk->length - pk->offset) {
+		return -1;
+	}
+
+	// The region is only read through the value, never written.
+	as_bytes *b = as_bytes_new_wrap((uint8_t *)pk->buffer + pk->offset, size,
+			false);
+
+	if (! b) {
+		return -2;
+	}
+
+	b->type = (as_bytes_type)type;
+	b->backing = backing;
+	*val = (as_val *)b;
+
+	cf_rc_reserve(backing);
+	pk->offset += size;
+
+	return 0;
+}
+
+static int
+unpack_blob(as_unpacker *pk, uint32_t size, as_val **val, const unpack_ctx *ctx)
 {
 	unsigned char type = 0;
 
 	if (size != 0) {
 		type = pk->buffer[pk->offset++];
 		size--;
+
+		// Strings and geojson need a terminator, so they are copied below.
+		if (ctx->backing && type != AS_BYTES_STRING &&
+				type != AS_BYTES_GEOJSON) {
+			return unpack_blob_borrowed(pk, type, size, val, ctx->backing);
+		}
+	}
+
+	if (ctx->arena) {
+		return unpack_blob_arena(pk, type, size, val, ctx->arena);
 	}
 
 	if (type == AS_BYTES_STRING) {
-		char *v = cf_strndup((const char *)pk->buffer + pk->offset, size);
-		*val = (as_val*)as_string_new(v, true);
+		*val = (as_val *)as_string_new_strndup(
+				(const char *)pk->buffer + pk->offset, size);
 	}
 	else if (type == AS_BYTES_GEOJSON) {
 		char *v = cf_strndup((const char *)pk->buffer + pk->offset, size);
@@ -868,8 +1238,33 @@ unpack_blob(as_unpacker *pk, uint32_t size, as_val **val)
 	return 0;
 }
 
+static as_arraylist *
+unpack_list_create(uint32_t capacity, uint32_t block_size,
+		const unpack_ctx *ctx)
+{
+	if (! ctx->arena) {
+		return as_arraylist_new(capacity, block_size);
+	}
+
+	// Fixed capacity, like a list from as_arraylist_inita().
+	as_arraylist *list = as_arena_alloc(ctx->arena, sizeof(as_arraylist));
+	as_val **elements = as_arena_alloc(ctx->arena,
+			sizeof(as_val *) * capacity);
+
+	if (! list || ! elements) {
+		return NULL;
+	}
+
+	as_arraylist_init(list, 0, 0);
+	list->elements = elements;
+	list->capacity = capacity;
+	arena_val(list);
+
+	return list;
+}
+
 static int
-unpack_list(as_unpacker *pk, uint32_t size, as_val **val)
+unpack_list(as_unpacker *pk, uint32_t size, as_val **val, const unpack_ctx *ctx)
 {
 	uint8_t flags = 0;
 
@@ -885,7 +1280,7 @@ unpack_list(as_unpacker *pk, uint32_t size, as_val **val)
 		size--;
 	}
 
-	as_arraylist *list = as_arraylist_new(size, 8);
+	as_arraylist *list = unpack_list_create(size, 8, ctx);
 
 	if (! list) {
 		return -2;
@@ -894,7 +1289,7 @@ unpack_list(as_unpacker *pk, uint32_t size, as_val **val)
 	for (uint32_t i = 0; i < size; i++) {
 		as_val *v = NULL;
 
-		if (as_unpack_val(pk, &v) != 0 || ! v) {
+		if (unpack_val(pk, &v, ctx) != 0 || ! v) {
 			as_arraylist_destroy(list);
 			return -3;
 		}
@@ -909,10 +1304,11 @@ unpack_list(as_unpacker *pk, uint32_t size, as_val **val)
 }
 
 static int
-unpack_map_create_list(as_unpacker *pk, uint32_t size, as_val **val)
+unpack_map_create_list(as_unpacker *pk, uint32_t size, as_val **val,
+		const unpack_ctx *ctx)
 {
 	// Create list of key value pairs.
-	as_arraylist *list = as_arraylist_new(2 * size, 2 * size);
+	as_arraylist *list = unpack_list_create(2 * size, 2 * size, ctx);
 
 	if (! list) {
 		return -1;
@@ -922,12 +1318,12 @@ unpack_map_create_list(as_unpacker *pk, uint32_t size, as_val **val)
 		as_val *k = NULL;
 		as_val *v = NULL;
 
-		if (as_unpack_val(pk, &k) != 0) {
+		if (unpack_val(pk, &k, ctx) != 0) {
 			as_arraylist_destroy(list);
 			return -2;
 		}
 
-		if (as_unpack_val(pk, &v) != 0) {
+		if (unpack_val(pk, &v, ctx) != 0) {
 			as_val_destroy(k);
 			as_arraylist_destroy(list);
 			return -3;
@@ -948,8 +1344,92 @@ unpack_map_create_list(as_unpacker *pk, uint32_t size, as_val **val)
 	return 0;
 }
 
+static as_hashmap *
+unpack_map_create(uint32_t size, const unpack_ctx *ctx)
+{
+	if (! ctx->arena) {
+		return as_hashmap_new(size > 32 ? size : 32);
+	}
+
+	as_hashmap *map = as_arena_alloc(ctx->arena, sizeof(as_hashmap));
+	void *storage = as_arena_alloc(ctx->arena, as_hashmap_wrap_size(size));
+
+	if (! map || ! storage) {
+		return NULL;
+	}
+
+	arena_val(as_hashmap_init_wrap(map, size, storage));
+
+	return map;
+}
+
+static as_orderedmap *
+unpack_orderedmap_create(uint32_t size, const unpack_ctx *ctx)
+{
+	if (! ctx->arena) {
+		return as_orderedmap_new(size);
+	}
+
+	as_orderedmap *map = as_arena_alloc(ctx->arena, sizeof(as_orderedmap));
+	void *storage = as_arena_alloc(ctx->arena, as_orderedmap_wrap_size(size));
+
+	if (! map || ! storage) {
+		return NULL;
+	}
+
+	arena_val(as_orderedmap_init_wrap(map, size, storage));
+
+	return map;
+}
+
+static int
+unpack_orderedmap(as_unpacker *pk, uint32_t size, as_val **val, uint8_t flags,
+		const unpack_ctx *ctx)
+{
+	as_orderedmap *map = unpack_orderedmap_create(size, ctx);
+
+	if (! map) {
+		return -2;
+	}
+
+	// Entries arrive sorted, so each set appends.
+	for (uint32_t i = 0; i < size; i++) {
+		as_val *k = NULL;
+		as_val *v = NULL;
+
+		if (unpack_val(pk, &k, ctx) != 0) {
+			as_orderedmap_destroy(map);
+			return -3;
+		}
+
+		if (unpack_val(pk, &v, ctx) != 0) {
+			as_val_destroy(k);
+			as_orderedmap_destroy(map);
+			return -4;
+		}
+
+		if (k && v) {
+			if (as_orderedmap_set(map, k, v) != 0) {
+				as_val_destroy(k);
+				as_val_destroy(v);
+				as_orderedmap_destroy(map);
+				return -5;
+			}
+		}
+		else {
+			as_val_destroy(k);
+			as_val_destroy(v);
+		}
+	}
+
+	*val = (as_val *)map;
+	map->_.flags = flags;
+
+	return 0;
+}
+
 static int
-unpack_map(as_unpacker *pk, uint32_t size, as_val **val)
+unpack_map(as_unpacker *pk, uint32_t size, as_val **val, const unpack_ctx *ctx)
 {
 	uint8_t flags = 0;
 
@@ -967,52 +1447,87 @@ unpack_map(as_unpacker *pk, uint32_t size, as_val **val)
 
 	// Check preserve order bit.
 	if ((flags & AS_PACKED_MAP_FLAG_PRESERVE_ORDER) != 0) {
-		return unpack_map_create_list(pk, size, val);
+		return unpack_map_create_list(pk, size, val, ctx);
+	}
+
+	if ((flags & AS_PACKED_MAP_FLAG_K_ORDERED) != 0) {
+		return unpack_orderedmap(pk, size, val, flags, ctx);
 	}
 
-	as_hashmap *map = as_hashmap_new(size > 32 ? size : 32);
+	as_hashmap *map = unpack_map_create(size, ctx);
 
 	if (! map) {
 		return -2;
 	}
 
+	// Unpack all entries, then load them into the map in one go.
+	as_val *small[2 * 16];
+	as_val **keys = size <= 16 ? small : cf_malloc(2 * sizeof(as_val *) * size);
+
+	if (! keys) {
+		as_hashmap_destroy(map);
+		return -2;
+	}
+
+	as_val **vals = keys + size;
+	uint32_t count = 0;
+	int rc = 0;
+
 	for (uint32_t i = 0; i < size; i++) {
 		as_val *k = NULL;
 		as_val *v = NULL;
 
-		if (as_unpack_val(pk, &k) != 0) {
-			as_hashmap_destroy(map);
-			return -3;
+		if (unpack_val(pk, &k, ctx) != 0) {
+			rc = -3;
+			break;
 		}
 
-		if (as_unpack_val(pk, &v) != 0) {
+		if (unpack_val(pk, &v, ctx) != 0) {
 			as_val_destroy(k);
-			as_hashmap_destroy(map);
-			return -4;
+			rc = -4;
+			break;
 		}
 
 		if (k && v) {
-			if (as_hashmap_set(map, k, v) != 0) {
-				as_val_destroy(k);
-				as_val_destroy(v);
-				as_hashmap_destroy(map);
-				return -5;
-			}
- 		}
+			keys[count] = k;
+			vals[count] = v;
+			count++;
+		}
 		else {
 			as_val_destroy(k);
 			as_val_destroy(v);
 		}
 	}
 
+	if (rc == 0 && as_hashmap_load(map, keys, vals, count, ctx->unique_keys) != 0) {
+		rc = -5;
+	}
+
+	if (rc != 0) {
+		for (uint32_t i = 0; i < count; i++) {
+			as_val_destroy(keys[i]);
+			as_val_destroy(vals[i]);
+		}
+
+		as_hashmap_destroy(map);
+	}
+
+	if (keys != small) {
+		cf_free(keys);
+	}
+
+	if (rc != 0) {
+		return rc;
+	}
+
 	*val = (as_val *)map;
 	map->_.flags = flags;
 
 	return 0;
 }
 
-int
-as_unpack_val(as_unpacker *pk, as_val **val)
+static int
+unpack_val(as_unpacker *pk, as_val **val, const unpack_ctx *ctx)
 {
 	if (as_unpack_peek_is_ext(pk)) {
 		as_unpack_size(pk);
@@ -1027,83 +1542,139 @@ as_unpack_val(as_unpacker *pk, as_val **val)
 		return unpack_nil(val);
 
 	case 0xc3: // boolean true
-		return unpack_boolean(true, val);
+		return unpack_boolean(true, val, ctx);
 	case 0xc2: // boolean false
-		return unpack_boolean(false, val);
+		return unpack_boolean(false, val, ctx);
 
 	case 0xca: // float
-		return unpack_double_val((double)extract_float(pk), val);
+		return unpack_double_val((double)extract_float(pk), val, ctx);
 	case 0xcb: // double
-		return unpack_double_val(extract_double(pk), val);
+		return unpack_double_val(extract_double(pk), val, ctx);
 
 	case 0xd0: // signed 8 bit integer
 		return unpack_integer_val((int64_t)(int8_t)pk->buffer[pk->offset++],
-				val);
+				val, ctx);
 	case 0xcc: // unsigned 8 bit integer
-		return unpack_integer_val((int64_t)pk->buffer[pk->offset++], val);
+		return unpack_integer_val((int64_t)pk->buffer[pk->offset++],
+				val, ctx);
 
 	case 0xd1: // signed 16 bit integer
-		return unpack_integer_val((int64_t)(int16_t)extract_uint16(pk), val);
+		return unpack_integer_val((int64_t)(int16_t)extract_uint16(pk),
+				val, ctx);
 	case 0xcd: // unsigned 16 bit integer
-		return unpack_integer_val((int64_t)extract_uint16(pk), val);
+		return unpack_integer_val((int64_t)extract_uint16(pk), val, ctx);
 
 	case 0xd2: // signed 32 bit integer
-		return unpack_integer_val((int64_t)(int32_t)extract_uint32(pk), val);
+		return unpack_integer_val((int64_t)(int32_t)extract_uint32(pk),
+				val, ctx);
 	case 0xce: // unsigned 32 bit integer
-		return unpack_integer_val((int64_t)extract_uint32(pk), val);
+		return unpack_integer_val((int64_t)extract_uint32(pk), val, ctx);
 
 	case 0xd3: // signed 64 bit integer
 	case 0xcf: // unsigned 64 bit integer
-		return unpack_integer_val((int64_t)extract_uint64(pk), val);
+		return unpack_integer_val((int64_t)extract_uint64(pk), val, ctx);
 
 	case 0xc4:
 	case 0xd9: // string/raw bytes with 8 bit header
-		return unpack_blob(pk, (uint32_t)pk->buffer[pk->offset++], val);
+		return unpack_blob(pk, (uint32_t)pk->buffer[pk->offset++],
+				val, ctx);
 	case 0xc5:
 	case 0xda: // string/raw bytes with 16 bit header
-		return unpack_blob(pk, (uint32_t)extract_uint16(pk), val);
+		return unpack_blob(pk, (uint32_t)extract_uint16(pk),
+				val, ctx);
 	case 0xc6:
 	case 0xdb: // string/raw bytes with 32 bit header
-		return unpack_blob(pk, extract_uint32(pk), val);
+		return unpack_blob(pk, extract_uint32(pk), val, ctx);
 
 	case 0xdc: // list with 16 bit header
-		return unpack_list(pk, (uint32_t)extract_uint16(pk), val);
+		return unpack_list(pk, (uint32_t)extract_uint16(pk),
+				val, ctx);
 	case 0xdd: // list with 32 bit header
-		return unpack_list(pk, extract_uint32(pk), val);
+		return unpack_list(pk, extract_uint32(pk), val, ctx);
 
 	case 0xde: // map with 16 bit header
-		return unpack_map(pk, (uint32_t)extract_uint16(pk), val);
+		return unpack_map(pk, (uint32_t)extract_uint16(pk),
+				val, ctx);
 	case 0xdf: // map with 32 bit header
-		return unpack_map(pk, extract_uint32(pk), val);
+		return unpack_map(pk, extract_uint32(pk), val, ctx);
 
 	case 0xd4: // fixext 1
 		return unpack_ext(pk, type, val);
 
 	default:
 		if ((type & 0xe0) == 0xa0) { // raw bytes with 8 bit combined header
-			return unpack_blob(pk, (uint32_t)(type & 0x1f), val);
+			return unpack_blob(pk, (uint32_t)(type & 0x1f),
+					val, ctx);
 		}
 
 		if ((type & 0xf0) == 0x80) { // map with 8 bit combined header
-			return unpack_map(pk, (uint32_t)(type & 0x0f), val);
+			return unpack_map(pk, (uint32_t)(type & 0x0f),
+					val, ctx);
 		}
 
 		if ((type & 0xf0) == 0x90) { // list with 8 bit combined header
-			return unpack_list(pk, (uint32_t)(type & 0x0f), val);
+			return unpack_list(pk, (uint32_t)(type & 0x0f),
+					val, ctx);
 		}
 
 		if (type < 0x80) { // 8 bit combined unsigned integer
-			return unpack_integer_val((int64_t)type, val);
+			return unpack_integer_val((int64_t)type, val, ctx);
 		}
 
 		if (type >= 0xe0) { // 8 bit combined signed integer
-			return unpack_integer_val((int64_t)(type & 0x1f) - 32, val);
+			return unpack_integer_val((int64_t)(type & 0x1f) - 32,
+					val, ctx);
 		}
 
 		return -2;
 	}
 }
 
+int
+as_unpack_val(as_unpacker *pk, as_val **val)
+{
+	const unpack_ctx ctx = {
+			.backing = NULL,
+			.arena = NULL,
+	};
+
+	return unpack_val(pk, val, &ctx);
+}
+
+int
+as_unpack_val_borrowed(as_unpacker *pk, as_val **val)
+{
+	const unpack_ctx ctx = {
+			.backing = (void *)pk->buffer,
+			.arena = NULL,
+	};
+
+	return unpack_val(pk, val, &ctx);
+}
+
+int
+as_unpack_val_arena(as_unpacker *pk, as_val **val, as_arena *arena)
+{
+	const unpack_ctx ctx = {
+			.backing = NULL,
+			.arena = arena,
+	};
+
+	return unpack_val(pk, val, &ctx);
+}
+
+int
+as_unpack_val_trusted(as_unpacker *pk, as_val **val)
+{
+	const unpack_ctx ctx = {
+			.backing = NULL,
+			.arena = NULL,
+			.unique_keys = true,
+	};
+
+	return unpack_val(pk, val, &ctx);
+}
+
 /******************************************************************************
  * Pack direct functions
  ******************************************************************************/
@@ -1224,7 +1795,7 @@ as_pack_bytes(as_packer *pk, const uint8_t *buf, uint32_t sz)
 	int rc = pack_byte_array_header(pk, sz, AS_BYTES_BLOB);
 
 	if (rc == 0) {
-		rc = pack_append(pk, buf, sz, false);
+		rc = pack_append_ref(pk, buf, sz, false);
 	}
 	return rc;
 }
@@ -1272,7 +1843,7 @@ as_pack_str(as_packer *pk, const uint8_t *buf, uint32_t sz)
 	}
 
 	if (rc == 0 && buf) {
-		return pack_append(pk, buf, sz, false);
+		return pack_append_ref(pk, buf, sz, false);
 	}
 
 	return rc;
@@ -1294,7 +1865,7 @@ as_pack_bin(as_packer *pk, const uint8_t *buf, uint32_t sz)
 	}
 
 	if (rc == 0 && buf) {
-		return pack_append(pk, buf, sz, false);
+		return pack_append_ref(pk, buf, sz, false);
 	}
 
 	return rc;
@@ -1429,88 +2000,296 @@ as_pack_append(as_packer *pk, const unsigned char *buf, uint32_t sz)
  * Unpack direct functions
  ******************************************************************************/
 
-/**
- * Get size of list with ele_count elements.
- * Assume header already extracted.
- * @return -1 on failure
- */
-static int64_t
-unpack_list_elements_size(as_unpacker *pk, uint32_t ele_count, uint32_t depth)
+// How to skip an element, indexed by its type byte. For SKIP_FIXED the arg is
+// the element's total size, for SKIP_FIXLIST and SKIP_FIXMAP it is the element
+// count, and for the others it is the width of the length or count field.
+typedef enum {
+	SKIP_ERROR,
+	SKIP_FIXED,
+	SKIP_FIXLIST,
+	SKIP_FIXMAP,
+	SKIP_BLOB,
+	SKIP_EXT,
+	SKIP_LIST,
+	SKIP_MAP
+} skip_kind;
+
+typedef struct skip_entry_s {
+	uint8_t kind;
+	uint8_t arg;
+} skip_entry;
+
+#define F(n)	{ SKIP_FIXED, n }
+#define FL(n)	{ SKIP_FIXLIST, n }
+#define FM(n)	{ SKIP_FIXMAP, n }
+#define B(n)	{ SKIP_BLOB, n }
+#define E(n)	{ SKIP_EXT, n }
+#define L(n)	{ SKIP_LIST, n }
+#define M(n)	{ SKIP_MAP, n }
+#define X(n)	{ SKIP_ERROR, n }
+
+static const skip_entry skip_table[256] = {
+	// 0x00 positive fixint
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	// 0x10
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	// 0x20
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	// 0x30
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	// 0x40
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	// 0x50
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	// 0x60
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	// 0x70
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	// 0x80 fixmap
+	FM(0), FM(1), FM(2), FM(3), FM(4), FM(5), FM(6), FM(7),
+	FM(8), FM(9), FM(10), FM(11), FM(12), FM(13), FM(14), FM(15),
+	// 0x90 fixarray
+	FL(0), FL(1), FL(2), FL(3), FL(4), FL(5), FL(6), FL(7),
+	FL(8), FL(9), FL(10), FL(11), FL(12), FL(13), FL(14), FL(15),
+	// 0xa0 fixstr
+	F(1), F(2), F(3), F(4), F(5), F(6), F(7), F(8),
+	F(9), F(10), F(11), F(12), F(13), F(14), F(15), F(16),
+	// 0xb0
+	F(17), F(18), F(19), F(20), F(21), F(22), F(23), F(24),
+	F(25), F(26), F(27), F(28), F(29), F(30), F(31), F(32),
+	// 0xc0 nil, bool, bin, ext, float, uint
+	F(1), X(0), F(1), F(1), B(1), B(2), B(4), E(1),
+	E(2), E(4), F(5), F(9), F(2), F(3), F(5), F(9),
+	// 0xd0 int, fixext, str, array, map
+	F(2), F(3), F(5), F(9), F(3), F(4), F(6), F(10),
+	F(18), B(1), B(2), B(4), L(2), L(4), M(2), M(4),
+	// 0xe0 negative fixint
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	// 0xf0
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+	F(1), F(1), F(1), F(1), F(1), F(1), F(1), F(1),
+};
+
+#undef F
+#undef FL
+#undef FM
+#undef B
+#undef E
+#undef L
+#undef M
+#undef X
+
+// Fixints are the bytes 0x00-0x7f and 0xe0-0xff, i.e. signed bytes >= -32.
+static inline bool
+skip_is_fixint(uint8_t b)
 {
-	if (++depth > MSGPACK_COMPARE_MAX_DEPTH) {
-		msgpack_parse_memblock *block = msgpack_parse_memblock_create(NULL);
-		msgpack_parse_state *state = msgpack_parse_memblock_next(&block);
+	return (int8_t)b >= -32;
+}
 
-		state->index = 0;
-		state->map_pair = 0;
-		state->len = ele_count;
-		state->type = AS_LIST;
+// Length of the run of fixints at buf, up to max bytes.
+static uint64_t
+skip_fixint_run_scalar(const uint8_t *buf, uint64_t max)
+{
+	uint64_t i = 0;
 
-		int64_t ret = unpack_size_non_recursive(pk, block, state);
+	while (i < max && skip_is_fixint(buf[i])) {
+		i++;
+	}
 
-		msgpack_parse_memblock_destroy(block);
+	return i;
+}
 
-		return ret;
+#if defined(__x86_64__) && defined(__GNUC__)
+static uint64_t
+skip_fixint_run_sse2(const uint8_t *buf, uint64_t max)
+{
+	const __m128i limit = _mm_set1_epi8(-33);
+	uint64_t i = 0;
+
+	while (i + 16 <= max) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(v, limit));
+
+		if (mask != 0xffff) {
+			return i + (uint64_t)__builtin_ctz(~mask);
+		}
+
+		i += 16;
 	}
 
-	int64_t total = 0;
+	return i + skip_fixint_run_scalar(buf + i, max - i);
+}
 
-	for (uint32_t i = 0; i < ele_count; i++) {
-		int64_t ret = unpack_size_internal(pk, depth);
+__attribute__((target("avx2")))
+static uint64_t
+skip_fixint_run_avx2(const uint8_t *buf, uint64_t max)
+{
+	const __m256i limit = _mm256_set1_epi8(-33);
+	uint64_t i = 0;
 
-		if (ret < 0) {
-			return -1;
+	while (i + 32 <= max) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(buf + i));
+		uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+				_mm256_cmpgt_epi8(v, limit));
+
+		if (mask != 0xffffffff) {
+			return i + (uint64_t)__builtin_ctz(~mask);
 		}
 
-		total += ret;
+		i += 32;
 	}
 
-	return total;
+	return i + skip_fixint_run_sse2(buf + i, max - i);
+}
+
+static uint64_t (*skip_fixint_run)(const uint8_t *buf, uint64_t max) =
+		skip_fixint_run_sse2;
+
+// Pick the widest implementation the CPU supports once, at load time, so
+// skipping threads only ever read the pointer.
+__attribute__((constructor))
+static void
+skip_fixint_run_init(void)
+{
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2")) {
+		skip_fixint_run = skip_fixint_run_avx2;
+	}
 }
+#else
+#define skip_fixint_run skip_fixint_run_scalar
+#endif
 
 /**
- * Get size of map with ele_count elements.
- * Assume header already extracted.
- * @return negative on failure
+ * Skip n elements, nested elements included. Instead of recursing, keep a
+ * count of elements still to skip, to which each list and map header adds
+ * its members.
+ * @return size in bytes of the skipped elements, negative on failure
  */
 static int64_t
-unpack_map_elements_size(as_unpacker *pk, uint32_t ele_count, uint32_t depth)
+unpack_skip(as_unpacker *pk, uint64_t n)
 {
-	if (++depth > MSGPACK_COMPARE_MAX_DEPTH) {
-		msgpack_parse_memblock *block = msgpack_parse_memblock_create(NULL);
-		msgpack_parse_state *state = msgpack_parse_memblock_next(&block);
+	const uint8_t *buf = pk->buffer;
+	uint64_t length = pk->length;
+	uint64_t offset = pk->offset;
+	uint64_t pending = n;
 
-		state->index = 0;
-		state->map_pair = 0;
-		state->len = ele_count;
-		state->type = AS_MAP;
+	while (pending != 0) {
+		if (offset >= length) {
+			return -1;
+		}
 
-		int64_t ret = unpack_size_non_recursive(pk, block, state);
-		msgpack_parse_memblock_destroy(block);
+		uint8_t type = buf[offset];
 
-		return ret;
-	}
+		// Runs of small integers are common in lists, skip them in bulk.
+		if (skip_is_fixint(type)) {
+			uint64_t max = length - offset;
+
+			if (pending > 1 && max > 1 && skip_is_fixint(buf[offset + 1])) {
+				uint64_t run = skip_fixint_run(buf + offset,
+						pending < max ? pending : max);
+
+				offset += run;
+				pending -= run;
+			}
+			else {
+				offset++;
+				pending--;
+			}
+
+			continue;
+		}
+
+		// So are runs of short strings - each fixstr header holds its length.
+		if ((type & 0xe0) == 0xa0) {
+			do {
+				offset += 1 + (type & 0x1f);
+				pending--;
+			} while (pending != 0 && offset < length &&
+					((type = buf[offset]) & 0xe0) == 0xa0);
+
+			continue;
+		}
+
+		const skip_entry *e = &skip_table[type];
+		uint64_t count;
+
+		pending--;
+
+		switch (e->kind) {
+		case SKIP_FIXED:
+			offset += e->arg;
+			continue;
+		case SKIP_FIXLIST:
+			offset++;
+			pending += e->arg;
+			continue;
+		case SKIP_FIXMAP:
+			offset++;
+			pending += 2 * (uint64_t)e->arg;
+			continue;
+		case SKIP_ERROR:
+			return -2;
+		default:
+			break;
+		}
 
-	int64_t total = 0;
+		// Remaining kinds have a length or count field of e->arg bytes.
+		if (offset + 1 + e->arg > length) {
+			return -3;
+		}
 
-	for (uint32_t i = 0; i < ele_count; i++) {
-		int64_t ret = unpack_size_internal(pk, depth);
+		const uint8_t *p = buf + offset + 1;
 
-		if (ret < 0) {
-			return -1;
+		switch (e->arg) {
+		case 1:
+			count = p[0];
+			break;
+		case 2:
+			count = ((uint32_t)p[0] << 8) | p[1];
+			break;
+		default:
+			count = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+					((uint32_t)p[2] << 8) | p[3];
+			break;
 		}
 
-		total += ret;
-		ret = unpack_size_internal(pk, depth);
+		offset += 1 + e->arg;
 
-		if (ret < 0) {
-			return -2;
+		switch (e->kind) {
+		case SKIP_BLOB:
+			offset += count;
+			break;
+		case SKIP_EXT:
+			offset += 1 + count;
+			break;
+		case SKIP_LIST:
+			pending += count;
+			break;
+		default: // SKIP_MAP
+			pending += 2 * count;
+			break;
 		}
+	}
 
-		total += ret;
+	if (offset > length) {
+		return -4;
 	}
 
-	return total;
+	int64_t size = (int64_t)(offset - pk->offset);
+
+	pk->offset = (uint32_t)offset;
+	return size;
 }
 
 static inline as_val_t
@@ -1642,232 +2421,6 @@ as_unpack_buf_peek_type(const uint8_t *buf, uint32_t size)
 	return as_unpack_peek_type(&pk);
 }
 
-static int64_t
-unpack_size_non_recursive(as_unpacker *pk, msgpack_parse_memblock *block,
-		msgpack_parse_state *state)
-{
-	int start = pk->offset;
-
-	while (state) {
-		while (state->index >= state->len) {
-			if (! msgpack_parse_memblock_has_prev(block)) {
-				return (int64_t)(pk->offset - start);
-			}
-
-			state = msgpack_parse_memblock_prev(&block);
-		}
-
-		if (state->type == AS_LIST) {
-			state->index++;
-		}
-		else if (state->type == AS_MAP) {
-			if (state->map_pair == 0) {
-				state->map_pair++;
-			}
-			else {
-				state->map_pair = 0;
-				state->index++;
-			}
-		}
-		else {
-			return -1;
-		}
-
-		as_val_t type = as_unpack_peek_type(pk);
-
-		if (type == AS_UNDEF) {
-			return -2;
-		}
-
-		if (type == AS_LIST ) {
-			state = msgpack_parse_memblock_next(&block);
-
-			if (! msgpack_parse_state_list_size_init(state, pk)) {
-				return -3;
-			}
-
-			continue;
-		}
-
-		if (type == AS_MAP) {
-			state = msgpack_parse_memblock_next(&block);
-
-			if (! msgpack_parse_state_map_size_init(state, pk)) {
-				return -4;
-			}
-
-			continue;
-		}
-
-		if (unpack_size_internal(pk, 0) < 0) {
-			return -5;
-		}
-	}
-
-	return -6;
-}
-
-static inline int64_t
-unpack_size_internal(as_unpacker *pk, uint32_t depth)
-{
-	if (pk->offset >= pk->length) {
-		return -1;
-	}
-
-	uint8_t type = pk->buffer[pk->offset++];
-
-	switch (type) {
-	case 0xc0: // nil
-	case 0xc3: // boolean true
-	case 0xc2: // boolean false
-		return 1;
-
-	case 0xd0: // signed 8 bit integer
-	case 0xcc: // unsigned 8 bit integer
-		pk->offset++;
-		return 1 + 1;
-
-	case 0xd1: // signed 16 bit integer
-	case 0xcd: // unsigned 16 bit integer
-		pk->offset += 2;
-		return 1 + 2;
-
-	case 0xca: // float
-	case 0xd2: // signed 32 bit integer
-	case 0xce: // unsigned 32 bit integer
-		pk->offset += 4;
-		return 1 + 4;
-
-	case 0xcb: // double
-	case 0xd3: // signed 64 bit integer
-	case 0xcf: // unsigned 64 bit integer
-		pk->offset += 8;
-		return 1 + 8;
-
-	case 0xc4:
-	case 0xd9: { // string/raw bytes with 8 bit header
-		uint8_t length = pk->buffer[pk->offset++];
-		pk->offset += length;
-		return 1 + 1 + length;
-	}
-
-	case 0xc5:
-	case 0xda: { // string/raw bytes with 16 bit header
-		uint16_t length = extract_uint16(pk);
-		pk->offset += length;
-		return 1 + 2 + length;
-	}
-
-	case 0xc6:
-	case 0xdb: { // string/raw bytes with 32 bit header
-		uint32_t length = extract_uint32(pk);
-		pk->offset += length;
-		return 1 + 4 + length;
-	}
-
-	case 0xdc: { // list with 16 bit header
-		uint16_t length = extract_uint16(pk);
-		int64_t ret = unpack_list_elements_size(pk, length, depth);
-		if (ret < 0) {
-			return -2;
-		}
-		return 1 + 2 + ret;
-	}
-
-	case 0xdd: { // list with 32 bit header
-		uint32_t length = extract_uint32(pk);
-		int64_t ret = unpack_list_elements_size(pk, length, depth);
-		if (ret < 0) {
-			return -3;
-		}
-		return 1 + 4 + ret;
-	}
-
-	case 0xde: { // map with 16 bit header
-		uint16_t length = extract_uint16(pk);
-		int64_t ret = unpack_map_elements_size(pk, length, depth);
-		if (ret < 0) {
-			return -4;
-		}
-		return 1 + 2 + ret;
-	}
-
-	case 0xdf: { // map with 32 bit header
-		uint32_t length = extract_uint32(pk);
-		int64_t ret = unpack_map_elements_size(pk, length, depth);
-		if (ret < 0) {
-			return -5;
-		}
-		return 1 + 4 + ret;
-	}
-
-	case 0xd4: // fixext 1
-		pk->offset += 1 + 1;
-		return 1 + 1 + 1;
-	case 0xd5: // fixext 2
-		pk->offset += 1 + 2;
-		return 1 + 1 + 2;
-	case 0xd6: // fixext 4
-		pk->offset += 1 + 4;
-		return 1 + 1 + 4;
-	case 0xd7: // fixext 8
-		pk->offset += 1 + 8;
-		return 1 + 1 + 8;
-	case 0xd8: // fixext 16
-		pk->offset += 1 + 16;
-		return 1 + 1 + 16;
-	case 0xc7: { // ext 8
-		uint8_t length = pk->buffer[pk->offset++];
-		pk->offset += 1 + length;
-		return 1 + 1 + 1 + length;
-	}
-	case 0xc8: { // ext 16
-		uint16_t length = extract_uint16(pk);
-		pk->offset += 1 + length;
-		return 1 + 2 + 1 + length;
-	}
-	case 0xc9: { // ext 32
-		uint32_t length = extract_uint32(pk);
-		pk->offset += 1 + length;
-		return 1 + 4 + 1 + length;
-	}
-	default:
-		break;
-	}
-
-	if ((type & 0xe0) == 0xa0) { // raw bytes with 8 bit combined header
-		int length = type & 0x1f;
-		pk->offset += length;
-		return 1 + length;
-	}
-
-	if ((type & 0xf0) == 0x80) { // map with 8 bit combined header
-		int64_t ret = unpack_map_elements_size(pk, type & 0x0f, depth);
-		if (ret < 0) {
-			return -6;
-		}
-		return 1 + ret;
-	}
-
-	if ((type & 0xf0) == 0x90) { // list with 8 bit combined header
-		int64_t ret = unpack_list_elements_size(pk, type & 0x0f, depth);
-		if (ret < 0) {
-			return -7;
-		}
-		return 1 + ret;
-	}
-
-	if (type < 0x80) { // 8 bit combined unsigned integer
-		return 1;
-	}
-
-	if (type >= 0xe0) { // 8 bit combined signed integer
-		return 1;
-	}
-
-	return -8;
-}
-
 int
 as_unpack_boolean(as_unpacker *pk, bool *value)
 {
@@ -1892,7 +2445,13 @@ as_unpack_nil(as_unpacker *pk)
 int64_t
 as_unpack_size(as_unpacker *pk)
 {
-	return unpack_size_internal(pk, 0);
+	return unpack_skip(pk, 1);
+}
+
+int64_t
+as_unpack_skip(as_unpacker *pk, uint32_t n)
+{
+	return unpack_skip(pk, n);
 }
 
 int64_t
@@ -2351,12 +2910,9 @@ msgpack_compare_blob_internal(as_unpacker *pk1, uint32_t len1, as_unpacker *pk2,
 	pk1->offset += len1;
 	pk2->offset += len2;
 
-	for (uint32_t i = 0; i < minlen; i++) {
-		unsigned char c1 = pk1->buffer[offset1++];
-		unsigned char c2 = pk2->buffer[offset2++];
+	int cmp = memcmp(pk1->buffer + offset1, pk2->buffer + offset2, minlen);
 
-		MSGPACK_COMPARE_RET_LESS_OR_GREATER(c1, c2);
-	}
+	MSGPACK_COMPARE_RET_LESS_OR_GREATER(cmp, 0);
 
 	MSGPACK_COMPARE_RET_LESS_OR_GREATER(len1, len2);
 
@@ -2388,13 +2944,7 @@ msgpack_compare_int64_t(int64_t x1, int64_t x2)
 static bool
 msgpack_skip(as_unpacker *pk, size_t n)
 {
-	for (size_t i = 0; i < n; i++) {
-		if (as_unpack_size(pk) < 0) {
-			return false;
-		}
-	}
-
-	return true;
+	return unpack_skip(pk, n) >= 0;
 }
 
 static bool
@@ -2450,27 +3000,56 @@ msgpack_compare_unwind_all(as_unpacker *pk1, as_unpacker *pk2,
 	return true;
 }
 
+// Compare a list or map without recursion, keeping parse states in block.
 static msgpack_compare_t
-msgpack_compare_list(as_unpacker *pk1, as_unpacker *pk2, size_t depth)
+msgpack_compare_nested(as_unpacker *pk1, as_unpacker *pk2,
+		msgpack_parse_memblock **block, as_val_t type)
 {
-	if (++depth > MSGPACK_COMPARE_MAX_DEPTH) {
-		msgpack_parse_memblock *block = msgpack_parse_memblock_create(NULL);
-		msgpack_parse_state *state = msgpack_parse_memblock_next(&block);
+	msgpack_parse_state *state = msgpack_parse_memblock_next(block);
+
+	if (! state) {
+		return MSGPACK_COMPARE_ERROR;
+	}
 
+	if (type == AS_LIST) {
 		if (! msgpack_parse_state_list_cmp_init(state, pk1, pk2)) {
-			msgpack_parse_memblock_destroy(block);
 			return MSGPACK_COMPARE_ERROR;
 		}
+	}
+	else {
+		if (! msgpack_parse_state_map_cmp_init(state, pk1, pk2)) {
+			return MSGPACK_COMPARE_ERROR;
+		}
+
+		if (state->default_compare_type != MSGPACK_COMPARE_EQUAL) {
+			return state->default_compare_type;
+		}
+	}
+
+	msgpack_compare_t ret = msgpack_compare_non_recursive(pk1, pk2, block,
+			state);
 
-		msgpack_compare_t ret = msgpack_compare_non_recursive(pk1, pk2, &block,
-				state);
+	if (ret == MSGPACK_COMPARE_ERROR ||
+			! msgpack_compare_unwind_all(pk1, pk2, block)) {
+		return MSGPACK_COMPARE_ERROR;
+	}
+
+	return ret;
+}
+
+static msgpack_compare_t
+msgpack_compare_list(as_unpacker *pk1, as_unpacker *pk2, size_t depth)
+{
+	if (++depth > MSGPACK_COMPARE_MAX_DEPTH) {
+		msgpack_parse_memblock *block = msgpack_parse_memblock_create(NULL);
 
-		if (ret == MSGPACK_COMPARE_ERROR ||
-				! msgpack_compare_unwind_all(pk1, pk2, &block)) {
-			msgpack_parse_memblock_destroy(block);
+		if (! block) {
 			return MSGPACK_COMPARE_ERROR;
 		}
 
+		msgpack_compare_t ret = msgpack_compare_nested(pk1, pk2, &block,
+				AS_LIST);
+
 		msgpack_parse_memblock_destroy(block);
 
 		return ret;
@@ -2520,26 +3099,13 @@ msgpack_compare_map(as_unpacker *pk1, as_unpacker *pk2, size_t depth)
 {
 	if (++depth > MSGPACK_COMPARE_MAX_DEPTH) {
 		msgpack_parse_memblock *block = msgpack_parse_memblock_create(NULL);
-		msgpack_parse_state *state = msgpack_parse_memblock_next(&block);
 
-		if (! msgpack_parse_state_map_cmp_init(state, pk1, pk2)) {
-			msgpack_parse_memblock_destroy(block);
+		if (! block) {
 			return MSGPACK_COMPARE_ERROR;
 		}
 
-		if (state->default_compare_type != MSGPACK_COMPARE_EQUAL) {
-			msgpack_parse_memblock_destroy(block);
-			return state->default_compare_type;
-		}
-
-		msgpack_compare_t ret = msgpack_compare_non_recursive(pk1, pk2, &block,
-				state);
-
-		if (ret == MSGPACK_COMPARE_ERROR ||
-				! msgpack_compare_unwind_all(pk1, pk2, &block)) {
-			msgpack_parse_memblock_destroy(block);
-			return MSGPACK_COMPARE_ERROR;
-		}
+		msgpack_compare_t ret = msgpack_compare_nested(pk1, pk2, &block,
+				AS_MAP);
 
 		msgpack_parse_memblock_destroy(block);
 
@@ -2647,6 +3213,8 @@ msgpack_compare_non_recursive(as_unpacker *pk1, as_unpacker *pk2,
 			}
 
 			if (! msgpack_parse_memblock_has_prev(*block)) {
+				// Already unwound, leave nothing for unwind_all.
+				(*block)->count = 0;
 				return state->default_compare_type;
 			}
 
@@ -2694,7 +3262,8 @@ msgpack_compare_non_recursive(as_unpacker *pk1, as_unpacker *pk2,
 		if (type == AS_LIST ) {
 			state = msgpack_parse_memblock_next(block);
 
-			if (! msgpack_parse_state_list_cmp_init(state, pk1, pk2)) {
+			if (! state ||
+					! msgpack_parse_state_list_cmp_init(state, pk1, pk2)) {
 				return MSGPACK_COMPARE_ERROR;
 			}
 
@@ -2704,7 +3273,8 @@ msgpack_compare_non_recursive(as_unpacker *pk1, as_unpacker *pk2,
 		if (type == AS_MAP) {
 			state = msgpack_parse_memblock_next(block);
 
-			if (! msgpack_parse_state_map_cmp_init(state, pk1, pk2)) {
+			if (! state ||
+					! msgpack_parse_state_map_cmp_init(state, pk1, pk2)) {
 				return MSGPACK_COMPARE_ERROR;
 			}
 
@@ -2722,6 +3292,7 @@ msgpack_compare_non_recursive(as_unpacker *pk1, as_unpacker *pk2,
 			}
 
 			if (! msgpack_parse_memblock_has_prev(*block)) {
+				(*block)->count = 0;
 				return MSGPACK_COMPARE_EQUAL;
 			}
 
@@ -2814,6 +3385,25 @@ msgpack_compare_internal(as_unpacker *pk1, as_unpacker *pk2, size_t depth,
 	return msgpack_compare_type(pk1, pk2, *type, depth);
 }
 
+// Byte identical scalars are equal under any collation, skip parsing them.
+static inline bool
+msgpack_compare_identical_scalar(const as_unpacker *pk1, const as_unpacker *pk2)
+{
+	uint32_t n = pk1->length - pk1->offset;
+
+	if (n == 0 || n != pk2->length - pk2->offset) {
+		return false;
+	}
+
+	as_val_t type = as_unpack_peek_type(pk1);
+
+	if (type == AS_UNDEF || type == AS_LIST || type == AS_MAP) {
+		return false;
+	}
+
+	return memcmp(pk1->buffer + pk1->offset, pk2->buffer + pk2->offset, n) == 0;
+}
+
 msgpack_compare_t
 as_unpack_buf_compare(const uint8_t *buf1, uint32_t size1, const uint8_t *buf2,
 		uint32_t size2)
@@ -2828,11 +3418,72 @@ as_unpack_buf_compare(const uint8_t *buf1, uint32_t size1, const uint8_t *buf2,
 			.offset = 0,
 			.length = size2
 	};
+
+	if (msgpack_compare_identical_scalar(&pk1, &pk2)) {
+		return MSGPACK_COMPARE_EQUAL;
+	}
+
 	as_val_t type;
 
 	return msgpack_compare_internal(&pk1, &pk2, 0, &type);
 }
 
+size_t
+as_unpack_compare_scratch_size(uint32_t max_depth)
+{
+	return sizeof(void *) + sizeof(msgpack_parse_memblock) +
+			(size_t)(max_depth != 0 ? max_depth : 1) *
+			sizeof(msgpack_parse_state);
+}
+
+msgpack_compare_t
+as_unpack_compare_scratch(as_unpacker *pk1, as_unpacker *pk2, void *scratch,
+		size_t scratch_size)
+{
+	as_val_t type;
+	msgpack_compare_t ret = msgpack_peek_compare_type(pk1, pk2, &type);
+
+	if (ret == MSGPACK_COMPARE_ERROR || ret == MSGPACK_COMPARE_END) {
+		return ret;
+	}
+
+	if (ret != MSGPACK_COMPARE_EQUAL || (type != AS_LIST && type != AS_MAP)) {
+		// Scalars, and mismatched types, never need parse state.
+		return msgpack_compare_internal(pk1, pk2, 0, &type);
+	}
+
+	msgpack_parse_memblock *block =
+			msgpack_parse_memblock_init_fixed(scratch, scratch_size);
+
+	if (! block) {
+		return MSGPACK_COMPARE_ERROR;
+	}
+
+	return msgpack_compare_nested(pk1, pk2, &block, type);
+}
+
+msgpack_compare_t
+as_unpack_buf_compare_scratch(const uint8_t *buf1, uint32_t size1,
+		const uint8_t *buf2, uint32_t size2, void *scratch, size_t scratch_size)
+{
+	as_unpacker pk1 = {
+			.buffer = buf1,
+			.offset = 0,
+			.length = size1
+	};
+	as_unpacker pk2 = {
+			.buffer = buf2,
+			.offset = 0,
+			.length = size2
+	};
+
+	if (msgpack_compare_identical_scalar(&pk1, &pk2)) {
+		return MSGPACK_COMPARE_EQUAL;
+	}
+
+	return as_unpack_compare_scratch(&pk1, &pk2, scratch, scratch_size);
+}
+
 msgpack_compare_t
 as_unpack_compare(as_unpacker *pk1, as_unpacker *pk2)
 {
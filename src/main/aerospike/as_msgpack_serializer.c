@@ -30,6 +30,7 @@ static void     as_msgpack_serializer_destroy(as_serializer *);
 static int      as_msgpack_serializer_serialize(as_serializer *, const as_val *, as_buffer *);
 static int32_t	as_msgpack_serializer_serialize_presized(as_serializer *, const as_val *, uint8_t *);
 static int      as_msgpack_serializer_deserialize(as_serializer *, as_buffer *, as_val **);
+static int      as_msgpack_serializer_deserialize_arena(as_serializer *, as_buffer *, as_val **);
 static uint32_t as_msgpack_serializer_serialize_getsize(as_serializer *, const as_val *);
 
 /******************************************************************************
@@ -44,6 +45,14 @@ static const as_serializer_hooks as_msgpack_serializer_hooks = {
 		.serialize_getsize = as_msgpack_serializer_serialize_getsize,
 };
 
+static const as_serializer_hooks as_msgpack_arena_serializer_hooks = {
+		.destroy           = as_msgpack_serializer_destroy,
+		.serialize         = as_msgpack_serializer_serialize,
+		.serialize_presized= as_msgpack_serializer_serialize_presized,
+		.deserialize       = as_msgpack_serializer_deserialize_arena,
+		.serialize_getsize = as_msgpack_serializer_serialize_getsize,
+};
+
 /******************************************************************************
  * FUNCTIONS
  *****************************************************************************/
@@ -59,6 +68,13 @@ as_serializer *as_msgpack_init(as_serializer *s)
 	return s;
 }
 
+as_serializer *as_msgpack_arena_init(as_msgpack_arena_serializer *s, as_arena *arena)
+{
+	as_serializer_init(&s->_, &as_msgpack_arena_serializer_hooks);
+	s->arena = arena;
+	return &s->_;
+}
+
 /******************************************************************************
  * STATIC FUNCTIONS
  *****************************************************************************/
@@ -106,81 +122,31 @@ static int32_t as_msgpack_serializer_serialize_presized(as_serializer *s, const
 
 static int as_msgpack_serializer_serialize(as_serializer *s, const as_val *v, as_buffer *buff)
 {
+	// Pack in a single pass into one buffer grown by doubling, which is then
+	// handed to the caller without a copy.
 	as_packer packer = {
 			.buffer = (unsigned char *)cf_malloc(AS_PACKER_BUFFER_SIZE),
 			.capacity = AS_PACKER_BUFFER_SIZE,
 			.offset = 0,
 			.head = 0,
 			.tail = 0,
+			.contiguous = true,
 	};
 
 	if (! packer.buffer) {
 		return 1;
 	}
 
-    int rc = as_pack_val(&packer, v);
-	
+	int rc = as_pack_val(&packer, v);
+
 	if (rc != 0) {
-		// Cleanup buffers on error.
-		as_packer_buffer *p = packer.head;
-		as_packer_buffer *tmp;
-
-		while (p) {
-			tmp = p;
-			p = p->next;
-			
-			// Free buffer entry.
-			cf_free(tmp->buffer);
-			cf_free(tmp);
-		}
-
-		// Free main buffer.
 		cf_free(packer.buffer);
 		return rc;
 	}
 
-	if (packer.head) {
-		// Combine buffers into a single contiguous buffer.
-		as_packer_buffer *p = packer.head;
-		int size = packer.offset;
-
-		while (p) {
-			size += p->length;
-			p = p->next;
-		}
-
-		unsigned char *target = (unsigned char *)cf_malloc(size);
-		p = packer.head;
-		int offset = 0;
-
-		while (p) {
-			memcpy(target + offset, p->buffer, p->length);
-			offset += p->length;
-			
-			as_packer_buffer *tmp = p;
-			p = p->next;
-			
-			// Free original buffer entry.
-			cf_free(tmp->buffer);
-			cf_free(tmp);
-		}
-
-		memcpy(target + offset, packer.buffer, packer.offset);
-
-		// Free original main buffer.
-		cf_free(packer.buffer);
-
-		// Transfer new buffer.
-		buff->data = target;
-		buff->size = size;
-		buff->capacity = size;
-	}
-	else {
-		// Use existing buffer directly.
-		buff->data = packer.buffer;
-		buff->size = packer.offset;
-		buff->capacity = packer.capacity;
-	}
+	buff->data = packer.buffer;
+	buff->size = packer.offset;
+	buff->capacity = packer.capacity;
 	return 0;
 }
 
@@ -194,3 +160,14 @@ static int as_msgpack_serializer_deserialize(as_serializer *s, as_buffer *buff,
 
 	return as_unpack_val(&unpacker, v);
 }
+
+static int as_msgpack_serializer_deserialize_arena(as_serializer *s, as_buffer *buff, as_val **v)
+{
+	as_unpacker unpacker = {
+			.buffer = buff->data,
+			.length = buff->size,
+			.offset = 0,
+	};
+
+	return as_unpack_val_arena(&unpacker, v, ((as_msgpack_arena_serializer *)s)->arena);
+}
@@ -0,0 +1,323 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_msgpack_sort.h>
+#include <aerospike/as_msgpack.h>
+
+#include <citrusleaf/alloc.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/******************************************************************************
+ *	TYPES
+ *****************************************************************************/
+
+// A slice with its precomputed sort key.
+typedef struct sort_item_s {
+	const uint8_t *data;
+	uint32_t size;
+	uint32_t index;		// original position, breaks ties
+	as_val_t type;
+	bool has_key;		// key (and len, particle_type) are set
+	uint8_t particle_type;	// blob particle type, breaks ties between blobs
+	uint32_t len;		// blob length, without the particle type byte
+	union {
+		int64_t i;
+		double d;
+		uint64_t prefix;	// first 8 blob bytes, big-endian, zero padded
+	} key;
+	as_msgpack_slice slice;
+} sort_item;
+
+/******************************************************************************
+ *	STATIC FUNCTIONS
+ *****************************************************************************/
+
+static inline bool
+sort_is_blob(uint8_t header)
+{
+	return (header & 0xe0) == 0xa0 || (header >= 0xc4 && header <= 0xc6) ||
+			(header >= 0xd9 && header <= 0xdb);
+}
+
+static int
+sort_item_init(sort_item *item, const uint8_t *buf, const as_msgpack_slice *slice, uint32_t index)
+{
+	item->data = buf + slice->offset;
+	item->size = slice->size;
+	item->index = index;
+	item->has_key = false;
+	item->slice = *slice;
+
+	as_unpacker pk = {
+			.buffer = item->data,
+			.offset = 0,
+			.length = item->size,
+	};
+
+	int64_t size = as_unpack_size(&pk);
+
+	if (size <= 0 || size > item->size) {
+		return -1;
+	}
+
+	pk.offset = 0;
+	item->particle_type = 0;
+
+	if (sort_is_blob(item->data[0])) {
+		uint32_t size;
+		const uint8_t *p = as_unpack_bin(&pk, &size);
+
+		if (! p) {
+			return -5;
+		}
+
+		// An empty blob has no particle type byte - as_unpack_compare() can't
+		// compare it, so it goes first among blobs of its msgpack family.
+		if (size == 0) {
+			item->type = item->data[0] >= 0xc4 && item->data[0] <= 0xc6 ?
+					AS_BYTES : AS_STRING;
+			item->key.prefix = 0;
+			item->len = 0;
+			item->has_key = true;
+			return 0;
+		}
+
+		pk.offset = 0;
+	}
+
+	item->type = as_unpack_peek_type(&pk);
+
+	switch (item->type) {
+	case AS_NIL:
+		item->key.i = 0;
+		break;
+	case AS_BOOLEAN: {
+		bool b;
+
+		if (as_unpack_boolean(&pk, &b) != 0) {
+			return -2;
+		}
+
+		item->key.i = b;
+		break;
+	}
+	case AS_INTEGER:
+		if (as_unpack_int64(&pk, &item->key.i) != 0) {
+			return -3;
+		}
+		break;
+	case AS_DOUBLE:
+		if (as_unpack_double(&pk, &item->key.d) != 0) {
+			return -4;
+		}
+		break;
+	case AS_STRING:
+	case AS_BYTES:
+	case AS_GEOJSON: {
+		uint32_t size;
+		const uint8_t *p = as_unpack_bin(&pk, &size);
+
+		if (! p) {
+			return -5;
+		}
+
+		// as_unpack_compare() skips the particle type byte - keep it aside
+		// to order blobs that are otherwise equal.
+		item->particle_type = p[0];
+		p++;
+		size--;
+
+		uint64_t prefix = 0;
+
+		for (uint32_t i = 0; i < 8; i++) {
+			prefix = (prefix << 8) | (i < size ? p[i] : 0);
+		}
+
+		item->key.prefix = prefix;
+		item->len = size;
+		break;
+	}
+	case AS_UNDEF:
+	case AS_CMP_WILDCARD:
+	case AS_CMP_INF:
+		// Comparison specials are for queries, not data - a wildcard equals
+		// anything, which no sort order can satisfy.
+		return -6;
+	default:
+		// Lists and maps are compared in full.
+		return 0;
+	}
+
+	item->has_key = true;
+	return 0;
+}
+
+#define SORT_RET_LESS_OR_GREATER(arg1, arg2) { \
+	if (arg1 < arg2) { \
+		return -1; \
+	} \
+	if (arg1 > arg2) { \
+		return 1; \
+	} \
+}
+
+// as_unpack_compare() gives NaN no order - sort it after every other double.
+static inline int
+sort_compare_double(double d1, double d2)
+{
+	bool nan1 = d1 != d1;
+	bool nan2 = d2 != d2;
+
+	if (nan1 || nan2) {
+		return nan1 == nan2 ? 0 : (nan1 ? 1 : -1);
+	}
+
+	SORT_RET_LESS_OR_GREATER(d1, d2);
+	return 0;
+}
+
+// Items are ordered by type, then by key when both have one. The full
+// compare only breaks ties between keys, or orders lists and maps, so every
+// order used refines the same total order.
+static int
+sort_item_compare(const void *v1, const void *v2)
+{
+	const sort_item *x = v1;
+	const sort_item *y = v2;
+
+	SORT_RET_LESS_OR_GREATER(x->type, y->type);
+
+	bool full = ! x->has_key || ! y->has_key;
+
+	if (! full) {
+		switch (x->type) {
+		case AS_DOUBLE: {
+			int cmp = sort_compare_double(x->key.d, y->key.d);
+
+			if (cmp != 0) {
+				return cmp;
+			}
+			break;
+		}
+		case AS_STRING:
+		case AS_BYTES:
+		case AS_GEOJSON:
+			SORT_RET_LESS_OR_GREATER(x->key.prefix, y->key.prefix);
+
+			// Longer blobs differ past the prefix.
+			if (x->len > 8 && y->len > 8) {
+				full = true;
+				break;
+			}
+
+			SORT_RET_LESS_OR_GREATER(x->len, y->len);
+			SORT_RET_LESS_OR_GREATER(x->particle_type, y->particle_type);
+			break;
+		default:
+			SORT_RET_LESS_OR_GREATER(x->key.i, y->key.i);
+			break;
+		}
+	}
+
+	if (full) {
+		switch (as_unpack_buf_compare(x->data, x->size, y->data, y->size)) {
+		case MSGPACK_COMPARE_LESS:
+			return -1;
+		case MSGPACK_COMPARE_GREATER:
+			return 1;
+		default:
+			break;
+		}
+
+		if (x->has_key && y->has_key) {
+			SORT_RET_LESS_OR_GREATER(x->particle_type, y->particle_type);
+		}
+	}
+
+	SORT_RET_LESS_OR_GREATER(x->index, y->index);
+	return 0;
+}
+
+static int
+pack_slices(as_packer *pk, const uint8_t *buf, const as_msgpack_slice *slices, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++) {
+		if (as_pack_append(pk, buf + slices[i].offset, slices[i].size) != 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *	FUNCTIONS
+ *****************************************************************************/
+
+int
+as_msgpack_sort_slices(const uint8_t *buf, as_msgpack_slice *slices, uint32_t count)
+{
+	if (count < 2) {
+		return 0;
+	}
+
+	sort_item *items = cf_malloc(count * sizeof(sort_item));
+
+	if (! items) {
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (sort_item_init(&items[i], buf, &slices[i], i) != 0) {
+			cf_free(items);
+			return -2;
+		}
+	}
+
+	qsort(items, count, sizeof(sort_item), sort_item_compare);
+
+	for (uint32_t i = 0; i < count; i++) {
+		slices[i] = items[i].slice;
+	}
+
+	cf_free(items);
+	return 0;
+}
+
+int
+as_msgpack_pack_ordered_list(as_packer *pk, const uint8_t *buf, const as_msgpack_slice *slices, uint32_t count)
+{
+	if (as_pack_list_header(pk, count + 1) != 0 ||
+			as_pack_ext_header(pk, 0, AS_PACKED_LIST_FLAG_ORDERED) != 0) {
+		return -1;
+	}
+
+	return pack_slices(pk, buf, slices, count);
+}
+
+int
+as_msgpack_pack_ordered_map(as_packer *pk, const uint8_t *buf, const as_msgpack_slice *slices, uint32_t count)
+{
+	if (as_pack_map_header(pk, count + 1) != 0 ||
+			as_pack_ext_header(pk, 0, AS_PACKED_MAP_FLAG_K_ORDERED) != 0 ||
+			as_pack_nil(pk) != 0) {
+		return -1;
+	}
+
+	return pack_slices(pk, buf, slices, count);
+}
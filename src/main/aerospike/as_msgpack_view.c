@@ -0,0 +1,632 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_msgpack_view.h>
+#include <aerospike/as_msgpack.h>
+
+#include <citrusleaf/alloc.h>
+
+#include <string.h>
+
+/******************************************************************************
+ *	CONSTANTS
+ *****************************************************************************/
+
+// Keys up to this packed size are packed on the stack for lookups.
+#define VIEW_KEY_STACK_SIZE 256
+
+/******************************************************************************
+ *	STATIC FUNCTIONS
+ *****************************************************************************/
+
+// Move the cursor to the item at index, where an item is a list element or a
+// map pair. Returns the offset of the item, or negative on failure.
+static int64_t
+view_seek(as_msgpack_view *view, uint32_t index)
+{
+	if (index >= view->count) {
+		return -1;
+	}
+
+	if (index < view->cursor_index) {
+		view->cursor_index = 0;
+		view->cursor_offset = view->content_offset;
+	}
+
+	as_unpacker pk = {
+			.buffer = view->buffer,
+			.offset = view->cursor_offset,
+			.length = view->size,
+	};
+
+	uint32_t per_item = view->type == AS_MAP ? 2 : 1;
+
+	if (as_unpack_skip(&pk, (index - view->cursor_index) * per_item) < 0) {
+		return -2;
+	}
+
+	view->cursor_index = index;
+	view->cursor_offset = pk.offset;
+
+	return (int64_t)view->cursor_offset;
+}
+
+// Initialize elem over the element at offset and return the offset just past
+// it, or negative on failure.
+static int64_t
+view_element(const as_msgpack_view *view, uint32_t offset, as_msgpack_view *elem)
+{
+	as_unpacker pk = {
+			.buffer = view->buffer,
+			.offset = offset,
+			.length = view->size,
+	};
+
+	int64_t size = as_unpack_size(&pk);
+
+	if (size < 0) {
+		return -1;
+	}
+
+	if (elem && as_msgpack_view_init(elem, view->buffer + offset, (uint32_t)size) != 0) {
+		return -2;
+	}
+
+	return (int64_t)pk.offset;
+}
+
+// Offset of the item at i, found by skipping from the nearest recorded
+// offset. Returns negative on failure.
+static int64_t
+index_seek(const as_msgpack_index *index, uint32_t i)
+{
+	const as_msgpack_view *view = &index->view;
+
+	if (i >= view->count) {
+		return -1;
+	}
+
+	as_unpacker pk = {
+			.buffer = view->buffer,
+			.offset = index->offsets[i / index->step],
+			.length = view->size,
+	};
+
+	uint32_t per_item = view->type == AS_MAP ? 2 : 1;
+
+	if (as_unpack_skip(&pk, (i % index->step) * per_item) < 0) {
+		return -2;
+	}
+
+	return (int64_t)pk.offset;
+}
+
+// Compare the packed key at offset with key.
+static msgpack_compare_t
+index_compare_key(const as_msgpack_index *index, uint32_t offset, const uint8_t *key, uint32_t key_size)
+{
+	as_unpacker pk = {
+			.buffer = index->view.buffer,
+			.offset = offset,
+			.length = index->view.size,
+	};
+
+	as_unpacker pk_key = {
+			.buffer = key,
+			.offset = 0,
+			.length = key_size,
+	};
+
+	return as_unpack_compare(&pk, &pk_key);
+}
+
+static inline as_unpacker
+view_unpacker(const as_msgpack_view *view)
+{
+	as_unpacker pk = {
+			.buffer = view->buffer,
+			.offset = 0,
+			.length = view->size,
+	};
+
+	return pk;
+}
+
+/******************************************************************************
+ *	FUNCTIONS
+ *****************************************************************************/
+
+int
+as_msgpack_view_init(as_msgpack_view *view, const uint8_t *buf, uint32_t size)
+{
+	as_unpacker pk = {
+			.buffer = buf,
+			.offset = 0,
+			.length = size,
+	};
+
+	as_val_t type = as_unpack_peek_type(&pk);
+
+	if (type == AS_UNDEF) {
+		return -1;
+	}
+
+	view->buffer = buf;
+	view->size = size;
+	view->type = type;
+	view->count = 0;
+	view->flags = 0;
+
+	if (type == AS_LIST) {
+		int64_t count = as_unpack_list_header_element_count(&pk);
+
+		if (count < 0) {
+			return -2;
+		}
+
+		view->count = (uint32_t)count;
+	}
+	else if (type == AS_MAP) {
+		int64_t count = as_unpack_map_header_element_count(&pk);
+
+		if (count < 0) {
+			return -3;
+		}
+
+		// Skip ext element key which is only at the start for metadata.
+		if (count != 0 && as_unpack_peek_is_ext(&pk)) {
+			as_msgpack_ext ext;
+
+			if (as_unpack_ext(&pk, &ext) != 0 || as_unpack_size(&pk) < 0) {
+				return -4;
+			}
+
+			view->flags = ext.type;
+			count--;
+		}
+
+		view->count = (uint32_t)count;
+	}
+
+	view->content_offset = pk.offset;
+	view->cursor_index = 0;
+	view->cursor_offset = pk.offset;
+
+	return 0;
+}
+
+int
+as_msgpack_view_list_get(as_msgpack_view *view, uint32_t index, as_msgpack_view *elem)
+{
+	if (view->type != AS_LIST) {
+		return -1;
+	}
+
+	int64_t offset = view_seek(view, index);
+
+	if (offset < 0) {
+		return -2;
+	}
+
+	if (view_element(view, (uint32_t)offset, elem) < 0) {
+		return -3;
+	}
+
+	return 0;
+}
+
+int
+as_msgpack_view_map_get_pair(as_msgpack_view *view, uint32_t index, as_msgpack_view *key, as_msgpack_view *value)
+{
+	if (view->type != AS_MAP) {
+		return -1;
+	}
+
+	int64_t offset = view_seek(view, index);
+
+	if (offset < 0) {
+		return -2;
+	}
+
+	offset = view_element(view, (uint32_t)offset, key);
+
+	if (offset < 0) {
+		return -3;
+	}
+
+	if (value && view_element(view, (uint32_t)offset, value) < 0) {
+		return -4;
+	}
+
+	return 0;
+}
+
+int
+as_msgpack_view_map_find(as_msgpack_view *view, const uint8_t *key, uint32_t key_size, as_msgpack_view *value)
+{
+	if (view->type != AS_MAP) {
+		return -1;
+	}
+
+	bool k_ordered = (view->flags & AS_PACKED_MAP_FLAG_K_ORDERED) != 0;
+
+	as_unpacker pk = {
+			.buffer = view->buffer,
+			.offset = view->content_offset,
+			.length = view->size,
+	};
+
+	for (uint32_t i = 0; i < view->count; i++) {
+		as_unpacker pk_key = {
+				.buffer = key,
+				.offset = 0,
+				.length = key_size,
+		};
+
+		uint32_t start = pk.offset;
+		msgpack_compare_t cmp = as_unpack_compare(&pk, &pk_key);
+
+		if (cmp == MSGPACK_COMPARE_ERROR || cmp == MSGPACK_COMPARE_END) {
+			return -2;
+		}
+
+		if (cmp == MSGPACK_COMPARE_EQUAL) {
+			view->cursor_index = i;
+			view->cursor_offset = start;
+
+			if (value && view_element(view, pk.offset, value) < 0) {
+				return -3;
+			}
+
+			return 0;
+		}
+
+		if (k_ordered && cmp == MSGPACK_COMPARE_GREATER) {
+			return 1;
+		}
+
+		// The compare consumed the key, skip the value.
+		if (as_unpack_size(&pk) < 0) {
+			return -4;
+		}
+	}
+
+	return 1;
+}
+
+int
+as_msgpack_view_map_get(as_msgpack_view *view, const as_val *key, as_msgpack_view *value)
+{
+	// Size pass.
+	as_packer pk = {
+			.buffer = NULL,
+			.capacity = UINT32_MAX,
+	};
+
+	if (as_pack_val(&pk, key) != 0) {
+		return -1;
+	}
+
+	uint32_t size = pk.offset;
+	uint8_t stack_buf[VIEW_KEY_STACK_SIZE];
+	uint8_t *buf = size <= sizeof(stack_buf) ? stack_buf : cf_malloc(size);
+
+	if (! buf) {
+		return -2;
+	}
+
+	pk.buffer = buf;
+	pk.offset = 0;
+	pk.capacity = size;
+
+	int rc = as_pack_val(&pk, key) == 0 ?
+			as_msgpack_view_map_find(view, buf, size, value) : -3;
+
+	if (buf != stack_buf) {
+		cf_free(buf);
+	}
+
+	return rc;
+}
+
+int
+as_msgpack_view_get_bool(const as_msgpack_view *view, bool *value)
+{
+	if (view->type != AS_BOOLEAN) {
+		return -1;
+	}
+
+	as_unpacker pk = view_unpacker(view);
+
+	return as_unpack_boolean(&pk, value);
+}
+
+int
+as_msgpack_view_get_int64(const as_msgpack_view *view, int64_t *value)
+{
+	if (view->type != AS_INTEGER) {
+		return -1;
+	}
+
+	as_unpacker pk = view_unpacker(view);
+
+	return as_unpack_int64(&pk, value);
+}
+
+int
+as_msgpack_view_get_double(const as_msgpack_view *view, double *value)
+{
+	if (view->type != AS_DOUBLE) {
+		return -1;
+	}
+
+	as_unpacker pk = view_unpacker(view);
+
+	return as_unpack_double(&pk, value);
+}
+
+const char *
+as_msgpack_view_get_str(const as_msgpack_view *view, uint32_t *len)
+{
+	if (view->type != AS_STRING && view->type != AS_GEOJSON) {
+		return NULL;
+	}
+
+	as_unpacker pk = view_unpacker(view);
+	uint32_t size;
+	const uint8_t *p = as_unpack_str(&pk, &size);
+
+	if (! p || size == 0) {
+		return NULL;
+	}
+
+	// Skip the particle type byte.
+	*len = size - 1;
+	return (const char *)p + 1;
+}
+
+const uint8_t *
+as_msgpack_view_get_bytes(const as_msgpack_view *view, uint32_t *size, as_bytes_type *type)
+{
+	if (view->type != AS_BYTES) {
+		return NULL;
+	}
+
+	as_unpacker pk = view_unpacker(view);
+	uint32_t sz;
+	const uint8_t *p = as_unpack_bin(&pk, &sz);
+
+	if (! p) {
+		return NULL;
+	}
+
+	if (sz == 0) {
+		*size = 0;
+
+		if (type) {
+			*type = AS_BYTES_UNDEF;
+		}
+
+		return p;
+	}
+
+	// Skip the particle type byte.
+	*size = sz - 1;
+
+	if (type) {
+		*type = (as_bytes_type)p[0];
+	}
+
+	return p + 1;
+}
+
+as_val *
+as_msgpack_view_to_val(const as_msgpack_view *view)
+{
+	as_unpacker pk = view_unpacker(view);
+	as_val *val = NULL;
+
+	if (as_unpack_val(&pk, &val) != 0) {
+		return NULL;
+	}
+
+	return val;
+}
+
+int
+as_msgpack_index_init(as_msgpack_index *index, const as_msgpack_view *view, uint32_t step)
+{
+	if (view->type != AS_LIST && view->type != AS_MAP) {
+		return -1;
+	}
+
+	if (step == 0) {
+		step = AS_MSGPACK_INDEX_STEP;
+	}
+
+	uint32_t offsets_count = (uint32_t)(((uint64_t)view->count + step - 1) / step);
+	uint32_t *offsets = NULL;
+
+	if (offsets_count != 0) {
+		offsets = cf_malloc(offsets_count * sizeof(uint32_t));
+
+		if (! offsets) {
+			return -2;
+		}
+	}
+
+	as_unpacker pk = {
+			.buffer = view->buffer,
+			.offset = view->content_offset,
+			.length = view->size,
+	};
+
+	uint64_t stride = (uint64_t)step * (view->type == AS_MAP ? 2 : 1);
+
+	// Skip a whole stride at a time, the last one may be short.
+	for (uint32_t i = 0; i < offsets_count; i++) {
+		offsets[i] = pk.offset;
+
+		if (i + 1 < offsets_count && as_unpack_skip(&pk, (uint32_t)stride) < 0) {
+			cf_free(offsets);
+			return -3;
+		}
+	}
+
+	index->view = *view;
+	index->step = step;
+	index->offsets = offsets;
+	index->offsets_count = offsets_count;
+
+	return 0;
+}
+
+void
+as_msgpack_index_destroy(as_msgpack_index *index)
+{
+	cf_free(index->offsets);
+	index->offsets = NULL;
+	index->offsets_count = 0;
+}
+
+int
+as_msgpack_index_list_get(const as_msgpack_index *index, uint32_t i, as_msgpack_view *elem)
+{
+	if (index->view.type != AS_LIST) {
+		return -1;
+	}
+
+	int64_t offset = index_seek(index, i);
+
+	if (offset < 0) {
+		return -2;
+	}
+
+	if (view_element(&index->view, (uint32_t)offset, elem) < 0) {
+		return -3;
+	}
+
+	return 0;
+}
+
+int
+as_msgpack_index_map_get_pair(const as_msgpack_index *index, uint32_t i, as_msgpack_view *key, as_msgpack_view *value)
+{
+	if (index->view.type != AS_MAP) {
+		return -1;
+	}
+
+	int64_t offset = index_seek(index, i);
+
+	if (offset < 0) {
+		return -2;
+	}
+
+	offset = view_element(&index->view, (uint32_t)offset, key);
+
+	if (offset < 0) {
+		return -3;
+	}
+
+	if (value && view_element(&index->view, (uint32_t)offset, value) < 0) {
+		return -4;
+	}
+
+	return 0;
+}
+
+int
+as_msgpack_index_map_find(const as_msgpack_index *index, const uint8_t *key, uint32_t key_size, as_msgpack_view *value)
+{
+	const as_msgpack_view *view = &index->view;
+
+	if (view->type != AS_MAP) {
+		return -1;
+	}
+
+	if ((view->flags & AS_PACKED_MAP_FLAG_K_ORDERED) == 0) {
+		// Unordered keys can't be searched, scan a copy of the view.
+		as_msgpack_view scan = *view;
+		return as_msgpack_view_map_find(&scan, key, key_size, value);
+	}
+
+	if (index->offsets_count == 0) {
+		return 1;
+	}
+
+	// Find the last block whose first key is not greater than key.
+	uint32_t lo = 0;
+	uint32_t hi = index->offsets_count;
+
+	while (hi - lo > 1) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		msgpack_compare_t cmp = index_compare_key(index, index->offsets[mid], key, key_size);
+
+		if (cmp == MSGPACK_COMPARE_ERROR || cmp == MSGPACK_COMPARE_END) {
+			return -2;
+		}
+
+		if (cmp == MSGPACK_COMPARE_GREATER) {
+			hi = mid;
+		}
+		else {
+			lo = mid;
+		}
+	}
+
+	// Scan the block.
+	as_unpacker pk = {
+			.buffer = view->buffer,
+			.offset = index->offsets[lo],
+			.length = view->size,
+	};
+
+	uint32_t end = (lo + 1) * index->step;
+
+	if (end > view->count) {
+		end = view->count;
+	}
+
+	for (uint32_t i = lo * index->step; i < end; i++) {
+		msgpack_compare_t cmp = index_compare_key(index, pk.offset, key, key_size);
+
+		if (cmp == MSGPACK_COMPARE_ERROR || cmp == MSGPACK_COMPARE_END) {
+			return -3;
+		}
+
+		if (cmp == MSGPACK_COMPARE_GREATER) {
+			return 1;
+		}
+
+		if (as_unpack_size(&pk) < 0) {
+			return -4;
+		}
+
+		if (cmp == MSGPACK_COMPARE_EQUAL) {
+			if (value && view_element(view, pk.offset, value) < 0) {
+				return -5;
+			}
+
+			return 0;
+		}
+
+		if (as_unpack_size(&pk) < 0) {
+			return -6;
+		}
+	}
+
+	return 1;
+}
@@ -0,0 +1,437 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_hashmap_key.h>
+#include <aerospike/as_map.h>
+#include <aerospike/as_nil.h>
+#include <aerospike/as_openmap.h>
+#include <aerospike/as_val.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_hash_math.h>
+#include <stddef.h>
+#include <string.h>
+
+/*******************************************************************************
+ *	EXTERNS
+ ******************************************************************************/
+
+extern const as_map_hooks as_openmap_map_hooks;
+
+/******************************************************************************
+ *	STATIC FUNCTIONS
+ ******************************************************************************/
+
+// Slots needed to hold count entries under the maximum load, 0 if too many.
+static uint32_t openmap_capacity_for(uint32_t count)
+{
+	uint64_t needed = ((uint64_t)count * 8 + AS_OPENMAP_MAX_LOAD - 1) / AS_OPENMAP_MAX_LOAD;
+	uint64_t capacity = AS_OPENMAP_MIN_CAPACITY;
+
+	while (capacity < needed) {
+		capacity *= 2;
+	}
+
+	return capacity > 0x80000000 ? 0 : (uint32_t)capacity;
+}
+
+static inline bool openmap_full(const as_openmap * map, uint32_t count)
+{
+	return (uint64_t)count * 8 > (uint64_t)map->capacity * AS_OPENMAP_MAX_LOAD;
+}
+
+// Slots are picked by the low bits - remix in case a key type's hashcode is
+// weak there.
+static inline uint32_t openmap_hash(uint32_t key_hash)
+{
+	return cf_hash_mix32(key_hash);
+}
+
+static as_openmap_slot * openmap_find(const as_openmap * map, const as_val * k, uint32_t h)
+{
+	uint32_t mask = map->capacity - 1;
+	uint32_t i = h & mask;
+
+	for (uint32_t dist = 1; ; dist++) {
+		as_openmap_slot * s = &map->slots[i];
+
+		// An empty slot, or one closer to its home than we are to ours, ends
+		// the probe - our key would have displaced it.
+		if (s->dist < dist) {
+			return NULL;
+		}
+
+		if (s->hash == h && as_hashmap_key_eq(s->p_key, k)) {
+			return s;
+		}
+
+		i = (i + 1) & mask;
+	}
+}
+
+// Place an entry known not to be in the table.
+static void openmap_place(as_openmap_slot * slots, uint32_t mask, as_openmap_slot e)
+{
+	uint32_t i = e.hash & mask;
+
+	e.dist = 1;
+
+	while (true) {
+		as_openmap_slot * s = &slots[i];
+
+		if (s->dist == 0) {
+			*s = e;
+			return;
+		}
+
+		// Take from the rich: the entry further from home gets the slot and
+		// the displaced one continues probing.
+		if (s->dist < e.dist) {
+			as_openmap_slot t = *s;
+			*s = e;
+			e = t;
+		}
+
+		e.dist++;
+		i = (i + 1) & mask;
+	}
+}
+
+static int openmap_resize(as_openmap * map, uint32_t capacity)
+{
+	as_openmap_slot * slots = (as_openmap_slot *)cf_malloc(capacity * sizeof(as_openmap_slot));
+
+	if (! slots) {
+		return -1;
+	}
+
+	memset(slots, 0, capacity * sizeof(as_openmap_slot));
+
+	for (uint32_t i = 0; i < map->capacity; i++) {
+		if (map->slots[i].dist != 0) {
+			openmap_place(slots, capacity - 1, map->slots[i]);
+		}
+	}
+
+	cf_free(map->slots);
+	map->slots = slots;
+	map->capacity = capacity;
+
+	return 0;
+}
+
+static as_openmap * as_openmap_cons(as_openmap * map, uint32_t capacity)
+{
+	map->count = 0;
+	map->hash_valid = false;
+	map->hash = 0;
+	map->capacity = openmap_capacity_for(capacity);
+
+	if (map->capacity == 0) {
+		return NULL;
+	}
+
+	size_t size = map->capacity * sizeof(as_openmap_slot);
+
+	map->slots = (as_openmap_slot *)cf_malloc(size);
+
+	if (! map->slots) {
+		return NULL;
+	}
+
+	memset(map->slots, 0, size);
+
+	return map;
+}
+
+/******************************************************************************
+ *	INSTANCE FUNCTIONS
+ ******************************************************************************/
+
+as_openmap * as_openmap_init(as_openmap * map, uint32_t capacity)
+{
+	if (! map) {
+		return NULL;
+	}
+
+	as_map_cons((as_map *)map, false, 0, &as_openmap_map_hooks);
+
+	return as_openmap_cons(map, capacity);
+}
+
+as_openmap * as_openmap_new(uint32_t capacity)
+{
+	as_openmap * map = (as_openmap *)cf_malloc(sizeof(as_openmap));
+
+	if (! map) {
+		return NULL;
+	}
+
+	as_map_cons((as_map *)map, true, 0, &as_openmap_map_hooks);
+
+	if (! as_openmap_cons(map, capacity)) {
+		cf_free(map);
+		return NULL;
+	}
+
+	return map;
+}
+
+bool as_openmap_release(as_openmap * map)
+{
+	if (! map) {
+		return false;
+	}
+
+	as_openmap_clear(map);
+	cf_free(map->slots);
+	map->slots = NULL;
+	map->capacity = 0;
+
+	return true;
+}
+
+void as_openmap_destroy(as_openmap * map)
+{
+	as_map_destroy((as_map *)map);
+}
+
+/******************************************************************************
+ *	INFO FUNCTIONS
+ ******************************************************************************/
+
+// Published as by as_hashmap_hashcode().
+uint32_t as_openmap_hashcode(const as_openmap * map)
+{
+	if (as_load_uint8((const uint8_t *)&map->hash_valid)) {
+		as_fence_lock();
+		return cf_hash_mix32(as_load_uint32(&map->hash) + map->count);
+	}
+
+	uint32_t hash = 0;
+	bool cacheable = true;
+
+	for (uint32_t i = 0; i < map->capacity; i++) {
+		const as_openmap_slot * s = &map->slots[i];
+
+		if (s->dist != 0) {
+			hash += as_hashmap_entry_hash(as_val_hashcode(s->p_key), s->p_val);
+			cacheable = cacheable && as_hashmap_entry_cacheable(s->p_key, s->p_val);
+		}
+	}
+
+	if (cacheable) {
+		as_store_uint32((uint32_t *)&map->hash, hash);
+		as_fence_store();
+		as_store_uint8((uint8_t *)&map->hash_valid, true);
+	}
+
+	return cf_hash_mix32(hash + map->count);
+}
+
+uint32_t as_openmap_size(const as_openmap * map)
+{
+	return map ? map->count : 0;
+}
+
+/*******************************************************************************
+ *	ACCESSOR & MODIFICATION FUNCTIONS
+ ******************************************************************************/
+
+int as_openmap_set(as_openmap * map, const as_val * k, const as_val * v)
+{
+	if (! map) {
+		return -1;
+	}
+
+	if (! as_hashmap_key_valid(k)) {
+		return -1;
+	}
+
+	as_val * safe_v = (as_val *)(v ? v : &as_nil);
+	uint32_t key_hash = as_val_hashcode(k);
+	uint32_t h = openmap_hash(key_hash);
+	as_openmap_slot * s = openmap_find(map, k, h);
+
+	if (! as_hashmap_entry_cacheable(k, safe_v)) {
+		map->hash_valid = false;
+	}
+
+	uint32_t entry_hash = map->hash_valid ?
+			as_hashmap_entry_hash(key_hash, safe_v) : 0;
+
+	// If we find our key, replace the existing key and value.
+	if (s) {
+		if (map->hash_valid) {
+			map->hash += entry_hash - as_hashmap_entry_hash(key_hash, s->p_val);
+		}
+
+		as_val_destroy(s->p_key);
+		as_val_destroy(s->p_val);
+		s->p_key = (as_val *)k;
+		s->p_val = safe_v;
+
+		return 0;
+	}
+
+	if (openmap_full(map, map->count + 1) &&
+			openmap_resize(map, map->capacity * 2) != 0) {
+		return -1;
+	}
+
+	as_openmap_slot e = {
+			.p_key = (as_val *)k,
+			.p_val = safe_v,
+			.hash = h
+	};
+
+	openmap_place(map->slots, map->capacity - 1, e);
+	map->count++;
+	map->hash += entry_hash;
+
+	return 0;
+}
+
+int as_openmap_reserve(as_openmap * map, uint32_t count)
+{
+	if (! map) {
+		return -1;
+	}
+
+	uint32_t capacity = openmap_capacity_for(count);
+
+	if (capacity == 0) {
+		return -1;
+	}
+
+	if (capacity <= map->capacity) {
+		return 0;
+	}
+
+	return openmap_resize(map, capacity);
+}
+
+as_val * as_openmap_get(const as_openmap * map, const as_val * k)
+{
+	if (! map) {
+		return NULL;
+	}
+
+	if (! as_hashmap_key_valid(k)) {
+		return NULL;
+	}
+
+	as_openmap_slot * s = openmap_find(map, k, openmap_hash(as_val_hashcode(k)));
+
+	return s ? s->p_val : NULL;
+}
+
+int as_openmap_clear(as_openmap * map)
+{
+	if (! map) {
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < map->capacity; i++) {
+		as_openmap_slot * s = &map->slots[i];
+
+		if (s->dist != 0) {
+			as_val_destroy(s->p_key);
+			as_val_destroy(s->p_val);
+		}
+	}
+
+	memset(map->slots, 0, map->capacity * sizeof(as_openmap_slot));
+	map->count = 0;
+	map->hash_valid = false;
+	map->hash = 0;
+
+	return 0;
+}
+
+int as_openmap_remove(as_openmap * map, const as_val * k)
+{
+	if (! map) {
+		return -1;
+	}
+
+	if (! as_hashmap_key_valid(k)) {
+		return -1;
+	}
+
+	uint32_t key_hash = as_val_hashcode(k);
+	as_openmap_slot * s = openmap_find(map, k, openmap_hash(key_hash));
+
+	if (! s) {
+		return 0;
+	}
+
+	map->count--;
+
+	if (map->hash_valid) {
+		map->hash -= as_hashmap_entry_hash(key_hash, s->p_val);
+	}
+
+	as_val_destroy(s->p_key);
+	as_val_destroy(s->p_val);
+
+	// Shift the following entries of the run back a slot, so no probe has to
+	// step over a hole.
+	uint32_t mask = map->capacity - 1;
+	uint32_t i = (uint32_t)(s - map->slots);
+
+	while (true) {
+		uint32_t next = (i + 1) & mask;
+		as_openmap_slot * n = &map->slots[next];
+
+		if (n->dist <= 1) {
+			break;
+		}
+
+		map->slots[i] = *n;
+		map->slots[i].dist--;
+		i = next;
+	}
+
+	memset(&map->slots[i], 0, sizeof(as_openmap_slot));
+
+	return 0;
+}
+
+/*******************************************************************************
+ *	ITERATION FUNCTIONS
+ ******************************************************************************/
+
+bool as_openmap_foreach(const as_openmap * map, as_map_foreach_callback callback, void * udata)
+{
+	if (! map) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < map->capacity; i++) {
+		as_openmap_slot * s = &map->slots[i];
+
+		if (s->dist == 0) {
+			continue;
+		}
+
+		if (! callback((const as_val *)s->p_key, (const as_val *)s->p_val, udata)) {
+			return false;
+		}
+	}
+
+	return true;
+}
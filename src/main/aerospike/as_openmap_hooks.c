@@ -0,0 +1,121 @@
+/* 
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_openmap.h>
+#include <aerospike/as_openmap_iterator.h>
+#include <aerospike/as_iterator.h>
+#include <aerospike/as_map.h>
+#include <aerospike/as_map_iterator.h>
+#include <aerospike/as_pair.h>
+#include <aerospike/as_val.h>
+
+/*******************************************************************************
+ *	EXTERN FUNCTIONS
+ ******************************************************************************/
+
+extern bool as_openmap_release(as_openmap * map);
+
+/*******************************************************************************
+ *	FUNCTIONS
+ ******************************************************************************/
+
+static bool _as_openmap_map_destroy(as_map * m) 
+{
+	return as_openmap_release((as_openmap *) m);
+}
+
+static uint32_t _as_openmap_map_hashcode(const as_map * m)
+{
+	return as_openmap_hashcode((const as_openmap *) m);
+}
+
+static int _as_openmap_map_set(as_map * m, const as_val * k, const as_val * v)
+{
+	return as_openmap_set((as_openmap *) m, k, v);
+}
+
+static as_val * _as_openmap_map_get(const as_map * m, const as_val * k)
+{
+	return as_openmap_get((as_openmap *) m, k);
+}
+
+static uint32_t _as_openmap_map_size(const as_map * m)
+{
+	return as_openmap_size((const as_openmap *) m);
+}
+
+static int _as_openmap_map_clear(as_map * m)
+{
+	return as_openmap_clear((as_openmap *) m);
+}
+
+static int _as_openmap_map_remove(as_map * m, const as_val * k)
+{
+	return as_openmap_remove((as_openmap *) m, k);
+}
+
+static bool _as_openmap_map_foreach(const as_map * m, as_map_foreach_callback callback, void * udata) 
+{
+	return as_openmap_foreach((const as_openmap *) m, callback, udata);
+}
+
+static as_map_iterator * _as_openmap_map_iterator_new(const as_map * m) 
+{
+	return (as_map_iterator *) as_openmap_iterator_new((const as_openmap *) m);
+}
+
+static as_map_iterator * _as_openmap_map_iterator_init(const as_map * m, as_map_iterator * it)
+{
+	return (as_map_iterator *) as_openmap_iterator_init((as_openmap_iterator *) it, (as_openmap *) m);
+}
+
+/*******************************************************************************
+ *	HOOKS
+ ******************************************************************************/
+
+const as_map_hooks as_openmap_map_hooks = {
+
+	/***************************************************************************
+	 *	instance hooks
+	 **************************************************************************/
+
+	.destroy	= _as_openmap_map_destroy,
+
+	/***************************************************************************
+	 *	info hooks
+	 **************************************************************************/
+
+	.hashcode	= _as_openmap_map_hashcode,
+	.size		= _as_openmap_map_size,
+
+	/***************************************************************************
+	 *	accessor and modifier hooks
+	 **************************************************************************/
+
+	.set		= _as_openmap_map_set,
+	.get		= _as_openmap_map_get,
+	.clear		= _as_openmap_map_clear,
+	.remove		= _as_openmap_map_remove,
+	
+	/***************************************************************************
+	 *	iteration hooks
+	 **************************************************************************/
+
+	.foreach		= _as_openmap_map_foreach,
+	.iterator_new	= _as_openmap_map_iterator_new,
+	.iterator_init	= _as_openmap_map_iterator_init,
+
+};
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_openmap.h>
+#include <aerospike/as_openmap_iterator.h>
+#include <aerospike/as_iterator.h>
+#include <aerospike/as_pair.h>
+#include <citrusleaf/alloc.h>
+
+/*******************************************************************************
+ *	EXTERNS
+ ******************************************************************************/
+
+extern const as_iterator_hooks as_openmap_iterator_hooks;
+
+/******************************************************************************
+ *	STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void as_openmap_iterator_reset(as_openmap_iterator * iterator)
+{
+	iterator->map = NULL;
+	iterator->pos = 0;
+}
+
+static bool as_openmap_iterator_seek(as_openmap_iterator * iterator)
+{
+	const as_openmap * map = iterator->map;
+
+	while (iterator->pos < map->capacity) {
+		if (map->slots[iterator->pos].dist != 0) {
+			return true;
+		}
+
+		iterator->pos++;
+	}
+
+	return false;
+}
+
+/******************************************************************************
+ *	FUNCTIONS
+ *****************************************************************************/
+
+as_openmap_iterator * as_openmap_iterator_init(as_openmap_iterator * iterator, const as_openmap * map)
+{
+	if (! iterator) {
+		return NULL;
+	}
+
+	as_iterator_init((as_iterator *)iterator, false, NULL, &as_openmap_iterator_hooks);
+	as_openmap_iterator_reset(iterator);
+	iterator->map = map;
+
+	return iterator;
+}
+
+as_openmap_iterator * as_openmap_iterator_new(const as_openmap * map)
+{
+	as_openmap_iterator * iterator = (as_openmap_iterator *)cf_malloc(sizeof(as_openmap_iterator));
+
+	if (! iterator) {
+		return NULL;
+	}
+
+	as_iterator_init((as_iterator *)iterator, true, NULL, &as_openmap_iterator_hooks);
+	as_openmap_iterator_reset(iterator);
+	iterator->map = map;
+
+	return iterator;
+}
+
+bool as_openmap_iterator_release(as_openmap_iterator * iterator)
+{
+	as_openmap_iterator_reset(iterator);
+
+	return true;
+}
+
+void as_openmap_iterator_destroy(as_openmap_iterator * iterator)
+{
+	as_iterator_destroy((as_iterator *)iterator);
+}
+
+bool as_openmap_iterator_has_next(const as_openmap_iterator * iterator)
+{
+	return as_openmap_iterator_seek((as_openmap_iterator *)iterator);
+}
+
+const as_val * as_openmap_iterator_next(as_openmap_iterator * iterator)
+{
+	if (! as_openmap_iterator_seek(iterator)) {
+		return NULL;
+	}
+
+	as_openmap_slot * s = &iterator->map->slots[iterator->pos++];
+
+	as_pair_init(&iterator->pair, s->p_key, s->p_val);
+
+	return (const as_val *)&iterator->pair;
+}
@@ -0,0 +1,634 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_boolean.h>
+#include <aerospike/as_bytes.h>
+#include <aerospike/as_double.h>
+#include <aerospike/as_geojson.h>
+#include <aerospike/as_hashmap_key.h>
+#include <aerospike/as_integer.h>
+#include <aerospike/as_list.h>
+#include <aerospike/as_map.h>
+#include <aerospike/as_msgpack.h>
+#include <aerospike/as_nil.h>
+#include <aerospike/as_orderedmap.h>
+#include <aerospike/as_string.h>
+#include <aerospike/as_val.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_hash_math.h>
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+/*******************************************************************************
+ *	EXTERNS
+ ******************************************************************************/
+
+extern const as_map_hooks as_orderedmap_map_hooks;
+
+/******************************************************************************
+ *	STATIC FUNCTIONS
+ ******************************************************************************/
+
+// Type as seen by as_unpack_compare() - bytes holding a string or geojson
+// pack with that particle type and sort with it.
+static as_val_t orderedmap_type(const as_val * v)
+{
+	as_val_t type = as_val_type(v);
+
+	if (type == AS_BYTES) {
+		uint8_t bytes_type = ((const as_bytes *)v)->type;
+
+		if (bytes_type == AS_BYTES_STRING) {
+			return AS_STRING;
+		}
+
+		if (bytes_type == AS_BYTES_GEOJSON) {
+			return AS_GEOJSON;
+		}
+	}
+
+	return type;
+}
+
+static inline int orderedmap_compare_blob(const void * p1, uint32_t len1, const void * p2, uint32_t len2)
+{
+	int cmp = memcmp(p1, p2, len1 < len2 ? len1 : len2);
+
+	if (cmp != 0) {
+		return cmp < 0 ? -1 : 1;
+	}
+
+	return len1 < len2 ? -1 : (len1 > len2 ? 1 : 0);
+}
+
+static uint8_t * orderedmap_pack(const as_val * v, uint32_t * size)
+{
+	as_packer pk = {
+			.buffer = NULL,
+			.capacity = UINT32_MAX
+	};
+
+	if (as_pack_val(&pk, v) != 0) {
+		return NULL;
+	}
+
+	uint8_t * buf = (uint8_t *)cf_malloc(pk.offset);
+
+	if (! buf) {
+		return NULL;
+	}
+
+	*size = pk.offset;
+	pk.buffer = buf;
+	pk.offset = 0;
+	pk.capacity = *size;
+
+	if (as_pack_val(&pk, v) != 0) {
+		cf_free(buf);
+		return NULL;
+	}
+
+	return buf;
+}
+
+// Only reached for keys as_orderedmap can't compare directly, like maps
+// inside list keys - compare them packed, with as_unpack_compare() itself.
+static int orderedmap_compare_packed(const as_val * v1, const as_val * v2)
+{
+	uint32_t size1 = 0;
+	uint32_t size2 = 0;
+	uint8_t * buf1 = orderedmap_pack(v1, &size1);
+	uint8_t * buf2 = orderedmap_pack(v2, &size2);
+	msgpack_compare_t ret = MSGPACK_COMPARE_ERROR;
+
+	if (buf1 && buf2) {
+		ret = as_unpack_buf_compare(buf1, size1, buf2, size2);
+	}
+	else {
+		// Unpackable keys sort last.
+		ret = buf1 ? MSGPACK_COMPARE_LESS :
+				(buf2 ? MSGPACK_COMPARE_GREATER : MSGPACK_COMPARE_EQUAL);
+	}
+
+	cf_free(buf1);
+	cf_free(buf2);
+
+	if (ret == MSGPACK_COMPARE_LESS) {
+		return -1;
+	}
+
+	if (ret == MSGPACK_COMPARE_EQUAL) {
+		return 0;
+	}
+
+	return 1;
+}
+
+// as_unpack_compare() gives NaN no order - sort it after every other double
+// and equal to itself, so the order stays strict weak.
+static inline int orderedmap_compare_double(double d1, double d2)
+{
+	bool nan1 = isnan(d1);
+	bool nan2 = isnan(d2);
+
+	if (nan1 || nan2) {
+		return nan1 == nan2 ? 0 : (nan1 ? 1 : -1);
+	}
+
+	return d1 < d2 ? -1 : (d1 > d2 ? 1 : 0);
+}
+
+// Blobs as_unpack_compare() finds equal - it skips the particle type byte -
+// are still different keys to as_hashmap_key_eq() when held in different
+// types, or in bytes of different particle types. Break the tie on those.
+static inline uint32_t orderedmap_blob_rank(const as_val * v)
+{
+	as_val_t type = as_val_type(v);
+	uint32_t rank = (uint32_t)type << 8;
+
+	if (type == AS_BYTES) {
+		rank |= ((const as_bytes *)v)->type;
+	}
+
+	return rank;
+}
+
+static int orderedmap_compare_blobs(const as_val * v1, const as_val * v2)
+{
+	const void * p[2];
+	uint32_t len[2];
+	const as_val * v[2] = { v1, v2 };
+
+	for (int i = 0; i < 2; i++) {
+		switch (as_val_type(v[i])) {
+		case AS_STRING:
+			p[i] = as_string_get((const as_string *)v[i]);
+			len[i] = (uint32_t)as_string_len((as_string *)v[i]);
+			break;
+		case AS_GEOJSON:
+			p[i] = as_geojson_get((const as_geojson *)v[i]);
+			len[i] = (uint32_t)as_geojson_len((as_geojson *)v[i]);
+			break;
+		default:
+			p[i] = ((const as_bytes *)v[i])->value;
+			len[i] = ((const as_bytes *)v[i])->size;
+			break;
+		}
+	}
+
+	int cmp = orderedmap_compare_blob(p[0], len[0], p[1], len[1]);
+
+	if (cmp != 0) {
+		return cmp;
+	}
+
+	uint32_t r1 = orderedmap_blob_rank(v1);
+	uint32_t r2 = orderedmap_blob_rank(v2);
+
+	return r1 < r2 ? -1 : (r1 > r2 ? 1 : 0);
+}
+
+static int orderedmap_compare(const as_val * v1, const as_val * v2);
+
+// Lists compare element by element, then shorter first, as packed.
+static int orderedmap_compare_lists(const as_list * l1, const as_list * l2)
+{
+	uint32_t n1 = as_list_size(l1);
+	uint32_t n2 = as_list_size(l2);
+	uint32_t n = n1 < n2 ? n1 : n2;
+
+	for (uint32_t i = 0; i < n; i++) {
+		int cmp = orderedmap_compare(as_list_get(l1, i), as_list_get(l2, i));
+
+		if (cmp != 0) {
+			return cmp;
+		}
+	}
+
+	return n1 < n2 ? -1 : (n1 > n2 ? 1 : 0);
+}
+
+// Compare keys in the order as_unpack_compare() gives them packed: by type,
+// then by value, with blobs compared bytewise and then by length. Ties
+// as_unpack_compare() leaves between keys as_hashmap_key_eq() tells apart are
+// broken, so equal here means the same key.
+static int orderedmap_compare(const as_val * v1, const as_val * v2)
+{
+	as_val_t t1 = orderedmap_type(v1);
+	as_val_t t2 = orderedmap_type(v2);
+
+	if (t1 != t2) {
+		return t1 < t2 ? -1 : 1;
+	}
+
+	switch (t1) {
+	case AS_UNDEF:
+	case AS_NIL:
+		return 0;
+	case AS_BOOLEAN: {
+		bool b1 = as_boolean_get((const as_boolean *)v1);
+		bool b2 = as_boolean_get((const as_boolean *)v2);
+		return b1 == b2 ? 0 : (b1 ? 1 : -1);
+	}
+	case AS_INTEGER: {
+		int64_t i1 = as_integer_get((const as_integer *)v1);
+		int64_t i2 = as_integer_get((const as_integer *)v2);
+		return i1 < i2 ? -1 : (i1 > i2 ? 1 : 0);
+	}
+	case AS_DOUBLE:
+		return orderedmap_compare_double(as_double_get((const as_double *)v1),
+				as_double_get((const as_double *)v2));
+	case AS_STRING:
+	case AS_GEOJSON:
+	case AS_BYTES:
+		// Strings and geojson may also be held in as_bytes.
+		return orderedmap_compare_blobs(v1, v2);
+	case AS_LIST:
+		return orderedmap_compare_lists((const as_list *)v1, (const as_list *)v2);
+	default:
+		return orderedmap_compare_packed(v1, v2);
+	}
+}
+
+// Index of the first entry not less than k.
+static uint32_t orderedmap_lower_bound(const as_orderedmap * map, const as_val * k, bool * found)
+{
+	uint32_t lo = 0;
+	uint32_t hi = map->count;
+
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+
+		if (orderedmap_compare(map->entries[mid].p_key, k) < 0) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+
+	*found = lo < map->count && orderedmap_compare(map->entries[lo].p_key, k) == 0;
+
+	return lo;
+}
+
+static int orderedmap_resize(as_orderedmap * map, uint32_t capacity)
+{
+	if (! map->free) {
+		return -1;
+	}
+
+	as_orderedmap_entry * entries = (as_orderedmap_entry *)cf_realloc(
+			map->entries, capacity * sizeof(as_orderedmap_entry));
+
+	if (! entries) {
+		return -1;
+	}
+
+	map->entries = entries;
+	map->capacity = capacity;
+
+	return 0;
+}
+
+static as_orderedmap * as_orderedmap_cons(as_orderedmap * map, uint32_t capacity)
+{
+	map->count = 0;
+	map->capacity = capacity > AS_ORDEREDMAP_MIN_CAPACITY ?
+			capacity : AS_ORDEREDMAP_MIN_CAPACITY;
+	map->entries = (as_orderedmap_entry *)cf_malloc(
+			map->capacity * sizeof(as_orderedmap_entry));
+	map->free = true;
+	map->hash_valid = false;
+	map->hash = 0;
+
+	return map->entries ? map : NULL;
+}
+
+/******************************************************************************
+ *	INSTANCE FUNCTIONS
+ ******************************************************************************/
+
+as_orderedmap * as_orderedmap_init(as_orderedmap * map, uint32_t capacity)
+{
+	if (! map) {
+		return NULL;
+	}
+
+	as_map_cons((as_map *)map, false, AS_PACKED_MAP_FLAG_K_ORDERED, &as_orderedmap_map_hooks);
+
+	return as_orderedmap_cons(map, capacity);
+}
+
+as_orderedmap * as_orderedmap_new(uint32_t capacity)
+{
+	as_orderedmap * map = (as_orderedmap *)cf_malloc(sizeof(as_orderedmap));
+
+	if (! map) {
+		return NULL;
+	}
+
+	as_map_cons((as_map *)map, true, AS_PACKED_MAP_FLAG_K_ORDERED, &as_orderedmap_map_hooks);
+
+	if (! as_orderedmap_cons(map, capacity)) {
+		cf_free(map);
+		return NULL;
+	}
+
+	return map;
+}
+
+as_orderedmap * as_orderedmap_init_wrap(as_orderedmap * map, uint32_t capacity, void * storage)
+{
+	if (! map || ! storage) {
+		return NULL;
+	}
+
+	as_map_cons((as_map *)map, false, AS_PACKED_MAP_FLAG_K_ORDERED, &as_orderedmap_map_hooks);
+
+	map->count = 0;
+	map->capacity = capacity;
+	map->entries = (as_orderedmap_entry *)storage;
+	map->free = false;
+	map->hash_valid = false;
+	map->hash = 0;
+
+	return map;
+}
+
+bool as_orderedmap_release(as_orderedmap * map)
+{
+	if (! map) {
+		return false;
+	}
+
+	as_orderedmap_clear(map);
+
+	if (map->free) {
+		cf_free(map->entries);
+	}
+
+	map->entries = NULL;
+	map->capacity = 0;
+
+	return true;
+}
+
+void as_orderedmap_destroy(as_orderedmap * map)
+{
+	as_map_destroy((as_map *)map);
+}
+
+/******************************************************************************
+ *	INFO FUNCTIONS
+ ******************************************************************************/
+
+// Published as by as_hashmap_hashcode().
+uint32_t as_orderedmap_hashcode(const as_orderedmap * map)
+{
+	if (as_load_uint8((const uint8_t *)&map->hash_valid)) {
+		as_fence_lock();
+		return cf_hash_mix32(as_load_uint32(&map->hash) + map->count);
+	}
+
+	uint32_t hash = 0;
+	bool cacheable = true;
+
+	for (uint32_t i = 0; i < map->count; i++) {
+		const as_orderedmap_entry * e = &map->entries[i];
+
+		hash += as_hashmap_entry_hash(as_val_hashcode(e->p_key), e->p_val);
+		cacheable = cacheable && as_hashmap_entry_cacheable(e->p_key, e->p_val);
+	}
+
+	if (cacheable) {
+		as_store_uint32((uint32_t *)&map->hash, hash);
+		as_fence_store();
+		as_store_uint8((uint8_t *)&map->hash_valid, true);
+	}
+
+	return cf_hash_mix32(hash + map->count);
+}
+
+uint32_t as_orderedmap_size(const as_orderedmap * map)
+{
+	return map ? map->count : 0;
+}
+
+/*******************************************************************************
+ *	ACCESSOR & MODIFICATION FUNCTIONS
+ ******************************************************************************/
+
+int as_orderedmap_set(as_orderedmap * map, const as_val * k, const as_val * v)
+{
+	if (! map) {
+		return -1;
+	}
+
+	if (! as_hashmap_key_valid(k)) {
+		return -1;
+	}
+
+	as_val * safe_v = (as_val *)(v ? v : &as_nil);
+	uint32_t i = map->count;
+	bool found = false;
+
+	// Keys arriving in order, as from a packed K-ordered map, are appended
+	// after a single compare.
+	if (map->count != 0 &&
+			orderedmap_compare(map->entries[map->count - 1].p_key, k) >= 0) {
+		i = orderedmap_lower_bound(map, k, &found);
+	}
+
+	if (! as_hashmap_entry_cacheable(k, safe_v)) {
+		map->hash_valid = false;
+	}
+
+	uint32_t key_hash = map->hash_valid ? as_val_hashcode(k) : 0;
+	uint32_t entry_hash = map->hash_valid ?
+			as_hashmap_entry_hash(key_hash, safe_v) : 0;
+	as_orderedmap_entry * e = &map->entries[i];
+
+	// If we find our key, replace the existing key and value.
+	if (found) {
+		if (map->hash_valid) {
+			map->hash += entry_hash - as_hashmap_entry_hash(key_hash, e->p_val);
+		}
+
+		as_val_destroy(e->p_key);
+		as_val_destroy(e->p_val);
+		e->p_key = (as_val *)k;
+		e->p_val = safe_v;
+
+		return 0;
+	}
+
+	if (map->count == map->capacity &&
+			orderedmap_resize(map, map->capacity * 2) != 0) {
+		return -1;
+	}
+
+	e = &map->entries[i];
+	memmove(e + 1, e, (map->count - i) * sizeof(as_orderedmap_entry));
+	e->p_key = (as_val *)k;
+	e->p_val = safe_v;
+	map->count++;
+	map->hash += entry_hash;
+
+	return 0;
+}
+
+int as_orderedmap_reserve(as_orderedmap * map, uint32_t count)
+{
+	if (! map) {
+		return -1;
+	}
+
+	if (count <= map->capacity) {
+		return 0;
+	}
+
+	return orderedmap_resize(map, count);
+}
+
+as_val * as_orderedmap_get(const as_orderedmap * map, const as_val * k)
+{
+	if (! map) {
+		return NULL;
+	}
+
+	if (! as_hashmap_key_valid(k)) {
+		return NULL;
+	}
+
+	bool found;
+	uint32_t i = orderedmap_lower_bound(map, k, &found);
+
+	return found ? map->entries[i].p_val : NULL;
+}
+
+uint32_t as_orderedmap_find(const as_orderedmap * map, const as_val * k, bool * found)
+{
+	bool f = false;
+	uint32_t i = 0;
+
+	if (map && as_hashmap_key_valid(k)) {
+		i = orderedmap_lower_bound(map, k, &f);
+	}
+
+	if (found) {
+		*found = f;
+	}
+
+	return i;
+}
+
+bool as_orderedmap_get_at(const as_orderedmap * map, uint32_t index, as_val ** k, as_val ** v)
+{
+	if (! map || index >= map->count) {
+		return false;
+	}
+
+	*k = map->entries[index].p_key;
+	*v = map->entries[index].p_val;
+
+	return true;
+}
+
+int as_orderedmap_clear(as_orderedmap * map)
+{
+	if (! map) {
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < map->count; i++) {
+		as_val_destroy(map->entries[i].p_key);
+		as_val_destroy(map->entries[i].p_val);
+	}
+
+	map->count = 0;
+	map->hash_valid = false;
+	map->hash = 0;
+
+	return 0;
+}
+
+int as_orderedmap_remove(as_orderedmap * map, const as_val * k)
+{
+	if (! map) {
+		return -1;
+	}
+
+	if (! as_hashmap_key_valid(k)) {
+		return -1;
+	}
+
+	bool found;
+	uint32_t i = orderedmap_lower_bound(map, k, &found);
+
+	if (! found) {
+		return 0;
+	}
+
+	as_orderedmap_entry * e = &map->entries[i];
+
+	if (map->hash_valid) {
+		map->hash -= as_hashmap_entry_hash(as_val_hashcode(e->p_key), e->p_val);
+	}
+
+	as_val_destroy(e->p_key);
+	as_val_destroy(e->p_val);
+
+	map->count--;
+	memmove(e, e + 1, (map->count - i) * sizeof(as_orderedmap_entry));
+
+	return 0;
+}
+
+/*******************************************************************************
+ *	ITERATION FUNCTIONS
+ ******************************************************************************/
+
+bool as_orderedmap_foreach(const as_orderedmap * map, as_map_foreach_callback callback, void * udata)
+{
+	return as_orderedmap_foreach_range(map, NULL, NULL, callback, udata);
+}
+
+bool as_orderedmap_foreach_range(const as_orderedmap * map, const as_val * begin, const as_val * end, as_map_foreach_callback callback, void * udata)
+{
+	if (! map) {
+		return false;
+	}
+
+	bool found;
+	uint32_t i = begin ? orderedmap_lower_bound(map, begin, &found) : 0;
+
+	for (; i < map->count; i++) {
+		as_orderedmap_entry * e = &map->entries[i];
+
+		if (end && orderedmap_compare(e->p_key, end) >= 0) {
+			break;
+		}
+
+		if (! callback((const as_val *)e->p_key, (const as_val *)e->p_val, udata)) {
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,121 @@
+/* 
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_orderedmap.h>
+#include <aerospike/as_orderedmap_iterator.h>
+#include <aerospike/as_iterator.h>
+#include <aerospike/as_map.h>
+#include <aerospike/as_map_iterator.h>
+#include <aerospike/as_pair.h>
+#include <aerospike/as_val.h>
+
+/*******************************************************************************
+ *	EXTERN FUNCTIONS
+ ******************************************************************************/
+
+extern bool as_orderedmap_release(as_orderedmap * map);
+
+/*******************************************************************************
+ *	FUNCTIONS
+ ******************************************************************************/
+
+static bool _as_orderedmap_map_destroy(as_map * m) 
+{
+	return as_orderedmap_release((as_orderedmap *) m);
+}
+
+static uint32_t _as_orderedmap_map_hashcode(const as_map * m)
+{
+	return as_orderedmap_hashcode((const as_orderedmap *) m);
+}
+
+static int _as_orderedmap_map_set(as_map * m, const as_val * k, const as_val * v)
+{
+	return as_orderedmap_set((as_orderedmap *) m, k, v);
+}
+
+static as_val * _as_orderedmap_map_get(const as_map * m, const as_val * k)
+{
+	return as_orderedmap_get((as_orderedmap *) m, k);
+}
+
+static uint32_t _as_orderedmap_map_size(const as_map * m)
+{
+	return as_orderedmap_size((const as_orderedmap *) m);
+}
+
+static int _as_orderedmap_map_clear(as_map * m)
+{
+	return as_orderedmap_clear((as_orderedmap *) m);
+}
+
+static int _as_orderedmap_map_remove(as_map * m, const as_val * k)
+{
+	return as_orderedmap_remove((as_orderedmap *) m, k);
+}
+
+static bool _as_orderedmap_map_foreach(const as_map * m, as_map_foreach_callback callback, void * udata) 
+{
+	return as_orderedmap_foreach((const as_orderedmap *) m, callback, udata);
+}
+
+static as_map_iterator * _as_orderedmap_map_iterator_new(const as_map * m) 
+{
+	return (as_map_iterator *) as_orderedmap_iterator_new((const as_orderedmap *) m);
+}
+
+static as_map_iterator * _as_orderedmap_map_iterator_init(const as_map * m, as_map_iterator * it)
+{
+	return (as_map_iterator *) as_orderedmap_iterator_init((as_orderedmap_iterator *) it, (as_orderedmap *) m);
+}
+
+/*******************************************************************************
+ *	HOOKS
+ ******************************************************************************/
+
+const as_map_hooks as_orderedmap_map_hooks = {
+
+	/***************************************************************************
+	 *	instance hooks
+	 **************************************************************************/
+
+	.destroy	= _as_orderedmap_map_destroy,
+
+	/***************************************************************************
+	 *	info hooks
+	 **************************************************************************/
+
+	.hashcode	= _as_orderedmap_map_hashcode,
+	.size		= _as_orderedmap_map_size,
+
+	/***************************************************************************
+	 *	accessor and modifier hooks
+	 **************************************************************************/
+
+	.set		= _as_orderedmap_map_set,
+	.get		= _as_orderedmap_map_get,
+	.clear		= _as_orderedmap_map_clear,
+	.remove		= _as_orderedmap_map_remove,
+	
+	/***************************************************************************
+	 *	iteration hooks
+	 **************************************************************************/
+
+	.foreach		= _as_orderedmap_map_foreach,
+	.iterator_new	= _as_orderedmap_map_iterator_new,
+	.iterator_init	= _as_orderedmap_map_iterator_init,
+
+};
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_orderedmap.h>
+#include <aerospike/as_orderedmap_iterator.h>
+#include <aerospike/as_iterator.h>
+#include <aerospike/as_pair.h>
+#include <citrusleaf/alloc.h>
+
+/*******************************************************************************
+ *	EXTERNS
+ ******************************************************************************/
+
+extern const as_iterator_hooks as_orderedmap_iterator_hooks;
+
+/******************************************************************************
+ *	STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void as_orderedmap_iterator_reset(as_orderedmap_iterator * iterator, const as_orderedmap * map)
+{
+	iterator->map = map;
+	iterator->pos = 0;
+	iterator->end = map ? map->count : 0;
+}
+
+/******************************************************************************
+ *	FUNCTIONS
+ *****************************************************************************/
+
+as_orderedmap_iterator * as_orderedmap_iterator_init(as_orderedmap_iterator * iterator, const as_orderedmap * map)
+{
+	if (! iterator) {
+		return NULL;
+	}
+
+	as_iterator_init((as_iterator *)iterator, false, NULL, &as_orderedmap_iterator_hooks);
+	as_orderedmap_iterator_reset(iterator, map);
+
+	return iterator;
+}
+
+as_orderedmap_iterator * as_orderedmap_iterator_init_range(as_orderedmap_iterator * iterator, const as_orderedmap * map, const as_val * begin, const as_val * end)
+{
+	if (! as_orderedmap_iterator_init(iterator, map)) {
+		return NULL;
+	}
+
+	if (begin) {
+		iterator->pos = as_orderedmap_find(map, begin, NULL);
+	}
+
+	if (end) {
+		iterator->end = as_orderedmap_find(map, end, NULL);
+	}
+
+	return iterator;
+}
+
+as_orderedmap_iterator * as_orderedmap_iterator_new(const as_orderedmap * map)
+{
+	as_orderedmap_iterator * iterator = (as_orderedmap_iterator *)cf_malloc(sizeof(as_orderedmap_iterator));
+
+	if (! iterator) {
+		return NULL;
+	}
+
+	as_iterator_init((as_iterator *)iterator, true, NULL, &as_orderedmap_iterator_hooks);
+	as_orderedmap_iterator_reset(iterator, map);
+
+	return iterator;
+}
+
+bool as_orderedmap_iterator_release(as_orderedmap_iterator * iterator)
+{
+	as_orderedmap_iterator_reset(iterator, NULL);
+
+	return true;
+}
+
+void as_orderedmap_iterator_destroy(as_orderedmap_iterator * iterator)
+{
+	as_iterator_destroy((as_iterator *)iterator);
+}
+
+bool as_orderedmap_iterator_has_next(const as_orderedmap_iterator * iterator)
+{
+	return iterator->map && iterator->pos < iterator->end &&
+			iterator->pos < iterator->map->count;
+}
+
+const as_val * as_orderedmap_iterator_next(as_orderedmap_iterator * iterator)
+{
+	if (! as_orderedmap_iterator_has_next(iterator)) {
+		return NULL;
+	}
+
+	as_orderedmap_entry * e = &iterator->map->entries[iterator->pos++];
+
+	as_pair_init(&iterator->pair, e->p_key, e->p_val);
+
+	return (const as_val *)&iterator->pair;
+}
@@ -14,8 +14,10 @@
  * License for the specific language governing permissions and limitations under
  * the License.
  */
+#include <aerospike/as_atomic.h>
 #include <aerospike/as_string.h>
 #include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_hash_math.h>
 #include <string.h>
 
 /******************************************************************************
@@ -30,6 +32,7 @@ static inline as_string * as_string_cons(as_string * string, bool free, char * v
 	string->free = value_free;
 	string->value = value;
 	string->len = len;
+	string->hash = 0;
 	return string;
 }
 
@@ -57,7 +60,22 @@ as_string * as_string_new_wlen(char * value, size_t len, bool free)
 
 as_string *as_string_new_strdup(const char * s)
 {
-	return as_string_new(cf_strdup(s), true);
+	return as_string_new_strndup(s, strlen(s));
+}
+
+as_string *as_string_new_strndup(const char * s, size_t n)
+{
+	size_t len = strnlen(s, n);
+
+	// The characters follow the as_string, so they are freed along with it.
+	as_string * string = (as_string *) cf_malloc(sizeof(as_string) + len + 1);
+	if ( !string ) return string;
+
+	char * value = (char *) (string + 1);
+	memcpy(value, s, len);
+	value[len] = 0;
+
+	return as_string_cons(string, true, value, len, false);
 }
 
 /******************************************************************************
@@ -165,11 +183,12 @@ uint32_t as_string_val_hashcode(const as_val * v)
 {
 	as_string * string = as_string_fromval(v);
 	if ( string == NULL || string->value == NULL) return 0;
-	uint32_t hash = 0;
-	int c;
-	char * str = string->value;
-	while ( (c = *str++) ) {
-		hash = c + (hash << 6) + (hash << 16) - hash;
+	// The string may be shared by readers, but they all compute and store the
+	// same hash, so a relaxed store is enough.
+	uint32_t hash = as_load_uint32(&string->hash);
+	if ( hash == 0 ) {
+		hash = cf_hash_murmur32((const uint8_t *) string->value, as_string_len(string));
+		as_store_uint32(&string->hash, hash);
 	}
 	return hash;
 }
@@ -15,8 +15,32 @@
  * the License.
  */
 #include <aerospike/as_thread_pool.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_monitor.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_clock.h>
+#include <stdio.h>
 #include <string.h>
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_THREAD_POOL_CACHE_LINE 64
+
+// Must be a power of 2.
+#define AS_THREAD_POOL_DEQUE_SIZE 1024
+
+// Most tasks a worker moves from its inbox at once.
+#define AS_THREAD_POOL_INBOX_BATCH 16
+
+// Most chunks a parallel_for is split into, so they can be counted in 32 bits.
+#define AS_THREAD_POOL_MAX_CHUNKS (1 << 30)
+
 /******************************************************************************
  * TYPES
  *****************************************************************************/
@@ -24,12 +48,106 @@
 typedef struct as_thread_pool_task_s {
 	as_task_fn task_fn;
 	void* task_data;
+	as_task_group* group;
 } as_thread_pool_task;
 
+// Shared state of a parallel_for. Freed by whichever of the caller and the
+// queued tasks lets go of it last.
+typedef struct as_thread_pool_range_s {
+	as_range_fn fn;
+	void* udata;
+	uint64_t begin;
+	uint64_t end;
+	uint64_t chunk;
+	uint64_t n_chunks;
+	uint64_t next;
+	uint32_t ref_count;
+	as_task_group group;
+} as_thread_pool_range;
+
+// Work stealing pool worker. The deque is a Chase-Lev deque - only the owning
+// thread pushes and pops at bottom, other workers steal from top. Tasks queued
+// from outside the pool go to the inbox.
+typedef struct as_thread_pool_worker_s {
+	uint32_t bottom;
+	uint8_t pad1[AS_THREAD_POOL_CACHE_LINE - sizeof(uint32_t)];
+	uint32_t top;
+	uint8_t pad2[AS_THREAD_POOL_CACHE_LINE - sizeof(uint32_t)];
+	as_thread_pool* pool;
+	cf_queue* inbox;
+	uint32_t index;
+	uint32_t stop;
+	as_thread_pool_task tasks[AS_THREAD_POOL_DEQUE_SIZE];
+} as_thread_pool_worker;
+
+// Handshake with a NUMA local worker thread, which creates its own worker.
+typedef struct as_thread_pool_start_s {
+	as_thread_pool* pool;
+	as_thread_pool_worker* worker;
+	uint32_t index;
+	as_monitor monitor;
+} as_thread_pool_start;
+
+/******************************************************************************
+ * GLOBALS
+ *****************************************************************************/
+
+// Worker run by the current thread, if it is in a work stealing pool.
+static __thread as_thread_pool_worker* as_thread_pool_current = NULL;
+
 /******************************************************************************
  * Functions
  *****************************************************************************/
 
+static void
+as_thread_pool_worker_done(as_thread_pool* pool)
+{
+	// Run the finalization function, if present.
+	if (pool->fini_fn) {
+		pool->fini_fn();
+	}
+	
+	// Send thread completion event back to caller.
+	uint32_t complete = 1;
+	cf_queue_push(pool->complete_queue, &complete);
+}
+
+static void
+as_task_group_complete(as_task_group* group)
+{
+	// Only the last completion takes the lock, and drops the count to zero
+	// under it, so a group is never touched after a wait sees it done.
+	while (true) {
+		uint32_t pending = as_load_uint32(&group->pending);
+
+		if (pending == 1) {
+			break;
+		}
+
+		if (as_cas_uint32(&group->pending, pending, pending - 1)) {
+			return;
+		}
+	}
+
+	pthread_mutex_lock(&group->lock);
+
+	if (as_aaf_uint32(&group->pending, -1) == 0) {
+		pthread_cond_broadcast(&group->cond);
+	}
+
+	pthread_mutex_unlock(&group->lock);
+}
+
+static inline void
+as_thread_pool_run(as_thread_pool_task* task)
+{
+	task->task_fn(task->task_data);
+
+	if (task->group) {
+		as_task_group_complete(task->group);
+	}
+}
+
 void*
 as_thread_worker(void* data)
 {
@@ -47,7 +165,7 @@ as_thread_worker(void* data)
 			}
 			
 			// Run task
-			task.task_fn(task.task_data);
+			as_thread_pool_run(&task);
 		}
 	}
 	else {
@@ -67,18 +185,378 @@ as_thread_worker(void* data)
 		}
 	}
 	
-	// Run the finalization function, if present.
-	if (pool->fini_fn) {
-		pool->fini_fn();
+	as_thread_pool_worker_done(pool);
+	return 0;
+}
+
+/******************************************************************************
+ * Work stealing
+ *****************************************************************************/
+
+static bool
+as_thread_pool_deque_push(as_thread_pool_worker* w, const as_thread_pool_task* task)
+{
+	uint32_t b = w->bottom;
+	uint32_t t = as_load_uint32(&w->top);
+
+	if (b - t >= AS_THREAD_POOL_DEQUE_SIZE) {
+		return false;
 	}
-	
-	// Send thread completion event back to caller.
-	uint32_t complete = 1;
-	cf_queue_push(pool->complete_queue, &complete);
 
+	w->tasks[b & (AS_THREAD_POOL_DEQUE_SIZE - 1)] = *task;
+	as_fence_store();
+	as_store_uint32(&w->bottom, b + 1);
+	return true;
+}
+
+static bool
+as_thread_pool_deque_pop(as_thread_pool_worker* w, as_thread_pool_task* task)
+{
+	uint32_t b = w->bottom - 1;
+
+	// Claim the bottom task before looking at top, so a thief either sees the
+	// claim or we see the theft.
+	as_store_uint32(&w->bottom, b);
+	as_fence_memory();
+
+	uint32_t t = as_load_uint32(&w->top);
+	int32_t n = (int32_t)(b - t);
+
+	if (n < 0) {
+		// Empty.
+		as_store_uint32(&w->bottom, t);
+		return false;
+	}
+
+	*task = w->tasks[b & (AS_THREAD_POOL_DEQUE_SIZE - 1)];
+
+	if (n > 0) {
+		return true;
+	}
+
+	// Last task - thieves may be after it too.
+	bool won = as_cas_uint32(&w->top, t, t + 1);
+	as_store_uint32(&w->bottom, t + 1);
+	return won;
+}
+
+static bool
+as_thread_pool_deque_steal(as_thread_pool_worker* w, as_thread_pool_task* task)
+{
+	uint32_t t = as_load_uint32(&w->top);
+	as_fence_memory();
+	uint32_t b = as_load_uint32(&w->bottom);
+
+	if ((int32_t)(b - t) <= 0) {
+		return false;
+	}
+
+	// The owner can't reuse this slot until top moves past it, so the copy is
+	// good if the CAS succeeds.
+	*task = w->tasks[t & (AS_THREAD_POOL_DEQUE_SIZE - 1)];
+	return as_cas_uint32(&w->top, t, t + 1);
+}
+
+static bool
+as_thread_pool_take_inbox(as_thread_pool_worker* w, as_thread_pool_task* task)
+{
+	as_thread_pool_task batch[AS_THREAD_POOL_INBOX_BATCH];
+	int n = cf_queue_pop_n(w->inbox, batch, AS_THREAD_POOL_INBOX_BATCH,
+			CF_QUEUE_NOWAIT);
+
+	if (n <= 0) {
+		return false;
+	}
+
+	// Keep the first, and move the rest to the deque where idle workers can
+	// steal them. Pushed in reverse so they pop in inbox order.
+	for (int i = n - 1; i > 0; i--) {
+		if (! as_thread_pool_deque_push(w, &batch[i])) {
+			cf_queue_push(w->inbox, &batch[i]);
+		}
+	}
+
+	*task = batch[0];
+	return true;
+}
+
+static bool
+as_thread_pool_steal(as_thread_pool* pool, as_thread_pool_worker* self,
+		as_thread_pool_task* task)
+{
+	uint32_t count = as_load_uint32(&pool->worker_count);
+	as_fence_lock();
+
+	// Stopped workers are included - tasks may still land in their inboxes.
+	for (uint32_t i = 1; i < count; i++) {
+		as_thread_pool_worker* w = pool->workers[(self->index + i) % count];
+
+		if (as_thread_pool_deque_steal(w, task) ||
+				cf_queue_pop(w->inbox, task, CF_QUEUE_NOWAIT) == CF_QUEUE_OK) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool
+as_thread_pool_has_work(as_thread_pool* pool)
+{
+	uint32_t count = as_load_uint32(&pool->worker_count);
+	as_fence_lock();
+
+	for (uint32_t i = 0; i < count; i++) {
+		as_thread_pool_worker* w = pool->workers[i];
+
+		if ((int32_t)(as_load_uint32(&w->bottom) - as_load_uint32(&w->top)) > 0 ||
+				cf_queue_sz(w->inbox) != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void
+as_thread_pool_park(as_thread_pool* pool, as_thread_pool_worker* w)
+{
+	pthread_mutex_lock(&pool->idle_lock);
+
+	// Count ourselves as sleeping before the last look, so a task queued
+	// meanwhile is either seen here or wakes us.
+	as_incr_uint32(&pool->sleepers);
+	as_fence_memory();
+
+	if (! as_load_uint32(&w->stop) && ! as_thread_pool_has_work(pool)) {
+		pthread_cond_wait(&pool->idle_cond, &pool->idle_lock);
+		as_store_uint32(&pool->waking, 0);
+	}
+
+	as_decr_uint32(&pool->sleepers);
+	pthread_mutex_unlock(&pool->idle_lock);
+}
+
+static void
+as_thread_pool_wake(as_thread_pool* pool)
+{
+	as_fence_memory();
+
+	// Only one wake up at a time - the woken worker wakes the next one if it
+	// finds work.
+	if (as_load_uint32(&pool->sleepers) == 0 ||
+			! as_cas_uint32(&pool->waking, 0, 1)) {
+		return;
+	}
+
+	pthread_mutex_lock(&pool->idle_lock);
+
+	// Sleepers counted under the lock are all waiting on the condvar.
+	if (pool->sleepers != 0) {
+		pthread_cond_signal(&pool->idle_cond);
+	}
+	else {
+		as_store_uint32(&pool->waking, 0);
+	}
+
+	pthread_mutex_unlock(&pool->idle_lock);
+}
+
+static void*
+as_thread_steal_worker(void* data)
+{
+	as_thread_pool_worker* w = data;
+	as_thread_pool* pool = w->pool;
+	as_thread_pool_task task;
+	bool parked = false;
+
+	as_thread_pool_current = w;
+
+	while (true) {
+		// Read stop before looking for tasks - everything queued before the
+		// stop is then found by this pass.
+		bool stop = as_load_uint32(&w->stop) != 0;
+
+		if (as_thread_pool_deque_pop(w, &task) ||
+				as_thread_pool_take_inbox(w, &task) ||
+				(! stop && as_thread_pool_steal(pool, w, &task))) {
+			if (parked) {
+				// Tasks queued while we were being woken didn't wake anyone.
+				as_thread_pool_wake(pool);
+				parked = false;
+			}
+
+			as_thread_pool_run(&task);
+			continue;
+		}
+
+		// A stopped worker leaves once its own tasks are done, so everything
+		// queued before shutdown is still run.
+		if (stop) {
+			break;
+		}
+
+		as_thread_pool_park(pool, w);
+		parked = true;
+	}
+
+	as_thread_pool_current = NULL;
+	as_thread_pool_worker_done(pool);
 	return 0;
 }
 
+static as_thread_pool_worker*
+as_thread_pool_get_worker(as_thread_pool* pool, uint32_t index)
+{
+	if (index < pool->worker_count) {
+		return pool->workers[index];
+	}
+
+	if (! pool->workers || index >= AS_THREAD_POOL_MAX_WORKERS) {
+		return NULL;
+	}
+
+	as_thread_pool_worker* w = cf_malloc(sizeof(as_thread_pool_worker));
+
+	if (! w) {
+		return NULL;
+	}
+
+	w->inbox = cf_queue_create(sizeof(as_thread_pool_task), true);
+
+	if (! w->inbox) {
+		cf_free(w);
+		return NULL;
+	}
+
+	w->bottom = 0;
+	w->top = 0;
+	w->pool = pool;
+	w->index = index;
+	w->stop = 0;
+
+	// Publish the worker before the count that makes it visible to thieves.
+	pool->workers[index] = w;
+	as_fence_store();
+	as_store_uint32(&pool->worker_count, index + 1);
+	return w;
+}
+
+static int
+as_thread_pool_submit(as_thread_pool* pool, const as_thread_pool_task* task)
+{
+	as_thread_pool_worker* w = as_thread_pool_current;
+
+	if (w && w->pool == pool) {
+		// Queued from a task - keep it local, overflowing to our own inbox.
+		if (! as_thread_pool_deque_push(w, task) &&
+				cf_queue_push(w->inbox, task) != CF_QUEUE_OK) {
+			return -2;
+		}
+	}
+	else {
+		uint32_t size = pool->thread_size;
+
+		if (size == 0) {
+			return -1;
+		}
+
+		w = pool->workers[as_faa_uint32(&pool->next_worker, 1) % size];
+
+		if (cf_queue_push(w->inbox, task) != CF_QUEUE_OK) {
+			return -2;
+		}
+	}
+
+	as_thread_pool_wake(pool);
+	return 0;
+}
+
+static void*
+as_thread_steal_start(void* data)
+{
+	as_thread_pool_start* start = data;
+
+	// Already running on our CPU, so the worker's pages are first touched,
+	// and placed, on its node.
+	as_thread_pool_worker* w = as_thread_pool_get_worker(start->pool, start->index);
+
+	if (w) {
+		w->stop = 0;
+	}
+
+	start->worker = w;
+	as_monitor_notify(&start->monitor);
+
+	// The creator reports the failure - this thread never ran as a worker.
+	return w ? as_thread_steal_worker(w) : 0;
+}
+
+static bool
+as_thread_pool_start_worker(as_thread_pool* pool, pthread_attr_t* attrs, pthread_t* thread,
+							uint32_t index)
+{
+	if (! pool->numa_local || index < pool->worker_count) {
+		// Reused workers stay where they were first created, which is the
+		// same CPU for the same index.
+		as_thread_pool_worker* w = as_thread_pool_get_worker(pool, index);
+
+		if (! w) {
+			return false;
+		}
+
+		w->stop = 0;
+		return pthread_create(thread, attrs, as_thread_steal_worker, w) == 0;
+	}
+
+	as_thread_pool_start start = {
+		.pool = pool,
+		.worker = NULL,
+		.index = index
+	};
+
+	as_monitor_init(&start.monitor);
+	as_monitor_begin(&start.monitor);
+
+	bool started = pthread_create(thread, attrs, as_thread_steal_start, &start) == 0;
+
+	if (started) {
+		as_monitor_wait(&start.monitor);
+		started = start.worker != NULL;
+	}
+
+	as_monitor_destroy(&start.monitor);
+	return started;
+}
+
+static void
+as_thread_pool_set_affinity(as_thread_pool* pool, pthread_attr_t* attrs, uint32_t index)
+{
+#if defined(__linux__)
+	if (pool->cpus) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(pool->cpus[index % pool->n_cpus], &set);
+		pthread_attr_setaffinity_np(attrs, sizeof(set), &set);
+	}
+#endif
+}
+
+static void
+as_thread_pool_set_name(as_thread_pool* pool, pthread_t thread, uint32_t index)
+{
+#if defined(__linux__)
+	// Threads can't exit until shutdown, which waits for the pool lock held
+	// by our caller, so thread is still valid.
+	if (pool->name[0]) {
+		// Linux limits names to 15 characters, so long ones are truncated.
+		char name[16];
+
+		if (snprintf(name, sizeof(name), "%s-%u", pool->name, index) > 0) {
+			pthread_setname_np(thread, name);
+		}
+	}
+#endif
+}
+
 static uint32_t
 as_thread_pool_create_threads(as_thread_pool* pool, uint32_t count)
 {
@@ -87,19 +565,89 @@ as_thread_pool_create_threads(as_thread_pool* pool, uint32_t count)
 	pthread_attr_t attrs;
 	pthread_attr_init(&attrs);
 	pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
+
+	if (pool->stack_size) {
+		pthread_attr_setstacksize(&attrs, pool->stack_size);
+	}
 	
 	uint32_t threads_created = 0;
 	pthread_t thread;
 	
+	// Threads are numbered contiguously after the pool->thread_size running ones.
 	for (uint32_t i = 0; i < count; i++) {
-		if (pthread_create(&thread, &attrs, as_thread_worker, pool) == 0) {
-			threads_created++;
+		uint32_t index = pool->thread_size + i;
+
+		as_thread_pool_set_affinity(pool, &attrs, index);
+
+		if (pool->stealing) {
+			// Worker indexes must stay contiguous.
+			if (! as_thread_pool_start_worker(pool, &attrs, &thread, index)) {
+				break;
+			}
+		}
+		else if (pthread_create(&thread, &attrs, as_thread_worker, pool) != 0) {
+			continue;
 		}
+
+		as_thread_pool_set_name(pool, thread, index);
+		threads_created++;
 	}
 	pthread_attr_destroy(&attrs);
 	return threads_created;
 }
 
+static void
+as_thread_pool_set_options(as_thread_pool* pool, const as_thread_pool_options* options)
+{
+	pool->cpus = NULL;
+	pool->n_cpus = 0;
+	pool->stack_size = 0;
+	pool->name[0] = 0;
+	pool->numa_local = false;
+
+	if (! options) {
+		return;
+	}
+
+	pool->stack_size = options->stack_size;
+	pool->numa_local = options->stealing && options->numa_local;
+
+	if (options->name) {
+		snprintf(pool->name, sizeof(pool->name), "%s", options->name);
+	}
+
+#if defined(__linux__)
+	if (options->cpus && options->n_cpus != 0) {
+		pool->cpus = cf_malloc(sizeof(uint16_t) * options->n_cpus);
+
+		if (pool->cpus) {
+			memcpy(pool->cpus, options->cpus, sizeof(uint16_t) * options->n_cpus);
+			pool->n_cpus = options->n_cpus;
+		}
+	}
+	else if (options->pin_per_cpu) {
+		cpu_set_t set;
+
+		if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+			return;
+		}
+
+		uint32_t n = CPU_COUNT(&set);
+		pool->cpus = n != 0 ? cf_malloc(sizeof(uint16_t) * n) : NULL;
+
+		if (! pool->cpus) {
+			return;
+		}
+
+		for (uint32_t cpu = 0; cpu < CPU_SETSIZE && pool->n_cpus < n; cpu++) {
+			if (CPU_ISSET(cpu, &set)) {
+				pool->cpus[pool->n_cpus++] = (uint16_t)cpu;
+			}
+		}
+	}
+#endif
+}
+
 static void
 as_thread_pool_shutdown_threads(as_thread_pool* pool, uint32_t count)
 {
@@ -107,11 +655,23 @@ as_thread_pool_shutdown_threads(as_thread_pool* pool, uint32_t count)
 	// "running" flag) to allow the workers to "wait forever" on processing the
 	// work dispatch queue, which has minimum impact when the queue is empty.
 	// This also means all queued requests get processed when shutting down.
-	if (pool->task_size == 0) {
+	if (pool->stealing) {
+		// Stop the workers past the new thread_size. Each one runs what is
+		// left on its own deque and inbox before it exits.
+		for (uint32_t i = 0; i < count; i++) {
+			as_store_uint32(&pool->workers[pool->thread_size + i]->stop, 1);
+		}
+
+		pthread_mutex_lock(&pool->idle_lock);
+		pthread_cond_broadcast(&pool->idle_cond);
+		pthread_mutex_unlock(&pool->idle_lock);
+	}
+	else if (pool->task_size == 0) {
 		// Send shutdown signal for variable tasks.
 		as_thread_pool_task task;
 		task.task_fn = NULL;
 		task.task_data = NULL;
+		task.group = NULL;
 
 		for (uint32_t i = 0; i < count; i++) {
 			cf_queue_push(pool->dispatch_queue, &task);
@@ -137,24 +697,35 @@ as_thread_pool_shutdown_threads(as_thread_pool* pool, uint32_t count)
 
 int
 as_thread_pool_init(as_thread_pool* pool, uint32_t thread_size)
+{
+	return as_thread_pool_init_options(pool, thread_size, NULL);
+}
+
+int
+as_thread_pool_init_fixed(as_thread_pool* pool, uint32_t thread_size, as_task_fn task_fn,
+						  uint32_t task_size, uint32_t task_complete_offset)
 {
 	if (pthread_mutex_init(&pool->lock, NULL)) {
 		return -1;
 	}
-
+	
     if (pthread_mutex_lock(&pool->lock)) {
         return -2;
     }
-
+	
 	// Initialize queues.
-	pool->dispatch_queue = cf_queue_create(sizeof(as_thread_pool_task), true);
+	pool->dispatch_queue = cf_queue_create(task_size, true);
 	pool->complete_queue = cf_queue_create(sizeof(uint32_t), true);
-	pool->task_fn = 0;
+	pool->task_fn = task_fn;
 	pool->fini_fn = NULL;
-	pool->task_size = 0;
-	pool->task_complete_offset = 0;
-	pool->thread_size = thread_size;
+	pool->task_size = task_size;
+	pool->task_complete_offset = task_complete_offset;
+	pool->thread_size = 0;
 	pool->initialized = 1;
+	pool->workers = NULL;
+	pool->worker_count = 0;
+	pool->stealing = false;
+	as_thread_pool_set_options(pool, NULL);
 	
 	// Start detached threads.
 	pool->thread_size = as_thread_pool_create_threads(pool, thread_size);
@@ -165,31 +736,65 @@ as_thread_pool_init(as_thread_pool* pool, uint32_t thread_size)
 }
 
 int
-as_thread_pool_init_fixed(as_thread_pool* pool, uint32_t thread_size, as_task_fn task_fn,
-						  uint32_t task_size, uint32_t task_complete_offset)
+as_thread_pool_init_stealing(as_thread_pool* pool, uint32_t thread_size)
 {
+	as_thread_pool_options options = {
+		.stealing = true
+	};
+
+	return as_thread_pool_init_options(pool, thread_size, &options);
+}
+
+int
+as_thread_pool_init_options(as_thread_pool* pool, uint32_t thread_size,
+							const as_thread_pool_options* options)
+{
+	bool stealing = options && options->stealing;
+
 	if (pthread_mutex_init(&pool->lock, NULL)) {
 		return -1;
 	}
-	
-    if (pthread_mutex_lock(&pool->lock)) {
-        return -2;
-    }
-	
-	// Initialize queues.
-	pool->dispatch_queue = cf_queue_create(task_size, true);
+
+	if (stealing) {
+		if (pthread_mutex_init(&pool->idle_lock, NULL)) {
+			pthread_mutex_destroy(&pool->lock);
+			return -1;
+		}
+
+		if (pthread_cond_init(&pool->idle_cond, NULL)) {
+			pthread_mutex_destroy(&pool->idle_lock);
+			pthread_mutex_destroy(&pool->lock);
+			return -1;
+		}
+	}
+
+	if (pthread_mutex_lock(&pool->lock)) {
+		return -2;
+	}
+
+	// Initialize queues. In work stealing mode, initialize the worker table
+	// instead of the dispatch queue - workers are created with their threads.
+	pool->dispatch_queue = stealing ? NULL : cf_queue_create(sizeof(as_thread_pool_task), true);
 	pool->complete_queue = cf_queue_create(sizeof(uint32_t), true);
-	pool->task_fn = task_fn;
+	pool->task_fn = 0;
 	pool->fini_fn = NULL;
-	pool->task_size = task_size;
-	pool->task_complete_offset = task_complete_offset;
-	pool->thread_size = thread_size;
+	pool->task_size = 0;
+	pool->task_complete_offset = 0;
+	pool->thread_size = 0;
 	pool->initialized = 1;
-	
+	pool->workers = stealing ?
+			cf_malloc(sizeof(as_thread_pool_worker*) * AS_THREAD_POOL_MAX_WORKERS) : NULL;
+	pool->worker_count = 0;
+	pool->next_worker = 0;
+	pool->sleepers = 0;
+	pool->waking = 0;
+	pool->stealing = stealing;
+	as_thread_pool_set_options(pool, options);
+
 	// Start detached threads.
 	pool->thread_size = as_thread_pool_create_threads(pool, thread_size);
 	int rc = (pool->thread_size == thread_size)? 0 : -3;
-	
+
 	pthread_mutex_unlock(&pool->lock);
 	return rc;
 }
@@ -238,6 +843,15 @@ as_thread_pool_resize(as_thread_pool* pool, uint32_t thread_size)
 int
 as_thread_pool_queue_task(as_thread_pool* pool, as_task_fn task_fn, void* task)
 {
+	if (pool->stealing) {
+		// Checks thread_size itself - tasks may queue more while stopping.
+		as_thread_pool_task vtask;
+		vtask.task_fn = task_fn;
+		vtask.task_data = task;
+		vtask.group = NULL;
+		return as_thread_pool_submit(pool, &vtask);
+	}
+
 	if (pool->thread_size == 0) {
 		// No threads are running to process task.
 		return -1;
@@ -248,6 +862,7 @@ as_thread_pool_queue_task(as_thread_pool* pool, as_task_fn task_fn, void* task)
 		as_thread_pool_task vtask;
 		vtask.task_fn = task_fn;
 		vtask.task_data = task;
+		vtask.group = NULL;
 		
 		if (cf_queue_push(pool->dispatch_queue, &vtask) != CF_QUEUE_OK) {
 			return -2;
@@ -270,12 +885,251 @@ as_thread_pool_queue_task_fixed(as_thread_pool* pool, void* task)
 		return -1;
 	}
 	
+	if (pool->stealing) {
+		// Fixed tasks are not supported in work stealing pools.
+		return -2;
+	}
+
 	if (cf_queue_push(pool->dispatch_queue, task) != CF_QUEUE_OK) {
 		return -2;
 	}
 	return 0;
 }
 
+int
+as_task_group_init(as_task_group* group, as_thread_pool* pool)
+{
+	if (pthread_mutex_init(&group->lock, NULL)) {
+		return -1;
+	}
+
+	if (pthread_cond_init(&group->cond, NULL)) {
+		pthread_mutex_destroy(&group->lock);
+		return -1;
+	}
+
+	group->pool = pool;
+	group->pending = 0;
+	return 0;
+}
+
+void
+as_task_group_destroy(as_task_group* group)
+{
+	// The last completion may still be releasing the lock.
+	pthread_mutex_lock(&group->lock);
+	pthread_mutex_unlock(&group->lock);
+
+	pthread_cond_destroy(&group->cond);
+	pthread_mutex_destroy(&group->lock);
+}
+
+int
+as_task_group_queue(as_task_group* group, as_task_fn task_fn, void* task)
+{
+	as_thread_pool* pool = group->pool;
+
+	if (pool->task_size != 0) {
+		// Fixed tasks can't carry a group.
+		return -2;
+	}
+
+	as_thread_pool_task vtask;
+	vtask.task_fn = task_fn;
+	vtask.task_data = task;
+	vtask.group = group;
+
+	as_incr_uint32(&group->pending);
+
+	int rc;
+
+	if (pool->stealing) {
+		rc = as_thread_pool_submit(pool, &vtask);
+	}
+	else if (pool->thread_size == 0) {
+		rc = -1;
+	}
+	else {
+		rc = cf_queue_push(pool->dispatch_queue, &vtask) == CF_QUEUE_OK ? 0 : -2;
+	}
+
+	if (rc != 0) {
+		as_task_group_complete(group);
+	}
+	return rc;
+}
+
+static bool
+as_task_group_help(as_task_group* group)
+{
+	// Run a task of the pool, if this is one of its work stealing threads.
+	as_thread_pool_worker* w = as_thread_pool_current;
+	as_thread_pool_task task;
+
+	if (! w || w->pool != group->pool) {
+		return false;
+	}
+
+	if (as_thread_pool_deque_pop(w, &task) ||
+			as_thread_pool_take_inbox(w, &task) ||
+			as_thread_pool_steal(w->pool, w, &task)) {
+		as_thread_pool_run(&task);
+		return true;
+	}
+	return false;
+}
+
+int
+as_task_group_wait(as_task_group* group, int ms_wait)
+{
+	uint64_t deadline = ms_wait > 0 ? cf_getms() + (uint64_t)ms_wait : 0;
+	as_thread_pool_worker* w = as_thread_pool_current;
+	bool helping = w && w->pool == group->pool && ms_wait != CF_QUEUE_NOWAIT;
+
+	while (true) {
+		// A pool thread runs tasks while it waits, in case the ones it waits
+		// for are queued behind it.
+		while (helping && as_load_uint32(&group->pending) != 0 &&
+				(ms_wait < 0 || cf_getms() < deadline) &&
+				as_task_group_help(group)) {
+		}
+
+		// Done only once seen under the lock, after the last completion has
+		// let go of it.
+		pthread_mutex_lock(&group->lock);
+
+		if (group->pending == 0) {
+			pthread_mutex_unlock(&group->lock);
+			return 0;
+		}
+
+		int wait = ms_wait;
+
+		if (ms_wait > 0) {
+			uint64_t now = cf_getms();
+			wait = now < deadline ? (int)(deadline - now) : 0;
+		}
+
+		if (wait == 0) {
+			pthread_mutex_unlock(&group->lock);
+			return -1;
+		}
+
+		if (helping && (wait < 0 || wait > 1)) {
+			// Look for tasks to run again soon.
+			wait = 1;
+		}
+
+		if (wait < 0) {
+			pthread_cond_wait(&group->cond, &group->lock);
+		}
+		else {
+			struct timespec tp;
+			cf_set_wait_timespec(wait, &tp);
+			pthread_cond_timedwait(&group->cond, &group->lock, &tp);
+		}
+
+		pthread_mutex_unlock(&group->lock);
+	}
+}
+
+static void
+as_thread_pool_range_release(as_thread_pool_range* range)
+{
+	if (as_aaf_uint32(&range->ref_count, -1) == 0) {
+		as_task_group_destroy(&range->group);
+		cf_free(range);
+	}
+}
+
+static void
+as_thread_pool_range_run(as_thread_pool_range* range)
+{
+	while (true) {
+		uint64_t i = as_faa_uint64(&range->next, 1);
+
+		if (i >= range->n_chunks) {
+			return;
+		}
+
+		uint64_t begin = range->begin + i * range->chunk;
+		uint64_t end = range->end - begin > range->chunk ? begin + range->chunk : range->end;
+
+		range->fn(range->udata, begin, end);
+		as_task_group_complete(&range->group);
+	}
+}
+
+static void
+as_thread_pool_range_task(void* data)
+{
+	as_thread_pool_range* range = data;
+
+	as_thread_pool_range_run(range);
+	as_thread_pool_range_release(range);
+}
+
+void
+as_thread_pool_parallel_for(as_thread_pool* pool, uint64_t begin, uint64_t end, uint64_t grain,
+							as_range_fn fn, void* udata)
+{
+	if (begin >= end) {
+		return;
+	}
+
+	uint32_t threads = pool->thread_size;
+	uint64_t n = end - begin;
+	uint64_t chunk = grain;
+
+	if (chunk == 0) {
+		// Several chunks per thread, so threads that finish early pick up
+		// the slack.
+		chunk = n / ((uint64_t)(threads + 1) * 8);
+		chunk = chunk != 0 ? chunk : 1;
+	}
+
+	if ((n - 1) / chunk >= AS_THREAD_POOL_MAX_CHUNKS) {
+		chunk = (n - 1) / AS_THREAD_POOL_MAX_CHUNKS + 1;
+	}
+
+	uint64_t n_chunks = (n - 1) / chunk + 1;
+	as_thread_pool_range* range = NULL;
+
+	if (threads != 0 && n_chunks > 1 && pool->task_size == 0) {
+		range = cf_malloc(sizeof(as_thread_pool_range));
+	}
+
+	if (! range || as_task_group_init(&range->group, pool) != 0) {
+		cf_free(range);
+		fn(udata, begin, end);
+		return;
+	}
+
+	range->fn = fn;
+	range->udata = udata;
+	range->begin = begin;
+	range->end = end;
+	range->chunk = chunk;
+	range->n_chunks = n_chunks;
+	range->next = 0;
+	range->group.pending = (uint32_t)n_chunks;
+
+	// The caller takes chunks too, so only n_chunks - 1 tasks can help.
+	uint32_t helpers = n_chunks - 1 < threads ? (uint32_t)(n_chunks - 1) : threads;
+
+	range->ref_count = helpers + 1;
+
+	for (uint32_t i = 0; i < helpers; i++) {
+		if (as_thread_pool_queue_task(pool, as_thread_pool_range_task, range) != 0) {
+			as_thread_pool_range_release(range);
+		}
+	}
+
+	as_thread_pool_range_run(range);
+	as_task_group_wait(&range->group, CF_QUEUE_FOREVER);
+	as_thread_pool_range_release(range);
+}
+
 int
 as_thread_pool_destroy(as_thread_pool* pool)
 {
@@ -289,9 +1143,30 @@ as_thread_pool_destroy(as_thread_pool* pool)
 		return -2;
 	}
 
-	as_thread_pool_shutdown_threads(pool, pool->thread_size);
-	cf_queue_destroy(pool->dispatch_queue);
+	// Disallow new tasks before shutting down threads, as in resize.
+	uint32_t threads_to_shutdown = pool->thread_size;
+	pool->thread_size = 0;
+
+	as_thread_pool_shutdown_threads(pool, threads_to_shutdown);
+
+	if (pool->stealing) {
+		for (uint32_t i = 0; i < pool->worker_count; i++) {
+			cf_queue_destroy(pool->workers[i]->inbox);
+			cf_free(pool->workers[i]);
+		}
+		cf_free(pool->workers);
+		pool->workers = NULL;
+		pool->worker_count = 0;
+		pthread_cond_destroy(&pool->idle_cond);
+		pthread_mutex_destroy(&pool->idle_lock);
+	}
+	else {
+		cf_queue_destroy(pool->dispatch_queue);
+	}
+
 	cf_queue_destroy(pool->complete_queue);
+	cf_free(pool->cpus);
+	pool->cpus = NULL;
 	pool->initialized = 0;
 	pthread_mutex_unlock(&pool->lock);
 	pthread_mutex_destroy(&pool->lock);
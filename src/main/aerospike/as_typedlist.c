@@ -0,0 +1,696 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_double.h>
+#include <aerospike/as_integer.h>
+#include <aerospike/as_list.h>
+#include <aerospike/as_typedlist.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_hash_math.h>
+#include <string.h>
+
+/*******************************************************************************
+ * EXTERNS
+ ******************************************************************************/
+
+extern const as_list_hooks as_typedlist_list_hooks;
+
+/*******************************************************************************
+ * STATIC FUNCTIONS
+ ******************************************************************************/
+
+// Same element hash multiplier as as_arraylist, so equal lists hash equal.
+#define HASH_MULT 0x01000193
+
+static inline int64_t*
+typedlist_ints(const as_typedlist* list)
+{
+	return (int64_t*)list->values;
+}
+
+static inline double*
+typedlist_doubles(const as_typedlist* list)
+{
+	return (double*)list->values;
+}
+
+// Hash of the value at index, as as_val_hashcode() hashes it boxed.
+static inline uint32_t
+typedlist_hash_at(const as_typedlist* list, uint32_t index)
+{
+	if (list->type == AS_INTEGER) {
+		return cf_hash_mix64((uint64_t)typedlist_ints(list)[index]);
+	}
+
+	double d = typedlist_doubles(list)[index];
+
+	// 0.0 and -0.0 are equal, so must hash the same.
+	if (d == 0) {
+		return cf_hash_mix64(0);
+	}
+
+	uint64_t bits;
+	memcpy(&bits, &d, sizeof(bits));
+	return cf_hash_mix64(bits);
+}
+
+// Read a number of the list's type out of v. Only an as_integer fits an
+// AS_INTEGER list and only an as_double fits an AS_DOUBLE list.
+static inline bool
+typedlist_unbox(const as_typedlist* list, const as_val* v, int64_t* i, double* d)
+{
+	if (as_val_type(v) != list->type) {
+		return false;
+	}
+
+	if (list->type == AS_INTEGER) {
+		*i = as_integer_get((const as_integer*)v);
+	}
+	else {
+		*d = as_double_get((const as_double*)v);
+	}
+
+	return true;
+}
+
+// Drop the box handed out for index, if any.
+static inline void
+typedlist_drop_box(as_typedlist* list, uint32_t index)
+{
+	if (list->boxed && list->boxed[index]) {
+		as_val_destroy(list->boxed[index]);
+		list->boxed[index] = NULL;
+	}
+}
+
+// Concurrent readers may box the same element, so the box array and each box
+// are installed with a CAS, and a reader that loses the race destroys its own
+// and uses the winner's. Boxes are a cache, not content - the list is
+// logically unchanged.
+static as_val*
+typedlist_box(const as_typedlist* list, uint32_t index)
+{
+	as_val** boxed = as_load_ptr(&list->boxed);
+
+	if (! boxed) {
+		boxed = (as_val**)cf_calloc(list->capacity, sizeof(as_val*));
+
+		if (! boxed) {
+			return NULL;
+		}
+
+		if (! as_cas_ptr((void**)&list->boxed, NULL, boxed)) {
+			cf_free(boxed);
+			boxed = as_load_ptr(&list->boxed);
+		}
+	}
+
+	as_val* v = as_load_ptr(&boxed[index]);
+
+	if (! v) {
+		v = list->type == AS_INTEGER ?
+				(as_val*)as_integer_new_shared(typedlist_ints(list)[index]) :
+				(as_val*)as_double_new(typedlist_doubles(list)[index]);
+
+		if (v && ! as_cas_ptr((void**)&boxed[index], NULL, v)) {
+			as_val_destroy(v);
+			v = as_load_ptr(&boxed[index]);
+		}
+	}
+
+	return v;
+}
+
+static int
+typedlist_resize(as_typedlist* list, uint32_t capacity)
+{
+	void* values = cf_realloc(list->values, (size_t)capacity * 8);
+
+	if (! values) {
+		return AS_ARRAYLIST_ERR_ALLOC;
+	}
+
+	list->values = values;
+
+	if (list->boxed) {
+		as_val** boxed = (as_val**)cf_realloc(list->boxed,
+				sizeof(as_val*) * capacity);
+
+		if (! boxed) {
+			return AS_ARRAYLIST_ERR_ALLOC;
+		}
+
+		if (capacity > list->capacity) {
+			memset(boxed + list->capacity, 0,
+					sizeof(as_val*) * (capacity - list->capacity));
+		}
+
+		list->boxed = boxed;
+	}
+
+	list->capacity = capacity;
+	return AS_ARRAYLIST_OK;
+}
+
+// Make room for delta more values, doubling so appends are amortized O(1).
+static int
+typedlist_ensure(as_typedlist* list, uint32_t delta)
+{
+	uint64_t needed = (uint64_t)list->size + delta;
+
+	if (needed <= list->capacity) {
+		return AS_ARRAYLIST_OK;
+	}
+
+	uint64_t capacity = (uint64_t)list->capacity * 2;
+
+	if (capacity < AS_TYPEDLIST_MIN_CAPACITY) {
+		capacity = AS_TYPEDLIST_MIN_CAPACITY;
+	}
+
+	if (capacity < needed) {
+		capacity = needed;
+	}
+
+	if (capacity > UINT32_MAX) {
+		if (needed > UINT32_MAX) {
+			return AS_ARRAYLIST_ERR_MAX;
+		}
+		capacity = UINT32_MAX;
+	}
+
+	return typedlist_resize(list, (uint32_t)capacity);
+}
+
+// Open a gap of one value at index.
+static int
+typedlist_open(as_typedlist* list, uint32_t index)
+{
+	if (index > list->size) {
+		return AS_ARRAYLIST_ERR_INDEX;
+	}
+
+	int rc = typedlist_ensure(list, 1);
+
+	if (rc != AS_ARRAYLIST_OK) {
+		return rc;
+	}
+
+	uint32_t tail = list->size - index;
+	int64_t* values = typedlist_ints(list);
+
+	memmove(values + index + 1, values + index, (size_t)tail * 8);
+
+	if (list->boxed) {
+		memmove(list->boxed + index + 1, list->boxed + index,
+				sizeof(as_val*) * tail);
+		list->boxed[index] = NULL;
+	}
+
+	list->size++;
+	list->hash_valid = false;
+	return AS_ARRAYLIST_OK;
+}
+
+// Make index writable, appending if it is the end of the list.
+static int
+typedlist_at(as_typedlist* list, uint32_t index)
+{
+	if (index == list->size) {
+		return typedlist_open(list, index);
+	}
+
+	if (index > list->size) {
+		return AS_ARRAYLIST_ERR_INDEX;
+	}
+
+	typedlist_drop_box(list, index);
+	list->hash_valid = false;
+	return AS_ARRAYLIST_OK;
+}
+
+static as_typedlist*
+as_typedlist_cons(as_typedlist* list, as_val_t type, uint32_t capacity)
+{
+	list->type = type;
+	list->capacity = 0;
+	list->size = 0;
+	list->hash = 0;
+	list->values = NULL;
+	list->boxed = NULL;
+	list->hash_valid = false;
+
+	if (capacity > 0 && typedlist_resize(list, capacity) != AS_ARRAYLIST_OK) {
+		return NULL;
+	}
+
+	return list;
+}
+
+/*******************************************************************************
+ * INSTANCE FUNCTIONS
+ ******************************************************************************/
+
+as_typedlist*
+as_typedlist_init(as_typedlist* list, as_val_t type, uint32_t capacity)
+{
+	if (! list || (type != AS_INTEGER && type != AS_DOUBLE)) {
+		return NULL;
+	}
+
+	as_list_cons((as_list*)list, false, &as_typedlist_list_hooks);
+	return as_typedlist_cons(list, type, capacity);
+}
+
+as_typedlist*
+as_typedlist_new(as_val_t type, uint32_t capacity)
+{
+	if (type != AS_INTEGER && type != AS_DOUBLE) {
+		return NULL;
+	}
+
+	as_typedlist* list = (as_typedlist*)cf_malloc(sizeof(as_typedlist));
+
+	if (! list) {
+		return NULL;
+	}
+
+	as_list_cons((as_list*)list, true, &as_typedlist_list_hooks);
+
+	if (! as_typedlist_cons(list, type, capacity)) {
+		cf_free(list);
+		return NULL;
+	}
+
+	return list;
+}
+
+bool
+as_typedlist_release(as_typedlist* list)
+{
+	if (list->boxed) {
+		for (uint32_t i = 0; i < list->size; i++) {
+			typedlist_drop_box(list, i);
+		}
+
+		cf_free(list->boxed);
+	}
+
+	cf_free(list->values);
+	list->values = NULL;
+	list->boxed = NULL;
+	list->size = 0;
+	list->capacity = 0;
+	list->hash = 0;
+	list->hash_valid = false;
+
+	return true;
+}
+
+void
+as_typedlist_destroy(as_typedlist* list)
+{
+	as_list_destroy((as_list*)list);
+}
+
+int
+as_typedlist_reserve(as_typedlist* list, uint32_t capacity)
+{
+	if (capacity <= list->capacity) {
+		return AS_ARRAYLIST_OK;
+	}
+
+	return typedlist_resize(list, capacity);
+}
+
+/*******************************************************************************
+ * VALUE FUNCTIONS
+ ******************************************************************************/
+
+// Readers may share the list, as for the boxes, so the hash is published with
+// hash_valid set last. Readers that race store the same hash.
+uint32_t
+as_typedlist_hashcode(const as_typedlist* list)
+{
+	if (as_load_uint8((const uint8_t*)&list->hash_valid)) {
+		as_fence_lock();
+		return cf_hash_mix32(as_load_uint32(&list->hash) + list->size);
+	}
+
+	uint32_t hash = 0;
+	uint32_t mult = 1;
+
+	for (uint32_t i = 0; i < list->size; i++) {
+		hash += typedlist_hash_at(list, i) * mult;
+		mult *= HASH_MULT;
+	}
+
+	as_store_uint32((uint32_t*)&list->hash, hash);
+	as_fence_store();
+	as_store_uint8((uint8_t*)&list->hash_valid, true);
+
+	return cf_hash_mix32(hash + list->size);
+}
+
+uint32_t
+as_typedlist_size(const as_typedlist* list)
+{
+	return list->size;
+}
+
+/*******************************************************************************
+ * ACCESSOR AND MODIFIER FUNCTIONS
+ ******************************************************************************/
+
+as_val*
+as_typedlist_get(const as_typedlist* list, uint32_t index)
+{
+	if (index >= list->size) {
+		return NULL;
+	}
+
+	return typedlist_box(list, index);
+}
+
+int64_t
+as_typedlist_get_int64(const as_typedlist* list, uint32_t index)
+{
+	if (index >= list->size || list->type != AS_INTEGER) {
+		return 0;
+	}
+
+	return typedlist_ints(list)[index];
+}
+
+double
+as_typedlist_get_double(const as_typedlist* list, uint32_t index)
+{
+	if (index >= list->size || list->type != AS_DOUBLE) {
+		return 0.0;
+	}
+
+	return typedlist_doubles(list)[index];
+}
+
+int
+as_typedlist_set(as_typedlist* list, uint32_t index, as_val* value)
+{
+	int64_t i = 0;
+	double d = 0.0;
+
+	if (! typedlist_unbox(list, value, &i, &d)) {
+		return AS_ARRAYLIST_ERR_TYPE;
+	}
+
+	int rc = typedlist_at(list, index);
+
+	if (rc != AS_ARRAYLIST_OK) {
+		return rc;
+	}
+
+	if (list->type == AS_INTEGER) {
+		typedlist_ints(list)[index] = i;
+	}
+	else {
+		typedlist_doubles(list)[index] = d;
+	}
+
+	as_val_destroy(value);
+	return AS_ARRAYLIST_OK;
+}
+
+int
+as_typedlist_set_int64(as_typedlist* list, uint32_t index, int64_t value)
+{
+	if (list->type != AS_INTEGER) {
+		return AS_ARRAYLIST_ERR_TYPE;
+	}
+
+	int rc = typedlist_at(list, index);
+
+	if (rc == AS_ARRAYLIST_OK) {
+		typedlist_ints(list)[index] = value;
+	}
+
+	return rc;
+}
+
+int
+as_typedlist_set_double(as_typedlist* list, uint32_t index, double value)
+{
+	if (list->type != AS_DOUBLE) {
+		return AS_ARRAYLIST_ERR_TYPE;
+	}
+
+	int rc = typedlist_at(list, index);
+
+	if (rc == AS_ARRAYLIST_OK) {
+		typedlist_doubles(list)[index] = value;
+	}
+
+	return rc;
+}
+
+int
+as_typedlist_insert(as_typedlist* list, uint32_t index, as_val* value)
+{
+	int64_t i = 0;
+	double d = 0.0;
+
+	if (! typedlist_unbox(list, value, &i, &d)) {
+		return AS_ARRAYLIST_ERR_TYPE;
+	}
+
+	int rc = typedlist_open(list, index);
+
+	if (rc != AS_ARRAYLIST_OK) {
+		return rc;
+	}
+
+	if (list->type == AS_INTEGER) {
+		typedlist_ints(list)[index] = i;
+	}
+	else {
+		typedlist_doubles(list)[index] = d;
+	}
+
+	as_val_destroy(value);
+	return AS_ARRAYLIST_OK;
+}
+
+int
+as_typedlist_insert_int64(as_typedlist* list, uint32_t index, int64_t value)
+{
+	if (list->type != AS_INTEGER) {
+		return AS_ARRAYLIST_ERR_TYPE;
+	}
+
+	int rc = typedlist_open(list, index);
+
+	if (rc == AS_ARRAYLIST_OK) {
+		typedlist_ints(list)[index] = value;
+	}
+
+	return rc;
+}
+
+int
+as_typedlist_insert_double(as_typedlist* list, uint32_t index, double value)
+{
+	if (list->type != AS_DOUBLE) {
+		return AS_ARRAYLIST_ERR_TYPE;
+	}
+
+	int rc = typedlist_open(list, index);
+
+	if (rc == AS_ARRAYLIST_OK) {
+		typedlist_doubles(list)[index] = value;
+	}
+
+	return rc;
+}
+
+int
+as_typedlist_append(as_typedlist* list, as_val* value)
+{
+	return as_typedlist_insert(list, list->size, value);
+}
+
+int
+as_typedlist_append_int64(as_typedlist* list, int64_t value)
+{
+	return as_typedlist_insert_int64(list, list->size, value);
+}
+
+int
+as_typedlist_append_double(as_typedlist* list, double value)
+{
+	return as_typedlist_insert_double(list, list->size, value);
+}
+
+int
+as_typedlist_remove(as_typedlist* list, uint32_t index)
+{
+	if (index >= list->size) {
+		return AS_ARRAYLIST_ERR_INDEX;
+	}
+
+	typedlist_drop_box(list, index);
+
+	uint32_t tail = list->size - index - 1;
+	int64_t* values = typedlist_ints(list);
+
+	memmove(values + index, values + index + 1, (size_t)tail * 8);
+
+	if (list->boxed) {
+		memmove(list->boxed + index, list->boxed + index + 1,
+				sizeof(as_val*) * tail);
+		list->boxed[list->size - 1] = NULL;
+	}
+
+	list->size--;
+	list->hash_valid = false;
+	return AS_ARRAYLIST_OK;
+}
+
+typedef struct {
+	as_typedlist* list;
+	uint32_t i;
+} typedlist_concat_data;
+
+static bool
+typedlist_concat_check(as_val* v, void* udata)
+{
+	typedlist_concat_data* data = (typedlist_concat_data*)udata;
+	int64_t i;
+	double d;
+
+	return typedlist_unbox(data->list, v, &i, &d);
+}
+
+static bool
+typedlist_concat_copy(as_val* v, void* udata)
+{
+	typedlist_concat_data* data = (typedlist_concat_data*)udata;
+	as_typedlist* list = data->list;
+	uint32_t index = list->size + data->i++;
+
+	typedlist_unbox(list, v, &typedlist_ints(list)[index],
+			&typedlist_doubles(list)[index]);
+	return true;
+}
+
+int
+as_typedlist_concat(as_typedlist* list, const as_list* list2)
+{
+	uint32_t n = as_list_size((as_list*)list2);
+
+	if (list2->hooks == &as_typedlist_list_hooks) {
+		const as_typedlist* t2 = (const as_typedlist*)list2;
+
+		if (t2->type != list->type) {
+			return AS_ARRAYLIST_ERR_TYPE;
+		}
+
+		int rc = typedlist_ensure(list, n);
+
+		if (rc != AS_ARRAYLIST_OK) {
+			return rc;
+		}
+
+		memcpy(typedlist_ints(list) + list->size, t2->values, (size_t)n * 8);
+	}
+	else {
+		// Check every element before changing anything.
+		typedlist_concat_data data = { list, 0 };
+
+		if (! as_list_foreach(list2, typedlist_concat_check, &data)) {
+			return AS_ARRAYLIST_ERR_TYPE;
+		}
+
+		int rc = typedlist_ensure(list, n);
+
+		if (rc != AS_ARRAYLIST_OK) {
+			return rc;
+		}
+
+		as_list_foreach(list2, typedlist_concat_copy, &data);
+	}
+
+	list->size += n;
+	list->hash_valid = false;
+	return AS_ARRAYLIST_OK;
+}
+
+int
+as_typedlist_trim(as_typedlist* list, uint32_t index)
+{
+	if (index >= list->size) {
+		return AS_ARRAYLIST_ERR_INDEX;
+	}
+
+	for (uint32_t i = index; i < list->size; i++) {
+		typedlist_drop_box(list, i);
+	}
+
+	list->size = index;
+	list->hash_valid = false;
+	return AS_ARRAYLIST_OK;
+}
+
+as_typedlist*
+as_typedlist_range(const as_typedlist* list, uint32_t index, uint32_t count)
+{
+	if (index > list->size) {
+		index = list->size;
+	}
+
+	if (count > list->size - index) {
+		count = list->size - index;
+	}
+
+	as_typedlist* list2 = as_typedlist_new(list->type, count);
+
+	if (! list2) {
+		return NULL;
+	}
+
+	if (count != 0) {
+		memcpy(list2->values, typedlist_ints(list) + index, (size_t)count * 8);
+	}
+
+	list2->size = count;
+	return list2;
+}
+
+/*******************************************************************************
+ * ITERATION FUNCTIONS
+ ******************************************************************************/
+
+bool
+as_typedlist_foreach(const as_typedlist* list, as_list_foreach_callback callback, void* udata)
+{
+	for (uint32_t i = 0; i < list->size; i++) {
+		as_val* v = as_typedlist_get(list, i);
+
+		if (! v || ! callback(v, udata)) {
+			return false;
+		}
+	}
+
+	return true;
+}
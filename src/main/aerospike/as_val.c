@@ -138,7 +138,11 @@ static as_val * as_val_reserve_noop(as_val * v)
 
 static as_val * as_val_reserve_count(as_val * v)
 {
-	as_incr_uint32(&v->count);
+	// Values without a count, like shared integers and arena values, aren't
+	// reference counted - as_val_destroy() ignores them too.
+	if ( as_load_uint32(&v->count) != 0 ) {
+		as_incr_uint32(&v->count);
+	}
 	return v;
 }
 
@@ -119,28 +119,26 @@ cf_queue_sz(cf_queue *q)
 }
 
 //
-// Internal function. Call with new size with lock held. This function only
-// works on full queues.
+// Internal function. Call with new size with lock held. The new size must be
+// big enough for the elements already queued.
 //
 static int
 cf_queue_resize(cf_queue *q, uint32_t new_sz)
 {
-	// Check if queue is not full.
-	if (CF_Q_SZ(q) != q->alloc_sz) {
+	uint32_t sz = CF_Q_SZ(q);
+
+	if (new_sz < sz) {
 		return CF_QUEUE_ERR;
 	}
 
-	// The rare case where the queue is not fragmented, and realloc makes sense
-	// and none of the offsets need to move.
+	// The case where the queue is not fragmented, and realloc makes sense and
+	// none of the offsets need to move.
 	if (0 == q->read_offset % q->alloc_sz) {
 		q->elements = (uint8_t*)cf_realloc(q->elements, new_sz * q->element_sz);
 
 		if (! q->elements) {
 			return CF_QUEUE_ERR;
 		}
-
-		q->read_offset = 0;
-		q->write_offset = q->alloc_sz;
 	}
 	else {
 		uint8_t *newq = (uint8_t*)cf_malloc(new_sz * q->element_sz);
@@ -149,21 +147,26 @@ cf_queue_resize(cf_queue *q, uint32_t new_sz)
 			return CF_QUEUE_ERR;
 		}
 
-		// end_sz is used bytes in old queue from insert point to end.
-		size_t end_sz =
-				(q->alloc_sz - (q->read_offset % q->alloc_sz)) * q->element_sz;
+		// end_n is queued elements from the read point to the end of the old
+		// queue, the rest wrap around to its start.
+		uint32_t r_index = q->read_offset % q->alloc_sz;
+		uint32_t end_n = q->alloc_sz - r_index;
+
+		if (end_n > sz) {
+			end_n = sz;
+		}
+
+		size_t end_sz = end_n * q->element_sz;
 
 		memcpy(&newq[0], CF_Q_ELEM_PTR(q, q->read_offset), end_sz);
-		memcpy(&newq[end_sz], &q->elements[0],
-				(q->alloc_sz * q->element_sz) - end_sz);
+		memcpy(&newq[end_sz], &q->elements[0], (sz - end_n) * q->element_sz);
 
 		cf_free(q->elements);
 		q->elements = newq;
-
-		q->write_offset = q->alloc_sz;
-		q->read_offset = 0;
 	}
 
+	q->write_offset = sz;
+	q->read_offset = 0;
 	q->alloc_sz = new_sz;
 
 	return CF_QUEUE_OK;
@@ -320,47 +323,116 @@ cf_queue_push_head(cf_queue *q, const void *ptr)
 }
 
 //
-// If ms_wait < 0, wait forever.
-// If ms_wait = 0, don't wait at all.
-// If ms_wait > 0, wait that number of milliseconds.
+// Push n elements to the tail of the queue, growing it at most once.
 //
 int
-cf_queue_pop(cf_queue *q, void *buf, int ms_wait)
+cf_queue_push_n(cf_queue *q, const void *ptr, uint32_t n)
+{
+	if (n == 0) {
+		return CF_QUEUE_OK;
+	}
+
+	cf_queue_lock(q);
+
+	uint32_t sz = CF_Q_SZ(q);
+
+	if (n > q->alloc_sz - sz) {
+		uint64_t new_sz = q->alloc_sz != 0 ? q->alloc_sz : 1;
+
+		while (new_sz < (uint64_t)sz + n) {
+			new_sz *= 2;
+		}
+
+		if (new_sz > 0x40000000 || 0 != cf_queue_resize(q, (uint32_t)new_sz)) {
+			cf_queue_unlock(q);
+			return CF_QUEUE_ERR;
+		}
+	}
+
+	// At most two copies - up to the end of the ring, then from its start.
+	uint32_t w_index = q->write_offset % q->alloc_sz;
+	uint32_t end_n = q->alloc_sz - w_index;
+
+	if (end_n > n) {
+		end_n = n;
+	}
+
+	size_t end_sz = end_n * q->element_sz;
+
+	memcpy(&q->elements[w_index * q->element_sz], ptr, end_sz);
+	memcpy(&q->elements[0], (const uint8_t*)ptr + end_sz,
+			(n - end_n) * q->element_sz);
+
+	q->write_offset += n;
+	cf_queue_unwrap(q);
+
+	if (q->threadsafe) {
+		if (n == 1) {
+			pthread_cond_signal(&q->CV);
+		}
+		else {
+			pthread_cond_broadcast(&q->CV);
+		}
+	}
+
+	cf_queue_unlock(q);
+	return CF_QUEUE_OK;
+}
+
+//
+// Wait, with lock held, until the queue is not empty. Returns with the lock
+// released if the queue is still empty.
+//
+static int
+cf_queue_wait(cf_queue *q, int ms_wait)
 {
+	if (! q->threadsafe) {
+		return CF_Q_EMPTY(q) ? CF_QUEUE_EMPTY : CF_QUEUE_OK;
+	}
+
 	struct timespec tp;
 
 	if (ms_wait > 0) {
 		cf_set_wait_timespec(ms_wait, &tp);
 	}
 
-	cf_queue_lock(q);
-
-	if (q->threadsafe) {
+	// Note that we have to use a while() loop. The pthread_cond_signal()
+	// documentation says that AT LEAST ONE waiting thread will be awakened.
+	// If more than one are awakened, the first will get the popped element,
+	// others will find the queue empty and go back to waiting.
 
-		// Note that we have to use a while() loop. The pthread_cond_signal()
-		// documentation says that AT LEAST ONE waiting thread will be awakened.
-		// If more than one are awakened, the first will get the popped element,
-		// others will find the queue empty and go back to waiting.
+	while (CF_Q_EMPTY(q)) {
+		if (CF_QUEUE_FOREVER == ms_wait) {
+			pthread_cond_wait(&q->CV, &q->LOCK);
+		}
+		else if (CF_QUEUE_NOWAIT == ms_wait) {
+			pthread_mutex_unlock(&q->LOCK);
+			return CF_QUEUE_EMPTY;
+		}
+		else {
+			pthread_cond_timedwait(&q->CV, &q->LOCK, &tp);
 
-		while (CF_Q_EMPTY(q)) {
-			if (CF_QUEUE_FOREVER == ms_wait) {
-				pthread_cond_wait(&q->CV, &q->LOCK);
-			}
-			else if (CF_QUEUE_NOWAIT == ms_wait) {
+			if (CF_Q_EMPTY(q)) {
 				pthread_mutex_unlock(&q->LOCK);
 				return CF_QUEUE_EMPTY;
 			}
-			else {
-				pthread_cond_timedwait(&q->CV, &q->LOCK, &tp);
-
-				if (CF_Q_EMPTY(q)) {
-					pthread_mutex_unlock(&q->LOCK);
-					return CF_QUEUE_EMPTY;
-				}
-			}
 		}
 	}
-	else if (CF_Q_EMPTY(q)) {
+
+	return CF_QUEUE_OK;
+}
+
+//
+// If ms_wait < 0, wait forever.
+// If ms_wait = 0, don't wait at all.
+// If ms_wait > 0, wait that number of milliseconds.
+//
+int
+cf_queue_pop(cf_queue *q, void *buf, int ms_wait)
+{
+	cf_queue_lock(q);
+
+	if (cf_queue_wait(q, ms_wait) != CF_QUEUE_OK) {
 		return CF_QUEUE_EMPTY;
 	}
 
@@ -376,6 +448,53 @@ cf_queue_pop(cf_queue *q, void *buf, int ms_wait)
 	return CF_QUEUE_OK;
 }
 
+//
+// Pop up to n elements from the head of the queue, waiting as cf_queue_pop()
+// does for the first one.
+//
+int
+cf_queue_pop_n(cf_queue *q, void *buf, uint32_t n, int ms_wait)
+{
+	if (n == 0) {
+		return 0;
+	}
+
+	cf_queue_lock(q);
+
+	if (cf_queue_wait(q, ms_wait) != CF_QUEUE_OK) {
+		return CF_QUEUE_EMPTY;
+	}
+
+	uint32_t sz = CF_Q_SZ(q);
+
+	if (n > sz) {
+		n = sz;
+	}
+
+	// At most two copies - up to the end of the ring, then from its start.
+	uint32_t r_index = q->read_offset % q->alloc_sz;
+	uint32_t end_n = q->alloc_sz - r_index;
+
+	if (end_n > n) {
+		end_n = n;
+	}
+
+	size_t end_sz = end_n * q->element_sz;
+
+	memcpy(buf, &q->elements[r_index * q->element_sz], end_sz);
+	memcpy((uint8_t*)buf + end_sz, &q->elements[0],
+			(n - end_n) * q->element_sz);
+
+	q->read_offset += n;
+
+	if (q->read_offset == q->write_offset) {
+		q->read_offset = q->write_offset = 0;
+	}
+
+	cf_queue_unlock(q);
+	return (int)n;
+}
+
 void
 cf_queue_delete_offset(cf_queue *q, uint32_t index)
 {
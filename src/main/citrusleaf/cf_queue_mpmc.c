@@ -0,0 +1,320 @@
+/*
+ * Copyright 2008-2019 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <citrusleaf/cf_queue_mpmc.h>
+#include <citrusleaf/cf_clock.h>
+#include <citrusleaf/alloc.h>
+#include <aerospike/as_atomic.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ ******************************************************************************/
+
+// A cell is its sequence number, followed by the element 8 bytes in. The
+// sequence number is pos when the cell is free for the push at pos, and
+// pos + 1 once that element can be popped.
+static inline uint32_t *
+cf_queue_mpmc_cell(cf_queue_mpmc *q, uint32_t pos)
+{
+	return (uint32_t*)(q->cells + (size_t)(pos & q->mask) * q->cell_sz);
+}
+
+static inline uint8_t *
+cf_queue_mpmc_element(uint32_t *cell)
+{
+	return (uint8_t*)cell + 8;
+}
+
+static void
+cf_queue_mpmc_park(cf_queue_mpmc *q, uint32_t wakeups, int ms_wait)
+{
+#if defined(__linux__)
+	struct timespec ts;
+	struct timespec *tp = NULL;
+
+	if (ms_wait >= 0) {
+		ts.tv_sec = ms_wait / 1000;
+		ts.tv_nsec = (ms_wait % 1000) * 1000000;
+		tp = &ts;
+	}
+
+	// Returns at once if wakeups has already moved on.
+	syscall(SYS_futex, &q->wakeups, FUTEX_WAIT_PRIVATE, wakeups, tp, NULL, 0);
+#else
+	struct timespec tp;
+
+	if (ms_wait >= 0) {
+		cf_set_wait_timespec(ms_wait, &tp);
+	}
+
+	pthread_mutex_lock(&q->LOCK);
+
+	while (as_load_uint32(&q->wakeups) == wakeups) {
+		if (ms_wait < 0) {
+			pthread_cond_wait(&q->CV, &q->LOCK);
+		}
+		else if (pthread_cond_timedwait(&q->CV, &q->LOCK, &tp) != 0) {
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&q->LOCK);
+#endif
+}
+
+static void
+cf_queue_mpmc_unpark(cf_queue_mpmc *q)
+{
+	as_incr_uint32(&q->wakeups);
+
+#if defined(__linux__)
+	syscall(SYS_futex, &q->wakeups, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+	pthread_mutex_lock(&q->LOCK);
+	pthread_cond_signal(&q->CV);
+	pthread_mutex_unlock(&q->LOCK);
+#endif
+}
+
+static bool
+cf_queue_mpmc_trypop(cf_queue_mpmc *q, void *buf)
+{
+	uint32_t pos = as_load_uint32(&q->pop_pos);
+	uint32_t *cell;
+
+	while (true) {
+		cell = cf_queue_mpmc_cell(q, pos);
+
+		int32_t diff = (int32_t)(as_load_uint32(cell) - (pos + 1));
+
+		if (diff == 0) {
+			if (as_cas_uint32(&q->pop_pos, pos, pos + 1)) {
+				break;
+			}
+		}
+		else if (diff < 0) {
+			// Nothing pushed to this cell yet - the queue is empty.
+			return false;
+		}
+
+		pos = as_load_uint32(&q->pop_pos);
+	}
+
+	as_fence_lock();
+	memcpy(buf, cf_queue_mpmc_element(cell), q->element_sz);
+
+	// Hand the cell to the push one lap on.
+	as_fence_unlock();
+	as_store_uint32(cell, pos + q->mask + 1);
+	return true;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+
+bool
+cf_queue_mpmc_init(cf_queue_mpmc *q, size_t element_sz, uint32_t capacity)
+{
+	if (capacity == 0 || capacity > 0x80000000 || element_sz > 0x7ffffff0) {
+		return false;
+	}
+
+	uint32_t n = 1;
+
+	while (n < capacity) {
+		n <<= 1;
+	}
+
+	q->push_pos = 0;
+	q->pop_pos = 0;
+	q->waiters = 0;
+	q->wakeups = 0;
+	q->mask = n - 1;
+	q->cell_sz = 8 + (uint32_t)((element_sz + 7) & ~(size_t)7);
+	q->element_sz = element_sz;
+	q->free_struct = false;
+
+	q->cells = (uint8_t*)cf_malloc((size_t)n * q->cell_sz);
+
+	if (! q->cells) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < n; i++) {
+		*cf_queue_mpmc_cell(q, i) = i;
+	}
+
+#if !defined(__linux__)
+	if (0 != pthread_mutex_init(&q->LOCK, NULL)) {
+		cf_free(q->cells);
+		return false;
+	}
+
+	if (0 != pthread_cond_init(&q->CV, NULL)) {
+		pthread_mutex_destroy(&q->LOCK);
+		cf_free(q->cells);
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+cf_queue_mpmc *
+cf_queue_mpmc_create(size_t element_sz, uint32_t capacity)
+{
+	cf_queue_mpmc *q = (cf_queue_mpmc*)cf_malloc(sizeof(cf_queue_mpmc));
+
+	if (! q) {
+		return NULL;
+	}
+
+	if (! cf_queue_mpmc_init(q, element_sz, capacity)) {
+		cf_free(q);
+		return NULL;
+	}
+
+	q->free_struct = true;
+
+	return q;
+}
+
+void
+cf_queue_mpmc_destroy(cf_queue_mpmc *q)
+{
+#if !defined(__linux__)
+	pthread_cond_destroy(&q->CV);
+	pthread_mutex_destroy(&q->LOCK);
+#endif
+
+	cf_free(q->cells);
+
+	if (q->free_struct) {
+		memset(q, 0, sizeof(cf_queue_mpmc));
+		cf_free(q);
+	}
+}
+
+int
+cf_queue_mpmc_sz(cf_queue_mpmc *q)
+{
+	uint32_t pop = as_load_uint32(&q->pop_pos);
+	uint32_t push = as_load_uint32(&q->push_pos);
+	int32_t sz = (int32_t)(push - pop);
+
+	if (sz < 0) {
+		return 0;
+	}
+
+	return sz > (int32_t)q->mask ? (int)q->mask + 1 : sz;
+}
+
+int
+cf_queue_mpmc_push(cf_queue_mpmc *q, const void *ptr)
+{
+	uint32_t pos = as_load_uint32(&q->push_pos);
+	uint32_t *cell;
+
+	while (true) {
+		cell = cf_queue_mpmc_cell(q, pos);
+
+		int32_t diff = (int32_t)(as_load_uint32(cell) - pos);
+
+		if (diff == 0) {
+			if (as_cas_uint32(&q->push_pos, pos, pos + 1)) {
+				break;
+			}
+		}
+		else if (diff < 0) {
+			// The cell still holds the element pushed a lap ago.
+			return CF_QUEUE_FULL;
+		}
+
+		pos = as_load_uint32(&q->push_pos);
+	}
+
+	as_fence_lock();
+	memcpy(cf_queue_mpmc_element(cell), ptr, q->element_sz);
+
+	as_fence_unlock();
+	as_store_uint32(cell, pos + 1);
+
+	// Pairs with the fence in cf_queue_mpmc_pop() - either the consumer
+	// finds this element, or we find it waiting.
+	as_fence_memory();
+
+	if (as_load_uint32(&q->waiters) != 0) {
+		cf_queue_mpmc_unpark(q);
+	}
+
+	return CF_QUEUE_OK;
+}
+
+int
+cf_queue_mpmc_pop(cf_queue_mpmc *q, void *buf, int ms_wait)
+{
+	if (cf_queue_mpmc_trypop(q, buf)) {
+		return CF_QUEUE_OK;
+	}
+
+	if (ms_wait == CF_QUEUE_NOWAIT) {
+		return CF_QUEUE_EMPTY;
+	}
+
+	uint64_t deadline = ms_wait > 0 ? cf_getms() + (uint64_t)ms_wait : 0;
+
+	while (true) {
+		uint32_t wakeups = as_load_uint32(&q->wakeups);
+
+		// Count ourselves as waiting before the last look, so a push either
+		// leaves an element for that look or sees us and wakes us up.
+		as_incr_uint32(&q->waiters);
+		as_fence_memory();
+
+		if (cf_queue_mpmc_trypop(q, buf)) {
+			as_decr_uint32(&q->waiters);
+			return CF_QUEUE_OK;
+		}
+
+		int wait = CF_QUEUE_FOREVER;
+
+		if (ms_wait > 0) {
+			uint64_t now = cf_getms();
+
+			if (now >= deadline) {
+				as_decr_uint32(&q->waiters);
+				return CF_QUEUE_EMPTY;
+			}
+
+			wait = (int)(deadline - now);
+		}
+
+		cf_queue_mpmc_park(q, wakeups, wait);
+		as_decr_uint32(&q->waiters);
+
+		if (cf_queue_mpmc_trypop(q, buf)) {
+			return CF_QUEUE_OK;
+		}
+	}
+}
@@ -18,15 +18,22 @@ PLAN(common) {
     plan_add(types_bytes);
     plan_add(types_arraylist);
     plan_add(types_hashmap);
+    plan_add(types_openmap);
+    plan_add(types_orderedmap);
+    plan_add(types_typedlist);
     plan_add(types_nil);
     plan_add(types_vector);
     plan_add(types_queue);
 	plan_add(types_queue_mt);
+	plan_add(types_queue_mpmc);
+	plan_add(types_queue_batch);
 
     plan_add(password);
     plan_add(string_builder);
 	plan_add(random_numbers);
+	plan_add(thread_pool);
 	
 	plan_add(msgpack_roundtrip);
 	plan_add(msgpack_direct);
+	plan_add(msgpack_view);
 }
@@ -6,6 +6,7 @@
 
 #include <aerospike/as_arraylist.h>
 #include <aerospike/as_arraylist_iterator.h>
+#include <aerospike/as_bytes.h>
 #include <aerospike/as_integer.h>
 #include <aerospike/as_hashmap.h>
 #include <aerospike/as_list.h>
@@ -13,6 +14,7 @@
 #include <aerospike/as_map.h>
 #include <aerospike/as_msgpack.h>
 #include <aerospike/as_msgpack_ext.h>
+#include <aerospike/as_msgpack_sort.h>
 #include <aerospike/as_serializer.h>
 #include <aerospike/as_string.h>
 #include <aerospike/as_stringmap.h>
@@ -65,6 +67,19 @@ compare_vals(as_val *v1, as_val *v2)
 		return MSGPACK_COMPARE_ERROR;
 	}
 
+	// The scratch engine must agree and consume the same bytes.
+	size_t scratch_size = as_unpack_compare_scratch_size(64);
+	void *scratch = alloca(scratch_size);
+
+	pk1.offset = 0;
+	pk2.offset = 0;
+
+	if (as_unpack_compare_scratch(&pk1, &pk2, scratch, scratch_size) != ret ||
+			pk1.offset != pk1.length || pk2.offset != pk2.length) {
+		info("scratch compare mismatch")
+		return MSGPACK_COMPARE_ERROR;
+	}
+
 	return ret;
 }
 
@@ -180,6 +195,14 @@ random_val()
 	return list[r]();
 }
 
+static void
+sort_pack_string(as_packer *pk, const char *str)
+{
+	as_string s;
+	as_string_init(&s, (char *)str, false);
+	as_pack_val(pk, (as_val *)&s);
+}
+
 /******************************************************************************
  * TEST CASES
  *****************************************************************************/
@@ -205,6 +228,67 @@ TEST( msgpack_size, "size deep list" )
 	assert( size == MAX_BUF_SIZE );
 }
 
+TEST( msgpack_skip, "skip mixed elements" )
+{
+	uint8_t buf[1024];
+	as_packer pk = {
+			.buffer = buf,
+			.capacity = sizeof(buf)
+	};
+
+	// 100 fixints, including negative ones, broken up by runs of fixstrs and
+	// other types.
+	static const char str[] = "abcdefghijklmnopqrstuvwxyz01234";
+	static const uint32_t str_lens[] = { 3, 0, 31, 1 };
+	uint32_t offsets[112];
+	uint32_t count = 0;
+
+	for (int64_t i = 0; i < 100; i++) {
+		offsets[count++] = pk.offset;
+		as_pack_int64(&pk, i % 2 == 0 ? i : -(i % 32));
+
+		if (i % 40 == 39) {
+			for (uint32_t s = 0; s < 4; s++) {
+				offsets[count++] = pk.offset;
+				as_pack_str(&pk, (const uint8_t *)str, str_lens[s]);
+			}
+
+			offsets[count++] = pk.offset;
+			as_pack_map_header(&pk, 1);
+			as_pack_int64(&pk, 1000);
+			as_pack_list_header(&pk, 2);
+			as_pack_double(&pk, 1.5);
+			as_pack_ext_header(&pk, 2, 7);
+			as_pack_append(&pk, (const uint8_t *)"xy", 2);
+		}
+	}
+
+	offsets[count] = pk.offset;
+
+	for (uint32_t i = 0; i <= count; i++) {
+		as_unpacker upk = {
+				.buffer = buf,
+				.length = pk.offset
+		};
+
+		assert_int_eq(as_unpack_skip(&upk, i), offsets[i]);
+		assert_int_eq(upk.offset, offsets[i]);
+	}
+
+	// Truncated input fails without moving the offset.
+	as_unpacker upk = {
+			.buffer = buf,
+			.offset = offsets[count - 1],
+			.length = pk.offset - 1
+	};
+
+	assert_true(as_unpack_skip(&upk, 1) < 0);
+	assert_int_eq(upk.offset, offsets[count - 1]);
+
+	upk.offset = 0;
+	assert_true(as_unpack_skip(&upk, count + 1) < 0);
+}
+
 TEST( msgpack_compare, "compare deep list" )
 {
 	// uint8_t buf[MAX_BUF_SIZE] will cause stack overflow on windows.
@@ -220,6 +304,43 @@ TEST( msgpack_compare, "compare deep list" )
 	assert( ret == MSGPACK_COMPARE_EQUAL );
 }
 
+TEST( msgpack_compare_scratch, "compare deep list in scratch memory" )
+{
+	uint32_t depth = 1000;
+	uint8_t* buf1 = malloc(depth + 1);
+	uint8_t* buf2 = malloc(depth + 1);
+
+	memset(buf1, 0x91, depth);
+	memset(buf2, 0x91, depth);
+	buf1[depth] = 0x01;
+	buf2[depth] = 0x02;
+
+	size_t scratch_size = as_unpack_compare_scratch_size(depth);
+	void *scratch = malloc(scratch_size);
+
+	msgpack_compare_t ret = as_unpack_buf_compare_scratch(buf1, depth + 1,
+			buf2, depth + 1, scratch, scratch_size);
+	assert_int_eq(ret, MSGPACK_COMPARE_LESS);
+
+	ret = as_unpack_buf_compare_scratch(buf1, depth + 1, buf1, depth + 1,
+			scratch, scratch_size);
+	assert_int_eq(ret, MSGPACK_COMPARE_EQUAL);
+
+	// Not enough scratch for the nesting.
+	ret = as_unpack_buf_compare_scratch(buf1, depth + 1, buf2, depth + 1,
+			scratch, as_unpack_compare_scratch_size(depth / 2));
+	assert_int_eq(ret, MSGPACK_COMPARE_ERROR);
+
+	// Scalars need no scratch.
+	ret = as_unpack_buf_compare_scratch(buf1 + depth, 1, buf2 + depth, 1,
+			NULL, 0);
+	assert_int_eq(ret, MSGPACK_COMPARE_LESS);
+
+	free(scratch);
+	free(buf1);
+	free(buf2);
+}
+
 TEST( msgpack_compare_utf8, "compare utf8" )
 {
 	as_string s1;
@@ -438,6 +559,348 @@ TEST( msgpack_int_direct, "signed int direct" )
 	}
 }
 
+static int
+grow_counted(as_packer *pk, uint32_t sz)
+{
+	(*(int *)pk->grow_udata)++;
+
+	uint32_t capacity = pk->offset + sz + 16;
+	unsigned char *buf = realloc(pk->buffer, capacity);
+
+	if (! buf) {
+		return -1;
+	}
+
+	pk->buffer = buf;
+	pk->capacity = capacity;
+	return 0;
+}
+
+TEST( msgpack_grow, "direct packing with contiguous and custom growth" )
+{
+	int grows = 0;
+	as_packer pk0 = {
+			.buffer = malloc(4),
+			.capacity = 4,
+			.grow = grow_counted,
+			.grow_udata = &grows
+	};
+
+	as_packer pk1 = {
+			.buffer = malloc(4),
+			.capacity = 4,
+			.contiguous = true
+	};
+
+	for (int64_t i = 0; i < 1000; i++) {
+		assert_int_eq(as_pack_int64(&pk0, i * 1000), 0);
+		assert_int_eq(as_pack_int64(&pk1, i * 1000), 0);
+	}
+
+	assert_true(grows > 0);
+	assert_null(pk0.head);
+	assert_null(pk1.head);
+	assert_int_eq(pk0.offset, pk1.offset);
+	assert_true(memcmp(pk0.buffer, pk1.buffer, pk0.offset) == 0);
+
+	as_unpacker upk = {
+			.buffer = pk1.buffer,
+			.length = pk1.offset
+	};
+
+	for (int64_t i = 0; i < 1000; i++) {
+		int64_t result = 0;
+
+		as_unpack_int64(&upk, &result);
+		assert_int_eq(result, i * 1000);
+	}
+
+	free(pk0.buffer);
+	free(pk1.buffer);
+}
+
+TEST( msgpack_pool, "pack into pool buffers" )
+{
+	as_buffer_pool pool;
+	assert_int_eq(as_buffer_pool_init(&pool, 8, 64), 0);
+
+	as_packer pk = { 0 };
+	assert_int_eq(as_packer_pool_init(&pk, &pool, 16), 0);
+	assert_int_eq(pk.capacity, 56);
+
+	memset(as_packer_pool_data(&pk), 0x77, 8);
+
+	as_arraylist list;
+	as_arraylist_init(&list, 100, 0);
+
+	for (int i = 0; i < 100; i++) {
+		as_arraylist_append_str(&list, "pool");
+	}
+
+	assert_int_eq(as_pack_val(&pk, (as_val *) &list), 0);
+	assert_null(pk.head);
+	assert_true(pk.capacity > 56);
+
+	// The pool header is carried over to the larger buffer.
+	uint8_t *data = as_packer_pool_data(&pk);
+	assert_int_eq(data[0], 0x77);
+	assert_int_eq(data[7], 0x77);
+
+	as_unpacker upk = {
+			.buffer = pk.buffer,
+			.length = pk.offset
+	};
+
+	as_val *val = NULL;
+	assert_int_eq(as_unpack_val(&upk, &val), 0);
+	assert_val_eq(val, &list);
+
+	as_packer_pool_release(&pk);
+	as_val_destroy(val);
+	as_arraylist_destroy(&list);
+	as_buffer_pool_destroy(&pool);
+}
+
+TEST( msgpack_iov, "pack large payloads by reference" )
+{
+	uint32_t blob_size = 100000;
+	uint8_t *blob = malloc(blob_size);
+
+	for (uint32_t i = 0; i < blob_size; i++) {
+		blob[i] = (uint8_t)i;
+	}
+
+	as_arraylist list;
+	as_arraylist_init(&list, 4, 0);
+	as_arraylist_append_int64(&list, 1);
+	as_arraylist_append(&list, (as_val *) as_bytes_new_wrap(blob, blob_size, false));
+	as_arraylist_append_str(&list, "small");
+	as_arraylist_append(&list, (as_val *) as_bytes_new_wrap(blob, blob_size, false));
+
+	as_serializer ser;
+	as_msgpack_init(&ser);
+
+	as_buffer b;
+	as_buffer_init(&b);
+	as_serializer_serialize(&ser, (as_val *) &list, &b);
+
+	as_packer_ref refs[4];
+	uint8_t buf[64];
+	as_packer pk = {
+			.buffer = buf,
+			.capacity = sizeof(buf),
+			.refs = refs,
+			.ref_capacity = 4,
+			.ref_threshold = 1024
+	};
+
+	assert_int_eq(as_pack_val(&pk, (as_val *) &list), 0);
+	assert_int_eq(pk.ref_count, 2);
+	assert_int_eq(as_packer_size(&pk), b.size);
+
+	struct iovec iov[5];
+	assert_true(as_packer_iov_count(&pk) <= 5);
+
+	int count = as_packer_iov(&pk, iov);
+	assert_int_eq(count, 4);
+
+	uint8_t *flat = malloc(b.size);
+	size_t offset = 0;
+
+	for (int i = 0; i < count; i++) {
+		memcpy(flat + offset, iov[i].iov_base, iov[i].iov_len);
+		offset += iov[i].iov_len;
+	}
+
+	assert_int_eq(offset, b.size);
+	assert_true(memcmp(flat, b.data, b.size) == 0);
+	assert_true(iov[1].iov_base == blob);
+
+	free(flat);
+	as_buffer_destroy(&b);
+	as_serializer_destroy(&ser);
+	as_arraylist_destroy(&list);
+	free(blob);
+}
+
+TEST( msgpack_sort, "sort packed elements and map pairs" )
+{
+	uint8_t buf[4096];
+	as_packer pk = {
+			.buffer = buf,
+			.capacity = sizeof(buf)
+	};
+
+	static const char *strs[] = {
+			"abcdefghij2", "abcdefghij1", "abc", "ab", "abcdefgh", "b", "abcdefgh"
+	};
+
+	as_msgpack_slice slices[64];
+	uint32_t count = 0;
+
+	for (int64_t i = 0; i < 12; i++) {
+		slices[count].offset = pk.offset;
+
+		switch (i % 6) {
+		case 0:
+			as_pack_int64(&pk, (i * 7919) % 23 - 11);
+			break;
+		case 1:
+			as_pack_double(&pk, 100.0 / (i - 6));
+			break;
+		case 2:
+			sort_pack_string(&pk, strs[i % 7]);
+			break;
+		case 3:
+			as_pack_list_header(&pk, 2);
+			as_pack_int64(&pk, i % 4);
+			as_pack_str(&pk, (const uint8_t *)"x", 1);
+			break;
+		case 4:
+			as_pack_bool(&pk, i % 8 == 4);
+			break;
+		default:
+			as_pack_nil(&pk);
+			break;
+		}
+
+		slices[count].size = pk.offset - slices[count].offset;
+		count++;
+	}
+
+	for (uint32_t i = 0; i < 7; i++) {
+		slices[count].offset = pk.offset;
+		sort_pack_string(&pk, strs[i]);
+		slices[count].size = pk.offset - slices[count].offset;
+		count++;
+	}
+
+	assert_int_eq(as_msgpack_sort_slices(buf, slices, count), 0);
+
+	for (uint32_t i = 1; i < count; i++) {
+		msgpack_compare_t cmp = as_unpack_buf_compare(
+				buf + slices[i - 1].offset, slices[i - 1].size,
+				buf + slices[i].offset, slices[i].size);
+
+		assert_true(cmp == MSGPACK_COMPARE_LESS || cmp == MSGPACK_COMPARE_EQUAL);
+
+		// Equal elements keep their order.
+		if (cmp == MSGPACK_COMPARE_EQUAL) {
+			assert_true(slices[i - 1].offset < slices[i].offset);
+		}
+	}
+
+	uint8_t out[4096];
+	as_packer opk = {
+			.buffer = out,
+			.capacity = sizeof(out)
+	};
+
+	assert_int_eq(as_msgpack_pack_ordered_list(&opk, buf, slices, count), 0);
+
+	as_unpacker upk = {
+			.buffer = out,
+			.length = opk.offset
+	};
+
+	as_msgpack_ext ext;
+
+	assert_int_eq(as_unpack_list_header_element_count(&upk), count + 1);
+	assert_int_eq(as_unpack_ext(&upk, &ext), 0);
+	assert_int_eq(ext.type, AS_PACKED_LIST_FLAG_ORDERED);
+	assert_true(as_unpack_skip(&upk, count) > 0);
+	assert_int_eq(upk.offset, opk.offset);
+
+	// Map pairs sort by key.
+	pk.offset = 0;
+	count = 0;
+
+	for (uint32_t i = 0; i < 7; i++) {
+		slices[count].offset = pk.offset;
+		sort_pack_string(&pk, strs[i]);
+		as_pack_int64(&pk, i);
+		slices[count].size = pk.offset - slices[count].offset;
+		count++;
+	}
+
+	// Duplicate "abcdefgh" keys stay in order.
+	assert_int_eq(as_msgpack_sort_slices(buf, slices, count), 0);
+
+	opk.offset = 0;
+	assert_int_eq(as_msgpack_pack_ordered_map(&opk, buf, slices, count), 0);
+
+	upk.offset = 0;
+	upk.length = opk.offset;
+
+	assert_int_eq(as_unpack_map_header_element_count(&upk), count + 1);
+	assert_int_eq(as_unpack_ext(&upk, &ext), 0);
+	assert_int_eq(ext.type, AS_PACKED_MAP_FLAG_K_ORDERED);
+	assert_int_eq(as_unpack_peek_type(&upk), AS_NIL);
+	as_unpack_skip(&upk, 1);
+
+	static const char *sorted[] = {
+			"ab", "abc", "abcdefgh", "abcdefgh", "abcdefghij1", "abcdefghij2", "b"
+	};
+	static const int64_t values[] = { 3, 2, 4, 6, 1, 0, 5 };
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t size;
+		const uint8_t *p = as_unpack_str(&upk, &size);
+		int64_t v;
+
+		assert_not_null(p);
+		assert_int_eq(size, strlen(sorted[i]) + 1);
+		assert_int_eq(memcmp(p + 1, sorted[i], size - 1), 0);
+		assert_int_eq(as_unpack_int64(&upk, &v), 0);
+		assert_int_eq(v, values[i]);
+	}
+
+	// Invalid elements are rejected.
+	slices[0].size = 1;
+	assert_true(as_msgpack_sort_slices(buf, slices, count) < 0);
+
+	// Empty strings sort first. Blobs with the same payload are ordered by
+	// particle type, which as_unpack_compare() skips.
+	static const uint8_t blobs[][4] = {
+			{ 0xa3, AS_BYTES_JAVA, 'x', 'y' },
+			{ 0xa0 },
+			{ 0xa3, AS_BYTES_BLOB, 'x', 'y' },
+			{ 0xa2, AS_BYTES_BLOB, 'x' },
+			{ 0xa0 },
+	};
+	static const uint32_t blob_sizes[] = { 4, 1, 4, 3, 1 };
+	static const uint32_t blob_order[] = { 1, 4, 3, 2, 0 };
+
+	pk.offset = 0;
+	count = 0;
+
+	for (uint32_t i = 0; i < 5; i++) {
+		slices[count].offset = pk.offset;
+		as_pack_append(&pk, blobs[i], blob_sizes[i]);
+		slices[count].size = blob_sizes[i];
+		count++;
+	}
+
+	assert_int_eq(as_msgpack_sort_slices(buf, slices, count), 0);
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t offset = 0;
+
+		for (uint32_t j = 0; j < blob_order[i]; j++) {
+			offset += blob_sizes[j];
+		}
+
+		assert_int_eq(slices[i].offset, offset);
+	}
+
+	// Comparison specials are not data.
+	slices[count].offset = pk.offset;
+	as_pack_cmp_wildcard(&pk);
+	slices[count].size = pk.offset - slices[count].offset;
+	count++;
+	assert_true(as_msgpack_sort_slices(buf, slices, count) < 0);
+}
+
 TEST( msgpack_deep, "deep list/map" )
 {
 	// uint8_t buf[MAX_BUF_SIZE] will cause stack overflow on windows.
@@ -629,11 +1092,17 @@ TEST( msgpack_deep, "deep list/map" )
 SUITE( msgpack_direct, "as_msgpack direct size/compare" )
 {
 	suite_add( msgpack_size );
+	suite_add( msgpack_skip );
 	suite_add( msgpack_compare );
+	suite_add( msgpack_compare_scratch );
 	suite_add( msgpack_compare_utf8 );
 	suite_add( msgpack_compare_mixed );
 	suite_add( msgpack_compare_mixed_level2 );
 	suite_add( msgpack_compare_lists );
 	suite_add( msgpack_int_direct );
+	suite_add( msgpack_grow );
+	suite_add( msgpack_pool );
+	suite_add( msgpack_iov );
+	suite_add( msgpack_sort );
 	suite_add( msgpack_deep );
 }
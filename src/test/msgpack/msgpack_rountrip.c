@@ -1,6 +1,7 @@
 #include "../test.h"
 #include "../test_common.h"
 
+#include <aerospike/as_arena.h>
 #include <aerospike/as_arraylist.h>
 #include <aerospike/as_arraylist_iterator.h>
 #include <aerospike/as_integer.h>
@@ -9,10 +10,15 @@
 #include <aerospike/as_list_iterator.h>
 #include <aerospike/as_map.h>
 #include <aerospike/as_msgpack.h>
+#include <aerospike/as_msgpack_serializer.h>
 #include <aerospike/as_serializer.h>
 #include <aerospike/as_string.h>
 #include <aerospike/as_stringmap.h>
 
+#include <citrusleaf/alloc.h>
+
+#include <string.h>
+
 /******************************************************************************
  * STATIC FUNCTIONS
  *****************************************************************************/
@@ -34,6 +40,64 @@ static as_val * roundtrip(as_val * in)
 	return out;
 }
 
+static as_val * roundtrip_borrowed(as_val * in)
+{
+	as_val * out = NULL;
+
+	as_serializer ser;
+	as_msgpack_init(&ser);
+
+	as_buffer b;
+	as_buffer_init(&b);
+	as_serializer_serialize(&ser, in, &b);
+
+	uint32_t size = b.size;
+	uint8_t * region = cf_rc_alloc(size);
+	memcpy(region, b.data, size);
+	as_buffer_destroy(&b);
+
+	as_unpacker pk = {
+			.buffer = region,
+			.offset = 0,
+			.length = size,
+	};
+
+	as_unpack_val_borrowed(&pk, &out);
+
+	// The region is left as valid msgpack.
+	as_buffer_init(&b);
+	as_serializer_serialize(&ser, in, &b);
+	if (b.size != size || memcmp(region, b.data, size) != 0) {
+		as_val_destroy(out);
+		out = NULL;
+	}
+	as_buffer_destroy(&b);
+	as_serializer_destroy(&ser);
+
+	// Borrowed values keep the region alive.
+	cf_rc_releaseandfree(region);
+
+	return out;
+}
+
+static as_val * roundtrip_arena(as_val * in, as_arena * arena)
+{
+	as_val * out = NULL;
+
+	as_msgpack_arena_serializer ser;
+	as_msgpack_arena_init(&ser, arena);
+
+	as_buffer b;
+	as_buffer_init(&b);
+
+	as_serializer_serialize((as_serializer *) &ser, in, &b);
+	as_serializer_deserialize((as_serializer *) &ser, &b, &out);
+	as_buffer_destroy(&b);
+	as_serializer_destroy((as_serializer *) &ser);
+
+	return out;
+}
+
 
 /******************************************************************************
  * TEST CASES
@@ -177,6 +241,176 @@ TEST( msgpack_roundtrip_map2, "roundtrip: {'abc': [1,2,3], 'def': [4,5,6], 'ghi'
 	as_hashmap_destroy(&m1);
 	as_val_destroy(v2);
 }
+
+TEST( msgpack_roundtrip_large, "roundtrip: 20000 element list larger than one pack buffer" )
+{
+	as_arraylist l1;
+	as_arraylist_init(&l1, 20000, 0);
+
+	for (int64_t i = 0; i < 20000; i++) {
+		if (i % 2 == 0) {
+			as_arraylist_append_int64(&l1, i * 1000);
+		}
+		else {
+			as_arraylist_append_str(&l1, "0123456789");
+		}
+	}
+
+	as_serializer ser;
+	as_msgpack_init(&ser);
+
+	as_buffer b;
+	as_buffer_init(&b);
+
+	uint32_t size = as_serializer_serialize_getsize(&ser, (as_val *) &l1);
+	assert_int_eq(as_serializer_serialize(&ser, (as_val *) &l1, &b), 0);
+	assert_true(size > AS_PACKER_BUFFER_SIZE);
+	assert_int_eq(b.size, size);
+	assert_true(b.capacity >= b.size);
+
+	as_val * v2 = NULL;
+	assert_int_eq(as_serializer_deserialize(&ser, &b, &v2), 0);
+	assert_val_eq(v2, &l1);
+
+	as_buffer_destroy(&b);
+	as_serializer_destroy(&ser);
+	as_arraylist_destroy(&l1);
+	as_val_destroy(v2);
+}
+
+TEST( msgpack_roundtrip_borrowed, "roundtrip borrowed: {'abc': ['x', 'yz'], 'def': 'uvw', 'ghi': bytes}" )
+{
+	as_arraylist l1;
+	as_arraylist_inita(&l1,2);
+	as_arraylist_append_str(&l1, "x");
+	as_arraylist_append_str(&l1, "yz");
+
+	uint8_t raw[3] = {1, 2, 3};
+	as_bytes b1;
+	as_bytes_init_wrap(&b1, raw, 3, false);
+
+	as_hashmap m1;
+	as_hashmap_init(&m1,3);
+	as_stringmap_set_list((as_map *) &m1, "abc", (as_list *) &l1);
+	as_stringmap_set_str((as_map *) &m1, "def", "uvw");
+	as_stringmap_set_bytes((as_map *) &m1, "ghi", &b1);
+
+	as_val * v2 = roundtrip_borrowed((as_val *) &m1);
+	assert_not_null(v2);
+
+	as_string * s2 = as_string_fromval(as_stringmap_get((as_map *) v2, "def"));
+	assert_not_null(s2);
+	assert_int_eq(as_string_len(s2), 3);
+	assert_string_eq(as_string_get(s2), "uvw");
+
+	as_list * l2 = as_list_fromval(as_stringmap_get((as_map *) v2, "abc"));
+	assert_val_eq(l2, &l1);
+
+	as_bytes * b2 = as_bytes_fromval(as_stringmap_get((as_map *) v2, "ghi"));
+	assert_not_null(b2);
+	assert_not_null(b2->backing);
+	assert_int_eq(as_bytes_size(b2), 3);
+	assert_int_eq(b2->value[2], 3);
+
+	// A value reserved past the lifetime of the tree stays valid.
+	as_val_reserve(b2);
+	as_val_destroy(v2);
+	assert_int_eq(b2->value[2], 3);
+	as_bytes_destroy(b2);
+
+	as_hashmap_destroy(&m1);
+}
+
+TEST( msgpack_roundtrip_arena, "roundtrip arena: {'abc': [1,2,3], 'def': 'uvw'}" )
+{
+	as_arraylist l1;
+	as_arraylist_inita(&l1,3);
+	as_arraylist_append_int64(&l1, 1);
+	as_arraylist_append_int64(&l1, 2);
+	as_arraylist_append_int64(&l1, 3);
+
+	as_hashmap m1;
+	as_hashmap_init(&m1,2);
+	as_stringmap_set_list((as_map *) &m1, "abc", (as_list *) &l1);
+	as_stringmap_set_str((as_map *) &m1, "def", "uvw");
+
+	as_arena arena;
+	as_arena_init(&arena, 256);
+
+	for (int i = 0; i < 3; i++) {
+		as_val * v2 = roundtrip_arena((as_val *) &m1, &arena);
+		assert_not_null(v2);
+		assert_val_eq(v2, &m1);
+
+		// Arena values are released with the arena, not by destroy.
+		as_val_destroy(v2);
+		assert_string_eq(as_stringmap_get_str((as_map *) v2, "def"), "uvw");
+
+		// Nor by a reserve followed by destroy, as a container would do.
+		as_val * l2 = (as_val *) as_stringmap_get_list((as_map *) v2, "abc");
+		as_val_reserve(v2);
+		as_val_reserve(l2);
+		assert_int_eq(v2->count, 0);
+		assert_int_eq(l2->count, 0);
+		as_val_destroy(l2);
+		as_val_destroy(v2);
+		assert_string_eq(as_stringmap_get_str((as_map *) v2, "def"), "uvw");
+		assert_int_eq(as_list_size((as_list *) l2), 3);
+		assert_int_eq(as_list_get_int64((as_list *) l2, 2), 3);
+
+		// Arena maps have fixed capacity and eventually refuse new keys.
+		as_integer k[8];
+		int rc = 0;
+
+		for (int j = 0; j < 8 && rc == 0; j++) {
+			as_integer_init(&k[j], j);
+			rc = as_map_set((as_map *) v2, (as_val *) &k[j], (as_val *) &k[j]);
+		}
+
+		assert_int_ne(rc, 0);
+
+		as_arena_reset(&arena);
+	}
+
+	as_arena_destroy(&arena);
+	as_hashmap_destroy(&m1);
+}
+
+TEST( msgpack_roundtrip_trusted, "roundtrip trusted: 100 entry map" )
+{
+	as_hashmap * m1 = as_hashmap_new(100);
+	char name[16];
+
+	for (int i = 0; i < 100; i++) {
+		sprintf(name, "key%d", i);
+		as_stringmap_set_int64((as_map *) m1, name, i);
+	}
+
+	as_serializer ser;
+	as_msgpack_init(&ser);
+
+	as_buffer b;
+	as_buffer_init(&b);
+	as_serializer_serialize(&ser, (as_val *) m1, &b);
+
+	as_unpacker pk = {
+			.buffer = b.data,
+			.offset = 0,
+			.length = b.size,
+	};
+
+	as_val * v2 = NULL;
+	assert_int_eq( as_unpack_val_trusted(&pk, &v2), 0 );
+	assert_not_null( v2 );
+	assert_val_eq( v2, m1 );
+	assert_int_eq( as_map_size((as_map *) v2), 100 );
+
+	as_val_destroy(v2);
+	as_buffer_destroy(&b);
+	as_serializer_destroy(&ser);
+	as_hashmap_destroy(m1);
+}
+
 /******************************************************************************
  * TEST SUITE
  *****************************************************************************/
@@ -189,4 +423,8 @@ SUITE( msgpack_roundtrip, "as_msgpack roundtrip serialize/deserialize" ) {
 	suite_add( msgpack_roundtrip_list2 );
 	suite_add( msgpack_roundtrip_map1 );
 	suite_add( msgpack_roundtrip_map2 );
+	suite_add( msgpack_roundtrip_large );
+	suite_add( msgpack_roundtrip_borrowed );
+	suite_add( msgpack_roundtrip_arena );
+	suite_add( msgpack_roundtrip_trusted );
 }
@@ -0,0 +1,325 @@
+#include "../test.h"
+#include "../test_common.h"
+
+#include <string.h>
+
+#include <aerospike/as_arraylist.h>
+#include <aerospike/as_boolean.h>
+#include <aerospike/as_bytes.h>
+#include <aerospike/as_double.h>
+#include <aerospike/as_integer.h>
+#include <aerospike/as_hashmap.h>
+#include <aerospike/as_list.h>
+#include <aerospike/as_map.h>
+#include <aerospike/as_msgpack.h>
+#include <aerospike/as_msgpack_view.h>
+#include <aerospike/as_serializer.h>
+#include <aerospike/as_string.h>
+#include <aerospike/as_stringmap.h>
+
+#include <citrusleaf/alloc.h>
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+serialize(as_val *val, as_buffer *b)
+{
+	as_serializer ser;
+	as_msgpack_init(&ser);
+	as_buffer_init(b);
+	as_serializer_serialize(&ser, val, b);
+	as_serializer_destroy(&ser);
+}
+
+// [1, "abc", 2.5, {"a": 1, "b": [true]}, bytes(1, 2, 3)]
+static as_val *
+build_list()
+{
+	as_arraylist *inner = as_arraylist_new(1, 0);
+	as_arraylist_append(inner, (as_val *)as_boolean_new(true));
+
+	as_hashmap *map = as_hashmap_new(4);
+	as_stringmap_set_int64((as_map *)map, "a", 1);
+	as_stringmap_set_list((as_map *)map, "b", (as_list *)inner);
+
+	uint8_t *raw = cf_malloc(3);
+	raw[0] = 1;
+	raw[1] = 2;
+	raw[2] = 3;
+
+	as_arraylist *list = as_arraylist_new(5, 0);
+	as_arraylist_append_int64(list, 1);
+	as_arraylist_append_str(list, "abc");
+	as_arraylist_append_double(list, 2.5);
+	as_arraylist_append(list, (as_val *)map);
+	as_arraylist_append(list, (as_val *)as_bytes_new_wrap(raw, 3, true));
+
+	return (as_val *)list;
+}
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST( msgpack_view_list, "view: list elements" )
+{
+	as_val *val = build_list();
+	as_buffer b;
+	serialize(val, &b);
+
+	as_msgpack_view view;
+	as_msgpack_view elem;
+
+	assert_int_eq(as_msgpack_view_init(&view, b.data, b.size), 0);
+	assert_int_eq(as_msgpack_view_type(&view), AS_LIST);
+	assert_int_eq(as_msgpack_view_count(&view), 5);
+
+	int64_t i;
+	assert_int_eq(as_msgpack_view_list_get(&view, 0, &elem), 0);
+	assert_int_eq(as_msgpack_view_get_int64(&elem, &i), 0);
+	assert_int_eq(i, 1);
+
+	uint32_t len;
+	assert_int_eq(as_msgpack_view_list_get(&view, 1, &elem), 0);
+	const char *s = as_msgpack_view_get_str(&elem, &len);
+	assert_not_null(s);
+	assert_int_eq(len, 3);
+	assert_true(memcmp(s, "abc", 3) == 0);
+
+	// Wrong type.
+	assert_int_ne(as_msgpack_view_get_int64(&elem, &i), 0);
+
+	// Out of order access restarts the scan.
+	double d;
+	assert_int_eq(as_msgpack_view_list_get(&view, 4, &elem), 0);
+	as_bytes_type type;
+	const uint8_t *raw = as_msgpack_view_get_bytes(&elem, &len, &type);
+	assert_not_null(raw);
+	assert_int_eq(len, 3);
+	assert_int_eq(type, AS_BYTES_BLOB);
+	assert_int_eq(raw[2], 3);
+
+	assert_int_eq(as_msgpack_view_list_get(&view, 2, &elem), 0);
+	assert_int_eq(as_msgpack_view_get_double(&elem, &d), 0);
+	assert_double_eq(d, 2.5);
+
+	assert_int_ne(as_msgpack_view_list_get(&view, 5, &elem), 0);
+
+	as_buffer_destroy(&b);
+	as_val_destroy(val);
+}
+
+TEST( msgpack_view_map, "view: map lookup" )
+{
+	as_val *val = build_list();
+	as_buffer b;
+	serialize(val, &b);
+
+	as_msgpack_view view;
+	as_msgpack_view map;
+	as_msgpack_view elem;
+
+	assert_int_eq(as_msgpack_view_init(&view, b.data, b.size), 0);
+	assert_int_eq(as_msgpack_view_list_get(&view, 3, &map), 0);
+	assert_int_eq(as_msgpack_view_type(&map), AS_MAP);
+	assert_int_eq(as_msgpack_view_count(&map), 2);
+
+	as_string key;
+	as_string_init(&key, "b", false);
+	assert_int_eq(as_msgpack_view_map_get(&map, (as_val *)&key, &elem), 0);
+	assert_int_eq(as_msgpack_view_type(&elem), AS_LIST);
+	assert_int_eq(as_msgpack_view_count(&elem), 1);
+
+	as_msgpack_view inner;
+	bool flag = false;
+	assert_int_eq(as_msgpack_view_list_get(&elem, 0, &inner), 0);
+	assert_int_eq(as_msgpack_view_get_bool(&inner, &flag), 0);
+	assert_true(flag);
+
+	as_string_init(&key, "c", false);
+	assert_int_eq(as_msgpack_view_map_get(&map, (as_val *)&key, &elem), 1);
+
+	as_msgpack_view k;
+	as_msgpack_view v;
+	uint32_t found = 0;
+
+	for (uint32_t i = 0; i < as_msgpack_view_count(&map); i++) {
+		assert_int_eq(as_msgpack_view_map_get_pair(&map, i, &k, &v), 0);
+		assert_int_eq(as_msgpack_view_type(&k), AS_STRING);
+		found++;
+	}
+
+	assert_int_eq(found, 2);
+
+	as_buffer_destroy(&b);
+	as_val_destroy(val);
+}
+
+TEST( msgpack_view_ordered_map, "view: key ordered map with metadata" )
+{
+	uint8_t buf[64];
+	as_packer pk = {
+			.buffer = buf,
+			.capacity = sizeof(buf),
+	};
+
+	// {ext: nil, 1: 10, 3: 30, 5: 50} with K_ORDERED flag.
+	as_pack_map_header(&pk, 4);
+	as_pack_ext_header(&pk, 0, AS_PACKED_MAP_FLAG_K_ORDERED);
+	as_pack_nil(&pk);
+
+	for (int64_t i = 1; i <= 5; i += 2) {
+		as_pack_int64(&pk, i);
+		as_pack_int64(&pk, i * 10);
+	}
+
+	as_msgpack_view view;
+	as_msgpack_view elem;
+
+	assert_int_eq(as_msgpack_view_init(&view, buf, pk.offset), 0);
+	assert_int_eq(as_msgpack_view_count(&view), 3);
+	assert_int_eq(view.flags, AS_PACKED_MAP_FLAG_K_ORDERED);
+
+	int64_t i;
+	as_integer key;
+	as_integer_init(&key, 3);
+	assert_int_eq(as_msgpack_view_map_get(&view, (as_val *)&key, &elem), 0);
+	assert_int_eq(as_msgpack_view_get_int64(&elem, &i), 0);
+	assert_int_eq(i, 30);
+
+	as_integer_init(&key, 2);
+	assert_int_eq(as_msgpack_view_map_get(&view, (as_val *)&key, &elem), 1);
+
+	as_msgpack_view k;
+	assert_int_eq(as_msgpack_view_map_get_pair(&view, 0, &k, NULL), 0);
+	assert_int_eq(as_msgpack_view_get_int64(&k, &i), 0);
+	assert_int_eq(i, 1);
+}
+
+TEST( msgpack_view_to_val, "view: materialize element" )
+{
+	as_val *val = build_list();
+	as_buffer b;
+	serialize(val, &b);
+
+	as_msgpack_view view;
+	as_msgpack_view elem;
+
+	assert_int_eq(as_msgpack_view_init(&view, b.data, b.size), 0);
+	assert_int_eq(as_msgpack_view_list_get(&view, 3, &elem), 0);
+
+	as_val *map = as_msgpack_view_to_val(&elem);
+	assert_not_null(map);
+	assert_int_eq(as_val_type(map), AS_MAP);
+	assert_int_eq(as_map_size((as_map *)map), 2);
+	assert_val_eq(as_stringmap_get((as_map *)map, "a"), as_stringmap_get((as_map *)as_list_get((as_list *)val, 3), "a"));
+	as_val_destroy(map);
+
+	as_val *all = as_msgpack_view_to_val(&view);
+	assert_not_null(all);
+	assert_int_eq(as_val_type(all), AS_LIST);
+	assert_int_eq(as_list_size((as_list *)all), 5);
+	assert_val_eq(as_list_get((as_list *)all, 1), as_list_get((as_list *)val, 1));
+	as_val_destroy(all);
+
+	as_buffer_destroy(&b);
+	as_val_destroy(val);
+}
+
+TEST( msgpack_view_index, "index: list and key ordered map" )
+{
+	uint32_t capacity = 8192;
+	uint8_t *buf = cf_malloc(capacity);
+	as_packer pk = {
+			.buffer = buf,
+			.capacity = capacity,
+	};
+
+	// [0, "s", 2, "s", ...] with 1000 elements.
+	as_pack_list_header(&pk, 1000);
+
+	for (int64_t i = 0; i < 1000; i++) {
+		if (i % 2 == 0) {
+			as_pack_int64(&pk, i);
+		}
+		else {
+			as_pack_str(&pk, (const uint8_t *)"s", 1);
+		}
+	}
+
+	as_msgpack_view view;
+	as_msgpack_index index;
+	as_msgpack_view elem;
+	int64_t v;
+
+	assert_int_eq(as_msgpack_view_init(&view, buf, pk.offset), 0);
+	assert_int_eq(as_msgpack_index_init(&index, &view, 7), 0);
+	assert_int_eq(index.offsets_count, 143);
+
+	for (uint32_t i = 998; i > 0; i -= 2) {
+		assert_int_eq(as_msgpack_index_list_get(&index, i, &elem), 0);
+		assert_int_eq(as_msgpack_view_get_int64(&elem, &v), 0);
+		assert_int_eq(v, i);
+	}
+
+	assert_int_ne(as_msgpack_index_list_get(&index, 1000, &elem), 0);
+	as_msgpack_index_destroy(&index);
+
+	// {ext: nil, 0: 0, 3: 30, 6: 60, ...} with K_ORDERED flag.
+	pk.offset = 0;
+	as_pack_map_header(&pk, 501);
+	as_pack_ext_header(&pk, 0, AS_PACKED_MAP_FLAG_K_ORDERED);
+	as_pack_nil(&pk);
+
+	for (int64_t i = 0; i < 500; i++) {
+		as_pack_int64(&pk, i * 3);
+		as_pack_int64(&pk, i * 30);
+	}
+
+	assert_int_eq(as_msgpack_view_init(&view, buf, pk.offset), 0);
+	assert_int_eq(as_msgpack_index_init(&index, &view, 0), 0);
+
+	for (int64_t k = -1; k <= 1500; k++) {
+		uint8_t key[16];
+		as_packer pk_key = {
+				.buffer = key,
+				.capacity = sizeof(key),
+		};
+
+		as_pack_int64(&pk_key, k);
+
+		int rc = as_msgpack_index_map_find(&index, key, pk_key.offset, &elem);
+
+		if (k >= 0 && k < 1500 && k % 3 == 0) {
+			assert_int_eq(rc, 0);
+			assert_int_eq(as_msgpack_view_get_int64(&elem, &v), 0);
+			assert_int_eq(v, k * 10);
+		}
+		else {
+			assert_int_eq(rc, 1);
+		}
+	}
+
+	as_msgpack_view k;
+	assert_int_eq(as_msgpack_index_map_get_pair(&index, 499, &k, &elem), 0);
+	assert_int_eq(as_msgpack_view_get_int64(&k, &v), 0);
+	assert_int_eq(v, 1497);
+
+	as_msgpack_index_destroy(&index);
+	cf_free(buf);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE( msgpack_view, "as_msgpack_view lazy access" )
+{
+	suite_add( msgpack_view_list );
+	suite_add( msgpack_view_map );
+	suite_add( msgpack_view_ordered_map );
+	suite_add( msgpack_view_to_val );
+	suite_add( msgpack_view_index );
+}
@@ -0,0 +1,313 @@
+#include "../test.h"
+
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_sleep.h>
+#include <aerospike/as_thread_pool.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <string.h>
+#endif
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+static uint32_t pool_counter;
+static uint32_t pool_finished;
+
+static void
+pool_fini()
+{
+	as_incr_uint32(&pool_finished);
+}
+
+static void
+pool_count_task(void* data)
+{
+	as_incr_uint32(&pool_counter);
+}
+
+TEST(thread_pool_stealing, "work stealing pool runs queued tasks")
+{
+	as_thread_pool pool;
+	assert_int_eq(as_thread_pool_init_stealing(&pool, 4), 0);
+	pool.fini_fn = pool_fini;
+
+	pool_counter = 0;
+	pool_finished = 0;
+
+	for (int i = 0; i < 10000; i++) {
+		assert_int_eq(as_thread_pool_queue_task(&pool, pool_count_task, NULL), 0);
+	}
+
+	assert_int_eq(as_thread_pool_queue_task_fixed(&pool, NULL), -2);
+
+	// Shrinking stops workers without losing their tasks.
+	assert_int_eq(as_thread_pool_resize(&pool, 1), 0);
+	assert_int_eq(pool_finished, 3);
+
+	for (int i = 0; i < 10000; i++) {
+		assert_int_eq(as_thread_pool_queue_task(&pool, pool_count_task, NULL), 0);
+	}
+
+	assert_int_eq(as_thread_pool_resize(&pool, 3), 0);
+
+	for (int i = 0; i < 10000; i++) {
+		assert_int_eq(as_thread_pool_queue_task(&pool, pool_count_task, NULL), 0);
+	}
+
+	// Destroy runs everything queued before it.
+	assert_int_eq(as_thread_pool_destroy(&pool), 0);
+	assert_int_eq(pool_counter, 30000);
+	assert_int_eq(pool_finished, 6);
+	assert_int_eq(as_thread_pool_queue_task(&pool, pool_count_task, NULL), -1);
+}
+
+typedef struct {
+	as_thread_pool* pool;
+	uint32_t depth;
+} pool_tree_node;
+
+static pool_tree_node pool_nodes[16];
+
+static void
+pool_tree_task(void* data)
+{
+	pool_tree_node* node = data;
+
+	as_incr_uint32(&pool_counter);
+
+	// Children are queued from a pool thread, so go on its own deque.
+	if (node->depth + 1 < 16) {
+		pool_tree_node* child = &pool_nodes[node->depth + 1];
+		as_thread_pool_queue_task(node->pool, pool_tree_task, child);
+		as_thread_pool_queue_task(node->pool, pool_tree_task, child);
+	}
+}
+
+TEST(thread_pool_stealing_nested, "work stealing pool runs tasks queued by tasks")
+{
+	as_thread_pool pool;
+	assert_int_eq(as_thread_pool_init_stealing(&pool, 4), 0);
+
+	pool_counter = 0;
+
+	for (uint32_t i = 0; i < 16; i++) {
+		pool_nodes[i].pool = &pool;
+		pool_nodes[i].depth = i;
+	}
+
+	assert_int_eq(as_thread_pool_queue_task(&pool, pool_tree_task, &pool_nodes[0]), 0);
+
+	assert_int_eq(as_thread_pool_destroy(&pool), 0);
+	assert_int_eq(pool_counter, (1 << 16) - 1);
+}
+
+static void
+pool_sleep_task(void* data)
+{
+	as_sleep(100);
+	as_incr_uint32(&pool_counter);
+}
+
+TEST(thread_pool_group, "task groups wait for their tasks")
+{
+	for (int stealing = 0; stealing < 2; stealing++) {
+		as_thread_pool pool;
+		assert_int_eq(stealing ? as_thread_pool_init_stealing(&pool, 4) :
+				as_thread_pool_init(&pool, 4), 0);
+
+		as_task_group group;
+		assert_int_eq(as_task_group_init(&group, &pool), 0);
+		assert_int_eq(as_task_group_wait(&group, CF_QUEUE_NOWAIT), 0);
+
+		pool_counter = 0;
+
+		for (int i = 0; i < 10000; i++) {
+			assert_int_eq(as_task_group_queue(&group, pool_count_task, NULL), 0);
+		}
+
+		assert_int_eq(as_task_group_wait(&group, CF_QUEUE_FOREVER), 0);
+		assert_int_eq(as_task_group_pending(&group), 0);
+		assert_int_eq(pool_counter, 10000);
+
+		// Reuse the group, timing out first.
+		assert_int_eq(as_task_group_queue(&group, pool_sleep_task, NULL), 0);
+		assert_int_eq(as_task_group_wait(&group, CF_QUEUE_NOWAIT), -1);
+		assert_int_eq(as_task_group_wait(&group, 10), -1);
+		assert_int_eq(as_task_group_pending(&group), 1);
+		assert_int_eq(as_task_group_wait(&group, CF_QUEUE_FOREVER), 0);
+		assert_int_eq(pool_counter, 10001);
+
+		as_task_group_destroy(&group);
+		assert_int_eq(as_thread_pool_destroy(&pool), 0);
+	}
+}
+
+static void
+pool_sum_range(void* udata, uint64_t begin, uint64_t end)
+{
+	uint64_t sum = 0;
+
+	for (uint64_t i = begin; i < end; i++) {
+		sum += i;
+	}
+
+	as_add_uint64((uint64_t*)udata, sum);
+}
+
+static as_thread_pool* pool_nested_pool;
+static uint64_t pool_nested_sum;
+
+static void
+pool_nested_task(void* data)
+{
+	// Runs on the pool's only thread, so the caller has to do every chunk.
+	as_thread_pool_parallel_for(pool_nested_pool, 0, 1000, 10, pool_sum_range,
+			&pool_nested_sum);
+}
+
+TEST(thread_pool_parallel_for, "parallel_for covers the range once")
+{
+	for (int stealing = 0; stealing < 2; stealing++) {
+		as_thread_pool pool;
+		assert_int_eq(stealing ? as_thread_pool_init_stealing(&pool, 4) :
+				as_thread_pool_init(&pool, 4), 0);
+
+		uint64_t sum = 0;
+		as_thread_pool_parallel_for(&pool, 0, 1000000, 0, pool_sum_range, &sum);
+		assert_int_eq(sum, 999999ULL * 1000000 / 2);
+
+		sum = 0;
+		as_thread_pool_parallel_for(&pool, 10, 11, 0, pool_sum_range, &sum);
+		assert_int_eq(sum, 10);
+
+		sum = 0;
+		as_thread_pool_parallel_for(&pool, 5, 5, 0, pool_sum_range, &sum);
+		assert_int_eq(sum, 0);
+
+		assert_int_eq(as_thread_pool_resize(&pool, 1), 0);
+
+		as_task_group group;
+		assert_int_eq(as_task_group_init(&group, &pool), 0);
+
+		pool_nested_pool = &pool;
+		pool_nested_sum = 0;
+		assert_int_eq(as_task_group_queue(&group, pool_nested_task, NULL), 0);
+		assert_int_eq(as_task_group_wait(&group, CF_QUEUE_FOREVER), 0);
+		assert_int_eq(pool_nested_sum, 999 * 1000 / 2);
+
+		as_task_group_destroy(&group);
+		assert_int_eq(as_thread_pool_destroy(&pool), 0);
+
+		// No threads - runs in the caller.
+		sum = 0;
+		as_thread_pool_parallel_for(&pool, 0, 100, 0, pool_sum_range, &sum);
+		assert_int_eq(sum, 99 * 100 / 2);
+	}
+}
+
+static uint32_t pool_placed;
+
+static void
+pool_placement_task(void* data)
+{
+#if defined(__linux__)
+	// Pinned to one CPU, named and given the requested stack.
+	cpu_set_t set;
+	char name[16];
+	pthread_attr_t attrs;
+	size_t stack_size = 0;
+
+	if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0 ||
+			CPU_COUNT(&set) != 1) {
+		return;
+	}
+
+	if (pthread_getname_np(pthread_self(), name, sizeof(name)) != 0 ||
+			strncmp(name, "tpool-", 6) != 0) {
+		return;
+	}
+
+	if (pthread_getattr_np(pthread_self(), &attrs) == 0) {
+		pthread_attr_getstacksize(&attrs, &stack_size);
+		pthread_attr_destroy(&attrs);
+	}
+
+	if (stack_size < 1024 * 1024) {
+		return;
+	}
+#endif
+	as_incr_uint32(&pool_placed);
+}
+
+TEST(thread_pool_options, "pool threads are pinned, named and sized")
+{
+	for (int stealing = 0; stealing < 2; stealing++) {
+		as_thread_pool_options options = {
+			.stealing = stealing,
+			.pin_per_cpu = true,
+			.numa_local = true,
+			.stack_size = 1024 * 1024,
+			.name = "tpool"
+		};
+
+		as_thread_pool pool;
+		assert_int_eq(as_thread_pool_init_options(&pool, 3, &options), 0);
+
+		as_task_group group;
+		assert_int_eq(as_task_group_init(&group, &pool), 0);
+
+		pool_placed = 0;
+
+		for (int i = 0; i < 100; i++) {
+			assert_int_eq(as_task_group_queue(&group, pool_placement_task, NULL), 0);
+		}
+
+		assert_int_eq(as_task_group_wait(&group, CF_QUEUE_FOREVER), 0);
+		assert_int_eq(pool_placed, 100);
+
+		// Threads started by a resize use the same options.
+		assert_int_eq(as_thread_pool_resize(&pool, 1), 0);
+		assert_int_eq(as_thread_pool_resize(&pool, 5), 0);
+
+		pool_placed = 0;
+
+		for (int i = 0; i < 100; i++) {
+			assert_int_eq(as_task_group_queue(&group, pool_placement_task, NULL), 0);
+		}
+
+		assert_int_eq(as_task_group_wait(&group, CF_QUEUE_FOREVER), 0);
+		assert_int_eq(pool_placed, 100);
+
+		as_task_group_destroy(&group);
+		assert_int_eq(as_thread_pool_destroy(&pool), 0);
+	}
+
+#if defined(__linux__)
+	// An explicit list with a CPU that doesn't exist fails to start threads.
+	uint16_t cpus[] = { CPU_SETSIZE - 1 };
+	as_thread_pool_options options = {
+		.cpus = cpus,
+		.n_cpus = 1
+	};
+
+	as_thread_pool pool;
+	assert_int_eq(as_thread_pool_init_options(&pool, 2, &options), -3);
+	assert_int_eq(as_thread_pool_destroy(&pool), 0);
+#endif
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(thread_pool, "as_thread_pool")
+{
+	suite_add(thread_pool_stealing);
+	suite_add(thread_pool_stealing_nested);
+	suite_add(thread_pool_group);
+	suite_add(thread_pool_parallel_for);
+	suite_add(thread_pool_options);
+}
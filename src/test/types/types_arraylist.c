@@ -2,11 +2,13 @@
 
 #include <aerospike/as_arraylist.h>
 #include <aerospike/as_arraylist_iterator.h>
+#include <aerospike/as_hashmap.h>
 #include <aerospike/as_integer.h>
 #include <aerospike/as_list.h>
 #include <aerospike/as_list_iterator.h>
 #include <aerospike/as_msgpack.h>
 #include <aerospike/as_serializer.h>
+#include <pthread.h>
 #include <string.h>
 
 /******************************************************************************
@@ -454,6 +456,325 @@ TEST(types_arraylist_msgpack, "as_arraylist msgpack")
 	as_buffer_destroy(&b);
 }
 
+TEST(types_arraylist_hashcode, "as_arraylist hashcode")
+{
+	// Same contents reached through different edits hash the same.
+	as_arraylist l1;
+	as_arraylist_init(&l1, 4, 4);
+	as_arraylist_append_int64(&l1, 1);
+	as_arraylist_append_str(&l1, "two");
+	as_arraylist_append_int64(&l1, 3);
+
+	uint32_t h = as_arraylist_hashcode(&l1);
+
+	as_arraylist l2;
+	as_arraylist_init(&l2, 4, 4);
+	as_arraylist_append_int64(&l2, 3);
+	assert_int_ne(as_arraylist_hashcode(&l2), h);
+	as_arraylist_prepend_str(&l2, "two");
+	as_arraylist_prepend_int64(&l2, 9);
+	as_arraylist_set_int64(&l2, 0, 1);
+	as_arraylist_append_int64(&l2, 4);
+	assert_int_ne(as_arraylist_hashcode(&l2), h);
+	as_arraylist_remove(&l2, 3);
+	assert_int_eq(as_arraylist_hashcode(&l2), h);
+
+	// Order matters.
+	as_arraylist_set_int64(&l2, 0, 3);
+	as_arraylist_set_int64(&l2, 2, 1);
+	assert_int_ne(as_arraylist_hashcode(&l2), h);
+	as_arraylist_set_int64(&l2, 0, 1);
+	as_arraylist_set_int64(&l2, 2, 3);
+
+	as_arraylist_append_int64(&l2, 5);
+	as_arraylist_append_int64(&l2, 6);
+	as_arraylist_trim(&l2, 3);
+	assert_int_eq(as_arraylist_hashcode(&l2), h);
+
+	// Lists are valid map keys, compared by contents.
+	as_hashmap m;
+	as_hashmap_init(&m, 8);
+	assert_int_eq(as_hashmap_set(&m, (as_val *) &l1, (as_val *) as_integer_new(7)), 0);
+
+	as_integer * v = (as_integer *) as_hashmap_get(&m, (as_val *) &l2);
+	assert_not_null(v);
+	assert_int_eq(as_integer_get(v), 7);
+
+	as_arraylist_append_int64(&l2, 4);
+	assert_null(as_hashmap_get(&m, (as_val *) &l2));
+
+	as_hashmap_destroy(&m);
+	as_arraylist_destroy(&l2);
+}
+
+TEST(types_arraylist_hashcode_nested, "as_arraylist hashcode follows nested lists")
+{
+	as_arraylist* inner = as_arraylist_new(2, 2);
+	as_arraylist_append_int64(inner, 1);
+
+	as_arraylist l1;
+	as_arraylist_init(&l1, 2, 2);
+	as_arraylist_append_int64(&l1, 0);
+	as_arraylist_append_list(&l1, (as_list*)inner);
+	as_arraylist_hashcode(&l1);
+
+	// Changing the nested list in place changes the outer hash.
+	as_list_append_int64(as_list_fromval(as_arraylist_get(&l1, 1)), 2);
+
+	as_arraylist* expect = as_arraylist_new(2, 2);
+	as_arraylist_append_int64(expect, 1);
+	as_arraylist_append_int64(expect, 2);
+
+	as_arraylist l2;
+	as_arraylist_init(&l2, 2, 2);
+	as_arraylist_append_int64(&l2, 0);
+	as_arraylist_append_list(&l2, (as_list*)expect);
+	assert_int_eq(as_arraylist_hashcode(&l1), as_arraylist_hashcode(&l2));
+
+	// A list key holding a nested list is still found after such a change.
+	as_hashmap m;
+	as_hashmap_init(&m, 8);
+	as_arraylist_hashcode(&l1);
+	as_list_append_int64(as_list_fromval(as_arraylist_get(&l1, 1)), 3);
+	as_list_append_int64((as_list*)expect, 3);
+	as_val_reserve(&l1);
+	assert_int_eq(as_hashmap_set(&m, (as_val*)&l1, (as_val*)as_integer_new(7)), 0);
+	assert_not_null(as_hashmap_get(&m, (as_val*)&l2));
+
+	as_hashmap_destroy(&m);
+	as_arraylist_destroy(&l1);
+	as_arraylist_destroy(&l2);
+}
+
+TEST(types_arraylist_growth, "as_arraylist growth policies, reserve and shrink_to_fit")
+{
+	// Hybrid growth is linear up to the threshold, then doubles.
+	as_arraylist l;
+	as_arraylist_init(&l, 0, 8);
+	assert_int_eq(l.growth, AS_ARRAYLIST_GROW_HYBRID);
+
+	uint32_t grows = 0;
+	uint32_t capacity = 0;
+
+	for (int64_t i = 0; i < 100000; i++) {
+		assert_int_eq(as_arraylist_append_int64(&l, i), AS_ARRAYLIST_OK);
+
+		if (l.capacity != capacity) {
+			capacity = l.capacity;
+			grows++;
+		}
+	}
+
+	assert_int_eq(l.size, 100000);
+	assert_true(l.capacity >= AS_ARRAYLIST_GROW_THRESHOLD);
+	assert_true(l.capacity < 2 * 100000);
+	assert_true(grows < AS_ARRAYLIST_GROW_THRESHOLD / 8 + 10);
+	assert_int_eq(as_arraylist_get_int64(&l, 99999), 99999);
+
+	assert_int_eq(as_arraylist_shrink_to_fit(&l), AS_ARRAYLIST_OK);
+	assert_int_eq(l.capacity, 100000);
+	assert_int_eq(as_arraylist_get_int64(&l, 12345), 12345);
+	as_arraylist_destroy(&l);
+
+	// Linear growth keeps adding single blocks.
+	as_arraylist_init(&l, 2000, 8);
+	as_arraylist_set_growth(&l, AS_ARRAYLIST_GROW_LINEAR);
+
+	for (int64_t i = 0; i < 2001; i++) {
+		as_arraylist_append_int64(&l, i);
+	}
+
+	assert_int_eq(l.capacity, 2008);
+	as_arraylist_destroy(&l);
+
+	// Geometric growth doubles from the start.
+	as_arraylist_init(&l, 10, 1);
+	as_arraylist_set_growth(&l, AS_ARRAYLIST_GROW_GEOMETRIC);
+
+	for (int64_t i = 0; i < 11; i++) {
+		as_arraylist_append_int64(&l, i);
+	}
+
+	assert_int_eq(l.capacity, 20);
+	as_arraylist_destroy(&l);
+
+	// Reserve works without a block size, and moves stack storage to the heap.
+	as_arraylist s;
+	as_arraylist_inita(&s, 2);
+	as_arraylist_append_int64(&s, 1);
+	as_arraylist_append_int64(&s, 2);
+	assert_int_ne(as_arraylist_append_int64(&s, 3), AS_ARRAYLIST_OK);
+
+	assert_int_eq(as_arraylist_reserve(&s, 100), AS_ARRAYLIST_OK);
+	assert_int_eq(s.capacity, 100);
+	assert_true(s.free);
+
+	for (int64_t i = 3; i <= 100; i++) {
+		assert_int_eq(as_arraylist_append_int64(&s, i), AS_ARRAYLIST_OK);
+	}
+
+	assert_int_ne(as_arraylist_append_int64(&s, 101), AS_ARRAYLIST_OK);
+	assert_int_eq(as_arraylist_get_int64(&s, 0), 1);
+	assert_int_eq(as_arraylist_get_int64(&s, 99), 100);
+
+	// Smaller reserves don't shrink.
+	assert_int_eq(as_arraylist_reserve(&s, 10), AS_ARRAYLIST_OK);
+	assert_int_eq(s.capacity, 100);
+
+	as_arraylist_trim(&s, 0);
+	assert_int_eq(as_arraylist_shrink_to_fit(&s), AS_ARRAYLIST_OK);
+	assert_int_eq(s.capacity, 0);
+	as_arraylist_destroy(&s);
+}
+
+TEST(types_arraylist_slice, "as_arraylist slices")
+{
+	as_arraylist l;
+	as_arraylist_init(&l, 0, 8);
+
+	for (int64_t i = 0; i < 1000; i++) {
+		as_arraylist_append_int64(&l, i);
+	}
+
+	uint32_t hash = as_arraylist_hashcode(&l);
+
+	// Head/tail recursion shares storage and takes no element references.
+	as_arraylist_set(&l, 1, (as_val*) as_integer_new(1));
+	as_val* first = as_arraylist_get(&l, 1);
+	as_list* rest = (as_list*) as_arraylist_tail(&l);
+	int64_t sum = 0;
+
+	while (as_list_size(rest) > 0) {
+		sum += as_integer_get((as_integer*) as_list_head(rest));
+		as_list* next = as_list_tail(rest);
+		as_list_destroy(rest);
+		rest = next;
+	}
+
+	as_list_destroy(rest);
+	assert_int_eq(sum, 999 * 1000 / 2);
+	assert_int_eq(first->count, 1);
+
+	as_arraylist* t = as_arraylist_take(&l, 3);
+	as_arraylist* d = as_arraylist_drop(&l, 998);
+	as_arraylist* e = as_arraylist_drop(&l, 2000);
+	assert_true(t->elements == l.elements);
+	assert_int_eq(as_arraylist_size(t), 3);
+	assert_int_eq(as_arraylist_get_int64(d, 1), 999);
+	assert_int_eq(as_arraylist_size(e), 0);
+	as_arraylist_destroy(e);
+
+	// Changes are copy-on-write, in either direction.
+	as_arraylist_set_int64(t, 0, 100);
+	assert_int_eq(as_arraylist_get_int64(&l, 0), 0);
+	assert_int_eq(as_arraylist_get_int64(t, 0), 100);
+	assert_int_eq(first->count, 2);
+
+	as_arraylist_remove(&l, 998);
+	assert_int_eq(as_arraylist_size(&l), 999);
+	assert_int_eq(as_arraylist_get_int64(&l, 998), 999);
+	assert_int_eq(as_arraylist_get_int64(d, 0), 998);
+	assert_int_eq(as_arraylist_size(d), 2);
+
+	// The last user of shared storage takes it over.
+	as_arraylist_append_int64(d, 1000);
+	assert_int_eq(as_arraylist_size(d), 3);
+	assert_int_eq(as_arraylist_get_int64(d, 2), 1000);
+
+	as_arraylist_destroy(t);
+	as_arraylist_destroy(d);
+
+	as_arraylist* all = as_arraylist_drop(&l, 0);
+	as_arraylist_insert_int64(&l, 998, 998);
+	assert_int_eq(as_arraylist_hashcode(&l), hash);
+	as_arraylist_destroy(all);
+	as_arraylist_destroy(&l);
+
+	// Storage the list doesn't own is copied.
+	as_arraylist s;
+	as_arraylist_inita(&s, 3);
+	as_arraylist_append_int64(&s, 1);
+	as_arraylist_append_int64(&s, 2);
+	as_arraylist_append_int64(&s, 3);
+
+	as_arraylist* c = as_arraylist_tail(&s);
+	assert_null(c->shared);
+	assert_int_eq(as_arraylist_size(c), 2);
+	assert_int_eq(as_arraylist_get_int64(c, 0), 2);
+	as_arraylist_destroy(c);
+	as_arraylist_destroy(&s);
+}
+
+#define SLICE_THREADS 4
+#define SLICES 100
+
+typedef struct slice_job_s {
+	const as_arraylist* list;
+	pthread_barrier_t* barrier;
+	as_arraylist* slices[SLICES];
+} slice_job;
+
+static void*
+slice_run(void* udata)
+{
+	slice_job* job = udata;
+
+	pthread_barrier_wait(job->barrier);
+
+	for (uint32_t i = 0; i < SLICES; i++) {
+		job->slices[i] = as_arraylist_drop(job->list, i);
+	}
+	return NULL;
+}
+
+TEST(types_arraylist_slice_concurrent, "concurrent slices of a read-only list")
+{
+	pthread_barrier_t barrier;
+	pthread_barrier_init(&barrier, NULL, SLICE_THREADS);
+
+	for (int round = 0; round < 20; round++) {
+		as_arraylist l;
+		as_arraylist_init(&l, SLICES, 0);
+
+		for (int64_t i = 0; i < SLICES; i++) {
+			as_arraylist_append_int64(&l, i);
+		}
+
+		slice_job jobs[SLICE_THREADS];
+		pthread_t threads[SLICE_THREADS];
+
+		for (int t = 0; t < SLICE_THREADS; t++) {
+			jobs[t].list = &l;
+			jobs[t].barrier = &barrier;
+			pthread_create(&threads[t], NULL, slice_run, &jobs[t]);
+		}
+
+		for (int t = 0; t < SLICE_THREADS; t++) {
+			pthread_join(threads[t], NULL);
+		}
+
+		// Every slice uses the one storage block the list installed.
+		for (int t = 0; t < SLICE_THREADS; t++) {
+			for (uint32_t i = 0; i < SLICES; i++) {
+				as_arraylist* s = jobs[t].slices[i];
+				assert_true(s->shared == l.shared);
+				assert_int_eq(as_arraylist_size(s), SLICES - i);
+				assert_int_eq(as_arraylist_get_int64(s, 0), i);
+			}
+		}
+
+		as_arraylist_destroy(&l);
+
+		for (int t = 0; t < SLICE_THREADS; t++) {
+			for (uint32_t i = 0; i < SLICES; i++) {
+				as_arraylist_destroy(jobs[t].slices[i]);
+			}
+		}
+	}
+
+	pthread_barrier_destroy(&barrier);
+}
+
 /******************************************************************************
  * TEST SUITE
  *****************************************************************************/
@@ -468,4 +789,9 @@ SUITE(types_arraylist, "as_arraylist")
 	suite_add(types_arraylist_list);
 	suite_add(types_arraylist_iterator);
 	suite_add(types_arraylist_msgpack);
+	suite_add(types_arraylist_hashcode);
+	suite_add(types_arraylist_hashcode_nested);
+	suite_add(types_arraylist_growth);
+	suite_add(types_arraylist_slice);
+	suite_add(types_arraylist_slice_concurrent);
 }
@@ -150,6 +150,26 @@ TEST( types_bytes_stack_append_set, "as_bytes append on stack, then set values"
     as_bytes_destroy(&b);
 }
 
+TEST( types_bytes_hashcode, "as_bytes hashcode follows writes" ) {
+    as_bytes b;
+    as_bytes_init(&b, 16);
+    as_bytes_append(&b, (uint8_t *) "abcdef", 6);
+
+    uint32_t h1 = as_val_hashcode((as_val *) &b);
+    assert_int_eq( b.hash, h1 );
+
+    as_bytes_set_byte(&b, 0, 'x');
+    assert_int_eq( b.hash, 0 );
+
+    uint32_t h2 = as_val_hashcode((as_val *) &b);
+    assert_int_ne( h1, h2 );
+
+    as_bytes_truncate(&b, 1);
+    assert_int_ne( as_val_hashcode((as_val *) &b), h2 );
+
+    as_bytes_destroy(&b);
+}
+
 /******************************************************************************
  * TEST SUITE
  *****************************************************************************/
@@ -161,4 +181,5 @@ SUITE( types_bytes, "as_bytes" ) {
     suite_add( types_bytes_get_set );
     suite_add( types_bytes_stack_append );
     suite_add( types_bytes_stack_append_set );
+    suite_add( types_bytes_hashcode );
 }
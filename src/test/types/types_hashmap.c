@@ -1,9 +1,13 @@
 #include "../test.h"
+#include "../test_common.h"
 
+#include <aerospike/as_arraylist.h>
 #include <aerospike/as_hashmap.h>
 #include <aerospike/as_hashmap_iterator.h>
 #include <aerospike/as_integer.h>
 #include <aerospike/as_map.h>
+#include <aerospike/as_openmap.h>
+#include <aerospike/as_orderedmap.h>
 #include <aerospike/as_pair.h>
 #include <aerospike/as_string.h>
 #include <aerospike/as_stringmap.h>
@@ -11,6 +15,8 @@
 #include <aerospike/as_serializer.h>
 #include <citrusleaf/alloc.h>
 
+#include <pthread.h>
+
 /******************************************************************************
  * TEST CASES
  *****************************************************************************/
@@ -404,6 +410,208 @@ TEST( types_hashmap_types, "as_hashmap types" ) {
 }
 
 
+TEST( types_hashmap_hashcode, "as_hashmap hashcode" ) {
+
+	// Same entries in a different order, and through replace and remove.
+	as_hashmap * m1 = as_hashmap_new(4);
+	as_stringmap_set_int64((as_map *) m1, "a", 1);
+	as_stringmap_set_int64((as_map *) m1, "b", 2);
+	as_stringmap_set_int64((as_map *) m1, "c", 3);
+
+	uint32_t h = as_hashmap_hashcode(m1);
+
+	as_hashmap * m2 = as_hashmap_new(2);
+	as_stringmap_set_int64((as_map *) m2, "c", 3);
+	assert_int_ne( as_hashmap_hashcode(m2), h );
+	as_stringmap_set_int64((as_map *) m2, "b", 7);
+	as_stringmap_set_int64((as_map *) m2, "a", 1);
+	as_stringmap_set_int64((as_map *) m2, "d", 4);
+	assert_int_ne( as_hashmap_hashcode(m2), h );
+	as_stringmap_set_int64((as_map *) m2, "b", 2);
+	as_string d;
+	as_hashmap_remove(m2, (as_val *) as_string_init(&d, "d", false));
+	assert_int_eq( as_hashmap_hashcode(m2), h );
+
+	// Swapping values between keys changes the hash.
+	as_stringmap_set_int64((as_map *) m2, "a", 2);
+	as_stringmap_set_int64((as_map *) m2, "b", 1);
+	assert_int_ne( as_hashmap_hashcode(m2), h );
+
+	// The open addressing map hashes the same contents the same way.
+	as_openmap * m3 = as_openmap_new(0);
+	as_stringmap_set_int64((as_map *) m3, "b", 2);
+	as_stringmap_set_int64((as_map *) m3, "c", 3);
+	as_stringmap_set_int64((as_map *) m3, "a", 1);
+	assert_int_eq( as_val_hashcode((as_val *) m3), h );
+
+	as_openmap_destroy(m3);
+	as_hashmap_destroy(m2);
+	as_hashmap_destroy(m1);
+}
+
+TEST( types_hashmap_hashcode_nested, "as_hashmap hashcode follows nested lists" ) {
+
+	as_hashmap * m1 = as_hashmap_new(4);
+	as_openmap * m2 = as_openmap_new(0);
+	as_orderedmap * m3 = as_orderedmap_new(0);
+	as_stringmap_set_list((as_map *) m1, "a", (as_list *) as_arraylist_new(2, 2));
+	as_stringmap_set_list((as_map *) m2, "a", (as_list *) as_arraylist_new(2, 2));
+	as_stringmap_set_list((as_map *) m3, "a", (as_list *) as_arraylist_new(2, 2));
+	as_stringmap_set_int64((as_map *) m1, "b", 2);
+	as_stringmap_set_int64((as_map *) m2, "b", 2);
+	as_stringmap_set_int64((as_map *) m3, "b", 2);
+
+	uint32_t h = as_hashmap_hashcode(m1);
+	assert_int_eq( as_openmap_hashcode(m2), h );
+	assert_int_eq( as_orderedmap_hashcode(m3), h );
+
+	// Changing a nested list in place changes the map hash.
+	as_list_append_int64(as_stringmap_get_list((as_map *) m1, "a"), 1);
+	assert_int_ne( as_hashmap_hashcode(m1), h );
+	as_list_append_int64(as_stringmap_get_list((as_map *) m2, "a"), 1);
+	assert_int_eq( as_openmap_hashcode(m2), as_hashmap_hashcode(m1) );
+	as_list_append_int64(as_stringmap_get_list((as_map *) m3, "a"), 1);
+	assert_int_eq( as_orderedmap_hashcode(m3), as_hashmap_hashcode(m1) );
+
+	as_orderedmap_destroy(m3);
+	as_openmap_destroy(m2);
+	as_hashmap_destroy(m1);
+}
+
+TEST( types_hashmap_load, "as_hashmap_load" ) {
+
+	// Small table, so most entries land in collision slots.
+	as_hashmap * m1 = as_hashmap_new(8);
+	as_stringmap_set_int64((as_map *) m1, "k3", 0);
+
+	as_val * keys[100];
+	as_val * vals[100];
+	char name[16];
+
+	for (int i = 0; i < 100; i++) {
+		sprintf(name, "k%d", i % 50);
+		keys[i] = (as_val *) as_string_new_strdup(name);
+		vals[i] = (as_val *) as_integer_new(i);
+	}
+
+	// Repeated keys replace earlier entries, including the one already there.
+	assert_int_eq( as_hashmap_load(m1, keys, vals, 100, false), 0 );
+	assert_int_eq( as_hashmap_size(m1), 50 );
+
+	for (int i = 0; i < 50; i++) {
+		sprintf(name, "k%d", i);
+		assert_int_eq( as_stringmap_get_int64((as_map *) m1, name), i + 50 );
+	}
+
+	// Unique keys load without searching and read back the same.
+	as_hashmap * m2 = as_hashmap_new(8);
+
+	for (int i = 0; i < 50; i++) {
+		sprintf(name, "k%d", i);
+		keys[i] = (as_val *) as_string_new_strdup(name);
+		vals[i] = (as_val *) as_integer_new(i + 50);
+	}
+
+	assert_int_eq( as_hashmap_load(m2, keys, vals, 50, true), 0 );
+	assert_int_eq( as_hashmap_size(m2), 50 );
+	assert_int_eq( as_hashmap_hashcode(m2), as_hashmap_hashcode(m1) );
+	assert_val_eq( m2, m1 );
+
+	// A map that can't grow refuses a load it might not fit, taking nothing.
+	as_hashmap m3;
+	void * storage = cf_malloc(as_hashmap_wrap_size(4));
+	as_hashmap_init_wrap(&m3, 4, storage);
+
+	for (int i = 0; i < 10; i++) {
+		keys[i] = (as_val *) as_integer_new(i);
+		vals[i] = (as_val *) as_integer_new(i);
+	}
+
+	assert_int_ne( as_hashmap_load(&m3, keys, vals, 10, true), 0 );
+	assert_int_eq( as_hashmap_size(&m3), 0 );
+	assert_int_eq( as_hashmap_load(&m3, keys, vals, 4, true), 0 );
+	assert_int_eq( as_hashmap_size(&m3), 4 );
+
+	for (int i = 0; i < 4; i++) {
+		as_integer k;
+		as_integer_init(&k, i);
+		assert_not_null( as_hashmap_get(&m3, (as_val *) &k) );
+	}
+
+	for (int i = 4; i < 10; i++) {
+		as_val_destroy(keys[i]);
+		as_val_destroy(vals[i]);
+	}
+
+	as_hashmap_destroy(&m3);
+	cf_free(storage);
+	as_hashmap_destroy(m2);
+	as_hashmap_destroy(m1);
+}
+
+#define HASH_THREADS 4
+
+typedef struct hash_job_s {
+	const as_hashmap * map;
+	pthread_barrier_t * barrier;
+	uint32_t hash;
+} hash_job;
+
+static void * hash_run(void * udata)
+{
+	hash_job * job = udata;
+
+	pthread_barrier_wait(job->barrier);
+	job->hash = as_hashmap_hashcode(job->map);
+	return NULL;
+}
+
+TEST( types_hashmap_hashcode_concurrent, "concurrent hashcode of a read-only as_hashmap" ) {
+
+	pthread_barrier_t barrier;
+	pthread_barrier_init(&barrier, NULL, HASH_THREADS);
+
+	as_hashmap * ref = as_hashmap_new(4096);
+
+	for (int64_t i = 0; i < 20000; i++) {
+		as_map_set((as_map *) ref, (as_val *) as_integer_new(i), (as_val *) as_integer_new(i * 3));
+	}
+
+	uint32_t h = as_hashmap_hashcode(ref);
+
+	for (int round = 0; round < 20; round++) {
+		as_hashmap * m = as_hashmap_new(4096);
+
+		for (int64_t i = 0; i < 20000; i++) {
+			as_map_set((as_map *) m, (as_val *) as_integer_new(i), (as_val *) as_integer_new(i * 3));
+		}
+
+		hash_job jobs[HASH_THREADS];
+		pthread_t threads[HASH_THREADS];
+
+		for (int t = 0; t < HASH_THREADS; t++) {
+			jobs[t].map = m;
+			jobs[t].barrier = &barrier;
+			pthread_create(&threads[t], NULL, hash_run, &jobs[t]);
+		}
+
+		for (int t = 0; t < HASH_THREADS; t++) {
+			pthread_join(threads[t], NULL);
+		}
+
+		// Racing readers neither see nor cache a partial sum.
+		for (int t = 0; t < HASH_THREADS; t++) {
+			assert_int_eq( jobs[t].hash, h );
+		}
+
+		assert_int_eq( as_hashmap_hashcode(m), h );
+		as_hashmap_destroy(m);
+	}
+
+	as_hashmap_destroy(ref);
+	pthread_barrier_destroy(&barrier);
+}
+
 /******************************************************************************
  * TEST SUITE
  *****************************************************************************/
@@ -416,4 +624,8 @@ SUITE( types_hashmap, "as_hashmap" ) {
 	suite_add( types_hashmap_iterator );
 	suite_add( types_hashmap_foreach );
 	suite_add( types_hashmap_msgpack );
+	suite_add( types_hashmap_hashcode );
+	suite_add( types_hashmap_hashcode_nested );
+	suite_add( types_hashmap_hashcode_concurrent );
+	suite_add( types_hashmap_load );
 }
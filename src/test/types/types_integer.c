@@ -45,6 +45,44 @@ TEST( types_integer_long_min, "as_integer containing LONG_MIN" ) {
     assert( as_integer_toint(&i) == LONG_MIN );
 }
 
+TEST( types_integer_hashcode, "as_integer hashcode spreads high bits" ) {
+    // Keys that differ only above bit 32 must still fill a small table.
+    uint32_t buckets[64] = { 0 };
+
+    for ( int64_t k = 0; k < 6400; k++ ) {
+        as_integer i;
+        as_integer_init(&i, k << 32);
+        buckets[as_val_hashcode((as_val *) &i) % 64]++;
+    }
+
+    for ( int b = 0; b < 64; b++ ) {
+        assert_true( buckets[b] > 50 && buckets[b] < 150 );
+    }
+}
+
+TEST( types_integer_shared, "as_integer shared small values" ) {
+    for ( int64_t v = AS_INTEGER_SHARED_MIN; v <= AS_INTEGER_SHARED_MAX; v++ ) {
+        as_integer * i = as_integer_new_shared(v);
+        assert_int_eq( as_integer_get(i), v );
+        assert_true( as_integer_new_shared(v) == i );
+    }
+
+    // Shared values survive reserve and destroy.
+    as_integer * i = as_integer_new_shared(7);
+    as_val_reserve(i);
+    as_integer_destroy(i);
+    as_integer_destroy(i);
+    assert_int_eq( i->_.count, 0 );
+    assert_int_eq( as_integer_get(as_integer_new_shared(7)), 7 );
+
+    // Others are allocated as usual.
+    as_integer * big = as_integer_new_shared(AS_INTEGER_SHARED_MAX + 1);
+    assert_int_eq( as_integer_get(big), AS_INTEGER_SHARED_MAX + 1 );
+    assert_int_eq( big->_.count, 1 );
+    assert_true( as_integer_new_shared(AS_INTEGER_SHARED_MIN) != as_integer_new_shared(AS_INTEGER_SHARED_MIN + 1) );
+    as_integer_destroy(big);
+}
+
 /******************************************************************************
  * TEST SUITE
  *****************************************************************************/
@@ -56,4 +94,6 @@ SUITE( types_integer, "as_integer" ) {
     suite_add( types_integer_ulong_max );
     suite_add( types_integer_long_max );
     suite_add( types_integer_long_min );
+    suite_add( types_integer_hashcode );
+    suite_add( types_integer_shared );
 }
\ No newline at end of file
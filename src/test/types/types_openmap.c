@@ -0,0 +1,200 @@
+#include "../test.h"
+
+#include <aerospike/as_integer.h>
+#include <aerospike/as_iterator.h>
+#include <aerospike/as_map.h>
+#include <aerospike/as_msgpack.h>
+#include <aerospike/as_openmap.h>
+#include <aerospike/as_openmap_iterator.h>
+#include <aerospike/as_pair.h>
+#include <aerospike/as_serializer.h>
+#include <aerospike/as_string.h>
+#include <aerospike/as_stringmap.h>
+#include <citrusleaf/alloc.h>
+
+#include <stdlib.h>
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST( types_openmap_empty, "as_openmap is empty" ) {
+	as_openmap * m = as_openmap_new(0);
+	assert_int_eq( as_map_size((as_map *) m), 0 );
+	assert_int_eq( m->capacity, AS_OPENMAP_MIN_CAPACITY );
+	as_map_destroy((as_map *) m);
+}
+
+TEST( types_openmap_ops, "as_openmap ops" ) {
+
+	as_val * a = (as_val *) as_string_new_strdup("a");
+	as_val * b = (as_val *) as_string_new_strdup("b");
+
+	as_openmap m;
+	as_openmap_init(&m, 2);
+
+	as_openmap_set(&m, as_val_reserve(a), (as_val *) as_integer_new(1));
+	as_openmap_set(&m, as_val_reserve(b), (as_val *) as_integer_new(2));
+	assert_int_eq( as_openmap_size(&m), 2 );
+
+	assert_int_eq( as_integer_get((as_integer *) as_openmap_get(&m, a)), 1 );
+	assert_int_eq( as_integer_get((as_integer *) as_openmap_get(&m, b)), 2 );
+
+	// Replace.
+	as_openmap_set(&m, as_val_reserve(a), (as_val *) as_integer_new(3));
+	assert_int_eq( as_openmap_size(&m), 2 );
+	assert_int_eq( as_integer_get((as_integer *) as_openmap_get(&m, a)), 3 );
+
+	// NULL values are stored as nil.
+	as_stringmap_set((as_map *) &m, "c", NULL);
+	assert_int_eq( as_val_type(as_stringmap_get((as_map *) &m, "c")), AS_NIL );
+
+	assert_int_eq( as_openmap_remove(&m, a), 0 );
+	assert_int_eq( as_openmap_size(&m), 2 );
+	assert_null( as_openmap_get(&m, a) );
+
+	// Only scalar keys are allowed.
+	// A failed set leaves the key and value with the caller.
+	as_map * bad = (as_map *) as_openmap_new(0);
+	as_integer * one = as_integer_new(1);
+	assert_int_ne( as_openmap_set(&m, (as_val *) bad, (as_val *) one), 0 );
+	as_map_destroy(bad);
+	as_integer_destroy(one);
+
+	assert_int_eq( as_openmap_clear(&m), 0 );
+	assert_int_eq( as_openmap_size(&m), 0 );
+	assert_null( as_openmap_get(&m, b) );
+
+	as_val_destroy(a);
+	as_val_destroy(b);
+	as_openmap_destroy(&m);
+}
+
+TEST( types_openmap_grow, "as_openmap grows and removes under load" ) {
+
+	// Start undersized and mirror every operation in a plain array.
+	const uint32_t n = 50000;
+	int64_t * ref = cf_malloc(n * sizeof(int64_t));
+	as_openmap * m = as_openmap_new(0);
+
+	for (uint32_t i = 0; i < n; i++) {
+		// Keys only differ in their high bits.
+		int64_t k = (int64_t)i << 32;
+		ref[i] = i;
+		assert_int_eq( as_openmap_set(m, (as_val *) as_integer_new(k), (as_val *) as_integer_new(i)), 0 );
+	}
+
+	assert_int_eq( as_openmap_size(m), n );
+	assert_true( (uint64_t)n * 8 <= (uint64_t)m->capacity * AS_OPENMAP_MAX_LOAD );
+
+	srand(17);
+
+	for (uint32_t r = 0; r < 2 * n; r++) {
+		uint32_t i = (uint32_t)rand() % n;
+		as_integer k;
+		as_integer_init(&k, (int64_t)i << 32);
+
+		if (r % 3 == 0) {
+			as_openmap_remove(m, (as_val *) &k);
+			ref[i] = -1;
+		}
+		else if (r % 3 == 1) {
+			as_openmap_set(m, (as_val *) as_integer_new((int64_t)i << 32), (as_val *) as_integer_new(r));
+			ref[i] = r;
+		}
+	}
+
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < n; i++) {
+		as_integer k;
+		as_integer_init(&k, (int64_t)i << 32);
+		as_integer * v = (as_integer *) as_openmap_get(m, (as_val *) &k);
+
+		if (ref[i] < 0) {
+			assert_null( v );
+		}
+		else {
+			assert_not_null( v );
+			assert_int_eq( as_integer_get(v), ref[i] );
+			count++;
+		}
+	}
+
+	assert_int_eq( as_openmap_size(m), count );
+
+	uint32_t capacity = m->capacity;
+	assert_int_eq( as_openmap_reserve(m, count), 0 );
+	assert_int_eq( m->capacity, capacity );
+
+	as_openmap_destroy(m);
+	cf_free(ref);
+}
+
+TEST( types_openmap_iterator, "as_openmap w/ as_iterator ops" ) {
+
+	as_openmap * m = as_openmap_new(0);
+
+	for (int64_t i = 0; i < 100; i++) {
+		as_openmap_set(m, (as_val *) as_integer_new(i), (as_val *) as_integer_new(i * 2));
+	}
+
+	as_iterator * it = (as_iterator *) as_openmap_iterator_new(m);
+
+	uint32_t count = 0;
+	while ( as_iterator_has_next(it) ) {
+		as_pair * p = (as_pair *) as_iterator_next(it);
+		as_integer * k = (as_integer *) as_pair_1(p);
+		as_integer * v = (as_integer *) as_pair_2(p);
+		assert_int_eq( as_integer_get(v), as_integer_get(k) * 2 );
+		count++;
+	}
+
+	as_iterator_destroy(it);
+	assert_int_eq( count, 100 );
+
+	as_openmap_destroy(m);
+}
+
+TEST( types_openmap_msgpack, "as_openmap msgpack" ) {
+
+	as_openmap * m1 = as_openmap_new(0);
+	as_stringmap_set_int64((as_map *) m1, "a", 1);
+	as_stringmap_set_int64((as_map *) m1, "b", 2);
+
+	as_serializer ser;
+	as_msgpack_init(&ser);
+
+	as_buffer b;
+	as_buffer_init(&b);
+
+	as_serializer_serialize(&ser, (as_val *) m1, &b);
+
+	as_val * v2 = NULL;
+	as_serializer_deserialize(&ser, &b, &v2);
+
+	assert_not_null( v2 );
+	assert_int_eq( as_val_type(v2), AS_MAP );
+
+	as_map * m2 = as_map_fromval(v2);
+	assert_int_eq( as_map_size(m2), 2 );
+	assert_int_eq( as_stringmap_get_int64(m2, "a"), 1 );
+	assert_int_eq( as_stringmap_get_int64(m2, "b"), 2 );
+
+	as_map_destroy(m2);
+	as_openmap_destroy(m1);
+	as_buffer_destroy(&b);
+	as_serializer_destroy(&ser);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE( types_openmap, "as_openmap" ) {
+	suite_add( types_openmap_empty );
+	suite_add( types_openmap_ops );
+	suite_add( types_openmap_grow );
+	suite_add( types_openmap_iterator );
+	suite_add( types_openmap_msgpack );
+}
@@ -0,0 +1,465 @@
+#include "../test.h"
+#include "../test_common.h"
+
+#include <aerospike/as_arena.h>
+#include <aerospike/as_arraylist.h>
+#include <aerospike/as_double.h>
+#include <aerospike/as_hashmap.h>
+#include <aerospike/as_integer.h>
+#include <aerospike/as_iterator.h>
+#include <aerospike/as_map.h>
+#include <aerospike/as_msgpack.h>
+#include <aerospike/as_msgpack_serializer.h>
+#include <aerospike/as_orderedmap.h>
+#include <aerospike/as_orderedmap_iterator.h>
+#include <aerospike/as_pair.h>
+#include <aerospike/as_serializer.h>
+#include <aerospike/as_string.h>
+#include <aerospike/as_stringmap.h>
+#include <citrusleaf/alloc.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static msgpack_compare_t packed_compare(const as_val * v1, const as_val * v2)
+{
+	as_serializer ser;
+	as_msgpack_init(&ser);
+
+	as_buffer b1;
+	as_buffer b2;
+	as_buffer_init(&b1);
+	as_buffer_init(&b2);
+	as_serializer_serialize(&ser, (as_val *) v1, &b1);
+	as_serializer_serialize(&ser, (as_val *) v2, &b2);
+
+	msgpack_compare_t ret = as_unpack_buf_compare(b1.data, b1.size, b2.data, b2.size);
+
+	as_buffer_destroy(&b1);
+	as_buffer_destroy(&b2);
+	as_serializer_destroy(&ser);
+
+	return ret;
+}
+
+static bool count_foreach(const as_val * key, const as_val * val, void * udata)
+{
+	(*(int64_t *) udata) += as_integer_get((as_integer *) val);
+	return true;
+}
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST( types_orderedmap_ops, "as_orderedmap ops" ) {
+
+	as_orderedmap m;
+	as_orderedmap_init(&m, 0);
+	assert_int_eq( m.capacity, AS_ORDEREDMAP_MIN_CAPACITY );
+	assert_int_eq( m._.flags, AS_PACKED_MAP_FLAG_K_ORDERED );
+
+	as_stringmap_set_int64((as_map *) &m, "c", 3);
+	as_stringmap_set_int64((as_map *) &m, "a", 1);
+	as_stringmap_set_int64((as_map *) &m, "b", 2);
+	assert_int_eq( as_orderedmap_size(&m), 3 );
+
+	as_val * k;
+	as_val * v;
+
+	assert_true( as_orderedmap_get_at(&m, 0, &k, &v) );
+	assert_string_eq( as_string_get((as_string *) k), "a" );
+	assert_true( as_orderedmap_get_at(&m, 2, &k, &v) );
+	assert_string_eq( as_string_get((as_string *) k), "c" );
+	assert_false( as_orderedmap_get_at(&m, 3, &k, &v) );
+
+	// Replace.
+	as_stringmap_set_int64((as_map *) &m, "b", 20);
+	assert_int_eq( as_orderedmap_size(&m), 3 );
+	assert_int_eq( as_stringmap_get_int64((as_map *) &m, "b"), 20 );
+
+	// NULL values are stored as nil.
+	as_stringmap_set((as_map *) &m, "d", NULL);
+	assert_int_eq( as_val_type(as_stringmap_get((as_map *) &m, "d")), AS_NIL );
+
+	as_string a;
+	as_string_init(&a, "a", false);
+	assert_int_eq( as_orderedmap_remove(&m, (as_val *) &a), 0 );
+	assert_int_eq( as_orderedmap_size(&m), 3 );
+	assert_null( as_orderedmap_get(&m, (as_val *) &a) );
+	assert_true( as_orderedmap_get_at(&m, 0, &k, &v) );
+	assert_string_eq( as_string_get((as_string *) k), "b" );
+
+	bool found;
+	assert_int_eq( as_orderedmap_find(&m, (as_val *) &a, &found), 0 );
+	assert_false( found );
+
+	// Only scalar and list keys are allowed.
+	// A failed set leaves the key and value with the caller.
+	as_map * bad = (as_map *) as_orderedmap_new(0);
+	as_integer * one = as_integer_new(1);
+	assert_int_ne( as_orderedmap_set(&m, (as_val *) bad, (as_val *) one), 0 );
+	as_map_destroy(bad);
+	as_integer_destroy(one);
+
+	// Growth past the initial capacity, out of order.
+	for (int i = 0; i < 100; i++) {
+		as_map_set((as_map *) &m, (as_val *) as_integer_new((i * 37) % 100), (as_val *) as_integer_new(i));
+	}
+
+	assert_int_eq( as_orderedmap_size(&m), 103 );
+
+	for (uint32_t i = 0; i < 100; i++) {
+		assert_true( as_orderedmap_get_at(&m, i, &k, &v) );
+		assert_int_eq( as_integer_get((as_integer *) k), i );
+	}
+
+	// Same contents hash the same as a hashmap.
+	as_hashmap h;
+	as_hashmap_init(&h, 128);
+	as_stringmap_set_int64((as_map *) &h, "d", 0);
+	as_stringmap_set((as_map *) &h, "d", NULL);
+	as_stringmap_set_int64((as_map *) &h, "b", 20);
+	as_stringmap_set_int64((as_map *) &h, "c", 3);
+
+	for (int i = 0; i < 100; i++) {
+		as_map_set((as_map *) &h, (as_val *) as_integer_new((i * 37) % 100), (as_val *) as_integer_new(i));
+	}
+
+	assert_int_eq( as_val_hashcode(&m), as_val_hashcode(&h) );
+	assert_val_eq( &h, &m );
+
+	as_hashmap_destroy(&h);
+	as_orderedmap_destroy(&m);
+}
+
+TEST( types_orderedmap_collation, "as_orderedmap orders keys like as_unpack_compare" ) {
+
+	as_orderedmap * m = as_orderedmap_new(0);
+
+	as_arraylist * l1 = as_arraylist_new(2, 0);
+	as_arraylist_append_int64(l1, 1);
+	as_arraylist_append_str(l1, "x");
+
+	as_arraylist * l2 = as_arraylist_new(1, 0);
+	as_arraylist_append_int64(l2, 1);
+
+	as_val * keys[] = {
+		(as_val *) as_string_new_strdup("ab"),
+		(as_val *) as_integer_new(-5),
+		(as_val *) as_double_new(2.5),
+		(as_val *) as_string_new_strdup("a"),
+		(as_val *) l1,
+		(as_val *) as_integer_new(7),
+		(as_val *) as_bytes_new_wrap((uint8_t *) "zz", 2, false),
+		(as_val *) as_string_new_strdup("b"),
+		(as_val *) &as_nil,
+		(as_val *) as_double_new(-1.0),
+		(as_val *) l2,
+		(as_val *) as_boolean_new(true),
+		(as_val *) as_boolean_new(false),
+	};
+	uint32_t n = sizeof(keys) / sizeof(keys[0]);
+
+	for (uint32_t i = 0; i < n; i++) {
+		assert_int_eq( as_orderedmap_set(m, keys[i], (as_val *) as_integer_new(i)), 0 );
+	}
+
+	assert_int_eq( as_orderedmap_size(m), n );
+
+	for (uint32_t i = 1; i < n; i++) {
+		as_val * k1;
+		as_val * k2;
+		as_val * v;
+
+		as_orderedmap_get_at(m, i - 1, &k1, &v);
+		as_orderedmap_get_at(m, i, &k2, &v);
+		assert_int_eq( packed_compare(k1, k2), MSGPACK_COMPARE_LESS );
+	}
+
+	// Every key is found again by binary search.
+	for (uint32_t i = 0; i < n; i++) {
+		as_val * v = as_orderedmap_get(m, keys[i]);
+		assert_not_null( v );
+		assert_int_eq( as_integer_get((as_integer *) v), i );
+	}
+
+	as_orderedmap_destroy(m);
+}
+
+TEST( types_orderedmap_key_ties, "as_orderedmap keys equal only when as_hashmap's are" ) {
+
+	as_orderedmap * m = as_orderedmap_new(0);
+
+	// Same payload held as a string, as string bytes and as two bytes types.
+	as_bytes * str_bytes = as_bytes_new_wrap((uint8_t *) "key", 3, false);
+	as_bytes_set_type(str_bytes, AS_BYTES_STRING);
+
+	as_bytes * java = as_bytes_new_wrap((uint8_t *) "key", 3, false);
+	as_bytes_set_type(java, AS_BYTES_JAVA);
+
+	as_val * keys[] = {
+		(as_val *) java,
+		(as_val *) as_string_new_strdup("key"),
+		(as_val *) as_bytes_new_wrap((uint8_t *) "key", 3, false),
+		(as_val *) str_bytes,
+	};
+	uint32_t n = sizeof(keys) / sizeof(keys[0]);
+
+	for (uint32_t i = 0; i < n; i++) {
+		assert_int_eq( as_orderedmap_set(m, keys[i], (as_val *) as_integer_new(i)), 0 );
+	}
+
+	assert_int_eq( as_orderedmap_size(m), n );
+
+	for (uint32_t i = 0; i < n; i++) {
+		as_val * v = as_orderedmap_get(m, keys[i]);
+		assert_not_null( v );
+		assert_int_eq( as_integer_get((as_integer *) v), i );
+	}
+
+	// Strings first, then bytes by particle type.
+	as_val * k;
+	as_val * v;
+	as_orderedmap_get_at(m, 0, &k, &v);
+	assert_int_eq( as_val_type(k), AS_STRING );
+	as_orderedmap_get_at(m, 1, &k, &v);
+	assert_int_eq( ((as_bytes *) k)->type, AS_BYTES_STRING );
+	as_orderedmap_get_at(m, 3, &k, &v);
+	assert_int_eq( ((as_bytes *) k)->type, AS_BYTES_JAVA );
+
+	as_orderedmap_destroy(m);
+
+	// NaN sorts after every other double and replaces itself.
+	m = as_orderedmap_new(0);
+	assert_int_eq( as_orderedmap_set(m, (as_val *) as_double_new(NAN), (as_val *) as_integer_new(1)), 0 );
+	assert_int_eq( as_orderedmap_set(m, (as_val *) as_double_new(INFINITY), (as_val *) as_integer_new(2)), 0 );
+	assert_int_eq( as_orderedmap_set(m, (as_val *) as_double_new(-1.5), (as_val *) as_integer_new(3)), 0 );
+	assert_int_eq( as_orderedmap_set(m, (as_val *) as_double_new(NAN), (as_val *) as_integer_new(4)), 0 );
+	assert_int_eq( as_orderedmap_size(m), 3 );
+
+	as_orderedmap_get_at(m, 2, &k, &v);
+	assert_true( isnan(as_double_get((as_double *) k)) );
+	assert_int_eq( as_integer_get((as_integer *) v), 4 );
+
+	as_orderedmap_destroy(m);
+}
+
+TEST( types_orderedmap_range, "as_orderedmap range iteration" ) {
+
+	as_orderedmap * m = as_orderedmap_new(0);
+
+	for (int i = 99; i >= 0; i--) {
+		as_map_set((as_map *) m, (as_val *) as_integer_new(i * 2), (as_val *) as_integer_new(i * 2));
+	}
+
+	// Whole map, in order.
+	as_orderedmap_iterator it;
+	as_orderedmap_iterator_init(&it, m);
+
+	int64_t expected = 0;
+
+	while (as_orderedmap_iterator_has_next(&it)) {
+		as_pair * p = (as_pair *) as_orderedmap_iterator_next(&it);
+		assert_int_eq( as_integer_get((as_integer *) as_pair_1(p)), expected );
+		expected += 2;
+	}
+
+	assert_int_eq( expected, 200 );
+	as_orderedmap_iterator_destroy(&it);
+
+	// [15, 31) holds 16, 18, ..., 30.
+	as_integer begin;
+	as_integer end;
+	as_integer_init(&begin, 15);
+	as_integer_init(&end, 31);
+
+	as_orderedmap_iterator_init_range(&it, m, (as_val *) &begin, (as_val *) &end);
+
+	expected = 16;
+
+	while (as_orderedmap_iterator_has_next(&it)) {
+		as_pair * p = (as_pair *) as_orderedmap_iterator_next(&it);
+		assert_int_eq( as_integer_get((as_integer *) as_pair_1(p)), expected );
+		expected += 2;
+	}
+
+	assert_int_eq( expected, 32 );
+	as_orderedmap_iterator_destroy(&it);
+
+	int64_t sum = 0;
+	assert_true( as_orderedmap_foreach_range(m, (as_val *) &begin, (as_val *) &end, count_foreach, &sum) );
+	assert_int_eq( sum, 16 + 18 + 20 + 22 + 24 + 26 + 28 + 30 );
+
+	// Open ended ranges.
+	as_integer_init(&begin, 190);
+	sum = 0;
+	as_orderedmap_foreach_range(m, (as_val *) &begin, NULL, count_foreach, &sum);
+	assert_int_eq( sum, 190 + 192 + 194 + 196 + 198 );
+
+	as_integer_init(&end, 4);
+	sum = 0;
+	as_orderedmap_foreach_range(m, NULL, (as_val *) &end, count_foreach, &sum);
+	assert_int_eq( sum, 0 + 2 );
+
+	// Through the as_map interface.
+	as_iterator * mi = (as_iterator *) as_map_iterator_new((as_map *) m);
+	int count = 0;
+
+	while (as_iterator_has_next(mi)) {
+		as_iterator_next(mi);
+		count++;
+	}
+
+	assert_int_eq( count, 100 );
+	as_iterator_destroy(mi);
+
+	as_orderedmap_destroy(m);
+}
+
+TEST( types_orderedmap_msgpack, "as_orderedmap msgpack" ) {
+
+	as_orderedmap * m1 = as_orderedmap_new(0);
+	char name[16];
+
+	for (int i = 0; i < 40; i++) {
+		sprintf(name, "key%d", (i * 7) % 40);
+		as_stringmap_set_int64((as_map *) m1, name, i);
+	}
+
+	as_serializer ser;
+	as_msgpack_init(&ser);
+
+	as_buffer b1;
+	as_buffer_init(&b1);
+	as_serializer_serialize(&ser, (as_val *) m1, &b1);
+
+	// Packed as a K-ordered map, and unpacked back into an ordered map.
+	as_unpacker pk = {
+			.buffer = b1.data,
+			.offset = 0,
+			.length = b1.size,
+	};
+
+	assert_int_eq( as_unpack_map_header_element_count(&pk), 41 );
+	assert_true( as_unpack_peek_is_ext(&pk) );
+
+	as_val * v2 = NULL;
+	as_serializer_deserialize(&ser, &b1, &v2);
+
+	assert_not_null( v2 );
+	assert_int_eq( ((as_map *) v2)->flags, AS_PACKED_MAP_FLAG_K_ORDERED );
+	assert_val_eq( v2, m1 );
+
+	as_val * k;
+	as_val * v;
+	assert_true( as_orderedmap_get_at((as_orderedmap *) v2, 0, &k, &v) );
+	assert_string_eq( as_string_get((as_string *) k), "key0" );
+
+	// Packs back out byte for byte.
+	as_buffer b2;
+	as_buffer_init(&b2);
+	as_serializer_serialize(&ser, v2, &b2);
+	assert_int_eq( b2.size, b1.size );
+	assert_int_eq( memcmp(b1.data, b2.data, b1.size), 0 );
+
+	// Arena unpacking gives a fixed capacity ordered map.
+	as_arena arena;
+	as_arena_init(&arena, 0);
+
+	as_msgpack_arena_serializer aser;
+	as_msgpack_arena_init(&aser, &arena);
+
+	as_val * v3 = NULL;
+	as_serializer_deserialize((as_serializer *) &aser, &b1, &v3);
+	assert_not_null( v3 );
+	assert_val_eq( v3, m1 );
+
+	// Arena maps are read only.
+	as_string * zzz = as_string_new_strdup("zzz");
+	as_integer * one = as_integer_new(1);
+	assert_int_ne( as_map_set((as_map *) v3, (as_val *) zzz, (as_val *) one), 0 );
+	as_string_destroy(zzz);
+	as_integer_destroy(one);
+
+	as_serializer_destroy((as_serializer *) &aser);
+	as_arena_destroy(&arena);
+
+	// Only as_orderedmap is packed K-ordered, whatever other maps' flags say.
+	as_hashmap h;
+	as_hashmap_init(&h, 32);
+	h._.flags = AS_PACKED_MAP_FLAG_K_ORDERED;
+	as_stringmap_set_int64((as_map *) &h, "b", 2);
+	as_stringmap_set_int64((as_map *) &h, "a", 1);
+
+	as_buffer b3;
+	as_buffer_init(&b3);
+	as_serializer_serialize(&ser, (as_val *) &h, &b3);
+
+	as_unpacker hpk = {
+			.buffer = b3.data,
+			.offset = 0,
+			.length = b3.size,
+	};
+
+	assert_int_eq( as_unpack_map_header_element_count(&hpk), 2 );
+	assert_false( as_unpack_peek_is_ext(&hpk) );
+
+	as_buffer_destroy(&b3);
+	as_hashmap_destroy(&h);
+
+	as_val_destroy(v2);
+	as_orderedmap_destroy(m1);
+	as_buffer_destroy(&b2);
+	as_buffer_destroy(&b1);
+	as_serializer_destroy(&ser);
+}
+
+TEST( types_orderedmap_msgpack_kv, "as_orderedmap msgpack KV-ordered roundtrip" ) {
+
+	// {ext(KV-ordered): nil, 1: 2, 3: 4}
+	uint8_t packed[] = { 0x83, 0xc7, 0x00, AS_PACKED_MAP_FLAG_KV_ORDERED, 0xc0,
+			0x01, 0x02, 0x03, 0x04 };
+
+	as_serializer ser;
+	as_msgpack_init(&ser);
+
+	as_buffer b1;
+	as_buffer_init(&b1);
+	b1.data = packed;
+	b1.size = sizeof(packed);
+
+	as_val * v = NULL;
+	as_serializer_deserialize(&ser, &b1, &v);
+	assert_not_null( v );
+	assert_int_eq( ((as_map *) v)->flags, AS_PACKED_MAP_FLAG_KV_ORDERED );
+
+	// Packs back out with the flags it came with.
+	as_buffer b2;
+	as_buffer_init(&b2);
+	as_serializer_serialize(&ser, v, &b2);
+	assert_int_eq( b2.size, sizeof(packed) );
+	assert_int_eq( memcmp(b2.data, packed, sizeof(packed)), 0 );
+
+	as_buffer_destroy(&b2);
+	as_val_destroy(v);
+	as_serializer_destroy(&ser);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE( types_orderedmap, "as_orderedmap" ) {
+	suite_add( types_orderedmap_ops );
+	suite_add( types_orderedmap_collation );
+	suite_add( types_orderedmap_key_ties );
+	suite_add( types_orderedmap_range );
+	suite_add( types_orderedmap_msgpack );
+	suite_add( types_orderedmap_msgpack_kv );
+}
@@ -0,0 +1,165 @@
+#include "../test.h"
+
+#include <aerospike/as_atomic.h>
+#include <citrusleaf/cf_queue.h>
+#include <pthread.h>
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(types_queue_batch_wrap, "cf_queue push_n and pop_n around the ring")
+{
+	cf_queue q;
+	assert_true(cf_queue_init(&q, sizeof(int), 8, true));
+
+	int in[32];
+	int out[32];
+
+	for (int i = 0; i < 32; i++) {
+		in[i] = i;
+	}
+
+	// Move the head part way round so the next batch wraps.
+	assert_int_eq(cf_queue_push_n(&q, in, 5), CF_QUEUE_OK);
+	assert_int_eq(cf_queue_pop_n(&q, out, 3, CF_QUEUE_NOWAIT), 3);
+	assert_int_eq(out[2], 2);
+
+	assert_int_eq(cf_queue_push_n(&q, in + 5, 4), CF_QUEUE_OK);
+	assert_int_eq(q.alloc_sz, 8);
+	assert_int_eq(cf_queue_sz(&q), 6);
+
+	// Short of n - only what is queued comes back.
+	assert_int_eq(cf_queue_pop_n(&q, out, 10, CF_QUEUE_NOWAIT), 6);
+
+	for (int i = 0; i < 6; i++) {
+		assert_int_eq(out[i], i + 3);
+	}
+
+	assert_int_eq(cf_queue_pop_n(&q, out, 10, CF_QUEUE_NOWAIT), CF_QUEUE_EMPTY);
+	assert_int_eq(cf_queue_pop_n(&q, out, 10, 20), CF_QUEUE_EMPTY);
+	assert_int_eq(cf_queue_pop_n(&q, out, 0, CF_QUEUE_NOWAIT), 0);
+
+	// Grow a fragmented queue in one step.
+	assert_int_eq(cf_queue_push_n(&q, in, 6), CF_QUEUE_OK);
+	assert_int_eq(cf_queue_pop_n(&q, out, 5, CF_QUEUE_NOWAIT), 5);
+	assert_int_eq(cf_queue_push_n(&q, in, 4), CF_QUEUE_OK);
+	assert_int_eq(cf_queue_push_n(&q, in + 4, 28), CF_QUEUE_OK);
+	assert_int_eq(q.alloc_sz, 64);
+	assert_int_eq(cf_queue_sz(&q), 33);
+
+	int v;
+	assert_int_eq(cf_queue_pop(&q, &v, CF_QUEUE_NOWAIT), CF_QUEUE_OK);
+	assert_int_eq(v, 5);
+	assert_int_eq(cf_queue_pop_n(&q, out, 32, CF_QUEUE_NOWAIT), 32);
+
+	for (int i = 0; i < 32; i++) {
+		assert_int_eq(out[i], i);
+	}
+
+	assert_int_eq(cf_queue_sz(&q), 0);
+
+	cf_queue_destroy(&q);
+}
+
+#define BATCH_THREADS 4
+#define BATCH_ITEMS 50000
+#define BATCH_BURST 16
+
+static void*
+batch_producer(void* udata)
+{
+	cf_queue* q = (cf_queue*)udata;
+	uint64_t burst[BATCH_BURST];
+	uint64_t next = 1;
+
+	while (next <= BATCH_ITEMS) {
+		uint32_t n = 0;
+
+		while (n < BATCH_BURST && next <= BATCH_ITEMS) {
+			burst[n++] = next++;
+		}
+
+		cf_queue_push_n(q, burst, n);
+	}
+
+	return NULL;
+}
+
+typedef struct {
+	cf_queue* q;
+	uint32_t done;
+} batch_args;
+
+static void*
+batch_consumer(void* udata)
+{
+	batch_args* args = (batch_args*)udata;
+	uint64_t burst[BATCH_BURST / 2];
+	uint64_t sum = 0;
+
+	while (true) {
+		// Once producers are done, finding the queue empty means it's drained.
+		bool done = as_load_uint32(&args->done) != 0;
+		int n = cf_queue_pop_n(args->q, burst, BATCH_BURST / 2, 10);
+
+		if (n == CF_QUEUE_EMPTY) {
+			if (done) {
+				return (void*)(uintptr_t)sum;
+			}
+
+			continue;
+		}
+
+		for (int i = 0; i < n; i++) {
+			sum += burst[i];
+		}
+	}
+}
+
+TEST(types_queue_batch_threads, "cf_queue push_n and pop_n across threads")
+{
+	batch_args args = {
+		.q = cf_queue_create(sizeof(uint64_t), true),
+		.done = 0
+	};
+
+	assert_not_null(args.q);
+
+	pthread_t producers[BATCH_THREADS];
+	pthread_t consumers[BATCH_THREADS];
+
+	for (int i = 0; i < BATCH_THREADS; i++) {
+		pthread_create(&consumers[i], NULL, batch_consumer, &args);
+		pthread_create(&producers[i], NULL, batch_producer, args.q);
+	}
+
+	for (int i = 0; i < BATCH_THREADS; i++) {
+		pthread_join(producers[i], NULL);
+	}
+
+	as_store_uint32(&args.done, 1);
+
+	uint64_t sum = 0;
+
+	for (int i = 0; i < BATCH_THREADS; i++) {
+		void* ret;
+		pthread_join(consumers[i], &ret);
+		sum += (uint64_t)(uintptr_t)ret;
+	}
+
+	assert_int_eq(sum, (uint64_t)BATCH_THREADS * BATCH_ITEMS * (BATCH_ITEMS + 1) / 2);
+	assert_int_eq(cf_queue_sz(args.q), 0);
+
+	cf_queue_destroy(args.q);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(types_queue_batch, "cf_queue batches")
+{
+	suite_add(types_queue_batch_wrap);
+	suite_add(types_queue_batch_threads);
+}
@@ -0,0 +1,133 @@
+#include "../test.h"
+
+#include <citrusleaf/cf_clock.h>
+#include <citrusleaf/cf_queue_mpmc.h>
+#include <pthread.h>
+#include <sched.h>
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+typedef struct {
+	uint64_t id;
+	uint32_t pad[3];
+} mpmc_item;
+
+TEST(types_queue_mpmc_fifo, "cf_queue_mpmc push and pop")
+{
+	assert_null(cf_queue_mpmc_create(sizeof(int), 0));
+
+	cf_queue_mpmc q;
+	assert_true(cf_queue_mpmc_init(&q, sizeof(mpmc_item), 10));
+	assert_int_eq(cf_queue_mpmc_capacity(&q), 16);
+	assert_int_eq(cf_queue_mpmc_sz(&q), 0);
+
+	mpmc_item item = { 0 };
+
+	// Several laps around the ring.
+	for (uint64_t lap = 0; lap < 5; lap++) {
+		for (uint64_t i = 0; i < 16; i++) {
+			item.id = lap * 100 + i;
+			assert_int_eq(cf_queue_mpmc_push(&q, &item), CF_QUEUE_OK);
+		}
+
+		assert_int_eq(cf_queue_mpmc_push(&q, &item), CF_QUEUE_FULL);
+		assert_int_eq(cf_queue_mpmc_sz(&q), 16);
+
+		for (uint64_t i = 0; i < 16; i++) {
+			assert_int_eq(cf_queue_mpmc_pop(&q, &item, CF_QUEUE_NOWAIT), CF_QUEUE_OK);
+			assert_int_eq(item.id, lap * 100 + i);
+		}
+
+		assert_int_eq(cf_queue_mpmc_pop(&q, &item, CF_QUEUE_NOWAIT), CF_QUEUE_EMPTY);
+	}
+
+	// Timed pops give up.
+	uint64_t start = cf_getms();
+	assert_int_eq(cf_queue_mpmc_pop(&q, &item, 50), CF_QUEUE_EMPTY);
+	assert_true(cf_getms() - start >= 50);
+
+	cf_queue_mpmc_destroy(&q);
+}
+
+#define MPMC_THREADS 4
+#define MPMC_ITEMS 100000
+
+static void*
+mpmc_producer(void* udata)
+{
+	cf_queue_mpmc* q = (cf_queue_mpmc*)udata;
+
+	for (uint64_t i = 1; i <= MPMC_ITEMS; i++) {
+		while (cf_queue_mpmc_push(q, &i) != CF_QUEUE_OK) {
+			sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+static void*
+mpmc_consumer(void* udata)
+{
+	cf_queue_mpmc* q = (cf_queue_mpmc*)udata;
+	uint64_t sum = 0;
+	uint64_t v;
+
+	// Zero is the signal to stop.
+	while (cf_queue_mpmc_pop(q, &v, CF_QUEUE_FOREVER) == CF_QUEUE_OK && v != 0) {
+		sum += v;
+	}
+
+	return (void*)(uintptr_t)sum;
+}
+
+TEST(types_queue_mpmc_threads, "cf_queue_mpmc many producers and consumers")
+{
+	cf_queue_mpmc* q = cf_queue_mpmc_create(sizeof(uint64_t), 64);
+	assert_not_null(q);
+
+	pthread_t producers[MPMC_THREADS];
+	pthread_t consumers[MPMC_THREADS];
+
+	for (int i = 0; i < MPMC_THREADS; i++) {
+		pthread_create(&consumers[i], NULL, mpmc_consumer, q);
+		pthread_create(&producers[i], NULL, mpmc_producer, q);
+	}
+
+	for (int i = 0; i < MPMC_THREADS; i++) {
+		pthread_join(producers[i], NULL);
+	}
+
+	uint64_t stop = 0;
+
+	for (int i = 0; i < MPMC_THREADS; i++) {
+		while (cf_queue_mpmc_push(q, &stop) != CF_QUEUE_OK) {
+			sched_yield();
+		}
+	}
+
+	uint64_t sum = 0;
+
+	for (int i = 0; i < MPMC_THREADS; i++) {
+		void* ret;
+		pthread_join(consumers[i], &ret);
+		sum += (uint64_t)(uintptr_t)ret;
+	}
+
+	assert_int_eq(sum, (uint64_t)MPMC_THREADS * MPMC_ITEMS * (MPMC_ITEMS + 1) / 2);
+	assert_int_eq(cf_queue_mpmc_sz(q), 0);
+
+	cf_queue_mpmc_destroy(q);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(types_queue_mpmc, "cf_queue_mpmc")
+{
+	suite_add(types_queue_mpmc_fifo);
+	suite_add(types_queue_mpmc_threads);
+}
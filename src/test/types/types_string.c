@@ -1,7 +1,12 @@
 
 #include "../test.h"
 
+#include <aerospike/as_hashmap.h>
+#include <aerospike/as_integer.h>
 #include <aerospike/as_string.h>
+#include <aerospike/as_stringmap.h>
+
+#include <string.h>
 
 /******************************************************************************
  * TEST CASES
@@ -28,6 +33,57 @@ TEST( types_string_random, "as_string containing random values" ) {
     as_string_destroy(&s);
 }
 
+TEST( types_string_hashcode, "as_string hashcode is cached" ) {
+    // Long keys that differ only at the end.
+    char k1[300];
+    char k2[300];
+    memset(k1, 'u', sizeof(k1) - 2);
+    k1[sizeof(k1) - 2] = '1';
+    k1[sizeof(k1) - 1] = 0;
+    strcpy(k2, k1);
+    k2[sizeof(k2) - 2] = '2';
+
+    as_string s;
+    as_string_init(&s, k1, false);
+    assert_int_eq( s.hash, 0 );
+
+    uint32_t h = as_val_hashcode((as_val *) &s);
+    assert_int_ne( h, 0 );
+    assert_int_eq( s.hash, h );
+    assert_int_eq( as_val_hashcode((as_val *) &s), h );
+
+    as_hashmap m;
+    as_hashmap_init(&m, 1);
+    as_stringmap_set_int64((as_map *) &m, k1, 1);
+    as_stringmap_set_int64((as_map *) &m, k2, 2);
+
+    assert_not_null( as_hashmap_get(&m, (as_val *) &s) );
+    assert_int_eq( as_integer_get((as_integer *) as_hashmap_get(&m, (as_val *) &s)), 1 );
+    assert_int_eq( as_stringmap_get_int64((as_map *) &m, k2), 2 );
+
+    as_hashmap_destroy(&m);
+    as_string_destroy(&s);
+}
+
+TEST( types_string_strndup, "as_string copied inline" ) {
+    as_string * s = as_string_new_strndup("hello world", 5);
+    assert_string_eq( as_string_get(s), "hello" );
+    assert_int_eq( as_string_len(s), 5 );
+    assert_false( s->free );
+    assert_true( s->value == (char *) (s + 1) );
+    as_string_destroy(s);
+
+    // Stops at a terminator, like cf_strndup().
+    s = as_string_new_strndup("ab\0cd", 5);
+    assert_int_eq( as_string_len(s), 2 );
+    as_string_destroy(s);
+
+    s = as_string_new_strdup("");
+    assert_string_eq( as_string_get(s), "" );
+    assert_int_eq( as_string_len(s), 0 );
+    as_string_destroy(s);
+}
+
 /******************************************************************************
  * TEST SUITE
  *****************************************************************************/
@@ -36,4 +92,6 @@ SUITE( types_string, "as_string" ) {
     // suite_add( types_string_null );
     suite_add( types_string_empty );
     suite_add( types_string_random );
+    suite_add( types_string_hashcode );
+    suite_add( types_string_strndup );
 }
\ No newline at end of file
@@ -0,0 +1,269 @@
+#include "../test.h"
+#include "../test_common.h"
+
+#include <aerospike/as_arraylist.h>
+#include <aerospike/as_double.h>
+#include <aerospike/as_integer.h>
+#include <aerospike/as_iterator.h>
+#include <aerospike/as_list.h>
+#include <aerospike/as_list_iterator.h>
+#include <aerospike/as_msgpack.h>
+#include <aerospike/as_msgpack_serializer.h>
+#include <aerospike/as_serializer.h>
+#include <aerospike/as_string.h>
+#include <aerospike/as_typedlist.h>
+#include <aerospike/as_typedlist_iterator.h>
+
+#include <pthread.h>
+#include <string.h>
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static bool sum_foreach(as_val * val, void * udata)
+{
+	(*(int64_t *) udata) += as_integer_get((as_integer *) val);
+	return true;
+}
+
+static bool same_packing(const as_val * v1, const as_val * v2)
+{
+	as_serializer ser;
+	as_msgpack_init(&ser);
+
+	as_buffer b1;
+	as_buffer b2;
+	as_buffer_init(&b1);
+	as_buffer_init(&b2);
+	as_serializer_serialize(&ser, (as_val *) v1, &b1);
+	as_serializer_serialize(&ser, (as_val *) v2, &b2);
+
+	bool same = b1.size == b2.size && memcmp(b1.data, b2.data, b1.size) == 0;
+
+	as_buffer_destroy(&b1);
+	as_buffer_destroy(&b2);
+	as_serializer_destroy(&ser);
+
+	return same;
+}
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST( types_typedlist_ops, "as_typedlist ops" ) {
+
+	assert_null( as_typedlist_new(AS_STRING, 0) );
+
+	as_typedlist l;
+	as_typedlist_init(&l, AS_INTEGER, 0);
+	as_list * list = (as_list *) &l;
+
+	for (int64_t i = 0; i < 100; i++) {
+		assert_int_eq( as_list_append_int64(list, i), AS_ARRAYLIST_OK );
+	}
+
+	assert_int_eq( as_list_size(list), 100 );
+	assert_int_eq( as_list_get_int64(list, 42), 42 );
+	assert_int_eq( as_typedlist_int64s(&l)[99], 99 );
+	assert_null( as_typedlist_doubles(&l) );
+
+	// Boxed access is cached and owned by the list.
+	as_val * v = as_list_get(list, 7);
+	assert_int_eq( as_val_type(v), AS_INTEGER );
+	assert_int_eq( as_integer_get((as_integer *) v), 7 );
+	assert_true( as_list_get(list, 7) == v );
+
+	// Only values of the list's type are accepted.
+	assert_int_eq( as_list_append_double(list, 1.5), AS_ARRAYLIST_ERR_TYPE );
+	assert_int_eq( as_list_append_str(list, "x"), AS_ARRAYLIST_ERR_TYPE );
+	as_string s;
+	as_string_init(&s, "x", false);
+	assert_int_eq( as_list_append(list, (as_val *) &s), AS_ARRAYLIST_ERR_TYPE );
+	assert_int_eq( as_list_size(list), 100 );
+
+	// Inserting and removing keeps cached boxes with their elements.
+	assert_int_eq( as_list_insert_int64(list, 0, -1), AS_ARRAYLIST_OK );
+	assert_true( as_list_get(list, 8) == v );
+	assert_int_eq( as_list_remove(list, 0), AS_ARRAYLIST_OK );
+	assert_true( as_list_get(list, 7) == v );
+	assert_int_eq( as_list_set(list, 7, (as_val *) as_integer_new(700)), AS_ARRAYLIST_OK );
+	assert_int_eq( as_integer_get((as_integer *) as_list_get(list, 7)), 700 );
+	assert_int_eq( as_list_set_int64(list, 100, 100), AS_ARRAYLIST_OK );
+	assert_int_eq( as_list_set_int64(list, 102, 102), AS_ARRAYLIST_ERR_INDEX );
+
+	int64_t sum = 0;
+	assert_true( as_list_foreach(list, sum_foreach, &sum) );
+	assert_int_eq( sum, 100 * 101 / 2 + 693 );
+
+	as_list_iterator it;
+	as_iterator * i = (as_iterator *) as_list_iterator_init(&it, list);
+	uint32_t n = 0;
+
+	while (as_iterator_has_next(i)) {
+		const as_val * e = as_iterator_next(i);
+		assert_int_eq( as_integer_get((as_integer *) e), as_list_get_int64(list, n) );
+		n++;
+	}
+
+	as_iterator_destroy(i);
+	assert_int_eq( n, 101 );
+
+	as_list * tail = as_list_tail(list);
+	assert_int_eq( as_list_size(tail), 100 );
+	assert_int_eq( as_list_get_int64(tail, 0), 1 );
+	as_list_destroy(tail);
+
+	assert_int_eq( as_list_trim(list, 10), AS_ARRAYLIST_OK );
+	assert_int_eq( as_list_size(list), 10 );
+
+	as_typedlist_destroy(&l);
+}
+
+TEST( types_typedlist_compat, "as_typedlist equals as_arraylist" ) {
+
+	as_typedlist * t = as_typedlist_new(AS_DOUBLE, 4);
+	as_arraylist a;
+	as_arraylist_init(&a, 4, 4);
+
+	for (int i = 0; i < 40; i++) {
+		as_typedlist_append_double(t, i * 0.25 - 2);
+		as_arraylist_append_double(&a, i * 0.25 - 2);
+	}
+
+	assert_true( as_typedlist_doubles(t)[3] == -1.25 );
+	assert_int_eq( as_val_hashcode(t), as_val_hashcode(&a) );
+	assert_true( same_packing((as_val *) t, (as_val *) &a) );
+	assert_val_eq( (as_val *) t, (as_val *) &a );
+
+	// Concatenating in either direction.
+	assert_int_eq( as_typedlist_concat(t, (as_list *) &a), AS_ARRAYLIST_OK );
+	assert_int_eq( as_typedlist_size(t), 80 );
+
+	as_arraylist a2;
+	as_arraylist_init(&a2, 0, 0);
+	assert_int_eq( as_list_concat((as_list *) &a2, (as_list *) t), AS_ARRAYLIST_ERR_MAX );
+	assert_int_eq( as_arraylist_size(&a2), 0 );
+	as_arraylist_init(&a2, 0, 8);
+	assert_int_eq( as_list_concat((as_list *) &a2, (as_list *) t), AS_ARRAYLIST_OK );
+	assert_int_eq( as_arraylist_size(&a2), 80 );
+	assert_int_eq( as_val_hashcode(t), as_val_hashcode(&a2) );
+	assert_true( same_packing((as_val *) t, (as_val *) &a2) );
+	as_arraylist_destroy(&a2);
+
+	// Mixed lists are refused whole.
+	as_arraylist_append_str(&a, "x");
+	assert_int_eq( as_typedlist_concat(t, (as_list *) &a), AS_ARRAYLIST_ERR_TYPE );
+	assert_int_eq( as_typedlist_size(t), 80 );
+
+	as_typedlist * ints = as_typedlist_new(AS_INTEGER, 0);
+	assert_int_eq( as_typedlist_concat(t, (as_list *) ints), AS_ARRAYLIST_ERR_TYPE );
+
+	// Round trips unpack as regular lists.
+	as_typedlist_append_int64(ints, -5);
+	as_typedlist_append_int64(ints, 1LL << 40);
+
+	as_serializer ser;
+	as_msgpack_init(&ser);
+	as_buffer b;
+	as_buffer_init(&b);
+	as_serializer_serialize(&ser, (as_val *) ints, &b);
+
+	as_val * out = NULL;
+	as_serializer_deserialize(&ser, &b, &out);
+	assert_int_eq( as_val_type(out), AS_LIST );
+	assert_val_eq( out, (as_val *) ints );
+
+	as_val_destroy(out);
+	as_buffer_destroy(&b);
+	as_serializer_destroy(&ser);
+	as_typedlist_destroy(ints);
+	as_arraylist_destroy(&a);
+	as_typedlist_destroy(t);
+}
+
+#define BOX_THREADS 4
+#define BOXES 100
+
+typedef struct box_job_s {
+	const as_typedlist * list;
+	pthread_barrier_t * barrier;
+	as_val * boxes[BOXES];
+	uint32_t hash;
+} box_job;
+
+static void * box_run(void * udata)
+{
+	box_job * job = udata;
+
+	pthread_barrier_wait(job->barrier);
+	job->hash = as_typedlist_hashcode(job->list);
+
+	for (uint32_t i = 0; i < BOXES; i++) {
+		job->boxes[i] = as_typedlist_get(job->list, i);
+	}
+	return NULL;
+}
+
+TEST( types_typedlist_box_concurrent, "concurrent boxing and hashing of a read-only as_typedlist" ) {
+
+	pthread_barrier_t barrier;
+	pthread_barrier_init(&barrier, NULL, BOX_THREADS);
+
+	as_typedlist ref;
+	as_typedlist_init(&ref, AS_DOUBLE, BOXES);
+
+	for (uint32_t i = 0; i < BOXES; i++) {
+		as_typedlist_append_double(&ref, i + 0.5);
+	}
+
+	uint32_t h = as_typedlist_hashcode(&ref);
+
+	for (int round = 0; round < 20; round++) {
+		as_typedlist l;
+		as_typedlist_init(&l, AS_DOUBLE, BOXES);
+
+		for (uint32_t i = 0; i < BOXES; i++) {
+			as_typedlist_append_double(&l, i + 0.5);
+		}
+
+		box_job jobs[BOX_THREADS];
+		pthread_t threads[BOX_THREADS];
+
+		for (int t = 0; t < BOX_THREADS; t++) {
+			jobs[t].list = &l;
+			jobs[t].barrier = &barrier;
+			pthread_create(&threads[t], NULL, box_run, &jobs[t]);
+		}
+
+		for (int t = 0; t < BOX_THREADS; t++) {
+			pthread_join(threads[t], NULL);
+		}
+
+		// Every reader got the one box the list kept, and the same hash.
+		for (int t = 0; t < BOX_THREADS; t++) {
+			assert_int_eq( jobs[t].hash, h );
+			for (uint32_t i = 0; i < BOXES; i++) {
+				assert_true( jobs[t].boxes[i] == l.boxed[i] );
+				assert_double_eq( as_double_get((as_double *) jobs[t].boxes[i]), i + 0.5 );
+			}
+		}
+
+		assert_int_eq( as_typedlist_hashcode(&l), h );
+		as_typedlist_destroy(&l);
+	}
+
+	as_typedlist_destroy(&ref);
+	pthread_barrier_destroy(&barrier);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE( types_typedlist, "as_typedlist" ) {
+	suite_add( types_typedlist_ops );
+	suite_add( types_typedlist_compat );
+	suite_add( types_typedlist_box_concurrent );
+}